@@ -0,0 +1,366 @@
+/*******************************************************************
+** FILE:
+**   	Acquisition_Functions
+** DESCRIPTION:
+** 		This file contains the sample ring used for interrupt
+** 		driven acquisition (see Acquisition_Config.h).
+** 		loop() burst reads the samples from the IMU FIFO with
+** 		Acq_FIFO_Read, dated by the stamps the IMU specific
+** 		interrupt handler records with Acq_Ring_Stamp
+** 		(interrupt mode), and drains the ring with Acq_Process.
+** 		These functions are platform independent; in emulation
+** 		mode a producer thread stands in for the interrupt.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#if EXE_MODE==1 /* Emulator Mode */
+	/* In emulation mode, "Emulator_Protos" is needed to
+	** use functions in other files.
+	** NOTE: This header should contain the function
+	** 			 prototypes for all execution functions */
+	#include "../Include/Emulator_Protos.h"
+#endif  /* End Emulator Mode */
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Acq_Ring_Init
+** VARIABLES:
+**		[IO]	ACQ_RING_TYPE	*p_ring
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty the ring and clear the counters.
+** 		Must be called before the producer starts.
+*/
+void Acq_Ring_Init( ACQ_RING_TYPE *p_ring )
+{
+	p_ring->nPushed  = 0;
+	p_ring->nDropped = 0;
+	p_ring->nPopped  = 0;
+	p_ring->nBatches = 0;
+	p_ring->MaxDepth = 0;
+	ACQ_STORE( &p_ring->nStamped, 0 );
+	ACQ_STORE( &p_ring->tail, 0 );
+	ACQ_STORE( &p_ring->head, 0 );
+} /* End Acq_Ring_Init */
+
+
+/*************************************************
+** FUNCTION: Acq_Ring_Push
+** VARIABLES:
+**		[IO]	ACQ_RING_TYPE					*p_ring
+**		[I ]	const ACQ_SAMPLE_TYPE	*p_sample
+** RETURN:
+**		BOOL	1:Sample queued
+**					0:Ring full, sample dropped
+** DESCRIPTION:
+** 		Producer side (FIFO read, emulator).
+** 		The sample is written before head is
+** 		published, so the consumer never sees
+** 		a partly written sample.
+*/
+bool Acq_Ring_Push( ACQ_RING_TYPE					*p_ring,
+										const ACQ_SAMPLE_TYPE	*p_sample )
+{
+	uint32_t head = p_ring->head;
+
+	if( head - ACQ_LOAD( &p_ring->tail ) >= ACQ_RING_SIZE )
+	{
+		p_ring->nDropped++;
+		return FALSE;
+	}
+
+	p_ring->sample[head & ACQ_RING_MASK] = *p_sample;
+	p_ring->nPushed++;
+	ACQ_STORE( &p_ring->head, head+1 );
+	return TRUE;
+} /* End Acq_Ring_Push */
+
+
+/*************************************************
+** FUNCTION: Acq_Ring_Stamp
+** VARIABLES:
+**		[IO]	ACQ_RING_TYPE	*p_ring
+**		[I ]	uint32_t			timestamp
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Producer side, data ready interrupt
+** 		handler. Records the time of the sample
+** 		the IMU just queued in its FIFO; the
+** 		sample itself is read from loop()
+** 		(Acq_FIFO_Read), so there is no bus
+** 		access in the interrupt. Nothing is
+** 		dropped here: the stamp is written
+** 		before nStamped is published, and the
+** 		oldest stamps are overwritten.
+*/
+void Acq_Ring_Stamp( ACQ_RING_TYPE	*p_ring,
+										 uint32_t				timestamp )
+{
+	uint32_t n = p_ring->nStamped;
+
+	p_ring->stamp[n & ACQ_RING_MASK] = timestamp;
+	ACQ_STORE( &p_ring->nStamped, n+1 );
+} /* End Acq_Ring_Stamp */
+
+
+/*************************************************
+** FUNCTION: Acq_Ring_Pop
+** VARIABLES:
+**		[IO]	ACQ_RING_TYPE		*p_ring
+**		[O ]	ACQ_SAMPLE_TYPE	*p_sample
+** RETURN:
+**		BOOL	1:Sample returned
+**					0:Ring empty
+** DESCRIPTION:
+** 		Consumer side (loop). The slot is
+** 		copied out before tail is released
+** 		back to the producer.
+*/
+bool Acq_Ring_Pop( ACQ_RING_TYPE		*p_ring,
+									 ACQ_SAMPLE_TYPE	*p_sample )
+{
+	uint32_t tail = p_ring->tail;
+
+	if( tail==ACQ_LOAD( &p_ring->head ) ) { return FALSE; }
+
+	*p_sample = p_ring->sample[tail & ACQ_RING_MASK];
+	p_ring->nPopped++;
+	ACQ_STORE( &p_ring->tail, tail+1 );
+	return TRUE;
+} /* End Acq_Ring_Pop */
+
+
+/*************************************************
+** FUNCTION: Acq_Begin_Batch
+** VARIABLES:
+**		[IO]	ACQ_RING_TYPE	*p_ring
+** RETURN:
+**		int		Number of samples to process
+** DESCRIPTION:
+** 		Consumer side. Returns the number of
+** 		samples waiting (at most ACQ_MAX_BATCH)
+** 		and updates the batch statistics.
+** 		Samples arriving during the batch are
+** 		left for the next one.
+*/
+int Acq_Begin_Batch( ACQ_RING_TYPE *p_ring )
+{
+	uint32_t depth = ACQ_LOAD( &p_ring->head ) - p_ring->tail;
+
+	if( depth==0 ) { return 0; }
+	if( depth>p_ring->MaxDepth ) { p_ring->MaxDepth = depth; }
+	p_ring->nBatches++;
+
+	return ( depth>ACQ_MAX_BATCH ) ? ACQ_MAX_BATCH : (int)depth;
+} /* End Acq_Begin_Batch */
+
+
+/*************************************************
+** FUNCTION: Acq_Load_Sample
+** VARIABLES:
+**		[IO]	CONTROL_TYPE					*p_control
+**		[IO]	SENSOR_STATE_TYPE			*p_sensor_state
+**		[I ]	const ACQ_SAMPLE_TYPE	*p_sample
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Copy a ring sample into the sensor state.
+** 		This takes the place of Read_Sensors; the
+** 		sample timestamp is used by Update_Time.
+*/
+void Acq_Load_Sample( CONTROL_TYPE						*p_control,
+											SENSOR_STATE_TYPE				*p_sensor_state,
+											const ACQ_SAMPLE_TYPE		*p_sample )
+{
+	p_control->acq_timestamp = p_sample->timestamp;
+
+	p_sensor_state->accel[0] = (float)p_sample->accel[0];
+	p_sensor_state->accel[1] = (float)p_sample->accel[1];
+	p_sensor_state->accel[2] = (float)p_sample->accel[2];
+	p_sensor_state->gyro[0]  = (float)p_sample->gyro[0];
+	p_sensor_state->gyro[1]  = (float)p_sample->gyro[1];
+	p_sensor_state->gyro[2]  = (float)p_sample->gyro[2];
+#if DSP_FIXED==1
+	memcpy( p_sensor_state->accel_raw, p_sample->accel, sizeof(p_sensor_state->accel_raw) );
+	memcpy( p_sensor_state->gyro_raw,  p_sample->gyro,  sizeof(p_sensor_state->gyro_raw) );
+#endif
+} /* End Acq_Load_Sample */
+
+
+/*************************************************
+** FUNCTION: Acq_Process
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+**		[IO]	ACQ_RING_TYPE				*p_ring
+** RETURN:
+**		int		Number of samples processed
+** DESCRIPTION:
+** 		Drain a batch of samples from the ring,
+** 		running the processing stages on each.
+*/
+int Acq_Process( PIPELINE_STATE_TYPE	*p_pipeline,
+								 ACQ_RING_TYPE				*p_ring )
+{
+	ACQ_SAMPLE_TYPE sample;
+	int i, n;
+
+	n = Acq_Begin_Batch( p_ring );
+	for( i=0; i<n; i++ )
+	{
+		if( Acq_Ring_Pop( p_ring, &sample )==FALSE ) { break; }
+		Acq_Load_Sample( &p_pipeline->control, &p_pipeline->sensor_state, &sample );
+		Pipeline_Update( p_pipeline );
+	}
+	return i;
+} /* End Acq_Process */
+
+
+/* Only link if using IMU9250 (FIFO register map) */
+#ifdef _IMU9250_
+
+/*************************************************
+** FUNCTION: Acq_FIFO_Init
+** VARIABLES:
+**		[O ]	ACQ_FIFO_TYPE	*p_fifo
+**		[I ]	uint32_t			period
+**		[I ]	bool					Stamped
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Set the IMU sample period (us), the
+** 		dating of the frames (Stamped: from the
+** 		data ready stamps) and clear the counters.
+** 		The IMU FIFO should be reset at the same
+** 		time (after the interrupt is attached,
+** 		so every frame queued has its stamp).
+*/
+void Acq_FIFO_Init( ACQ_FIFO_TYPE	*p_fifo,
+										uint32_t			period,
+										bool					Stamped )
+{
+	p_fifo->period     = period;
+	p_fifo->Stamped    = Stamped;
+	p_fifo->nReads     = 0;
+	p_fifo->nFrames    = 0;
+	p_fifo->nOverflows = 0;
+} /* End Acq_FIFO_Init */
+
+
+/*************************************************
+** FUNCTION: Acq_FIFO_Read
+** VARIABLES:
+**		[IO]	ACQ_FIFO_TYPE	*p_fifo
+**		[IO]	ACQ_RING_TYPE	*p_ring
+**		[I ]	uint32_t			now
+** RETURN:
+**		int		Number of samples queued,
+**					-1 on a bus error
+** DESCRIPTION:
+** 		Drain the frames waiting in the IMU FIFO
+** 		into the sample ring, ACQ_FIFO_BURST_FRAMES
+** 		per bus transaction. At most the free space
+** 		in the ring is read, the rest stays in the
+** 		FIFO for the next pass.
+** 		With Stamped, the newest frame in the FIFO
+** 		gets the newest data ready stamp, each older
+** 		frame the stamp before. The stamp count is
+** 		read before and after the FIFO count and the
+** 		count is read again if they differ, so a
+** 		sample queued during the count read is not
+** 		paired with the previous stamp. A frame is
+** 		still dated one period early if its interrupt
+** 		only runs after the second read of the stamp
+** 		count (the interrupt latency, microseconds).
+** 		Frames older than the first stamp are dated
+** 		back one period each.
+** 		Otherwise, now (us) is the time of the read:
+** 		the newest frame in the FIFO gets it as its
+** 		timestamp, each older frame one period less.
+** 		On overflow the FIFO data is no longer frame
+** 		aligned, so the FIFO is reset and the frames
+** 		in it are lost.
+*/
+int Acq_FIFO_Read( ACQ_FIFO_TYPE	*p_fifo,
+									 ACQ_RING_TYPE	*p_ring,
+									 uint32_t				now )
+{
+	uint8_t         data[ACQ_FIFO_BURST_FRAMES*ACQ_FIFO_FRAME_SIZE];
+	ACQ_SAMPLE_TYPE sample;
+	uint32_t        nWaiting, nFree, nRead, nQueued, nBurst, nStamped, age, i;
+	const uint8_t  *p_frame;
+
+	/* Frames waiting (and the samples stamped up to then) */
+	do
+	{
+		nStamped = ACQ_LOAD( &p_ring->nStamped );
+		if( ACQ_FIFO_READ( IMU_FIFO_COUNTH, 2, data )!=0 ) { return -1; }
+		p_fifo->nReads++;
+	} while( p_fifo->Stamped && ACQ_LOAD( &p_ring->nStamped )!=nStamped );
+	nWaiting = ( ((uint32_t)data[0]<<8) | data[1] ) / ACQ_FIFO_FRAME_SIZE;
+	if( nWaiting==0 ) { return 0; }
+
+	/* Near full, check for overflow */
+	if( nWaiting*ACQ_FIFO_FRAME_SIZE > IMU_FIFO_SIZE/2 )
+	{
+		if( ACQ_FIFO_READ( IMU_INT_STATUS, 1, data )!=0 ) { return -1; }
+		p_fifo->nReads++;
+		if( data[0] & IMU_INT_FIFO_OFLOW )
+		{
+			ACQ_FIFO_RESET();
+			p_fifo->nOverflows++;
+			return 0;
+		}
+	}
+
+	nFree   = ACQ_RING_SIZE - ( p_ring->head - ACQ_LOAD( &p_ring->tail ) );
+	nRead   = ( nWaiting<nFree ) ? nWaiting : nFree;
+	nQueued = nRead;
+
+	/* Time of the newest frame */
+	if( p_fifo->Stamped && nStamped>0 ) { now = p_ring->stamp[(nStamped-1) & ACQ_RING_MASK]; }
+	age = nWaiting;
+
+	while( nRead>0 )
+	{
+		nBurst = ( nRead<ACQ_FIFO_BURST_FRAMES ) ? nRead : ACQ_FIFO_BURST_FRAMES;
+		if( ACQ_FIFO_READ( IMU_FIFO_R_W, nBurst*ACQ_FIFO_FRAME_SIZE, data )!=0 ) { return -1; }
+		p_fifo->nReads++;
+
+		for( i=0; i<nBurst; i++ )
+		{
+			p_frame = &data[i*ACQ_FIFO_FRAME_SIZE];
+			sample.accel[0] = (int16_t)( (p_frame[0]<<8)  | p_frame[1] );
+			sample.accel[1] = (int16_t)( (p_frame[2]<<8)  | p_frame[3] );
+			sample.accel[2] = (int16_t)( (p_frame[4]<<8)  | p_frame[5] );
+			sample.gyro[0]  = (int16_t)( (p_frame[6]<<8)  | p_frame[7] );
+			sample.gyro[1]  = (int16_t)( (p_frame[8]<<8)  | p_frame[9] );
+			sample.gyro[2]  = (int16_t)( (p_frame[10]<<8) | p_frame[11] );
+
+			age--;
+			if( p_fifo->Stamped && age<nStamped ) { sample.timestamp = p_ring->stamp[(nStamped-1-age) & ACQ_RING_MASK]; }
+			else                                  { sample.timestamp = now - age*p_fifo->period; }
+
+			Acq_Ring_Push( p_ring, &sample );
+		}
+
+		p_fifo->nFrames += nBurst;
+		nRead           -= nBurst;
+	}
+
+	return (int)nQueued;
+} /* End Acq_FIFO_Read */
+
+#endif /* End _IMU9250_ */
@@ -58,6 +58,7 @@ void Common_Init ( CONTROL_TYPE 			*p_control,
   p_control->timestamp      = 0;
   p_control->timestamp_old  = 0;
   p_control->G_Dt           = 0.0;
+  p_control->acq_timestamp  = 0;
 
 	/* For emulation mode,
 	** am "emu timestamp" is needed  */
@@ -81,6 +82,9 @@ void Common_Init ( CONTROL_TYPE 			*p_control,
 	p_control->sensor_prms.gyro_on     = GYRO_ON;
 	p_control->sensor_prms.magn_on     = MAGN_ON;
 	p_control->sensor_prms.sample_rate = TIME_SR;
+
+	/* Clear the profiler */
+	Profile_Init( p_control );
 	
 	/* Initialize stats */
   p_sensor_state->gyro_Ave = 0.0;
@@ -94,6 +98,11 @@ void Common_Init ( CONTROL_TYPE 			*p_control,
   p_sensor_state->accel_M2   = 0.0;
   p_sensor_state->accel_sVar = 0.0;
   p_sensor_state->accel_pVar = 0.0;
+
+  p_sensor_state->gyro_min  = 0.0;
+  p_sensor_state->gyro_max  = 0.0;
+  p_sensor_state->accel_min = 0.0;
+  p_sensor_state->accel_max = 0.0;
 	
 } /* End Common_Init*/
 
@@ -111,18 +120,33 @@ void Common_Init ( CONTROL_TYPE 			*p_control,
 */
 void Update_Time( CONTROL_TYPE *p_control )
 {
+	/* Time spent waiting for the sample period */
+	unsigned long IdleTime = 0;
 
   #if EXE_MODE==1 /* Emulator Mode */
   	/* Timestamp is read from file */
   	p_control->timestamp_old = p_control->timestamp;
   	p_control->timestamp     = p_control->emu_data.timestamp;
 
+  #elif ACQ_MODE!=ACQ_MODE_POLL
+  	/* Timestamp was taken in the data ready interrupt (or
+  	** rebuilt from the FIFO read time, see Acq_FIFO_Read)
+  	** There is no need to wait, the sample is paced by the IMU */
+  	p_control->timestamp_old = p_control->timestamp;
+  	p_control->timestamp     = p_control->acq_timestamp;
+
   #else /* Real Time mode */
   	float minTime = (float) (TIME_RESOLUTION / (TIME_SR+1.0) ); /* Set Sampling Rate */
+  	#if PROFILE_ON==1
+  		IdleTime = TIME_FUPDATE;
+  	#endif
   	while( (TIME_FUPDATE - p_control->timestamp) < (minTime) ) {}
   	/* Update delta T */
   	p_control->timestamp_old = p_control->timestamp;
   	p_control->timestamp     = TIME_FUPDATE;
+  	#if PROFILE_ON==1
+  		IdleTime = p_control->timestamp - IdleTime;
+  	#endif
 
   #endif /* End Emulator Mode */
 
@@ -135,5 +159,137 @@ void Update_Time( CONTROL_TYPE *p_control )
   {
   	p_control->G_Dt = 0.0f;
   }
+
+  PROFILE_UPDATE_TIME( p_control, IdleTime );
 } /* End Update_Time */
 
+
+
+/*************************************************
+** FUNCTION: Pipeline_Init
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Initialize the algorithm states of a pipeline
+** 		instance. Common_Init must have been called and
+** 		the first sample read (it is used to set the
+** 		initial roll/pitch/yaw).
+*/
+void Pipeline_Init( PIPELINE_STATE_TYPE *p_pipeline )
+{
+	CONTROL_TYPE *p_control = &p_pipeline->control;
+
+  /* Initialize Freq. Filter */
+  if( p_control->DSP_on==1 ){ DSP_Filter_Init( p_control, &p_pipeline->dsp ); }
+
+	/* Empty the motion statistics windows */
+#if STATS_ON==1
+	Stats_Init( &p_pipeline->stats );
+#endif
+
+	/* Initialize calibration parameters */
+  if( p_control->calibration_on==1 ){ Calibration_Init( p_control, &p_pipeline->calibration ); }
+
+	/* Initialize the Directional Cosine Matrix algorithm parameters */
+  if( p_control->DCM_on==1 ){ DCM_Init( p_control, &p_pipeline->dcm_state, &p_pipeline->sensor_state ); }
+
+	/* Initialize GaPA parameters */
+  if( p_control->GaPA_on==1 ){ GaPA_Init( p_control, &p_pipeline->gapa_state ); }
+
+  /* Initialize Walking Incline and Speed Estimator */
+  if( p_control->WISE_on==1 ){ WISE_Init( p_control, &p_pipeline->sensor_state, &p_pipeline->wise_state ); }
+} /* End Pipeline_Init */
+
+
+/*************************************************
+** FUNCTION: Pipeline_Update
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Run the processing stages on the most recent
+** 		sample (Read_Sensors must be called first).
+** 		This is the stage sequence shared by the
+** 		real-time loop() and the emulator.
+*/
+void Pipeline_Update( PIPELINE_STATE_TYPE *p_pipeline )
+{
+	CONTROL_TYPE      *p_control      = &p_pipeline->control;
+	SENSOR_STATE_TYPE *p_sensor_state = &p_pipeline->sensor_state;
+
+  /* Update the timestamp */
+  Update_Time( p_control );
+
+#if DSP_FIXED==1
+	/* Read_Sensors only wrote the raw readings, the
+	** floats come from DSP_Fixed_Filter unless it is
+	** off or calibration needs them before it */
+	if( p_control->calibration_on==1 || p_control->DSP_on==0 )
+	{
+		DSP_Fixed_Load( p_sensor_state );
+	}
+#endif
+
+	/* If in calibration mode,
+	** call calibration function */
+	if( p_control->calibration_on==1 )
+	{
+		Calibrate( p_control, &p_pipeline->calibration, p_sensor_state );
+		PROFILE_LAP( p_control, PROFILE_CALIBRATE );
+	}
+
+	/* Apply Freq Filter to Input */
+	if( p_control->DSP_on==1 )
+	{
+#if DSP_FIXED==1
+		DSP_Fixed_Filter( p_control, &p_pipeline->dsp, p_sensor_state );
+#else
+		if( p_control->dsp_prms.FIR_on==1 ){ FIR_Filter( p_control, &p_pipeline->dsp, p_sensor_state ); }
+		if( p_control->dsp_prms.IIR_on==1 ){ IIR_Filter( p_control, &p_pipeline->dsp, p_sensor_state ); }
+#endif
+		DSP_Shift( p_control, &p_pipeline->dsp );
+		PROFILE_LAP( p_control, PROFILE_DSP );
+	}
+
+	/* Motion statistics (the GaPA/WISE motion gate)
+	** Not a profiled stage, timed with the next one */
+#if STATS_ON==1
+	Stats_Update( &p_pipeline->stats, p_sensor_state );
+#endif
+
+	/* Estimate the orientation (DCM or quaternion engine) */
+	if( p_control->DCM_on==1 )
+	{
+		Orientation_Update( p_control, &p_pipeline->dcm_state, p_sensor_state );
+		PROFILE_LAP( p_control, PROFILE_DCM );
+	}
+
+	/* Estimate the Gait Phase Angle */
+	if( p_control->GaPA_on==1 )
+	{
+		GaPA_Update( p_control, p_sensor_state, &p_pipeline->gapa_state );
+		GaPA_Predict( p_control, &p_pipeline->gapa_state );
+		PROFILE_LAP( p_control, PROFILE_GAPA );
+	}
+
+	/* Estimate Walking Speed and Incline */
+	if( p_control->WISE_on==1 )
+	{
+		/* GaPA stride period, for the stride history */
+		p_pipeline->wise_state.gapa_cycle_time = ( p_pipeline->gapa_state.stride_rate>0.0f ) ? 1.0f/p_pipeline->gapa_state.stride_rate : 0.0f;
+		/* Integrate while there is motion, restart the
+		** segment while the subject is stopped (see GaPA_Update) */
+		if( (p_sensor_state->gyro_mAve>=p_control->gapa_prms.min_gyro) )
+		{
+			WISE_Update( p_control, p_sensor_state, &p_pipeline->wise_state );
+		}
+		else
+		{
+			WISE_Reset( p_control, &p_pipeline->wise_state );
+		}
+		PROFILE_LAP( p_control, PROFILE_WISE );
+	}
+} /* End Pipeline_Update */
@@ -6,7 +6,8 @@
 ** 		This file contains all the serial communication functions
 **		and protocols for use in the real-time execution code. These
 **		functions are intended for the final executable.
-**		These functions cannot be used in emulation mode.
+**		In emulation mode the serial port is replaced by the
+**		emulator communication queues (see Emulator_Config.h).
 ********************************************************************/
 
 
@@ -35,6 +36,7 @@
 ** VARIABLES:
 **		[I ]	CONTROL_TYPE			*p_control
 **		[I ]	SENSOR_STATE_TYPE	*p_sensor_state
+**		[IO]	CALIBRATION_TYPE	*p_calibration
 **		[I ]	WISE_STATE_TYPE		*p_wise_state
 **		[I ]	int								nBytes
 ** RETURN:
@@ -48,9 +50,10 @@
 void f_RespondToInput( CONTROL_TYPE 			*p_control,
 											 SENSOR_STATE_TYPE 	*p_sensor_state,
 											 CALIBRATION_TYPE		*p_calibration,
+											 WISE_STATE_TYPE		*p_wise_state,
                        int nBytesIn )
 {
-  int i;
+  int i, j;
   unsigned char RequestByte;
 
 
@@ -136,9 +139,9 @@ void f_RespondToInput( CONTROL_TYPE 			*p_control,
         Response.PacketType     = 1;
         Response.Buffer_nBytes  = sizeof(uint8_t)*2*3;
         Response.Packet_nBytes  = sizeof(uint16_t)*2 + sizeof(uint8_t)*(1 + Response.Buffer_nBytes);
-        f_WriteFToPacket_u16( &Response.Buffer[sizeof(uint16_t)*0], TO_DEG(p_sensor_state->roll) );
+        f_WriteFToPacket_u16( &Response.Buffer[sizeof(uint16_t)*0], TO_DEG(Orientation_Roll( p_control, p_sensor_state )) );
         f_WriteFToPacket_u16( &Response.Buffer[sizeof(uint16_t)*1], TO_DEG(p_sensor_state->pitch) );
-        f_WriteFToPacket_u16( &Response.Buffer[sizeof(uint16_t)*2], TO_DEG(p_sensor_state->yaw) );
+        f_WriteFToPacket_u16( &Response.Buffer[sizeof(uint16_t)*2], TO_DEG(Orientation_Yaw( p_control, p_sensor_state )) );
         Response.CheckSum       = f_CheckSum( &Response.Buffer[0], Response.Buffer_nBytes );
         f_SendPacket( Response );
         break;
@@ -154,13 +157,38 @@ void f_RespondToInput( CONTROL_TYPE 			*p_control,
         Response.PacketType     = 2;
         Response.Buffer_nBytes  = sizeof(uint8_t)*4*3;
         Response.Packet_nBytes  = sizeof(uint16_t)*2 + sizeof(uint8_t)*(1 + Response.Buffer_nBytes);
-        f_WriteFToPacket_s32( &Response.Buffer[sizeof(uint32_t)*0], TO_DEG(p_sensor_state->roll) );
+        f_WriteFToPacket_s32( &Response.Buffer[sizeof(uint32_t)*0], TO_DEG(Orientation_Roll( p_control, p_sensor_state )) );
         f_WriteFToPacket_s32( &Response.Buffer[sizeof(uint32_t)*1], TO_DEG(p_sensor_state->pitch) );
-        f_WriteFToPacket_s32( &Response.Buffer[sizeof(uint32_t)*2], TO_DEG(p_sensor_state->yaw) );
+        f_WriteFToPacket_s32( &Response.Buffer[sizeof(uint32_t)*2], TO_DEG(Orientation_Yaw( p_control, p_sensor_state )) );
         Response.CheckSum       = f_CheckSum( &Response.Buffer[0], Response.Buffer_nBytes );
         f_SendPacket( Response );
         break;
 
+      case 0xA3:
+        /* Packet type 3
+        ** Stride history (see f_SendStrides)
+        ** The last WISE_STRIDE_PACKET strides in one
+        ** packet, polled instead of per sample data */
+  			sprintf(fastlog,"\tReceived Stride History Request: %x",RequestByte); LOG_PRINTLN( fastlog );
+        f_SendStrides( p_wise_state );
+        break;
+
+      case 0xC1:
+        /* Packet types 21,22
+        ** Profiler counters (see Profile_Config.h)
+        ** One summary packet followed by one
+        ** histogram packet per stage */
+  			sprintf(fastlog,"\tReceived Profile Request: %x",RequestByte); LOG_PRINTLN( fastlog );
+        f_SendProfile( p_control );
+        break;
+
+      case 0xC2:
+        /* Profiler - Reset the counters
+        ** Starts a new measurement window */
+  			sprintf(fastlog,"\t> Received Profile Reset Request ... Case : %d",RequestByte); LOG_PRINTLN( fastlog );
+        Profile_Reset( p_control );
+        break;
+
       case 0x62:
         /* DEBUG - Toggle Output
         ** Toggles calibration output mode
@@ -180,6 +208,30 @@ void f_RespondToInput( CONTROL_TYPE 			*p_control,
         Calibration_Init( p_control, p_calibration );
         break;
 
+      case 0xD1:
+        /* DSP - Next accel IIR bank
+        ** Steps all accel channels to the next
+        ** LPF bank (order/cutoff, see DSP_Config.h) */
+        for( j=0; j<3; j++ ) { p_control->dsp_prms.IIR_accel_bank[j] = (p_control->dsp_prms.IIR_accel_bank[j]+1)%DSP_NUM_BANKS; }
+  			sprintf(fastlog,"\t> Received Accel IIR Bank Request ... Bank : %d",p_control->dsp_prms.IIR_accel_bank[0]); LOG_PRINTLN( fastlog );
+        break;
+
+      case 0xD2:
+        /* DSP - Next gyro IIR bank
+        ** Steps all gyro channels to the next
+        ** HPF bank (order/cutoff, see DSP_Config.h) */
+        for( j=0; j<3; j++ ) { p_control->dsp_prms.IIR_gyro_bank[j] = (p_control->dsp_prms.IIR_gyro_bank[j]+1)%DSP_NUM_BANKS; }
+  			sprintf(fastlog,"\t> Received Gyro IIR Bank Request ... Bank : %d",p_control->dsp_prms.IIR_gyro_bank[0]); LOG_PRINTLN( fastlog );
+        break;
+
+      case 0xD3:
+        /* DCM - Next orientation engine
+        ** DCM or quaternion (see DCM_Config.h), the
+        ** state is handed over on the next sample */
+        p_control->dcm_prms.Engine = (p_control->dcm_prms.Engine+1)%NUM_ORIENTATION_ENGINES;
+  			sprintf(fastlog,"\t> Received Orientation Engine Request ... Engine : %d",p_control->dcm_prms.Engine); LOG_PRINTLN( fastlog );
+        break;
+
       case 0x64:
         /* WISE - Reset WISE state variables
         ** Simulate heel strike */
@@ -240,6 +292,122 @@ void f_SendPacket( COMMUNICATION_PACKET_TYPE Response )
 } /* End f_SendPacket */
 
 
+/*************************************************
+** FUNCTION: f_SendProfile
+** VARIABLES:
+**		[I ]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Send the profiler counters to the master.
+** 		All values are 32 bit unsigned integers
+** 		(times in us) unless noted.
+** 		Packet type 21, summary:
+** 			nLoops, nOverruns, budget, Dt_min, Dt_max,
+** 			idle, elapsed (since reset), loop max
+** 		Packet type 22, one per stage:
+** 			stage (16 bit), max,
+** 			PROFILE_N_BUCKETS histogram counts
+*/
+void f_SendProfile( CONTROL_TYPE *p_control )
+{
+  PROFILE_STATE_TYPE *p_profile = &p_control->profile;
+  COMMUNICATION_PACKET_TYPE Response;
+  uint32_t Summary[8];
+  int i, j;
+
+  Summary[0] = p_profile->nLoops;
+  Summary[1] = p_profile->nOverruns;
+  Summary[2] = p_profile->budget;
+  Summary[3] = ( p_profile->Dt_max>0 ) ? p_profile->Dt_min : 0;
+  Summary[4] = p_profile->Dt_max;
+  Summary[5] = p_profile->idle;
+  Summary[6] = (uint32_t)(PROFILE_TIME - p_profile->reset_time);
+  Summary[7] = p_profile->max[PROFILE_LOOP];
+
+  Response.PacketType     = 21;
+  Response.Buffer_nBytes  = sizeof(uint32_t)*8;
+  Response.Packet_nBytes  = sizeof(uint16_t)*2 + sizeof(uint8_t)*(1 + Response.Buffer_nBytes);
+  for( i=0; i<8; i++ ) { f_WriteLToPacket( &Response.Buffer[sizeof(uint32_t)*i], Summary[i] ); }
+  Response.CheckSum       = f_CheckSum( &Response.Buffer[0], Response.Buffer_nBytes );
+  f_SendPacket( Response );
+
+  for( i=0; i<PROFILE_N_STAGES; i++ )
+  {
+    Response.PacketType     = 22;
+    Response.Buffer_nBytes  = sizeof(uint16_t) + sizeof(uint32_t)*(1 + PROFILE_N_BUCKETS);
+    Response.Packet_nBytes  = sizeof(uint16_t)*2 + sizeof(uint8_t)*(1 + Response.Buffer_nBytes);
+    f_WriteIToPacket( &Response.Buffer[0], i );
+    f_WriteLToPacket( &Response.Buffer[sizeof(uint16_t)], p_profile->max[i] );
+    for( j=0; j<PROFILE_N_BUCKETS; j++ )
+    {
+      f_WriteLToPacket( &Response.Buffer[sizeof(uint16_t) + sizeof(uint32_t)*(1+j)], p_profile->hist[i][j] );
+    }
+    Response.CheckSum       = f_CheckSum( &Response.Buffer[0], Response.Buffer_nBytes );
+    f_SendPacket( Response );
+  }
+} /* End f_SendProfile */
+
+
+/*************************************************
+** FUNCTION: f_SendStrides
+** VARIABLES:
+**		[I ]	WISE_STATE_TYPE	*p_wise_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Send the last WISE_STRIDE_PACKET strides of
+** 		the stride history to the master.
+** 		Packet type 3:
+** 			nStrides (16 bit, strides recorded, wraps),
+** 			n (16 bit, strides in this packet),
+** 		then n strides, newest first:
+** 			end time (32 bit, us),
+** 			duration (16 bit, ms, saturated),
+** 			samples (16 bit),
+** 			vel_ave[0], Incline_gait,
+** 			drift[0] over the stride (16 bit signed,
+** 			shifted 7 bits, see f_WriteFToPacket_s16),
+** 			GaPA cycle time (16 bit, ms, saturated)
+** 		The master can tell missed strides from
+** 		the change in nStrides.
+*/
+void f_SendStrides( WISE_STATE_TYPE *p_wise_state )
+{
+  COMMUNICATION_PACKET_TYPE Response;
+  WISE_STRIDE_TYPE *p_stride;
+  uint8_t *p_buffer;
+  uint32_t n, i;
+  float    duration, cycle_time;
+
+  n = ( p_wise_state->nStrides<WISE_STRIDE_PACKET ) ? p_wise_state->nStrides : WISE_STRIDE_PACKET;
+
+  Response.PacketType     = 3;
+  Response.Buffer_nBytes  = sizeof(uint16_t)*2 + n*( sizeof(uint32_t) + sizeof(uint16_t)*6 );
+  Response.Packet_nBytes  = sizeof(uint16_t)*2 + sizeof(uint8_t)*(1 + Response.Buffer_nBytes);
+  f_WriteIToPacket( &Response.Buffer[0], (uint16_t)p_wise_state->nStrides );
+  f_WriteIToPacket( &Response.Buffer[sizeof(uint16_t)], (uint16_t)n );
+
+  p_buffer = &Response.Buffer[sizeof(uint16_t)*2];
+  for( i=0; i<n; i++ )
+  {
+    p_stride = &p_wise_state->strides[ (p_wise_state->nStrides-1-i) & WISE_STRIDE_MASK ];
+    duration   = MIN( (p_stride->EndTime-p_stride->StartTime)*1000.0f/TIME_RESOLUTION, 65535.0f );
+    cycle_time = MIN( p_stride->cycle_time*1000.0f, 65535.0f );
+    f_WriteLToPacket( &p_buffer[0], (uint32_t)p_stride->EndTime );
+    f_WriteIToPacket( &p_buffer[4], (uint16_t)duration );
+    f_WriteIToPacket( &p_buffer[6], (uint16_t)p_stride->Nsamples );
+    f_WriteFToPacket_s16( &p_buffer[8],  p_stride->vel_ave[0] );
+    f_WriteFToPacket_s16( &p_buffer[10], p_stride->Incline_gait );
+    f_WriteFToPacket_s16( &p_buffer[12], p_stride->drift[0]*( p_stride->EndTime-p_stride->StartTime )/TIME_RESOLUTION );
+    f_WriteIToPacket( &p_buffer[14], (uint16_t)cycle_time );
+    p_buffer += sizeof(uint32_t) + sizeof(uint16_t)*6;
+  }
+  Response.CheckSum       = f_CheckSum( &Response.Buffer[0], Response.Buffer_nBytes );
+  f_SendPacket( Response );
+} /* End f_SendStrides */
+
+
 /*************************************************
 ** FUNCTION: f_WriteIToPacket
 ** VARIABLES:
@@ -262,6 +430,29 @@ void f_WriteIToPacket( uint8_t *Packet, uint16_t InputBuffer )
   }
 } /* End f_WriteIToPacket */
 
+/*************************************************
+** FUNCTION: f_WriteLToPacket
+** VARIABLES:
+**		[IO]	uint8_t			*Packet
+**		[I ]	uint32_t		InputBuffer
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This is a helper function which copies an 4 byte integer
+** 		into an array of single bytes (most significant first,
+** 		as f_WriteIToPacket)
+*/
+void f_WriteLToPacket( uint8_t *Packet, uint32_t InputBuffer )
+{
+  int i;
+  int nBytes = sizeof(uint32_t);
+
+  for( i=0; i<nBytes; i++ )
+  {
+    Packet[i] = (uint8_t)(InputBuffer >> ((nBytes-1-i)*8));
+  }
+} /* End f_WriteLToPacket */
+
 /*************************************************
 ** FUNCTION: f_WriteFToPacket_u16
 ** VARIABLES:
@@ -300,6 +491,32 @@ void f_WriteFToPacket_u16( unsigned char *Packet, float Input )
   }
 } /* End f_WriteFToPacket_u16 */
 
+/*************************************************
+** FUNCTION: f_WriteFToPacket_s16
+** VARIABLES:
+**		[IO]	unsigned char	*Packet
+**		[I ]	float					Input
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Same as f_WriteFToPacket_u16 (shifted 7 bits),
+** 		but rounded and saturated as a two's complement
+** 		16 bit integer, so negative values survive
+** 		the conversion (NaN is sent as 0)
+*/
+void f_WriteFToPacket_s16( unsigned char *Packet, float Input )
+{
+  float   scaled = Input*128.0f;
+  int16_t hpFloat;
+
+  if( isnan( scaled ) )        { hpFloat = 0; }
+  else if( scaled>32767.0f )  { hpFloat = 32767; }
+  else if( scaled<-32768.0f ) { hpFloat = -32768; }
+  else { hpFloat = (int16_t)( ( scaled<0.0f ) ? scaled-0.5f : scaled+0.5f ); }
+
+  f_WriteIToPacket( Packet, (uint16_t)hpFloat );
+} /* End f_WriteFToPacket_s16 */
+
 /*************************************************
 ** FUNCTION: f_WriteFToPacket_s32
 ** VARIABLES:
@@ -351,7 +568,6 @@ void f_Handshake( CONTROL_TYPE *p_control )
 
   /* Rx/Tx variables */
   uint8_t IncomingByte;
-  uint8_t JunkByte;
   int     nBytesIn;
 
   /* Debug Logging */
@@ -386,7 +602,7 @@ void f_Handshake( CONTROL_TYPE *p_control )
     nBytesIn = COMM_AVAILABLE;
 
   	sprintf(fastlog,"> Clearing %d characters from buffer",nBytesIn); LOG_PRINTLN( fastlog );
-    while( nBytesIn-- > 0 ) { JunkByte = COMM_READ; }
+    while( nBytesIn-- > 0 ) { (void)COMM_READ; }
 
     /* Once handshake is initiated by the master,
     ** we send the lock character
@@ -438,7 +654,7 @@ void f_Handshake( CONTROL_TYPE *p_control )
       nBytesIn = COMM_AVAILABLE;
 
   		sprintf(fastlog,"> Clearing %d characters from buffer",nBytesIn); LOG_PRINTLN( fastlog );
-      while( nBytesIn-- > 0 ) { JunkByte = COMM_READ; }
+      while( nBytesIn-- > 0 ) { (void)COMM_READ; }
 
       /* Reply with Error char
       ** If the Baud lock truly failed, then
@@ -63,6 +63,7 @@ void DCM_Init( CONTROL_TYPE				*p_control,
 	p_control->dcm_prms.RollOrientation   = ROLL_O;
 	p_control->dcm_prms.RollRotationConv  = ROLL_ROT_CONV;
 	p_control->dcm_prms.RollRotationRef   = ROLL_ZREF;
+	p_control->dcm_prms.Engine            = ORIENTATION_ENGINE;
 
   LOG_PRINTLN("Kp_RollPitch : %f",p_control->dcm_prms.Kp_RollPitch);
   LOG_PRINTLN("Ki_RollPitch : %f",p_control->dcm_prms.Ki_RollPitch);
@@ -72,7 +73,11 @@ void DCM_Init( CONTROL_TYPE				*p_control,
   LOG_PRINTLN("PitchRotationConv : %i",p_control->dcm_prms.PitchRotationConv);
   LOG_PRINTLN("RollOrientation : %i",p_control->dcm_prms.RollOrientation);
   LOG_PRINTLN("RollRotationConv : %i",p_control->dcm_prms.RollRotationConv);
-  LOG_PRINTLN("RollRotationRef : %i\n",p_control->dcm_prms.RollRotationRef);
+  LOG_PRINTLN("RollRotationRef : %i",p_control->dcm_prms.RollRotationRef);
+  LOG_PRINTLN("Engine : %i\n",p_control->dcm_prms.Engine);
+
+	/* Euler angle stages for this mounting */
+	Orientation_Select_Stages( p_control );
 
 
 	/*
@@ -82,6 +87,11 @@ void DCM_Init( CONTROL_TYPE				*p_control,
   for(i=0;i<3;i++) p_dcm_state->Omega_I[i] = 0.0f;
   for(i=0;i<3;i++) p_dcm_state->Omega_P[i] = 0.0f;
   p_dcm_state->SampleNumber=0;
+  p_dcm_state->Engine=p_control->dcm_prms.Engine;
+#if DCM_FIXED==1 || EXE_MODE==1
+  for(i=0;i<3;i++) p_dcm_state->Omega_I_q[i] = 0;
+  for(i=0;i<3;i++) p_dcm_state->Omega_P_q[i] = 0;
+#endif
 
   Reset_Sensor_Fusion( p_control, p_dcm_state, p_sensor_state );
 } /* End DCM_Init */
@@ -136,7 +146,7 @@ void Set_Sensor_Fusion( CONTROL_TYPE			*p_control,
 
   /* GET PITCH
   ** Using y-z-plane-component/x-component of gravity vector */
-  p_sensor_state->pitch = -1 * f_atan2( p_sensor_state->accel[0], sqrt(p_sensor_state->accel[1]*p_sensor_state->accel[1] + p_sensor_state->accel[2]*p_sensor_state->accel[2]) );
+  p_sensor_state->pitch = -1 * F_ATAN2( DCM_ANGLE_TIER, p_sensor_state->accel[0], f_sqrt(p_sensor_state->accel[1]*p_sensor_state->accel[1] + p_sensor_state->accel[2]*p_sensor_state->accel[2]) );
 
   /* GET ROLL
   ** Compensate pitch of gravity vector */
@@ -146,13 +156,112 @@ void Set_Sensor_Fusion( CONTROL_TYPE			*p_control,
   /* Normally using x-z-plane-component/y-component of compensated gravity vector
   ** 	roll = atan2(temp2[1], sqrt(temp2[0] * temp2[0] + temp2[2] * temp2[2]));
   ** Since we compensated for pitch, x-z-plane-component equals z-component: */
-  p_sensor_state->roll = f_atan2(temp2[1], temp2[2]);
+  p_sensor_state->roll = F_ATAN2( DCM_ANGLE_TIER, temp2[1], temp2[2] );
 
   /* GET YAW */
   p_sensor_state->yaw = 0;
+
+  /* Roll and yaw are set, not pending extraction */
+  p_sensor_state->euler.RollDirty = FALSE;
+  p_sensor_state->euler.YawDirty  = FALSE;
 } /* End Set_Sensor_Fusion */
 
 
+/*************************************************
+** FUNCTION: Orientation_Update
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DCM_STATE_TYPE		*p_dcm_state
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Run the orientation engine selected in
+** 		dcm_prms.Engine. When the selection
+** 		changes, the state is handed over first
+** 		(see Orientation_Switch).
+*/
+void Orientation_Update( CONTROL_TYPE				*p_control,
+												 DCM_STATE_TYPE			*p_dcm_state,
+												 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	if( p_control->dcm_prms.Engine!=p_dcm_state->Engine )
+	{
+		Orientation_Switch( p_control, p_dcm_state );
+	}
+
+	if( p_dcm_state->Engine==ORIENTATION_QUATERNION )
+	{
+		Quaternion_Filter( p_control, p_dcm_state, p_sensor_state );
+	}
+	else
+	{
+#if DCM_FIXED==1
+		DCM_Filter_Fixed( p_control, p_dcm_state, p_sensor_state );
+#else
+		DCM_Filter( p_control, p_dcm_state, p_sensor_state );
+#endif
+	}
+} /* End Orientation_Update */
+
+
+/*************************************************
+** FUNCTION: Orientation_Switch
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DCM_STATE_TYPE		*p_dcm_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Hand the orientation over to the engine
+** 		selected in dcm_prms.Engine (the matrix
+** 		is converted to/from the quaternion), so
+** 		switching does not reset the estimate.
+** 		The integral correction (Omega_I) is
+** 		kept, the proportional one restarts.
+** 		An invalid selection keeps the current
+** 		engine.
+*/
+void Orientation_Switch( CONTROL_TYPE			*p_control,
+												 DCM_STATE_TYPE		*p_dcm_state )
+{
+	int i;
+#if DCM_FIXED==1
+	int j;
+#endif
+
+	if( p_control->dcm_prms.Engine<0 || p_control->dcm_prms.Engine>=NUM_ORIENTATION_ENGINES ) { return; }
+
+	if( p_control->dcm_prms.Engine==ORIENTATION_QUATERNION )
+	{
+#if DCM_FIXED==1
+		/* The fixed point DCM only updates its own copy */
+		for( i=0; i<3; i++ )
+		{
+			for( j=0; j<3; j++ ) { p_dcm_state->DCM_Matrix[i][j] = Q_TO_FLOAT( p_dcm_state->DCM_Matrix_q[i][j], DCM_Q_MATRIX ); }
+			p_dcm_state->Omega_I[i] = Q_TO_FLOAT( p_dcm_state->Omega_I_q[i], DCM_Q_OMEGA );
+		}
+#endif
+		Quaternion_From_DCM( p_dcm_state );
+	}
+	else
+	{
+		Quaternion_To_DCM( p_dcm_state );
+#if DCM_FIXED==1
+		for( i=0; i<3; i++ )
+		{
+			for( j=0; j<3; j++ ) { p_dcm_state->DCM_Matrix_q[i][j] = Q_FROM_FLOAT( p_dcm_state->DCM_Matrix[i][j], DCM_Q_MATRIX ); }
+			p_dcm_state->Omega_I_q[i] = Q_FROM_FLOAT( p_dcm_state->Omega_I[i], DCM_Q_OMEGA );
+			p_dcm_state->Omega_P_q[i] = 0;
+		}
+#endif
+	}
+	for( i=0; i<3; i++ ) { p_dcm_state->Omega_P[i] = 0.0f; }
+
+	p_dcm_state->Engine = p_control->dcm_prms.Engine;
+} /* End Orientation_Switch */
+
+
 /*************************************************
 ** FUNCTION: Init_Rotation_Matrix
 ** VARIABLES:
@@ -174,12 +283,14 @@ void Init_Rotation_Matrix( CONTROL_TYPE				*p_control,
 	float pitch = p_sensor_state->pitch;
 	float yaw 	= p_sensor_state->yaw;
 
-  float c1 = cos(roll);
-  float s1 = sin(roll);
-  float c2 = cos(pitch);
-  float s2 = sin(pitch);
-  float c3 = cos(yaw);
-  float s3 = sin(yaw);
+  float c1, s1, c2, s2, c3, s3;
+#if DCM_FIXED==1 || EXE_MODE==1
+  int i, j;
+#endif
+
+  f_sincos( roll,  &s1, &c1 );
+  f_sincos( pitch, &s2, &c2 );
+  f_sincos( yaw,   &s3, &c3 );
 
   /* Euler angles, right-handed, intrinsic, XYZ convention
   ** (which means: rotate around body axes Z, Y', X'')  */
@@ -194,6 +305,17 @@ void Init_Rotation_Matrix( CONTROL_TYPE				*p_control,
   m[2*3 + 0] = -s2;
   m[2*3 + 1] = c2 * s1;
   m[2*3 + 2] = c1 * c2;
+
+  /* Same orientation for the quaternion engine */
+  Quaternion_From_DCM( p_dcm_state );
+
+#if DCM_FIXED==1 || EXE_MODE==1
+  /* Fixed point copy (DCM_Filter_Fixed) */
+  for( i=0; i<3; i++ )
+  {
+    for( j=0; j<3; j++ ) { p_dcm_state->DCM_Matrix_q[i][j] = Q_FROM_FLOAT( p_dcm_state->DCM_Matrix[i][j], DCM_Q_MATRIX ); }
+  }
+#endif
 } /* End Init_Rotation_Matrix */
 
 
@@ -216,9 +338,6 @@ void DCM_Filter( CONTROL_TYPE				*p_control,
 								 DCM_STATE_TYPE			*p_dcm_state,
 								 SENSOR_STATE_TYPE	*p_sensor_state )
 {
-  int i;
-
-  float temp;
   float error = 0;
   float renorm = 0;
 
@@ -320,7 +439,7 @@ void DCM_Filter( CONTROL_TYPE				*p_control,
   /* Roll and Pitch
   ** Calculate the magnitude of the accelerometer vector
   ** Scale to gravity */
-  Accel_magnitude = sqrt( Vector_Dot_Product( &Accel_Vector[0], &Accel_Vector[0] ) ) / p_control->sensor_prms.gravity; //GRAVITY;
+  Accel_magnitude = f_sqrt( Vector_Dot_Product( &Accel_Vector[0], &Accel_Vector[0] ) ) / p_control->sensor_prms.gravity; //GRAVITY;
 
   /* Dynamic weighting of accelerometer info (reliability filter)
   ** Weight for accelerometer info (<0.5G = 0.0, 1G = 1.0 , >1.5G = 0.0) */
@@ -336,8 +455,8 @@ void DCM_Filter( CONTROL_TYPE				*p_control,
   ** by a integral and proportional gain in each cycle */
   Vector_Cross_Product( &Accel_Vector[0], &p_dcm_state->DCM_Matrix[2][0], &errorRollPitch[0] );
 
-  Vector_Scale( &errorRollPitch[0], Kp_ROLLPITCH*Accel_weight, &p_dcm_state->Omega_P[0] );
-  Vector_Scale( &errorRollPitch[0], Ki_ROLLPITCH*Accel_weight, &ErrorGain[0] );
+  Vector_Scale( &errorRollPitch[0], p_control->dcm_prms.Kp_RollPitch*Accel_weight, &p_dcm_state->Omega_P[0] );
+  Vector_Scale( &errorRollPitch[0], p_control->dcm_prms.Ki_RollPitch*Accel_weight, &ErrorGain[0] );
   Vector_Add( p_dcm_state->Omega_I, ErrorGain, p_dcm_state->Omega_I );
 
   /* Note:
@@ -371,63 +490,382 @@ void DCM_Filter( CONTROL_TYPE				*p_control,
   ** orientation of the IMU in space.
   ******************************************************************/
 
-  /* Pitch Conventions (set in config):
-  ** Range: -90:90
-  ** With PITCH_ROT_CONV==1 :
-  ** PITCH_O:1 - Pitch orientation #1. Angle x-axis w/ Horizontal Plane  +Rot:Aft-Down    0:Nadir0/Zenith down. +90:Aft down   -90:Fore down
-  ** PITCH_O:2 - Pitch orientation #2. Angle y-axis w/ Horizontal Plane  +Rot:Port-Down   0:Fore/Aft down       +90:Port down  -90:Starboard down
-  ** PITCH_O:3 - Pitch orientation #3. Angle z-axis w/ Horizontal Plane  +Rot:Nadir-Down  0:Fore/Aft down       +90:Nadir down -90:Zenith down */
-  switch ( p_control->dcm_prms.PitchOrientation )
-  {
-    case 1 :
-      //p_sensor_state->pitch = -PITCH_ROT_CONV*f_asin( p_dcm_state->DCM_Matrix[2][0] );
-      p_sensor_state->pitch = -p_control->dcm_prms.PitchRotationConv*f_asin( p_dcm_state->DCM_Matrix[2][0] );
-      break;
-    case 2 :
-      //p_sensor_state->pitch = -PITCH_ROT_CONV*f_asin( p_dcm_state->DCM_Matrix[2][1] );
-      p_sensor_state->pitch = -p_control->dcm_prms.PitchRotationConv*f_asin( p_dcm_state->DCM_Matrix[2][1] );
-      break;
-    case 3 :
-      //p_sensor_state->pitch = -PITCH_ROT_CONV*f_asin( p_dcm_state->DCM_Matrix[2][2] );
-      p_sensor_state->pitch = -p_control->dcm_prms.PitchRotationConv*f_asin( p_dcm_state->DCM_Matrix[2][2] );
-      break;
-  }
+  Orientation_Euler_Angles( p_control, p_dcm_state->DCM_Matrix[2], p_dcm_state->DCM_Matrix[1][0], p_dcm_state->DCM_Matrix[0][0], p_sensor_state );
+} /* End DCM_Filter */
 
-  /* Define roll orientation convention (set in config):
-  ** We should only be using 3,4,5 orientations, but they are all available for hacking.
-  ** Range: -180:180
-  ** With ROLL_ROT_CONV==1  ROLL_ZREF==1
-  ** ROLL_O:1 - Roll orientation #1. Rotation around z-axis (Nadir-Zenith) +Rot:Aft-Port    0:Port down     +-180:stbd down
-  ** ROLL_O:2 - Roll orientation #2. Rotation around y-axis (Port-Stbd)    +Rot:Aft-Nadir   0:Nadir down    +-180:Zenith down
-  ** ROLL_O:3 - Roll orientation #3. Rotation around x-axis (Fore-Aft)     +Rot:Port-Nadir  0:Nadir down    +-180:Zenith down
-  ** ROLL_O:4 - Roll orientation #4. Rotation around z-axis (Nadir-Zenith) +Rot:Aft-Port    0:Aft down      +-180:Fore down
-  ** ROLL_O:5 - Roll orientation #5. Rotation around y-axis (Port-Stbd)    +Rot:Aft-Nadir   0:Aft down      +-180:Fore down
-  ** ROLL_O:6 - Roll orientation #6. Rotation around x-axis (Fore-Aft)     +Rot:Port-Nadir  0:Port down     +-180:Stbd down
-  ** WARNING: ROLL should be determined from pitch orientation, not set manually */
-  switch ( p_control->dcm_prms.RollOrientation )
-  {
-    case 1 :
-      p_sensor_state->roll = -p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][0], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][1] );
-      break;
-    case 2 :
-      p_sensor_state->roll = -p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][0], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][2] );
-      break;
-    case 3 :
-      p_sensor_state->roll = -p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][1], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][2] );
-      break;
-    case 4 :
-      p_sensor_state->roll =  p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][1], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][0] );
-      break;
-    case 5 :
-      p_sensor_state->roll =  p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][2], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][0] );
-      break;
-    case 6 :
-      p_sensor_state->roll =  p_control->dcm_prms.RollRotationConv*f_atan2( p_dcm_state->DCM_Matrix[2][2], -p_control->dcm_prms.RollRotationRef*p_dcm_state->DCM_Matrix[2][1] );
-      break;
-  }
 
-  p_sensor_state->yaw   =  f_atan2( p_dcm_state->DCM_Matrix[1][0], p_dcm_state->DCM_Matrix[0][0] ); // A faster atan2
-} /* End DCM_Filter */
+/*************************************************
+** FUNCTION: Orientation_Select_Stages
+** VARIABLES:
+**		[IO]	CONTROL_TYPE			*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Pick the pitch and roll stages for the
+** 		orientations and conventions in dcm_prms,
+** 		once, so the per sample extraction has no
+** 		switch. A mounting that is not in the
+** 		tables falls back to the configured one
+** 		(PITCH_O, ROLL_O, which must have a policy
+** 		to compile).
+*/
+void Orientation_Select_Stages( CONTROL_TYPE *p_control )
+{
+	DCM_PRMS_TYPE *p_prms = &p_control->dcm_prms;
+	int PitchConv, RollConv, RollRef;
+
+	if( p_prms->PitchOrientation<1 || p_prms->PitchOrientation>3 ||
+			( p_prms->PitchRotationConv!=1 && p_prms->PitchRotationConv!=-1 ) )
+	{
+		LOG_PRINTLN("> Unsupported pitch orientation %i (%i), using %i (%i)",p_prms->PitchOrientation,p_prms->PitchRotationConv,PITCH_O,PITCH_ROT_CONV);
+		p_prms->PitchOrientation  = PITCH_O;
+		p_prms->PitchRotationConv = PITCH_ROT_CONV;
+	}
+	if( p_prms->RollOrientation<1 || p_prms->RollOrientation>6 ||
+			( p_prms->RollRotationConv!=1 && p_prms->RollRotationConv!=-1 ) ||
+			( p_prms->RollRotationRef!=1  && p_prms->RollRotationRef!=-1 ) )
+	{
+		LOG_PRINTLN("> Unsupported roll orientation %i (%i,%i), using %i (%i,%i)",p_prms->RollOrientation,p_prms->RollRotationConv,p_prms->RollRotationRef,ROLL_O,ROLL_ROT_CONV,ROLL_ZREF);
+		p_prms->RollOrientation  = ROLL_O;
+		p_prms->RollRotationConv = ROLL_ROT_CONV;
+		p_prms->RollRotationRef  = ROLL_ZREF;
+	}
+
+	PitchConv = ( p_prms->PitchRotationConv>0 ) ? 1 : 0;
+	RollConv  = ( p_prms->RollRotationConv>0 )  ? 1 : 0;
+	RollRef   = ( p_prms->RollRotationRef>0 )   ? 1 : 0;
+
+	p_prms->PitchStage   = DCM_Pitch_Stages[PitchConv][p_prms->PitchOrientation-1];
+	p_prms->RollStage    = DCM_Roll_Stages[RollConv][RollRef][p_prms->RollOrientation-1];
+#if DCM_FIXED==1 || EXE_MODE==1
+	p_prms->PitchStage_q = DCM_Pitch_Stages_q[PitchConv][p_prms->PitchOrientation-1];
+	p_prms->RollStage_q  = DCM_Roll_Stages_q[RollConv][RollRef][p_prms->RollOrientation-1];
+#endif
+} /* End Orientation_Select_Stages */
+
+
+/*************************************************
+** FUNCTION: Orientation_Euler_Angles
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[I ]	const float				Row2[3]
+**		[I ]	float							m10
+**		[I ]	float							m00
+**		[O ]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Extract the Euler angles from the rotation
+** 		(body to earth). Pitch and roll only need
+** 		the last row of the matrix (the gravity
+** 		direction in the body frame), yaw needs
+** 		m[1][0] and m[0][0].
+** 		Pitch is extracted here. The entries are
+** 		kept for roll and yaw, which are extracted
+** 		when read (Orientation_Roll, Orientation_Yaw),
+** 		or here with DCM_LAZY_EULER 0.
+*/
+void Orientation_Euler_Angles( CONTROL_TYPE				*p_control,
+															 const float				Row2[3],
+															 float							m10,
+															 float							m00,
+															 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+  /* Pitch (stage for PITCH_O/PITCH_ROT_CONV, see DCM_Kernels.h) */
+  p_sensor_state->pitch = p_control->dcm_prms.PitchStage( Row2 );
+
+  /* Roll and yaw, when read (see DCM_LAZY_EULER) */
+  p_sensor_state->euler.Row2[0]   = Row2[0];
+  p_sensor_state->euler.Row2[1]   = Row2[1];
+  p_sensor_state->euler.Row2[2]   = Row2[2];
+  p_sensor_state->euler.m10       = m10;
+  p_sensor_state->euler.m00       = m00;
+#if DCM_FIXED==1 || EXE_MODE==1
+  p_sensor_state->euler.Fixed     = FALSE;
+#endif
+  p_sensor_state->euler.RollDirty = TRUE;
+  p_sensor_state->euler.YawDirty  = TRUE;
+#if DCM_LAZY_EULER==0
+  Orientation_Roll( p_control, p_sensor_state );
+  Orientation_Yaw( p_control, p_sensor_state );
+#endif
+} /* End Orientation_Euler_Angles */
+
+
+/*************************************************
+** FUNCTION: Orientation_Roll
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		float	roll (rad)
+** DESCRIPTION:
+** 		Roll of the last orientation update,
+** 		extracted from the matrix entries kept
+** 		by Orientation_Euler_Angles (or by
+** 		DCM_Filter_Fixed) the first time it is
+** 		read, then cached in p_sensor_state->roll.
+*/
+float Orientation_Roll( CONTROL_TYPE				*p_control,
+												SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	DCM_EULER_TYPE *p_euler = &p_sensor_state->euler;
+
+	if( p_euler->RollDirty==FALSE ) { return p_sensor_state->roll; }
+
+#if DCM_FIXED==1 || EXE_MODE==1
+	if( p_euler->Fixed==TRUE )
+	{
+		p_sensor_state->roll = p_control->dcm_prms.RollStage_q( p_euler->Row2_q );
+		p_euler->RollDirty = FALSE;
+		return p_sensor_state->roll;
+	}
+#endif
+
+	/* Roll (stage for ROLL_O/ROLL_ROT_CONV/ROLL_ZREF, see DCM_Kernels.h) */
+	p_sensor_state->roll = p_control->dcm_prms.RollStage( p_euler->Row2 );
+
+	p_euler->RollDirty = FALSE;
+	return p_sensor_state->roll;
+} /* End Orientation_Roll */
+
+
+/*************************************************
+** FUNCTION: Orientation_Yaw
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		float	yaw (rad)
+** DESCRIPTION:
+** 		Yaw of the last orientation update,
+** 		as Orientation_Roll
+*/
+float Orientation_Yaw( CONTROL_TYPE				*p_control,
+											 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	DCM_EULER_TYPE *p_euler = &p_sensor_state->euler;
+
+	if( p_euler->YawDirty==FALSE ) { return p_sensor_state->yaw; }
+
+#if DCM_FIXED==1 || EXE_MODE==1
+	if( p_euler->Fixed==TRUE )
+	{
+		p_sensor_state->yaw = Q_TO_FLOAT( q_atan2( p_euler->m10_q, p_euler->m00_q ), Q_ANGLE_SHIFT );
+	}
+	else
+#endif
+	{
+		p_sensor_state->yaw = F_ATAN2( DCM_ANGLE_TIER, p_euler->m10, p_euler->m00 );
+	}
+	p_euler->YawDirty = FALSE;
+	return p_sensor_state->yaw;
+} /* End Orientation_Yaw */
+
+
+
+#if DCM_FIXED==1 || EXE_MODE==1
+/*************************************************
+** FUNCTION: DCM_Fixed_Gain
+** VARIABLES:
+**		[I ]	float			gain
+**		[O ]	int32_t		*p_mant
+** RETURN:
+**		int		exponent
+** DESCRIPTION:
+** 		Split a gain into a Q30 mantissa and a
+** 		power of 2 (gain = mant*2^exponent),
+** 		so gains from 1E-8 to 1 keep their
+** 		precision in 32 bits.
+*/
+int DCM_Fixed_Gain( float		gain,
+										int32_t	*p_mant )
+{
+	int exponent;
+
+	*p_mant = Q_FROM_FLOAT( frexpf( gain, &exponent ), 30 );
+	return exponent;
+} /* End DCM_Fixed_Gain */
+
+
+/*************************************************
+** FUNCTION: DCM_Fixed_Feedback
+** VARIABLES:
+**		[I ]	int32_t		error
+**		[I ]	int32_t		mant
+**		[I ]	int				exponent
+** RETURN:
+**		int32_t	error*gain (rad/s, Q(DCM_Q_OMEGA))
+** DESCRIPTION:
+** 		Apply a gain (see DCM_Fixed_Gain) to
+** 		a drift error (counts, Q(DCM_Q_ERROR))
+*/
+int32_t DCM_Fixed_Feedback( int32_t	error,
+														int32_t	mant,
+														int			exponent )
+{
+	int shift = 30 + DCM_Q_ERROR - DCM_Q_OMEGA - exponent;
+	int64_t acc = (int64_t)error*mant;
+
+	if( shift>62 ) { return 0; }
+	if( shift<1 )  { return Q_SAT32( acc ); }
+	return Q_SAT32( ( acc + ( (int64_t)1<<(shift-1) ) ) >> shift );
+} /* End DCM_Fixed_Feedback */
+
+
+/******************************************************************
+** FUNCTION: DCM_Filter_Fixed
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DCM_STATE_TYPE			*p_dcm_state
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		DCM_Filter in fixed point (DCM_FIXED), for the
+** 		FPU-less SAMD21. The same 4 parts, on the integer
+** 		state in p_dcm_state (DCM_Matrix_q, Omega_P_q,
+** 		Omega_I_q, see DCM_Config.h for the formats):
+**   1. Matrix update    - Q30 products in 64 bits
+**   2. Normalize        - The same first order renormalization
+**   3. Drift correction - Integer magnitude (q_sqrt), the gains
+**                         as mantissa/exponent (DCM_Fixed_Gain)
+**   4. Euler angles     - Pitch with q_asin (CORDIC), roll and
+**                         yaw (q_atan2) when read, see
+**                         Orientation_Roll/Orientation_Yaw
+** The float DCM_Matrix/Omega_P/Omega_I are not updated.
+*/
+void DCM_Filter_Fixed( CONTROL_TYPE				*p_control,
+											 DCM_STATE_TYPE			*p_dcm_state,
+											 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	int32_t (*m)[3] = p_dcm_state->DCM_Matrix_q;
+	int32_t Accel_Vector[3];
+	int32_t Theta[3];
+	int32_t TempM[3][3];
+	int32_t TempM2[2][3];
+	int32_t errorRollPitch[3];
+	int32_t dt, gravity, error, renorm;
+	int32_t Accel_magnitude, Accel_weight;
+	int32_t Kp_mant, Ki_mant;
+	int     Kp_exp, Ki_exp;
+	int64_t acc;
+	int     i, j;
+
+	const int32_t GyroOffset[3] = { DCM_GYRO_OFFSET_Q( GYRO_AVERAGE_OFFSET_X ),
+																	DCM_GYRO_OFFSET_Q( GYRO_AVERAGE_OFFSET_Y ),
+																	DCM_GYRO_OFFSET_Q( GYRO_AVERAGE_OFFSET_Z ) };
+
+	/******************************************************************
+	** DCM 1. Update the Direction Cosine Matrix
+	** Rotation over this sample (rad, Q30):
+	**   Theta = ( gyro*gain + Omega_I + Omega_P ) * G_Dt
+	******************************************************************/
+
+	dt = Q_FROM_FLOAT( p_control->G_Dt, DCM_Q_MATRIX );
+	for( i=0; i<3; i++ )
+	{
+		Accel_Vector[i] = Q_FROM_FLOAT( p_sensor_state->accel[i], DCM_Q_SENSOR );
+
+		acc = (int64_t)( Q_FROM_FLOAT( p_sensor_state->gyro[i], DCM_Q_SENSOR ) - GyroOffset[i] )*DCM_GYRO_GAIN_Q;
+		acc = ( acc + ( (int64_t)1<<(DCM_GYRO_SHIFT-1) ) ) >> DCM_GYRO_SHIFT;
+		acc = acc + p_dcm_state->Omega_I_q[i] + p_dcm_state->Omega_P_q[i];
+		Theta[i] = Q_MUL( Q_SAT32( acc ), dt, DCM_Q_OMEGA );
+	}
+
+	/* TempM2[i][:] = DCM[i][:] + DCM[i][:] x Theta */
+	for( i=0; i<2; i++ )
+	{
+		TempM2[i][0] = m[i][0] + (int32_t)( ( (int64_t)m[i][1]*Theta[2] - (int64_t)m[i][2]*Theta[1] + ( (int64_t)1<<(DCM_Q_MATRIX-1) ) ) >> DCM_Q_MATRIX );
+		TempM2[i][1] = m[i][1] + (int32_t)( ( (int64_t)m[i][2]*Theta[0] - (int64_t)m[i][0]*Theta[2] + ( (int64_t)1<<(DCM_Q_MATRIX-1) ) ) >> DCM_Q_MATRIX );
+		TempM2[i][2] = m[i][2] + (int32_t)( ( (int64_t)m[i][0]*Theta[1] - (int64_t)m[i][1]*Theta[0] + ( (int64_t)1<<(DCM_Q_MATRIX-1) ) ) >> DCM_Q_MATRIX );
+	}
+
+	/******************************************************************
+	** DCM 2. Normalize DCM
+	** error = -<DCM[0],DCM[1]>/2, shared between rows 0 and 1,
+	** row 2 from their cross product, then each row scaled by
+	** (3 - |row|^2)/2
+	******************************************************************/
+
+	acc = 0;
+	for( j=0; j<3; j++ ) { acc += (int64_t)TempM2[0][j]*TempM2[1][j]; }
+	error = -(int32_t)( acc >> (DCM_Q_MATRIX+1) );
+
+	for( j=0; j<3; j++ )
+	{
+		TempM[0][j] = TempM2[0][j] + Q_MUL( TempM2[1][j], error, DCM_Q_MATRIX );
+		TempM[1][j] = TempM2[1][j] + Q_MUL( TempM2[0][j], error, DCM_Q_MATRIX );
+	}
+
+	TempM[2][0] = (int32_t)( ( (int64_t)TempM[0][1]*TempM[1][2] - (int64_t)TempM[0][2]*TempM[1][1] ) >> DCM_Q_MATRIX );
+	TempM[2][1] = (int32_t)( ( (int64_t)TempM[0][2]*TempM[1][0] - (int64_t)TempM[0][0]*TempM[1][2] ) >> DCM_Q_MATRIX );
+	TempM[2][2] = (int32_t)( ( (int64_t)TempM[0][0]*TempM[1][1] - (int64_t)TempM[0][1]*TempM[1][0] ) >> DCM_Q_MATRIX );
+
+	for( i=0; i<3; i++ )
+	{
+		acc = (int64_t)3 << (2*DCM_Q_MATRIX);
+		for( j=0; j<3; j++ ) { acc -= (int64_t)TempM[i][j]*TempM[i][j]; }
+		renorm = (int32_t)( acc >> (DCM_Q_MATRIX+1) );
+		for( j=0; j<3; j++ ) { m[i][j] = Q_MUL( TempM[i][j], renorm, DCM_Q_MATRIX ); }
+	}
+
+	/******************************************************************
+	** DCM 3. Drift correction (roll and pitch)
+	** Weight for accelerometer info (<0.5G = 0.0, 1G = 1.0 , >1.5G = 0.0)
+	** errorRP = accel x DCM[2][:]
+	******************************************************************/
+
+	acc = 0;
+	for( j=0; j<3; j++ ) { acc += (int64_t)Accel_Vector[j]*Accel_Vector[j]; }
+	gravity = Q_FROM_FLOAT( p_control->sensor_prms.gravity, DCM_Q_SENSOR );
+	Accel_magnitude = ( gravity>0 ) ? (int32_t)MIN( ( (int64_t)q_sqrt( (uint64_t)acc ) << 30 )/gravity, (int64_t)INT32_MAX ) : 0;
+	Accel_weight    = ( 1L<<30 ) - 2*MIN( ABS( ( 1L<<30 ) - (int64_t)Accel_magnitude ), (int64_t)( 1L<<29 ) );
+
+	if( Accel_weight>0 )
+	{
+		/* Q(SENSOR)*Q(MATRIX) -> Q(ERROR) */
+		errorRollPitch[0] = (int32_t)( ( (int64_t)Accel_Vector[1]*m[2][2] - (int64_t)Accel_Vector[2]*m[2][1] ) >> ( DCM_Q_SENSOR+DCM_Q_MATRIX-DCM_Q_ERROR ) );
+		errorRollPitch[1] = (int32_t)( ( (int64_t)Accel_Vector[2]*m[2][0] - (int64_t)Accel_Vector[0]*m[2][2] ) >> ( DCM_Q_SENSOR+DCM_Q_MATRIX-DCM_Q_ERROR ) );
+		errorRollPitch[2] = (int32_t)( ( (int64_t)Accel_Vector[0]*m[2][1] - (int64_t)Accel_Vector[1]*m[2][0] ) >> ( DCM_Q_SENSOR+DCM_Q_MATRIX-DCM_Q_ERROR ) );
+
+		Kp_exp  = DCM_Fixed_Gain( p_control->dcm_prms.Kp_RollPitch, &Kp_mant );
+		Ki_exp  = DCM_Fixed_Gain( p_control->dcm_prms.Ki_RollPitch, &Ki_mant );
+		Kp_mant = Q_MUL( Kp_mant, Accel_weight, 30 );
+		Ki_mant = Q_MUL( Ki_mant, Accel_weight, 30 );
+
+		for( i=0; i<3; i++ )
+		{
+			p_dcm_state->Omega_P_q[i] = DCM_Fixed_Feedback( errorRollPitch[i], Kp_mant, Kp_exp );
+			acc = (int64_t)p_dcm_state->Omega_I_q[i] + DCM_Fixed_Feedback( errorRollPitch[i], Ki_mant, Ki_exp );
+			p_dcm_state->Omega_I_q[i] = Q_SAT32( acc );
+		}
+	}
+	else
+	{
+		for( i=0; i<3; i++ ) { p_dcm_state->Omega_P_q[i] = 0; }
+	}
+
+	/******************************************************************
+	** DCM 4. Extract Euler Angles from DCM
+	** Same conventions as DCM_Filter
+	******************************************************************/
+
+	p_sensor_state->pitch = p_control->dcm_prms.PitchStage_q( m[2] );
+
+	/* Roll and yaw, when read (see DCM_LAZY_EULER) */
+	for( i=0; i<3; i++ ) { p_sensor_state->euler.Row2_q[i] = m[2][i]; }
+	p_sensor_state->euler.m10_q     = m[1][0];
+	p_sensor_state->euler.m00_q     = m[0][0];
+	p_sensor_state->euler.Fixed     = TRUE;
+	p_sensor_state->euler.RollDirty = TRUE;
+	p_sensor_state->euler.YawDirty  = TRUE;
+#if DCM_LAZY_EULER==0
+	Orientation_Roll( p_control, p_sensor_state );
+	Orientation_Yaw( p_control, p_sensor_state );
+#endif
+} /* End DCM_Filter_Fixed */
+#endif /* End DCM_FIXED */
 
 
 
@@ -12,6 +12,14 @@
 ** 		A short FIR LP filter and a IIR filter on
 ** 		each of the input accelerations
 ** 		A short FIR HP filter on the gyro
+** 		The FIR histories are ring buffers with mirrored storage
+** 		(see DSP_Config.h), so the per-sample history update
+** 		is O(1) and the taps are read without wrapping.
+** 		The IIR filters run a cascade of biquads per channel,
+** 		5 multiply-adds per section, from the banks below.
+** 		With DSP_FIXED, the same filters run in integer on
+** 		the raw readings (DSP_Fixed_Filter), for the FPU-less
+** 		SAMD21; floats are only used from the DCM onward.
 ********************************************************************/
 
 
@@ -30,6 +38,40 @@
 	#include "../Include/Emulator_Protos.h"
 #endif  /* End Emulator Mode */
 
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* IIR coefficient banks (see DSP_Config.h)
+** Indexed by dsp_prms.IIR_accel_bank (LPF) and
+** dsp_prms.IIR_gyro_bank (HPF) */
+const DSP_BANK_TYPE g_dsp_LPF_banks[DSP_NUM_BANKS] =
+{
+	{ 0.05f, 1, IIR_LPF_2_05 },
+	{ 0.10f, 1, IIR_LPF_2_10 },
+	{ 0.20f, 1, IIR_LPF_2_20 },
+	{ 0.05f, 2, IIR_LPF_4_05 },
+	{ 0.10f, 2, IIR_LPF_4_10 },
+	{ 0.20f, 2, IIR_LPF_4_20 },
+	{ 0.05f, 4, IIR_LPF_8_05 },
+	{ 0.10f, 4, IIR_LPF_8_10 },
+	{ 0.20f, 4, IIR_LPF_8_20 }
+};
+
+const DSP_BANK_TYPE g_dsp_HPF_banks[DSP_NUM_BANKS] =
+{
+	{ 0.05f, 1, IIR_HPF_2_05 },
+	{ 0.10f, 1, IIR_HPF_2_10 },
+	{ 0.20f, 1, IIR_HPF_2_20 },
+	{ 0.05f, 2, IIR_HPF_4_05 },
+	{ 0.10f, 2, IIR_HPF_4_10 },
+	{ 0.20f, 2, IIR_HPF_4_20 },
+	{ 0.05f, 4, IIR_HPF_8_05 },
+	{ 0.10f, 4, IIR_HPF_8_10 },
+	{ 0.20f, 4, IIR_HPF_8_20 }
+};
+
+
 /*******************************************************************
 ** Functions *******************************************************
 ********************************************************************/
@@ -50,10 +92,6 @@ void DSP_Filter_Init ( CONTROL_TYPE			*p_control,
 {
 	int i,j;
 
-  float IIR_coeffs_La[NTAPS] = IIR_LPF_a;
-	float IIR_coeffs_Lb[NTAPS] = IIR_LPF_b;
-	float IIR_coeffs_Ha[NTAPS] = IIR_HPF_a;
-	float IIR_coeffs_Hb[NTAPS] = IIR_HPF_b;
 	float FIR_coeffs_L[NTAPS]  = FIR_LPF;
 	float FIR_coeffs_H[NTAPS]  = FIR_HPF;
 
@@ -66,52 +104,63 @@ void DSP_Filter_Init ( CONTROL_TYPE			*p_control,
 	p_control->dsp_prms.n_taps = NTAPS;
 	p_control->dsp_prms.FIR_on = DSP_FIR_ON;
 	p_control->dsp_prms.IIR_on = DSP_IIR_ON;
+	for( i=0;i<3;i++ )
+	{
+		p_control->dsp_prms.IIR_accel_bank[i] = DSP_LPF_BANK;
+		p_control->dsp_prms.IIR_gyro_bank[i]  = DSP_HPF_BANK;
+	}
 
 	/*
 	** Initialize DSP state parameters
 	*/
 
-	memcpy(&p_dsp_state->IIR_coeffs_La[0],&IIR_coeffs_La[0],NTAPS*sizeof(float));
-	memcpy(&p_dsp_state->IIR_coeffs_Lb[0],&IIR_coeffs_Lb[0],NTAPS*sizeof(float));
-	memcpy(&p_dsp_state->IIR_coeffs_Ha[0],&IIR_coeffs_Ha[0],NTAPS*sizeof(float));
-	memcpy(&p_dsp_state->IIR_coeffs_Hb[0],&IIR_coeffs_Hb[0],NTAPS*sizeof(float));
 	memcpy(&p_dsp_state->FIR_coeffs_L[0],&FIR_coeffs_L[0],NTAPS*sizeof(float));
 	memcpy(&p_dsp_state->FIR_coeffs_H[0],&FIR_coeffs_H[0],NTAPS*sizeof(float));
 
 	for( i=0;i<3;i++ )
 	{
-		for( j=0;j<NTAPS;j++ )
+		for( j=0;j<2*NTAPS;j++ )
 		{
-			p_dsp_state->accel_mem[i][j] = 0.0f;
-			p_dsp_state->gyro_mem[i][j] = 0.0f;
+			p_dsp_state->FIR_accel_x[i][j] = 0.0f;
+			p_dsp_state->FIR_gyro_x[i][j]  = 0.0f;
 		}
+		p_dsp_state->IIR_accel_bank[i] = DSP_LPF_BANK;
+		p_dsp_state->IIR_gyro_bank[i]  = DSP_HPF_BANK;
+		DSP_Biquad_Reset( p_dsp_state->IIR_accel_z[i] );
+		DSP_Biquad_Reset( p_dsp_state->IIR_gyro_z[i] );
 	}
+	p_dsp_state->head = 0;
+
+#if DSP_FIXED==1 || EXE_MODE==1
+	DSP_Fixed_Init( p_dsp_state );
+#endif
 } /* End DSP_Filter_Init */
 
 
 /*************************************************
 ** FUNCTION: DSP_Update
 ** VARIABLES:
-**		[I ]	CONTROL_TYPE			*p_control
-**		[IO]	DSP_STATE_TYPE		*p_dsp_state
-**		[I ]	SENSOR_STATE_TYPE *p_sensor_state
+**		[I ]	DSP_STATE_TYPE		*p_dsp_state
+**		[IO]	float							mem[3][2*NTAPS]
+**		[I ]	const float				*p_value
 ** RETURN:
 **		NONE
 ** DESCRIPTION:
-** 		This function updates the necessary
-** 		DSP state variabls. This includes
-** 		the memory arrays
+** 		This function logs the current sample
+** 		(x, y, z) in a history, at head and
+** 		at its mirror head+NTAPS
 */
-void DSP_Update ( CONTROL_TYPE			*p_control,
-									DSP_STATE_TYPE		*p_dsp_state,
-									SENSOR_STATE_TYPE *p_sensor_state )
+void DSP_Update ( DSP_STATE_TYPE		*p_dsp_state,
+									float							mem[3][2*NTAPS],
+									const float				*p_value )
 {
+	int head = p_dsp_state->head;
 	int i;
-	/* log new inputs */
+
 	for( i=0;i<3;i++ )
 	{
-		p_dsp_state->accel_mem[i][0] = p_sensor_state->accel[i];
-		p_dsp_state->gyro_mem[i][0]  = p_sensor_state->gyro[i];
+		mem[i][head]       = p_value[i];
+		mem[i][head+NTAPS] = p_value[i];
 	}
 } /* DSP_Update */
 
@@ -124,24 +173,101 @@ void DSP_Update ( CONTROL_TYPE			*p_control,
 ** RETURN:
 **		NONE
 ** DESCRIPTION:
-** 		This function shifts the memory
-** 		arrays in preparation for the next
-** 		iteration
+** 		This function moves head back one slot
+** 		in preparation for the next iteration.
+** 		The current sample becomes x[n-1], the
+** 		oldest one is overwritten next.
 */
 void DSP_Shift ( CONTROL_TYPE				*p_control,
 								 DSP_STATE_TYPE		*p_dsp_state )
 {
-	int i,j;
-	/* Shift sesor values */
-	for( i=0;i<3;i++)
+	p_dsp_state->head = ( p_dsp_state->head==0 ) ? NTAPS-1 : p_dsp_state->head-1;
+} /* End DSP_Shift */
+
+
+/*************************************************
+** FUNCTION: DSP_Biquad_Reset
+** VARIABLES:
+**		[O ]	float		z[DSP_MAX_SECTIONS][2]
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function clears the section
+** 		states of one channel
+*/
+void DSP_Biquad_Reset ( float z[DSP_MAX_SECTIONS][2] )
+{
+	int k;
+
+	for( k=0;k<DSP_MAX_SECTIONS;k++ )
 	{
-		for( j=0;j<(NTAPS-1);j++)
-		{
-			p_dsp_state->accel_mem[i][j+1] = p_dsp_state->accel_mem[i][j];
-			p_dsp_state->gyro_mem[i][j+1]  = p_dsp_state->gyro_mem[i][j];
-		}
+		z[k][0] = 0.0f;
+		z[k][1] = 0.0f;
 	}
-} /* End DSP_Shift */
+} /* End DSP_Biquad_Reset */
+
+
+/*************************************************
+** FUNCTION: DSP_Biquad_Select
+** VARIABLES:
+**		[I ]	int			bank
+**		[IO]	int			*p_bank
+**		[IO]	float		z[DSP_MAX_SECTIONS][2]
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function switches a channel to the
+** 		selected bank. When the selection changes
+** 		the channel state is cleared; an invalid
+** 		selection keeps the current bank.
+*/
+void DSP_Biquad_Select ( int		bank,
+												 int		*p_bank,
+												 float	z[DSP_MAX_SECTIONS][2] )
+{
+	if( bank!=*p_bank && bank>=0 && bank<DSP_NUM_BANKS )
+	{
+		*p_bank = bank;
+		DSP_Biquad_Reset( z );
+	}
+} /* End DSP_Biquad_Select */
+
+
+/*************************************************
+** FUNCTION: DSP_Biquad
+** VARIABLES:
+**		[I ]	const DSP_BANK_TYPE	*p_bank
+**		[IO]	float								z[DSP_MAX_SECTIONS][2]
+**		[I ]	float								x
+** RETURN:
+**		float	Filtered sample
+** DESCRIPTION:
+** 		This function runs one sample through
+** 		a cascade of biquads (transposed direct
+** 		form II), each section feeding the next.
+** 		Equation (per section):
+**			y[n] = b0*x[n] + z1
+**			z1   = b1*x[n] - a1*y[n] + z2
+**			z2   = b2*x[n] - a2*y[n]
+*/
+float DSP_Biquad ( const DSP_BANK_TYPE	*p_bank,
+									 float								z[DSP_MAX_SECTIONS][2],
+									 float								x )
+{
+	const DSP_BIQUAD_TYPE *p_sec;
+	float y;
+	int k;
+
+	for( k=0;k<p_bank->nSections;k++ )
+	{
+		p_sec   = &p_bank->section[k];
+		y       = p_sec->b0*x + z[k][0];
+		z[k][0] = p_sec->b1*x - p_sec->a1*y + z[k][1];
+		z[k][1] = p_sec->b2*x - p_sec->a2*y;
+		x       = y;
+	}
+	return x;
+} /* End DSP_Biquad */
 
 
 /*************************************************
@@ -154,35 +280,31 @@ void DSP_Shift ( CONTROL_TYPE				*p_control,
 **		NONE
 ** DESCRIPTION:
 ** 		This function applies a IIR filter
-** 		to the input sensor data.
-** 		Equation:
-**			y[n] = (1/a[0]) * ( b[0]*x[n] + ... + b[P]*x[n-P] - a[1]*y[n-1] - ... - a[Q]*y[n-Q] )
+** 		to the input sensor data, using the
+** 		bank selected for each channel in
+** 		dsp_prms (accel: LPF, gyro: HPF).
 */
 void IIR_Filter ( CONTROL_TYPE				*p_control,
 								  DSP_STATE_TYPE			*p_dsp_state,
 									SENSOR_STATE_TYPE 	*p_sensor_state )
 {
-	/* TO DO: Add functionality for additional modes */
-	int i,j;
-	float temp;
-
-	DSP_Update( p_control, p_dsp_state, p_sensor_state );
+	int j;
 
 	/* Accel - LPF */
 	for( j=0;j<3;j++ )
 	{
-		temp = 0.0f;
-		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->IIR_coeffs_Lb[i]*p_dsp_state->accel_mem[j][i]; }
-		for( i=1;i<NTAPS;i++ ) { temp = temp - p_dsp_state->IIR_coeffs_La[i]*p_dsp_state->accel_mem[j][i]; }
-		p_sensor_state->accel[j] = (1/p_dsp_state->IIR_coeffs_La[0])*temp;
+		DSP_Biquad_Select( p_control->dsp_prms.IIR_accel_bank[j], &p_dsp_state->IIR_accel_bank[j], p_dsp_state->IIR_accel_z[j] );
+		p_sensor_state->accel[j] = DSP_Biquad( &g_dsp_LPF_banks[p_dsp_state->IIR_accel_bank[j]],
+																					 p_dsp_state->IIR_accel_z[j],
+																					 p_sensor_state->accel[j] );
 	}
 	/* Gyro - HPF */
 	for( j=0;j<3;j++ )
 	{
-		temp = 0.0f;
-		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->IIR_coeffs_Hb[i]*p_dsp_state->accel_mem[j][i]; }
-		for( i=1;i<NTAPS;i++ ) { temp = temp - p_dsp_state->IIR_coeffs_Ha[i]*p_dsp_state->accel_mem[j][i]; }
-		p_sensor_state->gyro[j] = (1/p_dsp_state->IIR_coeffs_Ha[0])*temp;
+		DSP_Biquad_Select( p_control->dsp_prms.IIR_gyro_bank[j], &p_dsp_state->IIR_gyro_bank[j], p_dsp_state->IIR_gyro_z[j] );
+		p_sensor_state->gyro[j] = DSP_Biquad( &g_dsp_HPF_banks[p_dsp_state->IIR_gyro_bank[j]],
+																					p_dsp_state->IIR_gyro_z[j],
+																					p_sensor_state->gyro[j] );
 	}
 } /* End IIR_Filter */
 
@@ -197,7 +319,8 @@ void IIR_Filter ( CONTROL_TYPE				*p_control,
 **		NONE
 ** DESCRIPTION:
 ** 		This function applies a FIR filter
-** 		to the input sensor data.
+** 		to the input sensor data, with the
+** 		kernel set by DSP_FIR_KERNEL.
 ** 		Equation:
 **			y[n] = b[0]*x[n] + b[1]*x[n-1] + ... + b[N]*x[n-N]
 */
@@ -206,27 +329,354 @@ void FIR_Filter ( CONTROL_TYPE				*p_control,
 									SENSOR_STATE_TYPE 	*p_sensor_state )
 {
 	/* TO DO: Add functionality for additional modes */
-	int i,j;
+	int j;
+#if DSP_FIR_KERNEL==DSP_FIR_LOOP
+	int i;
+#endif
+	int head = p_dsp_state->head;
+	const float *x;
 	float temp;
 
-	DSP_Update( p_control, p_dsp_state, p_sensor_state );
+	DSP_Update( p_dsp_state, p_dsp_state->FIR_accel_x, p_sensor_state->accel );
+	DSP_Update( p_dsp_state, p_dsp_state->FIR_gyro_x,  p_sensor_state->gyro );
 
 	/* Accel - LPF */
 	for( j=0;j<3;j++ )
 	{
+		x = &p_dsp_state->FIR_accel_x[j][head];
+#if DSP_FIR_KERNEL==DSP_FIR_LOOP
 		temp = 0.0f;
-		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->FIR_coeffs_L[i]*p_dsp_state->accel_mem[j][i]; }
+		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->FIR_coeffs_L[i]*x[i]; }
+#elif DSP_FIR_KERNEL==DSP_FIR_UNROLL
+		temp = DSP_FIR_Kernel<NTAPS,DSP_FIR_LPF_taps,false>::Run( x );
+#else
+		temp = DSP_FIR_Kernel<NTAPS,DSP_FIR_LPF_taps>::Run( x );
+#endif
 		p_sensor_state->accel[j] = temp;
 	}
 	/* Gyro - HPF */
 	for( j=0;j<3;j++ )
 	{
+		x = &p_dsp_state->FIR_gyro_x[j][head];
+#if DSP_FIR_KERNEL==DSP_FIR_LOOP
 		temp = 0.0f;
-		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->FIR_coeffs_H[i]*p_dsp_state->accel_mem[j][i]; }
+		for( i=0;i<NTAPS;i++ ) { temp = temp + p_dsp_state->FIR_coeffs_H[i]*x[i]; }
+#elif DSP_FIR_KERNEL==DSP_FIR_UNROLL
+		temp = DSP_FIR_Kernel<NTAPS,DSP_FIR_HPF_taps,false>::Run( x );
+#else
+		temp = DSP_FIR_Kernel<NTAPS,DSP_FIR_HPF_taps>::Run( x );
+#endif
 		p_sensor_state->gyro[j] = temp;
 	}
 } /* End FIR_Filter */
 
 
+#if DSP_FIXED==1 || EXE_MODE==1
+/*************************************************
+** FUNCTION: DSP_Fixed_Init
+** VARIABLES:
+**		[IO]	DSP_STATE_TYPE	*p_dsp_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function initializes the fixed
+** 		point state (DSP_FIXED): Q15 FIR
+** 		coefficients, cleared histories and the
+** 		default banks in Q30
+*/
+void DSP_Fixed_Init ( DSP_STATE_TYPE		*p_dsp_state )
+{
+	int i,j;
+
+	float FIR_coeffs_L[NTAPS]  = FIR_LPF;
+	float FIR_coeffs_H[NTAPS]  = FIR_HPF;
+
+	for( i=0;i<NTAPS;i++ )
+	{
+		p_dsp_state->FIR_coeffs_Lq[i] = (int16_t)DSP_TO_Q( FIR_coeffs_L[i], DSP_Q15_SHIFT );
+		p_dsp_state->FIR_coeffs_Hq[i] = (int16_t)DSP_TO_Q( FIR_coeffs_H[i], DSP_Q15_SHIFT );
+	}
+
+	for( i=0;i<3;i++ )
+	{
+		for( j=0;j<2*NTAPS;j++ )
+		{
+			p_dsp_state->FIR_accel_xq[i][j] = 0;
+			p_dsp_state->FIR_gyro_xq[i][j]  = 0;
+		}
+		/* Force the load of the default banks */
+		p_dsp_state->IIR_accel_bank_q[i] = -1;
+		p_dsp_state->IIR_gyro_bank_q[i]  = -1;
+		DSP_Fixed_Select( DSP_LPF_BANK, &p_dsp_state->IIR_accel_bank_q[i], g_dsp_LPF_banks,
+											p_dsp_state->IIR_accel_q[i], p_dsp_state->IIR_accel_zq[i] );
+		DSP_Fixed_Select( DSP_HPF_BANK, &p_dsp_state->IIR_gyro_bank_q[i], g_dsp_HPF_banks,
+											p_dsp_state->IIR_gyro_q[i], p_dsp_state->IIR_gyro_zq[i] );
+	}
+} /* End DSP_Fixed_Init */
 
 
+/*************************************************
+** FUNCTION: DSP_Fixed_Select
+** VARIABLES:
+**		[I ]	int									bank
+**		[IO]	int									*p_bank
+**		[I ]	const DSP_BANK_TYPE	*p_banks
+**		[O ]	DSP_BIQUAD_Q_TYPE		sec[DSP_MAX_SECTIONS]
+**		[O ]	int32_t							z[DSP_MAX_SECTIONS][2]
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function switches a fixed point
+** 		channel to the selected bank, as
+** 		DSP_Biquad_Select. The sections of the
+** 		new bank are converted to Q30 once here,
+** 		so the filter itself needs no float.
+*/
+void DSP_Fixed_Select ( int										bank,
+												int										*p_bank,
+												const DSP_BANK_TYPE		*p_banks,
+												DSP_BIQUAD_Q_TYPE			sec[DSP_MAX_SECTIONS],
+												int32_t								z[DSP_MAX_SECTIONS][2] )
+{
+	const DSP_BIQUAD_TYPE *p_sec;
+	int k;
+
+	if( bank!=*p_bank && bank>=0 && bank<DSP_NUM_BANKS )
+	{
+		*p_bank = bank;
+		for( k=0;k<DSP_MAX_SECTIONS;k++ )
+		{
+			if( k<p_banks[bank].nSections )
+			{
+				p_sec     = &p_banks[bank].section[k];
+				sec[k].b0 = DSP_TO_Q( p_sec->b0, DSP_Q30_SHIFT );
+				sec[k].b1 = DSP_TO_Q( p_sec->b1, DSP_Q30_SHIFT );
+				sec[k].b2 = DSP_TO_Q( p_sec->b2, DSP_Q30_SHIFT );
+				sec[k].a1 = DSP_TO_Q( p_sec->a1, DSP_Q30_SHIFT );
+				sec[k].a2 = DSP_TO_Q( p_sec->a2, DSP_Q30_SHIFT );
+			}
+			else
+			{
+				memset( &sec[k], 0, sizeof(sec[k]) );
+			}
+			z[k][0] = 0;
+			z[k][1] = 0;
+		}
+	}
+} /* End DSP_Fixed_Select */
+
+
+/*************************************************
+** FUNCTION: DSP_Fixed_Biquad
+** VARIABLES:
+**		[I ]	const DSP_BIQUAD_Q_TYPE	sec[DSP_MAX_SECTIONS]
+**		[I ]	int											nSections
+**		[IO]	int32_t									z[DSP_MAX_SECTIONS][2]
+**		[I ]	int32_t									x
+** RETURN:
+**		int32_t	Filtered sample
+** DESCRIPTION:
+** 		This function runs one sample through
+** 		the first nSections biquads of a
+** 		channel, as DSP_Biquad. The Q30 products
+** 		are summed in 64 bits, rounded back to
+** 		the signal format and saturated.
+*/
+int32_t DSP_Fixed_Biquad ( const DSP_BIQUAD_Q_TYPE	sec[DSP_MAX_SECTIONS],
+													 int											nSections,
+													 int32_t									z[DSP_MAX_SECTIONS][2],
+													 int32_t									x )
+{
+	int64_t acc;
+	int32_t y;
+	int k;
+
+	for( k=0;k<nSections;k++ )
+	{
+		acc     = (int64_t)sec[k].b0*x + ( (int64_t)z[k][0]<<DSP_Q30_SHIFT );
+		y       = DSP_SAT32( DSP_ROUND_SHIFT( acc, DSP_Q30_SHIFT ) );
+		acc     = (int64_t)sec[k].b1*x - (int64_t)sec[k].a1*y + ( (int64_t)z[k][1]<<DSP_Q30_SHIFT );
+		z[k][0] = DSP_SAT32( DSP_ROUND_SHIFT( acc, DSP_Q30_SHIFT ) );
+		acc     = (int64_t)sec[k].b2*x - (int64_t)sec[k].a2*y;
+		z[k][1] = DSP_SAT32( DSP_ROUND_SHIFT( acc, DSP_Q30_SHIFT ) );
+		x       = y;
+	}
+	return x;
+} /* End DSP_Fixed_Biquad */
+
+
+/*************************************************
+** FUNCTION: FIR_Filter_Fixed
+** VARIABLES:
+**		[IO]	DSP_STATE_TYPE		*p_dsp_state
+**		[I ]	SENSOR_STATE_TYPE *p_sensor_state
+**		[O ]	int32_t						accel[3]
+**		[O ]	int32_t						gyro[3]
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function applies the FIR filters
+** 		to the raw readings, as FIR_Filter.
+** 		The Q15 taps are summed in 64 bits
+** 		(counts with 15 fraction bits) and
+** 		rounded to the signal format.
+*/
+void FIR_Filter_Fixed ( DSP_STATE_TYPE			*p_dsp_state,
+												SENSOR_STATE_TYPE 	*p_sensor_state,
+												int32_t							accel[3],
+												int32_t							gyro[3] )
+{
+	int head = p_dsp_state->head;
+	const int16_t *x;
+	int64_t acc;
+	int i,j;
+
+	for( j=0;j<3;j++ )
+	{
+		p_dsp_state->FIR_accel_xq[j][head]       = p_sensor_state->accel_raw[j];
+		p_dsp_state->FIR_accel_xq[j][head+NTAPS] = p_sensor_state->accel_raw[j];
+		p_dsp_state->FIR_gyro_xq[j][head]        = p_sensor_state->gyro_raw[j];
+		p_dsp_state->FIR_gyro_xq[j][head+NTAPS]  = p_sensor_state->gyro_raw[j];
+	}
+
+	/* Accel - LPF */
+	for( j=0;j<3;j++ )
+	{
+		x   = &p_dsp_state->FIR_accel_xq[j][head];
+		acc = 0;
+		for( i=0;i<NTAPS;i++ ) { acc += (int32_t)p_dsp_state->FIR_coeffs_Lq[i]*x[i]; }
+		accel[j] = DSP_SAT32( DSP_ROUND_SHIFT( acc, DSP_Q15_SHIFT-DSP_Q_SHIFT ) );
+	}
+	/* Gyro - HPF */
+	for( j=0;j<3;j++ )
+	{
+		x   = &p_dsp_state->FIR_gyro_xq[j][head];
+		acc = 0;
+		for( i=0;i<NTAPS;i++ ) { acc += (int32_t)p_dsp_state->FIR_coeffs_Hq[i]*x[i]; }
+		gyro[j] = DSP_SAT32( DSP_ROUND_SHIFT( acc, DSP_Q15_SHIFT-DSP_Q_SHIFT ) );
+	}
+} /* End FIR_Filter_Fixed */
+
+
+/*************************************************
+** FUNCTION: IIR_Filter_Fixed
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DSP_STATE_TYPE		*p_dsp_state
+**		[IO]	int32_t						accel[3]
+**		[IO]	int32_t						gyro[3]
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function applies the IIR filters
+** 		to the fixed point signals, as
+** 		IIR_Filter (accel: LPF, gyro: HPF).
+*/
+void IIR_Filter_Fixed ( CONTROL_TYPE				*p_control,
+												DSP_STATE_TYPE			*p_dsp_state,
+												int32_t							accel[3],
+												int32_t							gyro[3] )
+{
+	int j;
+
+	/* Accel - LPF */
+	for( j=0;j<3;j++ )
+	{
+		DSP_Fixed_Select( p_control->dsp_prms.IIR_accel_bank[j], &p_dsp_state->IIR_accel_bank_q[j], g_dsp_LPF_banks,
+											p_dsp_state->IIR_accel_q[j], p_dsp_state->IIR_accel_zq[j] );
+		accel[j] = DSP_Fixed_Biquad( p_dsp_state->IIR_accel_q[j],
+																 g_dsp_LPF_banks[p_dsp_state->IIR_accel_bank_q[j]].nSections,
+																 p_dsp_state->IIR_accel_zq[j], accel[j] );
+	}
+	/* Gyro - HPF */
+	for( j=0;j<3;j++ )
+	{
+		DSP_Fixed_Select( p_control->dsp_prms.IIR_gyro_bank[j], &p_dsp_state->IIR_gyro_bank_q[j], g_dsp_HPF_banks,
+											p_dsp_state->IIR_gyro_q[j], p_dsp_state->IIR_gyro_zq[j] );
+		gyro[j] = DSP_Fixed_Biquad( p_dsp_state->IIR_gyro_q[j],
+																g_dsp_HPF_banks[p_dsp_state->IIR_gyro_bank_q[j]].nSections,
+																p_dsp_state->IIR_gyro_zq[j], gyro[j] );
+	}
+} /* End IIR_Filter_Fixed */
+
+
+/*************************************************
+** FUNCTION: DSP_Fixed_Load
+** VARIABLES:
+**		[IO]	SENSOR_STATE_TYPE *p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function converts the raw readings
+** 		to float (in counts). With DSP_FIXED,
+** 		Read_Sensors only writes the raw readings,
+** 		so this is for the stages that need the
+** 		floats before or without DSP_Fixed_Filter.
+*/
+void DSP_Fixed_Load ( SENSOR_STATE_TYPE *p_sensor_state )
+{
+	int j;
+
+	for( j=0;j<3;j++ )
+	{
+		p_sensor_state->accel[j] = (float)p_sensor_state->accel_raw[j];
+		p_sensor_state->gyro[j]  = (float)p_sensor_state->gyro_raw[j];
+	}
+} /* End DSP_Fixed_Load */
+
+
+/*************************************************
+** FUNCTION: DSP_Fixed_Filter
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DSP_STATE_TYPE		*p_dsp_state
+**		[IO]	SENSOR_STATE_TYPE *p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		This function is the fixed point DSP
+** 		stage (DSP_FIXED): the raw readings go
+** 		through the FIR and IIR filters in
+** 		integer and the result is converted
+** 		to float (in counts, as Read_Sensors
+** 		leaves accel and gyro) for the later
+** 		stages. With both filters off, the
+** 		raw readings are converted as they are.
+*/
+void DSP_Fixed_Filter ( CONTROL_TYPE				*p_control,
+												DSP_STATE_TYPE			*p_dsp_state,
+												SENSOR_STATE_TYPE 	*p_sensor_state )
+{
+	int32_t accel[3], gyro[3];
+	int j;
+
+	if( p_control->dsp_prms.FIR_on==0 && p_control->dsp_prms.IIR_on==0 )
+	{
+		DSP_Fixed_Load( p_sensor_state );
+		return;
+	}
+
+	if( p_control->dsp_prms.FIR_on==1 )
+	{
+		FIR_Filter_Fixed( p_dsp_state, p_sensor_state, accel, gyro );
+	}
+	else
+	{
+		for( j=0;j<3;j++ )
+		{
+			accel[j] = (int32_t)p_sensor_state->accel_raw[j]*(1L<<DSP_Q_SHIFT);
+			gyro[j]  = (int32_t)p_sensor_state->gyro_raw[j]*(1L<<DSP_Q_SHIFT);
+		}
+	}
+	if( p_control->dsp_prms.IIR_on==1 )
+	{
+		IIR_Filter_Fixed( p_control, p_dsp_state, accel, gyro );
+	}
+
+	for( j=0;j<3;j++ )
+	{
+		p_sensor_state->accel[j] = (float)accel[j]*( 1.0f/(float)(1L<<DSP_Q_SHIFT) );
+		p_sensor_state->gyro[j]  = (float)gyro[j]*( 1.0f/(float)(1L<<DSP_Q_SHIFT) );
+	}
+} /* End DSP_Fixed_Filter */
+#endif /* End DSP_FIXED */
@@ -0,0 +1,415 @@
+/*******************************************************************
+** FILE:
+**   	Emulator
+** DESCRIPTION:
+** 		This is the calling executable for the host (Linux)
+** 		emulator. It replays a recorded data set through the
+** 		same stage sequence as the real-time loop() in
+** 		SparkFun-9DoF-IMU-WISE, as fast as the CPU allows
+** 		(i.e. not at the sensor rate), and reports the
+** 		achieved throughput in samples/sec.
+** 		Usage:
+** 			WISE_Emulator <input recording> [output results]
+** 			WISE_Emulator -c <text recording> <binary recording>
+** 			WISE_Emulator -j <workers> <output dir|-> <recordings...>
+** 			WISE_Emulator -s <grid> <labels> <recording> [sweep results]
+** 			WISE_Emulator -b <recording> [bench results|-] [thresholds]
+** 			WISE_Emulator -a <speed> <recording> [output results]
+** 			WISE_Emulator -f <frames per loop> <recording> [output results]
+** 			WISE_Emulator -w <recording> [max bus time per sample (us)]
+** 			WISE_Emulator -d <recording> [block size]
+** 			WISE_Emulator -q <recording> [max error (counts)]
+** 			WISE_Emulator -o <recording> [max error (deg)]
+** 			WISE_Emulator -e <recording> [max error (deg)]
+** 			WISE_Emulator -t [stride]
+** 			WISE_Emulator -m [samples]
+** 			WISE_Emulator -l <recording> [trigger phase] [labels]
+** 		The input recording may be text or binary (see
+** 		Recording_Config.h), the format is detected on open.
+** 		The benchmark (-b) exits with 2 if any stage is over
+** 		its threshold, the I2C test (-w) if the bus time per
+** 		sample is over the maximum, the block DSP test (-d)
+** 		if a block output or a FIR kernel is off the per
+** 		sample loop (see DSP_FIR_FOLD_MAX_ERROR), the fixed
+** 		point DSP test (-q) if its error against the float
+** 		DSP is over the maximum, and the fixed point DCM
+** 		(-o) and quaternion engine (-e) tests if their Euler
+** 		angles are off the float DCM by more than the
+** 		maximum. The trig test (-t) exits with 2 if a tier
+** 		is over the error bounds in Math.h, and the motion
+** 		stats test (-m) if a window is off the brute force
+** 		window. The FES latency test (-l) reports the relay latency of the current and
+** 		predicted phase triggers.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#include "../Include/Common_Config.h"
+#include "../Include/Emulator_Protos.h"
+
+#include <stdlib.h>
+
+
+/*******************************************************************
+** START ***********************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: setup
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+**		[I ]	const char					*InputPath
+**		[I ]	const char					*OutputPath
+** RETURN:
+**		BOOL	1:Successful initialization
+**					0:Failure
+** DESCRIPTION:
+** 		Emulator equivalent of the real-time setup().
+** 		The input recording replaces the IMU.
+*/
+bool setup( PIPELINE_STATE_TYPE	*p_pipeline,
+						const char					*InputPath,
+						const char					*OutputPath )
+{
+	/* Initialize the control structure */
+	Common_Init( &p_pipeline->control, &p_pipeline->sensor_state );
+
+	/* Open the recording */
+	if( Emulator_Init( &p_pipeline->control, InputPath, OutputPath )==FALSE ) { return FALSE; }
+
+	/* Read the first sample
+	** Used to set the initial roll/pitch/yaw */
+	Read_Sensors( &p_pipeline->control, &p_pipeline->sensor_state );
+	if( p_pipeline->control.emu_data.EndOfFile==TRUE )
+	{
+		LOG_PRINTLN("ERROR : Setup : Empty recording %s",InputPath);
+		return FALSE;
+	}
+
+	/* Initialize the algorithms */
+	Pipeline_Init( p_pipeline );
+
+	LOG_PRINTLN("> Emulator Setup Done");
+	return TRUE;
+} /* End setup */
+
+
+/*************************************************
+** FUNCTION: loop
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Emulator equivalent of the real-time loop().
+** 		Processes a single sample from the recording.
+*/
+void loop( PIPELINE_STATE_TYPE *p_pipeline )
+{
+	PROFILE_LOOP_BEGIN( &p_pipeline->control );
+
+	/* Update sensor readings */
+	Read_Sensors( &p_pipeline->control, &p_pipeline->sensor_state );
+	if( p_pipeline->control.emu_data.EndOfFile==TRUE ) { return; }
+	PROFILE_LAP( &p_pipeline->control, PROFILE_READ_SENSORS );
+
+	/* Run the processing stages */
+	Pipeline_Update( p_pipeline );
+
+	/* Log the current states to the output file */
+	PROFILE_MARK( &p_pipeline->control );
+	Emulator_LogOut( &p_pipeline->control, &p_pipeline->sensor_state, &p_pipeline->gapa_state, &p_pipeline->wise_state );
+	PROFILE_LAP( &p_pipeline->control, PROFILE_LOG );
+
+	PROFILE_LOOP_END( &p_pipeline->control );
+} /* End loop */
+
+
+/*************************************************
+** FUNCTION: Emulator_Replay
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+**		[I ]	const char					*InputPath
+**		[I ]	const char					*OutputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Replay a full recording through one
+** 		pipeline instance. Everything the replay
+** 		touches is held in p_pipeline, so several
+** 		replays can run at once on separate instances.
+*/
+bool Emulator_Replay( PIPELINE_STATE_TYPE	*p_pipeline,
+											const char					*InputPath,
+											const char					*OutputPath )
+{
+	if( setup( p_pipeline, InputPath, OutputPath )==FALSE )
+	{
+		Emulator_Close( &p_pipeline->control );
+		return FALSE;
+	}
+
+	while( p_pipeline->control.emu_data.EndOfFile==FALSE ) { loop( p_pipeline ); }
+
+	Emulator_Close( &p_pipeline->control );
+	return TRUE;
+} /* End Emulator_Replay */
+
+
+/*************************************************
+** FUNCTION: main
+** VARIABLES:
+**		[I ]	int		argc
+**		[I ]	char	**argv
+** RETURN:
+**		int		0:Success
+**					1:Failure
+**					2:Benchmark regression
+** DESCRIPTION:
+** 		Replay the recording and report throughput,
+** 		replay many recordings in parallel (-j),
+** 		sweep the filter gains over a recording (-s),
+** 		benchmark each stage over a recording (-b),
+** 		replay through the interrupt sample ring (-a),
+** 		check the block DSP and FIR kernels (-d),
+** 		check the fixed point DSP (-q) or DCM (-o),
+** 		compare the quaternion engine to the DCM (-e),
+** 		check and time the trig tiers against libm (-t),
+** 		check the motion stats windows (-m),
+** 		measure the FES trigger latency (-l),
+** 		or convert a text recording to binary (-c)
+*/
+int main( int argc, char **argv )
+{
+	PIPELINE_STATE_TYPE *p_pipeline;
+	double StartTime, ElapsedTime;
+	bool   ret;
+	int    nRegressed;
+
+	if( argc<2 )
+	{
+		fprintf(stderr,"Usage: %s <input recording> [output results]\n",argv[0]);
+		fprintf(stderr,"       %s -c <text recording> <binary recording>\n",argv[0]);
+		fprintf(stderr,"       %s -j <workers> <output dir|-> <recordings...>\n",argv[0]);
+		fprintf(stderr,"       %s -s <grid> <labels> <recording> [sweep results]\n",argv[0]);
+		fprintf(stderr,"       %s -b <recording> [bench results|-] [thresholds]\n",argv[0]);
+		fprintf(stderr,"       %s -a <speed> <recording> [output results]\n",argv[0]);
+		fprintf(stderr,"       %s -f <frames per loop> <recording> [output results]\n",argv[0]);
+		fprintf(stderr,"       %s -w <recording> [max bus time per sample (us)]\n",argv[0]);
+		fprintf(stderr,"       %s -d <recording> [block size]\n",argv[0]);
+		fprintf(stderr,"       %s -q <recording> [max error (counts)]\n",argv[0]);
+		fprintf(stderr,"       %s -o <recording> [max error (deg)]\n",argv[0]);
+		fprintf(stderr,"       %s -e <recording> [max error (deg)]\n",argv[0]);
+		fprintf(stderr,"       %s -t [stride]\n",argv[0]);
+		fprintf(stderr,"       %s -m [samples]\n",argv[0]);
+		fprintf(stderr,"       %s -l <recording> [trigger phase] [labels]\n",argv[0]);
+		return 1;
+	}
+
+	/* Convert a text recording to binary */
+	if( strcmp( argv[1], "-c" )==0 )
+	{
+		if( argc<4 )
+		{
+			fprintf(stderr,"Usage: %s -c <text recording> <binary recording>\n",argv[0]);
+			return 1;
+		}
+		return ( Emulator_Convert_Recording( argv[2], argv[3] )==TRUE ) ? 0 : 1;
+	}
+
+	/* Replay many recordings in parallel
+	** workers=0 uses one worker per core, "-" discards the results */
+	if( strcmp( argv[1], "-j" )==0 )
+	{
+		if( argc<5 )
+		{
+			fprintf(stderr,"Usage: %s -j <workers> <output dir|-> <recordings...>\n",argv[0]);
+			return 1;
+		}
+		return ( Emulator_Run_Parallel( &argv[4], argc-4, (strcmp( argv[3], "-" )==0) ? NULL : argv[3], atoi( argv[2] ) )==0 ) ? 0 : 1;
+	}
+
+	/* Sweep the filter gains over one recording */
+	if( strcmp( argv[1], "-s" )==0 )
+	{
+		if( argc<5 )
+		{
+			fprintf(stderr,"Usage: %s -s <grid> <labels> <recording> [sweep results]\n",argv[0]);
+			return 1;
+		}
+		return ( Emulator_Sweep( argv[2], argv[3], argv[4], (argc>5) ? argv[5] : NULL )==TRUE ) ? 0 : 1;
+	}
+
+	/* Benchmark each stage over one recording */
+	if( strcmp( argv[1], "-b" )==0 )
+	{
+		if( argc<3 )
+		{
+			fprintf(stderr,"Usage: %s -b <recording> [bench results|-] [thresholds]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Bench( argv[2], (argc>3) ? argv[3] : NULL, (argc>4) ? argv[4] : NULL );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	#ifdef _IMU9250_
+	/* Replay through the MPU-9250 FIFO stand-in and the
+	** sample ring, with a producer thread in place of the
+	** IMU and its data ready interrupt. Speed is x real
+	** time, 0 is as fast as the consumer keeps up (no drops) */
+	if( strcmp( argv[1], "-a" )==0 )
+	{
+		if( argc<4 )
+		{
+			fprintf(stderr,"Usage: %s -a <speed> <recording> [output results]\n",argv[0]);
+			return 1;
+		}
+		return ( Emulator_Acquire( argv[3], (argc>4) ? argv[4] : NULL, atof( argv[2] ) )==TRUE ) ? 0 : 1;
+	}
+
+	/* Replay through the MPU-9250 FIFO stand-in, with
+	** FramesPerLoop samples queued in the FIFO per loop */
+	if( strcmp( argv[1], "-f" )==0 )
+	{
+		if( argc<4 || atoi( argv[2] )<1 )
+		{
+			fprintf(stderr,"Usage: %s -f <frames per loop> <recording> [output results]\n",argv[0]);
+			return 1;
+		}
+		return ( Emulator_Acquire_FIFO( argv[3], (argc>4) ? argv[4] : NULL, atoi( argv[2] ) )==TRUE ) ? 0 : 1;
+	}
+	#endif
+
+	/* Read a recording through the IMU10736 I2C read
+	** set on the Wire stand-in, and time the bus */
+	if( strcmp( argv[1], "-w" )==0 )
+	{
+		if( argc<3 )
+		{
+			fprintf(stderr,"Usage: %s -w <recording> [max bus time per sample (us)]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Wire_Test( argv[2], (argc>3) ? atof( argv[3] ) : 0.0 );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Filter a recording with the block DSP and check
+	** it and the FIR kernels against the per-sample filters */
+	if( strcmp( argv[1], "-d" )==0 )
+	{
+		if( argc<3 || ( argc>3 && atoi( argv[3] )<1 ) )
+		{
+			fprintf(stderr,"Usage: %s -d <recording> [block size]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_DSP_Test( argv[2], (argc>3) ? atoi( argv[3] ) : DSP_BLOCK_SIZE );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Filter a recording with the fixed point DSP and
+	** bound its error against the float filters */
+	if( strcmp( argv[1], "-q" )==0 )
+	{
+		if( argc<3 )
+		{
+			fprintf(stderr,"Usage: %s -q <recording> [max error (counts)]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_DSP_Fixed_Test( argv[2], (argc>3) ? (float)atof( argv[3] ) : DSP_FIXED_MAX_ERROR );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Run the fixed point DCM next to the float DCM
+	** and bound the difference of the Euler angles */
+	if( strcmp( argv[1], "-o" )==0 )
+	{
+		if( argc<3 )
+		{
+			fprintf(stderr,"Usage: %s -o <recording> [max error (deg)]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_DCM_Fixed_Test( argv[2], (argc>3) ? (float)atof( argv[3] ) : DCM_FIXED_MAX_ERROR );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Run the quaternion engine next to the DCM, compare
+	** their cost and bound the difference of the angles */
+	if( strcmp( argv[1], "-e" )==0 )
+	{
+		if( argc<3 )
+		{
+			fprintf(stderr,"Usage: %s -e <recording> [max error (deg)]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Quaternion_Test( argv[2], (argc>3) ? (float)atof( argv[3] ) : QUATERNION_MAX_ERROR );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Sweep the trig tiers against libm, every
+	** stride-th float (1: every float) */
+	if( strcmp( argv[1], "-t" )==0 )
+	{
+		if( argc>2 && atol( argv[2] )<1 )
+		{
+			fprintf(stderr,"Usage: %s -t [stride]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Trig_Test( (argc>2) ? (unsigned long)atol( argv[2] ) : TRIG_TEST_STRIDE );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Check the motion stats windows against a
+	** brute force rescan of each window */
+	if( strcmp( argv[1], "-m" )==0 )
+	{
+		if( argc>2 && atol( argv[2] )<1 )
+		{
+			fprintf(stderr,"Usage: %s -m [samples]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Stats_Test( (argc>2) ? (unsigned long)atol( argv[2] ) : STATS_TEST_SAMPLES );
+		if( nRegressed<0 ) { return 1; }
+		return ( nRegressed==0 ) ? 0 : 2;
+	}
+
+	/* Latency of the FES triggers on the current
+	** and predicted phase angles */
+	if( strcmp( argv[1], "-l" )==0 )
+	{
+		if( argc<3 || ( argc>3 && ( atof( argv[3] )<=0.0 || atof( argv[3] )>=1.0 ) ) )
+		{
+			fprintf(stderr,"Usage: %s -l <recording> [trigger phase] [labels]\n",argv[0]);
+			return 1;
+		}
+		nRegressed = Emulator_Phase_Test( argv[2], (argc>3) ? (float)atof( argv[3] ) : PHASE_TEST_PHASE, (argc>4) ? argv[4] : NULL );
+		return ( nRegressed==0 ) ? 0 : 1;
+	}
+
+	/* Replay as fast as possible */
+	p_pipeline = new PIPELINE_STATE_TYPE();
+	StartTime  = Emulator_Clock();
+	ret = Emulator_Replay( p_pipeline, argv[1], (argc>2) ? argv[2] : NULL );
+	ElapsedTime = Emulator_Clock() - StartTime;
+
+	if( ret==TRUE )
+	{
+		fprintf(stderr,"> Processed %lu samples in %.3f s (%.0f samples/sec)\n",
+			p_pipeline->control.emu_data.nSamples, ElapsedTime,
+			(ElapsedTime>0) ? (p_pipeline->control.emu_data.nSamples/ElapsedTime) : 0.0 );
+	}
+
+	delete p_pipeline;
+	return ( ret==TRUE ) ? 0 : 1;
+} /* End main */
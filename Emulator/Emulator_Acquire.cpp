@@ -0,0 +1,472 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Acquire
+** DESCRIPTION:
+** 		This file contains the host (Linux) test of interrupt
+** 		driven acquisition (see Acquisition_Config.h), against
+** 		a stand-in for the MPU-9250 FIFO registers (see
+** 		Emulator_MPU9250.cpp).
+** 		A producer thread stands in for the IMU and its data
+** 		ready interrupt: it steps through a recording at the
+** 		recorded sample instants (optionally sped up), writes
+** 		each sample to the FIFO and stamps it in the ring
+** 		(Acq_Ring_Stamp). The main thread stands in for
+** 		loop(): it burst reads the FIFO into the ring
+** 		(Acq_FIFO_Read, dated by the stamps) and runs the
+** 		processing stages on each sample.
+** 		The producer's lateness against the recorded sample
+** 		instants, the samples lost to FIFO overflow and the
+** 		skew of each sample timestamp against its sampled
+** 		time are reported. Without losses or skew, the
+** 		results are identical to a plain replay of the
+** 		recording.
+** 		The FIFO acquisition (ACQ_MODE_FIFO) is tested in the
+** 		same way, without the stamps and with the loop length
+** 		set in samples.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <atomic>
+#include <thread>
+
+/* Only link if using IMU9250 (FIFO register map) */
+#ifdef _IMU9250_
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/*
+** TYPE: ACQUIRE_TYPE
+** State shared by the producer and consumer */
+typedef struct
+{
+	ACQ_RING_TYPE ring;
+
+	/* Producer settings */
+	const char *InputPath;
+	double      Speed; /* x real time, 0: no pacing (no FIFO overflow) */
+
+	/* Set by the producer once the recording is exhausted */
+	std::atomic<bool> Done;
+	bool              Success;
+
+	/* Producer lateness against the recorded sample instants (us) */
+	double        Late_max;
+	double        Late_sum;
+	unsigned long nSamples;
+} ACQUIRE_TYPE;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Acquire_Producer
+** VARIABLES:
+**		[IO]	ACQUIRE_TYPE	*p_acquire
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Producer thread body (the IMU and its
+** 		data ready interrupt). Reads the recording
+** 		through its own emulator instance and, at
+** 		each recorded sample instant, writes the
+** 		sample to the FIFO and stamps it.
+*/
+void Acquire_Producer( ACQUIRE_TYPE *p_acquire )
+{
+	CONTROL_TYPE      control;
+	SENSOR_STATE_TYPE sensor_state;
+	ACQ_SAMPLE_TYPE   sample;
+	struct timespec   ts;
+	unsigned long     FirstTimestamp = 0;
+	double            StartTime, Target, Late;
+	int               i;
+
+	memset( &control, 0, sizeof(control) );
+	memset( &sensor_state, 0, sizeof(sensor_state) );
+
+	p_acquire->Success = Emulator_Init( &control, p_acquire->InputPath, NULL );
+	StartTime = Emulator_Clock();
+
+	while( p_acquire->Success==TRUE )
+	{
+		Read_Sensors( &control, &sensor_state );
+		if( control.emu_data.EndOfFile==TRUE ) { break; }
+
+		sample.timestamp = (uint32_t)control.emu_data.timestamp;
+		for( i=0; i<3; i++ )
+		{
+			sample.accel[i] = (int16_t)lrintf( sensor_state.accel[i] );
+			sample.gyro[i]  = (int16_t)lrintf( sensor_state.gyro[i] );
+		}
+
+		/* Wait for the sample instant */
+		if( p_acquire->nSamples==0 ) { FirstTimestamp = control.emu_data.timestamp; }
+		if( p_acquire->Speed>0.0 )
+		{
+			Target = StartTime + (double)(control.emu_data.timestamp-FirstTimestamp)/TIME_RESOLUTION/p_acquire->Speed;
+			ts.tv_sec  = (time_t)Target;
+			ts.tv_nsec = (long)( (Target-(double)ts.tv_sec)*1.0e9 );
+			clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL );
+
+			Late = ( Emulator_Clock()-Target )*1.0e6;
+			if( Late>p_acquire->Late_max ) { p_acquire->Late_max = Late; }
+			p_acquire->Late_sum += Late;
+		}
+		else
+		{
+			/* Unpaced: wait for room instead of overflowing
+			** (the IMU cannot, this measures throughput) */
+			while( Emulator_MPU_Frames()>=EMU_MPU_FIFO_FRAMES ) { std::this_thread::yield(); }
+		}
+
+		Emulator_MPU_Sample( &sample );
+		Acq_Ring_Stamp( &p_acquire->ring, sample.timestamp );
+		p_acquire->nSamples++;
+	}
+
+	Emulator_Close( &control );
+	p_acquire->Done.store( true, std::memory_order_release );
+} /* End Acquire_Producer */
+
+
+/*************************************************
+** FUNCTION: Acquire_Load
+** VARIABLES:
+**		[IO]	PIPELINE_STATE_TYPE		*p_pipeline
+**		[I ]	const ACQ_SAMPLE_TYPE	*p_sample
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Load a ring sample into the pipeline.
+** 		The 32 bit timestamp is unwrapped into
+** 		the emulator timestamp (see Update_Time).
+*/
+void Acquire_Load( PIPELINE_STATE_TYPE		*p_pipeline,
+									 const ACQ_SAMPLE_TYPE	*p_sample )
+{
+	EMULATION_TYPE *p_emu = &p_pipeline->control.emu_data;
+
+	Acq_Load_Sample( &p_pipeline->control, &p_pipeline->sensor_state, p_sample );
+
+	if( p_emu->nSamples>0 && p_sample->timestamp<p_emu->timestamp_raw ) { p_emu->timestamp_wrap += 4294967296UL; }
+	p_emu->timestamp_raw = p_sample->timestamp;
+	p_emu->timestamp     = p_emu->timestamp_wrap + p_sample->timestamp;
+	p_emu->nSamples++;
+} /* End Acquire_Load */
+
+
+/*************************************************
+** FUNCTION: Acquire_Wait
+** VARIABLES:
+**		[IO]	ACQUIRE_TYPE	*p_acquire
+**		[IO]	ACQ_FIFO_TYPE	*p_fifo
+** RETURN:
+**		int		Number of samples read from the FIFO,
+**					0 once the producer is done and
+**					the FIFO is empty, -1 on a bus error
+** DESCRIPTION:
+** 		Consumer side. Wait for the next burst.
+** 		The done flag is read before the FIFO,
+** 		so a sample written just before the
+** 		producer finished is never missed.
+*/
+int Acquire_Wait( ACQUIRE_TYPE	*p_acquire,
+									ACQ_FIFO_TYPE	*p_fifo )
+{
+	bool Done;
+	int  n;
+
+	while( TRUE )
+	{
+		Done = p_acquire->Done.load( std::memory_order_acquire );
+		n    = Acq_FIFO_Read( p_fifo, &p_acquire->ring, 0 );
+		if( n!=0 || Done ) { return n; }
+		std::this_thread::yield();
+	}
+} /* End Acquire_Wait */
+
+
+/*************************************************
+** FUNCTION: Emulator_Acquire
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	const char	*OutputPath
+**		[I ]	double			Speed
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Replay a recording as in ACQ_MODE_INTERRUPT,
+** 		with a producer thread in place of the IMU
+** 		and its data ready interrupt. Speed sets the
+** 		producer rate (x real time). At 0 the
+** 		producer is not paced and waits for room in
+** 		the FIFO rather than overflowing it.
+** 		Each sample timestamp is checked against the
+** 		time the sample was written to the FIFO.
+** 		The results are written to OutputPath (none
+** 		if NULL).
+*/
+bool Emulator_Acquire( const char	*InputPath,
+											 const char	*OutputPath,
+											 double			Speed )
+{
+	ACQUIRE_TYPE            *p_acquire  = new ACQUIRE_TYPE();
+	PIPELINE_STATE_TYPE     *p_pipeline = new PIPELINE_STATE_TYPE();
+	ACQ_FIFO_TYPE            fifo;
+	ACQ_SAMPLE_TYPE          sample;
+	const EMULATOR_MPU_TYPE *p_mpu;
+	std::thread              producer;
+	uint32_t                 truth;
+	double                   StartTime, ElapsedTime;
+	double                   Skew, Skew_max = 0.0, Skew_sum = 0.0;
+	unsigned long            nChecked = 0, nSkewed = 0;
+	bool                     Initialized = FALSE;
+	bool                     ret;
+	int                      n;
+
+	Emulator_MPU_Reset();
+	Acq_Ring_Init( &p_acquire->ring );
+	Acq_FIFO_Init( &fifo, EMU_MPU_PERIOD, TRUE );
+	p_acquire->InputPath = InputPath;
+	p_acquire->Speed     = Speed;
+	p_acquire->Done.store( false );
+
+	Common_Init( &p_pipeline->control, &p_pipeline->sensor_state );
+	if( OutputPath!=NULL )
+	{
+		p_pipeline->control.emu_data.OutputFID = fopen( OutputPath, "w" );
+		if( p_pipeline->control.emu_data.OutputFID==NULL )
+		{
+			LOG_PRINTLN("ERROR : Emulator_Acquire : Cant open output %s",OutputPath);
+			delete p_pipeline;
+			delete p_acquire;
+			return FALSE;
+		}
+	}
+
+	LOG_PRINTLN("> Acquiring %s (%.1fx real time)",InputPath,Speed);
+	StartTime = Emulator_Clock();
+	producer  = std::thread( Acquire_Producer, p_acquire );
+
+	/* loop(), the now argument of Acq_FIFO_Read is
+	** only used for frames older than the first stamp */
+	while( (n=Acquire_Wait( p_acquire, &fifo ))!=0 )
+	{
+		if( n<0 )
+		{
+			LOG_PRINTLN("ERROR : Emulator_Acquire : Bus error");
+			break;
+		}
+
+		n = Acq_Begin_Batch( &p_acquire->ring );
+		while( n-- > 0 && Acq_Ring_Pop( &p_acquire->ring, &sample )==TRUE )
+		{
+			if( Emulator_MPU_Read_Time( &truth )==TRUE )
+			{
+				Skew = fabs( (double)(int32_t)( sample.timestamp-truth ) );
+				if( Skew>Skew_max ) { Skew_max = Skew; }
+				if( Skew>0.0 ) { nSkewed++; }
+				Skew_sum += Skew;
+				nChecked++;
+			}
+
+			Acquire_Load( p_pipeline, &sample );
+
+			/* The first sample sets the initial
+			** roll/pitch/yaw, as in setup() */
+			if( Initialized==FALSE )
+			{
+				Pipeline_Init( p_pipeline );
+				Initialized = TRUE;
+				continue;
+			}
+
+			Pipeline_Update( p_pipeline );
+			Emulator_LogOut( &p_pipeline->control, &p_pipeline->sensor_state, &p_pipeline->gapa_state, &p_pipeline->wise_state );
+		}
+	}
+
+	producer.join();
+	ElapsedTime = Emulator_Clock() - StartTime;
+	ret = ( p_acquire->Success==TRUE && n==0 ) ? TRUE : FALSE;
+
+	if( ret==TRUE )
+	{
+		p_mpu = Emulator_MPU_State();
+		fprintf(stderr,"> Acquired %lu samples in %.3f s: %u read, %lu dropped (%u FIFO overflows), %u processed\n",
+			p_acquire->nSamples, ElapsedTime, fifo.nFrames, p_mpu->nLost, fifo.nOverflows, p_acquire->ring.nPopped );
+		fprintf(stderr,"> %u batches (mean %.2f, max depth %u of %d)",
+			p_acquire->ring.nBatches,
+			( p_acquire->ring.nBatches>0 ) ? (double)p_acquire->ring.nPopped/p_acquire->ring.nBatches : 0.0,
+			p_acquire->ring.MaxDepth, ACQ_RING_SIZE );
+		if( Speed>0.0 && p_acquire->nSamples>0 )
+		{
+			fprintf(stderr,", producer late mean %.1f us max %.1f us",
+				p_acquire->Late_sum/p_acquire->nSamples, p_acquire->Late_max );
+		}
+		fprintf(stderr,"\n");
+		fprintf(stderr,"> Timestamp skew mean %.1f us max %.1f us (%lu of %lu samples off their sampled time)\n",
+			( nChecked>0 ) ? Skew_sum/nChecked : 0.0, Skew_max, nSkewed, nChecked );
+	}
+
+	if( p_pipeline->control.emu_data.OutputFID!=NULL ) { fclose( p_pipeline->control.emu_data.OutputFID ); }
+	delete p_pipeline;
+	delete p_acquire;
+	return ret;
+} /* End Emulator_Acquire */
+
+
+/*************************************************
+** FUNCTION: Emulator_Acquire_FIFO
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	const char	*OutputPath
+**		[I ]	int					FramesPerLoop
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Replay a recording through the MPU-9250 FIFO
+** 		stand-in (Emulator_MPU_*) and Acq_FIFO_Read,
+** 		as loop() does in ACQ_MODE_FIFO. Each pass,
+** 		FramesPerLoop samples are written to the FIFO
+** 		(the loop is that many sample periods long),
+** 		then the FIFO is read and the samples run
+** 		through the processing stages.
+** 		The bus traffic, FIFO overflows and the error
+** 		of the rebuilt timestamps are reported. With
+** 		one frame per loop the results are identical
+** 		to a plain replay of the recording.
+** 		The results are written to OutputPath (none
+** 		if NULL).
+*/
+bool Emulator_Acquire_FIFO( const char	*InputPath,
+														const char	*OutputPath,
+														int					FramesPerLoop )
+{
+	CONTROL_TYPE             reader;
+	SENSOR_STATE_TYPE        reader_sensor;
+	PIPELINE_STATE_TYPE     *p_pipeline = new PIPELINE_STATE_TYPE();
+	ACQ_RING_TYPE            ring;
+	ACQ_FIFO_TYPE            fifo;
+	ACQ_SAMPLE_TYPE          sample;
+	const EMULATOR_MPU_TYPE *p_mpu;
+	uint32_t                 now = 0, truth;
+	double                   Error, Error_max = 0.0, Error_sum = 0.0;
+	unsigned long            nLoops = 0, nChecked = 0;
+	bool                     Initialized = FALSE;
+	int                      i, j;
+
+	memset( &reader, 0, sizeof(reader) );
+	memset( &reader_sensor, 0, sizeof(reader_sensor) );
+	if( Emulator_Init( &reader, InputPath, NULL )==FALSE )
+	{
+		delete p_pipeline;
+		return FALSE;
+	}
+
+	Common_Init( &p_pipeline->control, &p_pipeline->sensor_state );
+	if( OutputPath!=NULL )
+	{
+		p_pipeline->control.emu_data.OutputFID = fopen( OutputPath, "w" );
+		if( p_pipeline->control.emu_data.OutputFID==NULL )
+		{
+			LOG_PRINTLN("ERROR : Emulator_Acquire_FIFO : Cant open output %s",OutputPath);
+			Emulator_Close( &reader );
+			delete p_pipeline;
+			return FALSE;
+		}
+	}
+
+	Emulator_MPU_Reset();
+	Acq_Ring_Init( &ring );
+	Acq_FIFO_Init( &fifo, EMU_MPU_PERIOD, FALSE );
+
+	LOG_PRINTLN("> Acquiring %s through the FIFO (%d frames per loop)",InputPath,FramesPerLoop);
+
+	while( reader.emu_data.EndOfFile==FALSE )
+	{
+		/* The IMU samples while loop() is busy */
+		for( i=0; i<FramesPerLoop; i++ )
+		{
+			Read_Sensors( &reader, &reader_sensor );
+			if( reader.emu_data.EndOfFile==TRUE ) { break; }
+
+			sample.timestamp = (uint32_t)reader.emu_data.timestamp;
+			for( j=0; j<3; j++ )
+			{
+				sample.accel[j] = (int16_t)lrintf( reader_sensor.accel[j] );
+				sample.gyro[j]  = (int16_t)lrintf( reader_sensor.gyro[j] );
+			}
+			Emulator_MPU_Sample( &sample );
+			now = sample.timestamp;
+		}
+
+		/* loop() */
+		if( Acq_FIFO_Read( &fifo, &ring, now )<0 )
+		{
+			LOG_PRINTLN("ERROR : Emulator_Acquire_FIFO : Bus error");
+			break;
+		}
+		nLoops++;
+
+		while( Acq_Ring_Pop( &ring, &sample )==TRUE )
+		{
+			if( Emulator_MPU_Read_Time( &truth )==TRUE )
+			{
+				Error = fabs( (double)(int32_t)( sample.timestamp-truth ) );
+				if( Error>Error_max ) { Error_max = Error; }
+				Error_sum += Error;
+				nChecked++;
+			}
+
+			Acquire_Load( p_pipeline, &sample );
+
+			/* The first sample sets the initial
+			** roll/pitch/yaw, as in setup() */
+			if( Initialized==FALSE )
+			{
+				Pipeline_Init( p_pipeline );
+				Initialized = TRUE;
+				continue;
+			}
+
+			Pipeline_Update( p_pipeline );
+			Emulator_LogOut( &p_pipeline->control, &p_pipeline->sensor_state, &p_pipeline->gapa_state, &p_pipeline->wise_state );
+		}
+	}
+
+	p_mpu = Emulator_MPU_State();
+	fprintf(stderr,"> %lu samples in %lu loops: %u read, %lu lost (%u overflows)\n",
+		p_mpu->nSampled, nLoops, fifo.nFrames, p_mpu->nLost, fifo.nOverflows );
+	fprintf(stderr,"> %lu bus transactions (%.3f per sample, 2 when polled), %lu bytes\n",
+		p_mpu->nTransactions,
+		( fifo.nFrames>0 ) ? (double)p_mpu->nTransactions/fifo.nFrames : 0.0,
+		p_mpu->nBytes );
+	fprintf(stderr,"> Timestamp error mean %.1f us max %.1f us\n",
+		( nChecked>0 ) ? Error_sum/nChecked : 0.0, Error_max );
+
+	Emulator_Close( &reader );
+	if( p_pipeline->control.emu_data.OutputFID!=NULL ) { fclose( p_pipeline->control.emu_data.OutputFID ); }
+	delete p_pipeline;
+	return TRUE;
+} /* End Emulator_Acquire_FIFO */
+
+#endif /* End _IMU9250_ */
@@ -0,0 +1,545 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Bench
+** DESCRIPTION:
+** 		This file contains the per-stage benchmark for the host
+** 		(Linux) emulator. A recording is replayed BENCH_REPEATS
+** 		times and every processing stage is timed separately on
+** 		every sample, giving ns/sample, p50/p99/max latency and
+** 		throughput per stage (see Bench_Config.h).
+** 		All stages are run on every sample regardless of the
+** 		DSP_on/WISE_on settings and the WISE gate, so each one
+** 		is measured on the same realistic inputs:
+** 			- FIR_Filter and IIR_Filter are each run on a copy of
+** 			  the sensor state, so the downstream stages see the
+** 			  same (unfiltered) inputs as the default pipeline.
+** 			- Debug_LogOut output is sent to /dev/null.
+** 			- f_RespondToInput answers one request per sample
+** 			  (cycling through the data/debug requests) from the
+** 			  emulator communication queue.
+** 		The timer overhead is measured first and removed from
+** 		every latency. Host timings are not SAMD21 timings, they
+** 		are meant for comparing one change against another on
+** 		the same machine.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* Stage names, indexed by BENCH_*
+** Used in the results and the thresholds file */
+const char *Bench_Stage_Names[BENCH_N_STAGES] =
+{
+	"FIR_Filter",
+	"IIR_Filter",
+	"DSP_Shift",
+	"Stats_Update",
+	"DCM_Filter",
+	"GaPA_Update",
+	"WISE_Update",
+	"Debug_LogOut",
+	"f_RespondToInput",
+	"Total"
+};
+
+/* Requests sent to f_RespondToInput, one per sample */
+static const uint8_t Bench_Requests[] = { 0xA1, 0xA2, 0xA3, 0xB1, 0xB2 };
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Bench_Now
+** VARIABLES:
+**		NONE
+** RETURN:
+**		uint64_t	Monotonic time (ns)
+** DESCRIPTION:
+** 		Timer used around each stage call
+*/
+static inline uint64_t Bench_Now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+} /* End Bench_Now */
+
+
+/*************************************************
+** FUNCTION: Bench_Timer_Overhead
+** VARIABLES:
+**		NONE
+** RETURN:
+**		double	Timer overhead (ns)
+** DESCRIPTION:
+** 		Median time between two back to back
+** 		timer reads. This is the cost of timing
+** 		an empty stage.
+*/
+double Bench_Timer_Overhead( void )
+{
+	uint32_t *delta = (uint32_t*)malloc( BENCH_CAL_READS*sizeof(uint32_t) );
+	uint64_t  t0, t1;
+	double    overhead;
+	int       i;
+
+	if( delta==NULL ) { return 0.0; }
+
+	for( i=0; i<BENCH_CAL_READS; i++ )
+	{
+		t0 = Bench_Now();
+		t1 = Bench_Now();
+		delta[i] = (uint32_t)( t1-t0 );
+	}
+	std::nth_element( delta, delta+BENCH_CAL_READS/2, delta+BENCH_CAL_READS );
+	overhead = delta[BENCH_CAL_READS/2];
+
+	free( delta );
+	return overhead;
+} /* End Bench_Timer_Overhead */
+
+
+/*************************************************
+** FUNCTION: Bench_Record
+** VARIABLES:
+**		[IO]	BENCH_STAGE_TYPE	*p_stage
+**		[I ]	int								Repeat
+**		[I ]	double						latency
+** RETURN:
+**		BOOL	1:Successful
+**					0:Out of memory
+** DESCRIPTION:
+** 		Store one call latency (ns, timer
+** 		overhead already removed).
+*/
+bool Bench_Record( BENCH_STAGE_TYPE	*p_stage,
+									 int							Repeat,
+									 double						latency )
+{
+	uint32_t     *p_new;
+	unsigned long nAlloc;
+
+	if( p_stage->nCalls==p_stage->nAlloc )
+	{
+		nAlloc = ( p_stage->nAlloc==0 ) ? 65536 : 2*p_stage->nAlloc;
+		p_new  = (uint32_t*)realloc( p_stage->latency, nAlloc*sizeof(uint32_t) );
+		if( p_new==NULL ) { return FALSE; }
+		p_stage->latency = p_new;
+		p_stage->nAlloc  = nAlloc;
+	}
+
+	if( latency<0.0 )          { latency = 0.0; }
+	if( latency>4294967295.0 ) { latency = 4294967295.0; }
+	p_stage->latency[p_stage->nCalls++] = (uint32_t)latency;
+	p_stage->total_ns[Repeat] += latency;
+	return TRUE;
+} /* End Bench_Record */
+
+
+/*************************************************
+** FUNCTION: Bench_Read_Thresholds
+** VARIABLES:
+**		[I ]	const char				*ThresholdsPath
+**		[IO]	BENCH_STATE_TYPE	*p_bench
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Read the regression thresholds. Each line
+** 		holds a stage name, the maximum ns/sample
+** 		and optionally the maximum p99 latency (ns):
+** 			DCM_Filter 250 900
+** 		A value of 0 is not checked. Lines starting
+** 		with '#' are comments, stages which are not
+** 		listed are not checked.
+*/
+bool Bench_Read_Thresholds( const char				*ThresholdsPath,
+														BENCH_STATE_TYPE	*p_bench )
+{
+	FILE *ThresholdsFID;
+	char  line[EMU_LINE_LENGTH];
+	char *p_str;
+	char *p_end;
+	char *p_name;
+	int   i;
+
+	ThresholdsFID = fopen( ThresholdsPath, "r" );
+	if( ThresholdsFID==NULL )
+	{
+		LOG_PRINTLN("ERROR : Bench_Read_Thresholds : Cant open %s",ThresholdsPath);
+		return FALSE;
+	}
+
+	while( fgets( line, EMU_LINE_LENGTH, ThresholdsFID )!=NULL )
+	{
+		/* Stage name */
+		p_str = line;
+		while( isspace( (unsigned char)*p_str ) ) { p_str++; }
+		if( *p_str=='#' || *p_str=='\0' ) { continue; }
+		p_name = p_str;
+		while( *p_str!='\0' && !isspace( (unsigned char)*p_str ) ) { p_str++; }
+		if( *p_str!='\0' ) { *p_str++ = '\0'; }
+
+		for( i=0; i<BENCH_N_STAGES; i++ ) { if( strcmp( p_name, Bench_Stage_Names[i] )==0 ) { break; } }
+		if( i==BENCH_N_STAGES )
+		{
+			LOG_PRINTLN("ERROR : Bench_Read_Thresholds : Unknown stage %s",p_name);
+			fclose( ThresholdsFID );
+			return FALSE;
+		}
+
+		/* Limits */
+		p_bench->stage[i].max_ns_per_sample = strtod( p_str, &p_end );
+		if( p_end==p_str )
+		{
+			LOG_PRINTLN("ERROR : Bench_Read_Thresholds : No limit for %s",p_name);
+			fclose( ThresholdsFID );
+			return FALSE;
+		}
+		p_str = p_end;
+		p_bench->stage[i].max_p99_ns = strtod( p_str, &p_end );
+		if( p_end==p_str ) { p_bench->stage[i].max_p99_ns = 0.0; }
+	}
+
+	fclose( ThresholdsFID );
+	return TRUE;
+} /* End Bench_Read_Thresholds */
+
+
+/*************************************************
+** FUNCTION: Bench_Replay
+** VARIABLES:
+**		[IO]	BENCH_STATE_TYPE		*p_bench
+**		[IO]	PIPELINE_STATE_TYPE	*p_pipeline
+**		[I ]	const char					*InputPath
+**		[I ]	int									Repeat
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Replay the recording once from a clean
+** 		pipeline, timing every stage on every
+** 		sample. Log output (Debug_LogOut and the
+** 		request logging) is sent to /dev/null for
+** 		the length of the replay.
+*/
+bool Bench_Replay( BENCH_STATE_TYPE			*p_bench,
+									 PIPELINE_STATE_TYPE	*p_pipeline,
+									 const char						*InputPath,
+									 int									Repeat )
+{
+	CONTROL_TYPE      *p_control      = &p_pipeline->control;
+	SENSOR_STATE_TYPE *p_sensor_state = &p_pipeline->sensor_state;
+	SENSOR_STATE_TYPE  scratch;
+	unsigned long      FirstTimestamp, nSamples = 0;
+	double             latency[BENCH_N_STAGES];
+	uint64_t           t0;
+	uint8_t            request;
+	int                i, NullFD, LogFD;
+	bool               ret = TRUE;
+
+	/* Clean pipeline, with every timed stage initialized */
+	memset( p_pipeline, 0, sizeof(PIPELINE_STATE_TYPE) );
+	Common_Init( p_control, p_sensor_state );
+	p_control->DSP_on  = 1;
+	p_control->DCM_on  = 1;
+	p_control->GaPA_on = 1;
+	p_control->WISE_on = 1;
+	if( Emulator_Init( p_control, InputPath, NULL )==FALSE )
+	{
+		Emulator_Close( p_control );
+		return FALSE;
+	}
+	Read_Sensors( p_control, p_sensor_state );
+	if( p_control->emu_data.EndOfFile==TRUE )
+	{
+		LOG_PRINTLN("ERROR : Bench_Replay : Empty recording %s",InputPath);
+		Emulator_Close( p_control );
+		return FALSE;
+	}
+	Pipeline_Init( p_pipeline );
+	Emulator_Comm_Reset();
+	FirstTimestamp = p_control->emu_data.timestamp;
+
+	/* Silence the log port */
+	fflush( LOG_PORT );
+	LogFD  = dup( fileno(LOG_PORT) );
+	NullFD = open( "/dev/null", O_WRONLY );
+	if( LogFD>=0 && NullFD>=0 ) { dup2( NullFD, fileno(LOG_PORT) ); }
+
+	while( ret==TRUE )
+	{
+		Read_Sensors( p_control, p_sensor_state );
+		if( p_control->emu_data.EndOfFile==TRUE ) { break; }
+		Update_Time( p_control );
+
+		/* DSP */
+		scratch = *p_sensor_state;
+		t0 = Bench_Now();
+		FIR_Filter( p_control, &p_pipeline->dsp, &scratch );
+		latency[BENCH_FIR_FILTER] = (double)( Bench_Now()-t0 );
+
+		scratch = *p_sensor_state;
+		t0 = Bench_Now();
+		IIR_Filter( p_control, &p_pipeline->dsp, &scratch );
+		latency[BENCH_IIR_FILTER] = (double)( Bench_Now()-t0 );
+
+		t0 = Bench_Now();
+		DSP_Shift( p_control, &p_pipeline->dsp );
+		latency[BENCH_DSP_SHIFT] = (double)( Bench_Now()-t0 );
+
+		/* Motion statistics */
+		t0 = Bench_Now();
+		Stats_Update( &p_pipeline->stats, p_sensor_state );
+		latency[BENCH_STATS_UPDATE] = (double)( Bench_Now()-t0 );
+
+		/* Orientation, gait phase, speed and incline */
+		t0 = Bench_Now();
+		DCM_Filter( p_control, &p_pipeline->dcm_state, p_sensor_state );
+		latency[BENCH_DCM_FILTER] = (double)( Bench_Now()-t0 );
+
+		t0 = Bench_Now();
+		GaPA_Update( p_control, p_sensor_state, &p_pipeline->gapa_state );
+		GaPA_Predict( p_control, &p_pipeline->gapa_state );
+		latency[BENCH_GAPA_UPDATE] = (double)( Bench_Now()-t0 );
+
+		t0 = Bench_Now();
+		p_pipeline->wise_state.gapa_cycle_time = ( p_pipeline->gapa_state.stride_rate>0.0f ) ? 1.0f/p_pipeline->gapa_state.stride_rate : 0.0f;
+		WISE_Update( p_control, p_sensor_state, &p_pipeline->wise_state );
+		latency[BENCH_WISE_UPDATE] = (double)( Bench_Now()-t0 );
+
+		/* Logging and communication */
+		t0 = Bench_Now();
+		Debug_LogOut( p_control, p_sensor_state, &p_pipeline->gapa_state, &p_pipeline->wise_state );
+		latency[BENCH_DEBUG_LOGOUT] = (double)( Bench_Now()-t0 );
+
+		request = Bench_Requests[nSamples%sizeof(Bench_Requests)];
+		Emulator_Comm_Send( &request, 1 );
+		t0 = Bench_Now();
+		f_RespondToInput( p_control, p_sensor_state, &p_pipeline->calibration, &p_pipeline->wise_state, COMM_AVAILABLE );
+		latency[BENCH_RESPOND_TO_INPUT] = (double)( Bench_Now()-t0 );
+		Emulator_Comm_Receive( NULL, EMU_COMM_BUFFER );
+
+		/* Store */
+		latency[BENCH_TOTAL] = 0.0;
+		for( i=0; i<BENCH_TOTAL; i++ )
+		{
+			latency[i] -= p_bench->TimerOverhead_ns;
+			if( latency[i]<0.0 ) { latency[i] = 0.0; }
+			latency[BENCH_TOTAL] += latency[i];
+		}
+		for( i=0; i<BENCH_N_STAGES && ret==TRUE; i++ ) { ret = Bench_Record( &p_bench->stage[i], Repeat, latency[i] ); }
+		nSamples++;
+	}
+
+	/* Restore the log port */
+	fflush( LOG_PORT );
+	if( LogFD>=0 && NullFD>=0 ) { dup2( LogFD, fileno(LOG_PORT) ); }
+	if( LogFD>=0 )  { close( LogFD ); }
+	if( NullFD>=0 ) { close( NullFD ); }
+
+	if( ret==FALSE ) { LOG_PRINTLN("ERROR : Bench_Replay : Out of memory"); }
+
+	p_bench->nSamples = nSamples;
+	if( nSamples>1 )
+	{
+		p_bench->SamplePeriod_ns = 1.0e9*(double)( p_control->emu_data.timestamp-FirstTimestamp )/TIME_RESOLUTION/(double)nSamples;
+	}
+
+	Emulator_Close( p_control );
+	return ret;
+} /* End Bench_Replay */
+
+
+/*************************************************
+** FUNCTION: Bench_Results
+** VARIABLES:
+**		[IO]	BENCH_STATE_TYPE	*p_bench
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Compute the per-stage results from the
+** 		stored latencies and check the thresholds.
+** 		ns/sample is the best of the replays, the
+** 		latency percentiles are over all calls.
+*/
+void Bench_Results( BENCH_STATE_TYPE *p_bench )
+{
+	BENCH_STAGE_TYPE *p_stage;
+	double total;
+	int    i, r;
+
+	p_bench->nRegressed = 0;
+	for( i=0; i<BENCH_N_STAGES; i++ )
+	{
+		p_stage = &p_bench->stage[i];
+		if( p_stage->nCalls==0 || p_bench->nSamples==0 ) { continue; }
+
+		total = 0.0;
+		p_stage->ns_per_sample = p_stage->total_ns[0];
+		for( r=0; r<BENCH_REPEATS; r++ )
+		{
+			total += p_stage->total_ns[r];
+			p_stage->ns_per_sample = std::min( p_stage->ns_per_sample, p_stage->total_ns[r] );
+		}
+		p_stage->ns_per_sample /= (double)p_bench->nSamples;
+		p_stage->mean_ns        = total/(double)p_stage->nCalls;
+		p_stage->throughput     = ( p_stage->ns_per_sample>0.0 ) ? 1.0e9/p_stage->ns_per_sample : 0.0;
+
+		std::sort( p_stage->latency, p_stage->latency+p_stage->nCalls );
+		p_stage->p50_ns = p_stage->latency[(p_stage->nCalls-1)/2];
+		p_stage->p99_ns = p_stage->latency[(unsigned long)( 0.99*(double)(p_stage->nCalls-1) )];
+		p_stage->max_ns = p_stage->latency[p_stage->nCalls-1];
+
+		p_stage->Regressed = ( p_stage->max_ns_per_sample>0.0 && p_stage->ns_per_sample>p_stage->max_ns_per_sample ) ||
+		                     ( p_stage->max_p99_ns>0.0        && p_stage->p99_ns>p_stage->max_p99_ns );
+		if( p_stage->Regressed ) { p_bench->nRegressed++; }
+	}
+} /* End Bench_Results */
+
+
+/*************************************************
+** FUNCTION: Bench_Report
+** VARIABLES:
+**		[I ]	BENCH_STATE_TYPE	*p_bench
+**		[I ]	const char				*InputPath
+**		[I ]	const char				*OutputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Write the results as JSON to OutputPath
+** 		(stdout if NULL or "-") and a summary
+** 		table to stderr. budget_pct is the share
+** 		of the recorded sample period.
+*/
+bool Bench_Report( BENCH_STATE_TYPE	*p_bench,
+									 const char				*InputPath,
+									 const char				*OutputPath )
+{
+	const BENCH_STAGE_TYPE *p_stage;
+	FILE *OutputFID = stdout;
+	int   i;
+
+	if( OutputPath!=NULL && strcmp( OutputPath, "-" )!=0 )
+	{
+		OutputFID = fopen( OutputPath, "w" );
+		if( OutputFID==NULL )
+		{
+			LOG_PRINTLN("ERROR : Bench_Report : Cant open output %s",OutputPath);
+			return FALSE;
+		}
+	}
+
+	fprintf(OutputFID,"{\n");
+	fprintf(OutputFID,"  \"recording\": \"%s\",\n",InputPath);
+	fprintf(OutputFID,"  \"samples\": %lu,\n",p_bench->nSamples);
+	fprintf(OutputFID,"  \"repeats\": %d,\n",BENCH_REPEATS);
+	fprintf(OutputFID,"  \"sample_period_ns\": %.1f,\n",p_bench->SamplePeriod_ns);
+	fprintf(OutputFID,"  \"timer_overhead_ns\": %.1f,\n",p_bench->TimerOverhead_ns);
+	fprintf(OutputFID,"  \"stages\": [\n");
+	for( i=0; i<BENCH_N_STAGES; i++ )
+	{
+		p_stage = &p_bench->stage[i];
+		fprintf(OutputFID,"    { \"name\": \"%s\", \"ns_per_sample\": %.2f, \"mean_ns\": %.2f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"max_ns\": %.0f, "
+		                  "\"throughput\": %.0f, \"budget_pct\": %.4f, \"max_ns_per_sample\": %.2f, \"max_p99_ns\": %.0f, \"regressed\": %s }%s\n",
+			Bench_Stage_Names[i], p_stage->ns_per_sample, p_stage->mean_ns, p_stage->p50_ns, p_stage->p99_ns, p_stage->max_ns,
+			p_stage->throughput, ( p_bench->SamplePeriod_ns>0.0 ) ? 100.0*p_stage->ns_per_sample/p_bench->SamplePeriod_ns : 0.0,
+			p_stage->max_ns_per_sample, p_stage->max_p99_ns, p_stage->Regressed ? "true" : "false",
+			( i<BENCH_N_STAGES-1 ) ? "," : "" );
+	}
+	fprintf(OutputFID,"  ],\n");
+	fprintf(OutputFID,"  \"regressions\": %d\n",p_bench->nRegressed);
+	fprintf(OutputFID,"}\n");
+	if( OutputFID!=stdout ) { fclose( OutputFID ); }
+
+	/* Summary */
+	fprintf(stderr,"> %lu samples x %d replays, sample period %.0f ns, timer overhead %.1f ns\n",
+		p_bench->nSamples, BENCH_REPEATS, p_bench->SamplePeriod_ns, p_bench->TimerOverhead_ns );
+	fprintf(stderr,"  %-18s %12s %10s %10s %10s %14s\n","stage","ns/sample","p50 ns","p99 ns","max ns","samples/sec");
+	for( i=0; i<BENCH_N_STAGES; i++ )
+	{
+		p_stage = &p_bench->stage[i];
+		fprintf(stderr,"  %-18s %12.1f %10.0f %10.0f %10.0f %14.0f%s\n",
+			Bench_Stage_Names[i], p_stage->ns_per_sample, p_stage->p50_ns, p_stage->p99_ns,
+			p_stage->max_ns, p_stage->throughput, p_stage->Regressed ? "  REGRESSED" : "" );
+	}
+	if( p_bench->nRegressed>0 ) { fprintf(stderr,"> %d stage(s) over threshold\n",p_bench->nRegressed); }
+
+	return TRUE;
+} /* End Bench_Report */
+
+
+/*************************************************
+** FUNCTION: Emulator_Bench
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	const char	*OutputPath
+**		[I ]	const char	*ThresholdsPath
+** RETURN:
+**		int		Number of stages over threshold,
+**					-1 on failure
+** DESCRIPTION:
+** 		Benchmark every stage over a recording.
+** 		The results are written as JSON to OutputPath
+** 		(stdout if NULL or "-"). ThresholdsPath may be
+** 		NULL, in which case nothing is checked.
+*/
+int Emulator_Bench( const char	*InputPath,
+										const char	*OutputPath,
+										const char	*ThresholdsPath )
+{
+	PIPELINE_STATE_TYPE *p_pipeline;
+	BENCH_STATE_TYPE    *p_bench;
+	bool ret = TRUE;
+	int  i, r, nRegressed = -1;
+
+	p_bench    = new BENCH_STATE_TYPE();
+	p_pipeline = new PIPELINE_STATE_TYPE();
+
+	if( ThresholdsPath!=NULL ) { ret = Bench_Read_Thresholds( ThresholdsPath, p_bench ); }
+
+	if( ret==TRUE )
+	{
+		p_bench->TimerOverhead_ns = Bench_Timer_Overhead();
+		LOG_PRINTLN("> Benchmarking %s (%d replays)",InputPath,BENCH_REPEATS);
+	}
+	for( r=0; r<BENCH_REPEATS && ret==TRUE; r++ )
+	{
+		ret = Bench_Replay( p_bench, p_pipeline, InputPath, r );
+	}
+
+	if( ret==TRUE )
+	{
+		Bench_Results( p_bench );
+		if( Bench_Report( p_bench, InputPath, OutputPath )==TRUE ) { nRegressed = p_bench->nRegressed; }
+	}
+
+	for( i=0; i<BENCH_N_STAGES; i++ ) { free( p_bench->stage[i].latency ); }
+	delete p_pipeline;
+	delete p_bench;
+	return nRegressed;
+} /* End Emulator_Bench */
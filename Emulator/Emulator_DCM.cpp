@@ -0,0 +1,226 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_DCM
+** DESCRIPTION:
+** 		This file contains the replay tests of the orientation
+** 		filters against the float DCM (DCM_Filter): the fixed
+** 		point DCM (DCM_Filter_Fixed) and the quaternion engine
+** 		(Quaternion_Filter). Both filters run on every sample
+** 		of a recording, from the same initial state and inputs,
+** 		and their Euler angles are compared.
+** 		The time per sample of each is reported in ns and, on
+** 		x86 hosts, in TSC cycles. Host timings are not SAMD21
+** 		timings (the host has an FPU), they are meant for
+** 		comparing one change against another.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/* Filter under test, same interface as DCM_Filter */
+typedef void (*DCM_TEST_FILTER_TYPE)( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: DCM_Test_Now
+** VARIABLES:
+**		NONE
+** RETURN:
+**		uint64_t	Cycle counter (0 if there is none)
+** DESCRIPTION:
+** 		Timestamp counter read around each filter
+*/
+static inline uint64_t DCM_Test_Now( void )
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+} /* End DCM_Test_Now */
+
+
+/*************************************************
+** FUNCTION: DCM_Test_Wrap
+** VARIABLES:
+**		[I ]	double	angle
+** RETURN:
+**		double	angle in [-180,180) (deg)
+** DESCRIPTION:
+** 		Wrap an angle difference, so roll and
+** 		yaw near +-180 compare correctly
+*/
+static double DCM_Test_Wrap( double angle )
+{
+	return angle - 360.0*floor( ( angle+180.0 )/360.0 );
+} /* End DCM_Test_Wrap */
+
+
+/*************************************************
+** FUNCTION: DCM_Test_Run
+** VARIABLES:
+**		[I ]	const char					*InputPath
+**		[I ]	const char					*Name
+**		[I ]	DCM_TEST_FILTER_TYPE	Filter
+**		[I ]	float								MaxError
+** RETURN:
+**		int		0:Passed
+**					1:Error over MaxError
+**					-1:Failure
+** DESCRIPTION:
+** 		Run DCM_Filter and Filter on every
+** 		sample of a recording and report the
+** 		max and RMS difference of their pitch,
+** 		roll and yaw (deg), and the time per
+** 		sample of each. The test fails if any
+** 		difference is over MaxError (deg).
+*/
+static int DCM_Test_Run( const char						*InputPath,
+												 const char						*Name,
+												 DCM_TEST_FILTER_TYPE	Filter,
+												 float								MaxError )
+{
+	const char *Names[3] = { "pitch", "roll", "yaw" };
+	CONTROL_TYPE      control;
+	SENSOR_STATE_TYPE sensor, sensor_f, sensor_q;
+	DCM_STATE_TYPE    dcm_f, dcm_q;
+	unsigned long nSamples = 0;
+	uint64_t CyclesFloat = 0, CyclesTest = 0, t0;
+	double TimeFloat = 0.0, TimeTest = 0.0, StartTime;
+	double Error, MaxAngle[3] = { 0.0, 0.0, 0.0 }, SumSq[3] = { 0.0, 0.0, 0.0 }, MaxAll = 0.0;
+	int i;
+
+	memset( &control, 0, sizeof(control) );
+	memset( &sensor, 0, sizeof(sensor) );
+	memset( &dcm_f, 0, sizeof(dcm_f) );
+	Common_Init( &control, &sensor );
+	if( Emulator_Init( &control, InputPath, NULL )==FALSE )
+	{
+		Emulator_Close( &control );
+		return -1;
+	}
+	Read_Sensors( &control, &sensor );
+	if( control.emu_data.EndOfFile==TRUE )
+	{
+		LOG_PRINTLN("ERROR : DCM_Test_Run : Empty recording %s",InputPath);
+		Emulator_Close( &control );
+		return -1;
+	}
+
+	/* Same initial state (Init_Rotation_Matrix sets the
+	** float and fixed point matrices and the quaternion) */
+	DCM_Init( &control, &dcm_f, &sensor );
+	dcm_q = dcm_f;
+
+	while( TRUE )
+	{
+		Read_Sensors( &control, &sensor );
+		if( control.emu_data.EndOfFile==TRUE ) { break; }
+		Update_Time( &control );
+
+		sensor_f  = sensor;
+		StartTime = Emulator_Clock();
+		t0        = DCM_Test_Now();
+		DCM_Filter( &control, &dcm_f, &sensor_f );
+		Orientation_Roll( &control, &sensor_f );
+		Orientation_Yaw( &control, &sensor_f );
+		CyclesFloat += DCM_Test_Now() - t0;
+		TimeFloat   += Emulator_Clock() - StartTime;
+
+		sensor_q  = sensor;
+		StartTime = Emulator_Clock();
+		t0        = DCM_Test_Now();
+		Filter( &control, &dcm_q, &sensor_q );
+		Orientation_Roll( &control, &sensor_q );
+		Orientation_Yaw( &control, &sensor_q );
+		CyclesTest += DCM_Test_Now() - t0;
+		TimeTest   += Emulator_Clock() - StartTime;
+
+		for( i=0; i<3; i++ )
+		{
+			Error = ( i==0 ) ? sensor_q.pitch - sensor_f.pitch : ( ( i==1 ) ? sensor_q.roll - sensor_f.roll : sensor_q.yaw - sensor_f.yaw );
+			Error = fabs( DCM_Test_Wrap( TO_DEG( Error ) ) );
+			SumSq[i]   += Error*Error;
+			MaxAngle[i] = ( Error>MaxAngle[i] ) ? Error : MaxAngle[i];
+		}
+		nSamples++;
+	}
+	Emulator_Close( &control );
+	if( nSamples==0 ) { return -1; }
+
+	for( i=0; i<3; i++ )
+	{
+		MaxAll = ( MaxAngle[i]>MaxAll ) ? MaxAngle[i] : MaxAll;
+		fprintf(stderr,"> %-5s : max error %.5f, rms %.5f deg\n", Names[i], MaxAngle[i], sqrt( SumSq[i]/nSamples ) );
+	}
+	fprintf(stderr,"> %lu samples: DCM_Filter %.1f ns/sample, %s %.1f ns/sample\n",
+		nSamples, TimeFloat*1.0e9/nSamples, Name, TimeTest*1.0e9/nSamples );
+	if( CyclesFloat>0 )
+	{
+		fprintf(stderr,"> Host cycles (TSC) per sample: DCM_Filter %.1f, %s %.1f\n",
+			(double)CyclesFloat/nSamples, Name, (double)CyclesTest/nSamples );
+	}
+	fprintf(stderr,"> Max error %.5f deg (bound %.5f)\n", MaxAll, MaxError );
+
+	return ( MaxAll<=MaxError ) ? 0 : 1;
+} /* End DCM_Test_Run */
+
+
+/*************************************************
+** FUNCTION: Emulator_DCM_Fixed_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	float				MaxError
+** RETURN:
+**		int		0:Passed
+**					1:Error over MaxError
+**					-1:Failure
+** DESCRIPTION:
+** 		Compare DCM_Filter_Fixed to DCM_Filter
+*/
+int Emulator_DCM_Fixed_Test( const char	*InputPath,
+														 float			MaxError )
+{
+	return DCM_Test_Run( InputPath, "DCM_Filter_Fixed", DCM_Filter_Fixed, MaxError );
+} /* End Emulator_DCM_Fixed_Test */
+
+
+/*************************************************
+** FUNCTION: Emulator_Quaternion_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	float				MaxError
+** RETURN:
+**		int		0:Passed
+**					1:Error over MaxError
+**					-1:Failure
+** DESCRIPTION:
+** 		Compare Quaternion_Filter to DCM_Filter
+*/
+int Emulator_Quaternion_Test( const char	*InputPath,
+															float				MaxError )
+{
+	return DCM_Test_Run( InputPath, "Quaternion_Filter", Quaternion_Filter, MaxError );
+} /* End Emulator_Quaternion_Test */
@@ -0,0 +1,606 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_DSP
+** DESCRIPTION:
+** 		This file contains block versions of FIR_Filter and
+** 		IIR_Filter for host side reprocessing, e.g. sweeping
+** 		the filter banks over long recordings.
+** 		A block holds nSamples rows of DSP_BLOCK_CHANNELS
+** 		channels (accel x,y,z then gyro x,y,z), filtered in
+** 		place in one pass over all the channels:
+** 			- The FIR runs each channel over the whole block,
+** 			  one tap at a time, so the inner loop is across
+** 			  time (vectorized)
+** 			- The IIR recursion cannot run across time, so the
+** 			  six channels run side by side as lanes, one
+** 			  section at a time over the whole block
+** 			  (vectorized across channels)
+** 		The arithmetic is the same as the per-sample path, in
+** 		the same order, so the outputs match it bit for bit
+** 		and the DSP state can be handed back and forth between
+** 		the two (WISE_Emulator -d checks this).
+** 		WISE_Emulator -d also checks the FIR kernels of
+** 		FIR_Filter (DSP_FIR_KERNEL) against each other.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <float.h>
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: DSP_Block_FIR_Taps
+** VARIABLES:
+**		[I ]	const float	*b
+**		[I ]	bool				fold
+**		[I ]	const float	*x
+**		[O ]	float				*y
+**		[I ]	int					nSamples
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		One channel of the FIR over a block.
+** 		x[t-i] must be valid for i<NTAPS (the
+** 		history is stored before x[0]). The taps
+** 		are added in the order of the kernel set
+** 		by DSP_FIR_KERNEL (see DSP_Kernels.h),
+** 		folded when fold is set.
+*/
+static void DSP_Block_FIR_Taps( const float	*b,
+																bool				fold,
+																const float	*x,
+																float				*y,
+																int					nSamples )
+{
+	int i, t;
+
+	for( t=0; t<nSamples; t++ ) { y[t] = 0.0f; }
+
+	if( fold==TRUE )
+	{
+		for( i=0; i<NTAPS/2; i++ )
+		{
+			for( t=0; t<nSamples; t++ ) { y[t] = y[t] + b[i]*( x[t-i] + x[t-(NTAPS-1-i)] ); }
+		}
+		if( NTAPS%2==1 )
+		{
+			for( t=0; t<nSamples; t++ ) { y[t] = y[t] + b[NTAPS/2]*x[t-NTAPS/2]; }
+		}
+	}
+	else
+	{
+		for( i=0; i<NTAPS; i++ )
+		{
+			for( t=0; t<nSamples; t++ ) { y[t] = y[t] + b[i]*x[t-i]; }
+		}
+	}
+} /* End DSP_Block_FIR_Taps */
+
+
+/*************************************************
+** FUNCTION: DSP_Block_FIR
+** VARIABLES:
+**		[I ]	CONTROL_TYPE		*p_control
+**		[IO]	DSP_STATE_TYPE	*p_dsp_state
+**		[IO]	float						block[][DSP_BLOCK_CHANNELS]
+**		[I ]	int							nSamples
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		FIR_Filter over a block of at most
+** 		DSP_BLOCK_SIZE samples. The FIR histories
+** 		are read and left as FIR_Filter would for
+** 		each sample; head is not moved (see
+** 		DSP_Block_Filter).
+*/
+void DSP_Block_FIR( CONTROL_TYPE		*p_control,
+										DSP_STATE_TYPE	*p_dsp_state,
+										float						block[][DSP_BLOCK_CHANNELS],
+										int							nSamples )
+{
+	float w[NTAPS-1+DSP_BLOCK_SIZE];
+	float y[DSP_BLOCK_SIZE];
+	float (*mem)[2*NTAPS];
+	const float *b;
+	bool  fold;
+	int   head = p_dsp_state->head;
+	int   c, k, t, slot;
+
+	for( c=0; c<DSP_BLOCK_CHANNELS; c++ )
+	{
+		/* Accel - LPF, Gyro - HPF */
+		mem = ( c<3 ) ? p_dsp_state->FIR_accel_x : p_dsp_state->FIR_gyro_x;
+#if DSP_FIR_KERNEL==DSP_FIR_FOLD
+		b    = ( c<3 ) ? DSP_FIR_LPF_taps : DSP_FIR_HPF_taps;
+		fold = ( c<3 ) ? DSP_FIR_Symmetric( DSP_FIR_LPF_taps, NTAPS, 0 ) : DSP_FIR_Symmetric( DSP_FIR_HPF_taps, NTAPS, 0 );
+#else
+		b    = ( c<3 ) ? p_dsp_state->FIR_coeffs_L : p_dsp_state->FIR_coeffs_H;
+		fold = FALSE;
+#endif
+
+		/* x[n-NTAPS+1]..x[n-1] from the history, then the block */
+		for( k=0; k<NTAPS-1; k++ ) { w[NTAPS-2-k] = mem[c%3][head+1+k]; }
+		for( t=0; t<nSamples; t++ ) { w[NTAPS-1+t] = block[t][c]; }
+
+		DSP_Block_FIR_Taps( b, fold, &w[NTAPS-1], y, nSamples );
+
+		/* Log the last samples where DSP_Update would have */
+		for( t=( nSamples>NTAPS ) ? nSamples-NTAPS : 0; t<nSamples; t++ )
+		{
+			slot = ( ( head-t )%NTAPS + NTAPS )%NTAPS;
+			mem[c%3][slot]       = w[NTAPS-1+t];
+			mem[c%3][slot+NTAPS] = w[NTAPS-1+t];
+		}
+
+		for( t=0; t<nSamples; t++ ) { block[t][c] = y[t]; }
+	}
+} /* End DSP_Block_FIR */
+
+
+/*************************************************
+** FUNCTION: DSP_Block_IIR
+** VARIABLES:
+**		[I ]	CONTROL_TYPE		*p_control
+**		[IO]	DSP_STATE_TYPE	*p_dsp_state
+**		[IO]	float						block[][DSP_BLOCK_CHANNELS]
+**		[I ]	int							nSamples
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		IIR_Filter over a block of at most
+** 		DSP_BLOCK_SIZE samples. The channels are
+** 		copied into lanes and run one section at
+** 		a time over the whole block, each step
+** 		updating all the lanes (DSP_LANES_TYPE);
+** 		the section states stay in registers for
+** 		the pass. A lane whose bank has fewer
+** 		sections passes its samples through the
+** 		extra ones unchanged. The lanes are on the
+** 		stack, so runs (-j) can filter in parallel.
+*/
+void DSP_Block_IIR( CONTROL_TYPE		*p_control,
+										DSP_STATE_TYPE	*p_dsp_state,
+										float						block[][DSP_BLOCK_CHANNELS],
+										int							nSamples )
+{
+	DSP_LANES_TYPE w[DSP_BLOCK_SIZE][DSP_BLOCK_VECTORS];
+	DSP_LANES_TYPE b0[DSP_BLOCK_VECTORS], b1[DSP_BLOCK_VECTORS], b2[DSP_BLOCK_VECTORS];
+	DSP_LANES_TYPE a1[DSP_BLOCK_VECTORS], a2[DSP_BLOCK_VECTORS];
+	DSP_LANES_TYPE z1[DSP_BLOCK_VECTORS], z2[DSP_BLOCK_VECTORS];
+	DSP_MASK_TYPE  on[DSP_BLOCK_VECTORS];
+	DSP_LANES_TYPE x, y;
+	float (*z[DSP_BLOCK_CHANNELS])[2];
+	const DSP_BANK_TYPE *p_bank[DSP_BLOCK_CHANNELS];
+	int   nSections = 0;
+	int   j, k, l, t, v, i;
+
+	/* Bank selection, as IIR_Filter */
+	for( j=0; j<3; j++ )
+	{
+		DSP_Biquad_Select( p_control->dsp_prms.IIR_accel_bank[j], &p_dsp_state->IIR_accel_bank[j], p_dsp_state->IIR_accel_z[j] );
+		DSP_Biquad_Select( p_control->dsp_prms.IIR_gyro_bank[j], &p_dsp_state->IIR_gyro_bank[j], p_dsp_state->IIR_gyro_z[j] );
+
+		p_bank[j]   = &g_dsp_LPF_banks[p_dsp_state->IIR_accel_bank[j]];
+		p_bank[j+3] = &g_dsp_HPF_banks[p_dsp_state->IIR_gyro_bank[j]];
+		z[j]        = p_dsp_state->IIR_accel_z[j];
+		z[j+3]      = p_dsp_state->IIR_gyro_z[j];
+	}
+	for( l=0; l<DSP_BLOCK_CHANNELS; l++ )
+	{
+		if( p_bank[l]->nSections>nSections ) { nSections = p_bank[l]->nSections; }
+	}
+
+	/* Channels to lanes, the padding lanes are zero
+	** (lane l is element l%DSP_BLOCK_WIDTH of vector
+	** l/DSP_BLOCK_WIDTH) */
+	for( t=0; t<nSamples; t++ )
+	{
+		for( l=0; l<DSP_BLOCK_LANES; l++ )
+		{
+			w[t][l/DSP_BLOCK_WIDTH][l%DSP_BLOCK_WIDTH] = ( l<DSP_BLOCK_CHANNELS ) ? block[t][l] : 0.0f;
+		}
+	}
+
+	for( k=0; k<nSections; k++ )
+	{
+		/* Section k of each lane, off (and zero) past
+		** the end of the lane's bank */
+		for( l=0; l<DSP_BLOCK_LANES; l++ )
+		{
+			v = l/DSP_BLOCK_WIDTH;
+			i = l%DSP_BLOCK_WIDTH;
+			on[v][i] = ( l<DSP_BLOCK_CHANNELS && k<p_bank[l]->nSections ) ? -1 : 0;
+			b0[v][i] = ( on[v][i] ) ? p_bank[l]->section[k].b0 : 0.0f;
+			b1[v][i] = ( on[v][i] ) ? p_bank[l]->section[k].b1 : 0.0f;
+			b2[v][i] = ( on[v][i] ) ? p_bank[l]->section[k].b2 : 0.0f;
+			a1[v][i] = ( on[v][i] ) ? p_bank[l]->section[k].a1 : 0.0f;
+			a2[v][i] = ( on[v][i] ) ? p_bank[l]->section[k].a2 : 0.0f;
+			z1[v][i] = ( on[v][i] ) ? z[l][k][0] : 0.0f;
+			z2[v][i] = ( on[v][i] ) ? z[l][k][1] : 0.0f;
+		}
+
+		/* All lanes at once */
+		for( t=0; t<nSamples; t++ )
+		{
+			for( v=0; v<DSP_BLOCK_VECTORS; v++ )
+			{
+				x       = w[t][v];
+				y       = b0[v]*x + z1[v];
+				z1[v]   = b1[v]*x - a1[v]*y + z2[v];
+				z2[v]   = b2[v]*x - a2[v]*y;
+				w[t][v] = ( on[v]!=0 ) ? y : x;
+			}
+		}
+
+		for( l=0; l<DSP_BLOCK_CHANNELS; l++ )
+		{
+			v = l/DSP_BLOCK_WIDTH;
+			i = l%DSP_BLOCK_WIDTH;
+			if( on[v][i] ) { z[l][k][0] = z1[v][i]; z[l][k][1] = z2[v][i]; }
+		}
+	}
+
+	for( t=0; t<nSamples; t++ )
+	{
+		for( l=0; l<DSP_BLOCK_CHANNELS; l++ ) { block[t][l] = w[t][l/DSP_BLOCK_WIDTH][l%DSP_BLOCK_WIDTH]; }
+	}
+} /* End DSP_Block_IIR */
+
+
+/*************************************************
+** FUNCTION: DSP_Block_Filter
+** VARIABLES:
+**		[I ]	CONTROL_TYPE		*p_control
+**		[IO]	DSP_STATE_TYPE	*p_dsp_state
+**		[IO]	float						block[][DSP_BLOCK_CHANNELS]
+**		[I ]	int							nSamples
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		The DSP stage of Pipeline_Update over a
+** 		block of any length: the FIR and IIR
+** 		filters as enabled in dsp_prms, then
+** 		DSP_Shift once per sample.
+*/
+void DSP_Block_Filter( CONTROL_TYPE			*p_control,
+											 DSP_STATE_TYPE		*p_dsp_state,
+											 float						block[][DSP_BLOCK_CHANNELS],
+											 int							nSamples )
+{
+	int start, n;
+
+	for( start=0; start<nSamples; start+=n )
+	{
+		n = ( nSamples-start<DSP_BLOCK_SIZE ) ? nSamples-start : DSP_BLOCK_SIZE;
+
+		if( p_control->dsp_prms.FIR_on==1 ){ DSP_Block_FIR( p_control, p_dsp_state, &block[start], n ); }
+		if( p_control->dsp_prms.IIR_on==1 ){ DSP_Block_IIR( p_control, p_dsp_state, &block[start], n ); }
+		p_dsp_state->head = ( ( p_dsp_state->head-n )%NTAPS + NTAPS )%NTAPS;
+	}
+} /* End DSP_Block_Filter */
+
+
+/*************************************************
+** FUNCTION: DSP_FIR_Kernel_Test
+** VARIABLES:
+**		[I ]	const float	(*p_input)[DSP_BLOCK_CHANNELS]
+**		[I ]	unsigned long	nSamples
+** RETURN:
+**		unsigned long	Number of outputs out of bounds
+** DESCRIPTION:
+** 		Run the three FIR kernels (DSP_FIR_KERNEL)
+** 		on every window of NTAPS samples of each
+** 		channel, whichever one is configured:
+** 			- UNROLL must match LOOP bit for bit
+** 			- FOLD must be within
+** 			  DSP_FIR_FOLD_MAX_ERROR*FLT_EPSILON*sum(|b[i]*x[i]|)
+** 			  of LOOP (the rounding of the sum)
+*/
+static unsigned long DSP_FIR_Kernel_Test( const float		(*p_input)[DSP_BLOCK_CHANNELS],
+																					unsigned long	nSamples )
+{
+	float x[NTAPS];
+	const float *b;
+	float loop, unroll, fold, scale, err, MaxErr = 0.0f;
+	unsigned long t, nUnroll = 0, nFold = 0;
+	int   c, i;
+
+	for( c=0; c<DSP_BLOCK_CHANNELS; c++ )
+	{
+		/* Accel - LPF, Gyro - HPF */
+		b = ( c<3 ) ? DSP_FIR_LPF_taps : DSP_FIR_HPF_taps;
+
+		for( t=NTAPS-1; t<nSamples; t++ )
+		{
+			/* x[i]=x[n-i], as in the FIR history */
+			for( i=0; i<NTAPS; i++ ) { x[i] = p_input[t-i][c]; }
+
+			loop  = 0.0f;
+			scale = 0.0f;
+			for( i=0; i<NTAPS; i++ )
+			{
+				loop  = loop + b[i]*x[i];
+				scale = scale + fabsf( b[i]*x[i] );
+			}
+			if( c<3 )
+			{
+				unroll = DSP_FIR_Kernel<NTAPS,DSP_FIR_LPF_taps,false>::Run( x );
+				fold   = DSP_FIR_Kernel<NTAPS,DSP_FIR_LPF_taps>::Run( x );
+			}
+			else
+			{
+				unroll = DSP_FIR_Kernel<NTAPS,DSP_FIR_HPF_taps,false>::Run( x );
+				fold   = DSP_FIR_Kernel<NTAPS,DSP_FIR_HPF_taps>::Run( x );
+			}
+
+			if( memcmp( &unroll, &loop, sizeof(float) )!=0 ) { nUnroll++; }
+
+			err = ( scale>0.0f ) ? fabsf( fold - loop )/( FLT_EPSILON*scale ) : fabsf( fold - loop );
+			if( err>MaxErr ) { MaxErr = err; }
+			if( err>DSP_FIR_FOLD_MAX_ERROR ) { nFold++; }
+		}
+	}
+
+	fprintf(stderr,"> FIR kernels (kernel %d in use): unroll %lu outputs differ from the loop, fold max error %.2f (bound %.2f) x eps x sum|b*x|, %lu over\n",
+		DSP_FIR_KERNEL, nUnroll, MaxErr, (double)DSP_FIR_FOLD_MAX_ERROR, nFold );
+
+	return nUnroll + nFold;
+} /* End DSP_FIR_Kernel_Test */
+
+
+/*************************************************
+** FUNCTION: Emulator_DSP_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	int					BlockSize
+** RETURN:
+**		int		0:Passed
+**					1:Block output differs
+**					-1:Failure
+** DESCRIPTION:
+** 		Filter the samples of a recording with
+** 		the FIR and IIR on, for each IIR bank
+** 		(the accel and gyro channels on different
+** 		banks), with FIR_Filter/IIR_Filter one
+** 		sample at a time and with DSP_Block_Filter
+** 		BlockSize samples at a time. The outputs
+** 		are compared bit for bit and the
+** 		throughput of both is reported.
+** 		The FIR kernels are checked first (see
+** 		DSP_FIR_Kernel_Test).
+*/
+int Emulator_DSP_Test( const char	*InputPath,
+											 int				BlockSize )
+{
+	CONTROL_TYPE      reader, init_control, control;
+	SENSOR_STATE_TYPE sensor;
+	DSP_STATE_TYPE    init_dsp, dsp;
+	float (*p_input)[DSP_BLOCK_CHANNELS] = NULL;
+	float (*p_ref)[DSP_BLOCK_CHANNELS];
+	float (*p_out)[DSP_BLOCK_CHANNELS];
+	unsigned long nSamples = 0, nAlloc = 0, nMismatch, nTotal = 0;
+	unsigned long t, start, n;
+	double StartTime, SampleTime = 0.0, BlockTime = 0.0;
+	int    bank, j;
+
+	/* Read the samples */
+	memset( &reader, 0, sizeof(reader) );
+	memset( &sensor, 0, sizeof(sensor) );
+	if( Emulator_Init( &reader, InputPath, NULL )==FALSE ) { return -1; }
+	while( TRUE )
+	{
+		Read_Sensors( &reader, &sensor );
+		if( reader.emu_data.EndOfFile==TRUE ) { break; }
+		if( nSamples==nAlloc )
+		{
+			nAlloc  = ( nAlloc==0 ) ? 4096 : 2*nAlloc;
+			p_input = (float (*)[DSP_BLOCK_CHANNELS])realloc( p_input, nAlloc*sizeof(*p_input) );
+			if( p_input==NULL ) { Emulator_Close( &reader ); return -1; }
+		}
+		for( j=0; j<3; j++ )
+		{
+			p_input[nSamples][j]   = sensor.accel[j];
+			p_input[nSamples][j+3] = sensor.gyro[j];
+		}
+		nSamples++;
+	}
+	Emulator_Close( &reader );
+	if( nSamples==0 ) { free( p_input ); return -1; }
+
+	p_ref = (float (*)[DSP_BLOCK_CHANNELS])malloc( nSamples*sizeof(*p_ref) );
+	p_out = (float (*)[DSP_BLOCK_CHANNELS])malloc( nSamples*sizeof(*p_out) );
+	if( p_ref==NULL || p_out==NULL ) { free( p_input ); free( p_ref ); free( p_out ); return -1; }
+
+	nTotal = DSP_FIR_Kernel_Test( p_input, nSamples );
+
+	memset( &init_control, 0, sizeof(init_control) );
+	DSP_Filter_Init( &init_control, &init_dsp );
+	init_control.dsp_prms.FIR_on = 1;
+	init_control.dsp_prms.IIR_on = 1;
+
+	for( bank=0; bank<DSP_NUM_BANKS; bank++ )
+	{
+		/* Accel on bank, gyro on the mirror bank
+		** (different section counts across the lanes) */
+		for( j=0; j<3; j++ )
+		{
+			init_control.dsp_prms.IIR_accel_bank[j] = bank;
+			init_control.dsp_prms.IIR_gyro_bank[j]  = DSP_NUM_BANKS-1-bank;
+		}
+
+		/* One sample at a time */
+		control = init_control;
+		dsp     = init_dsp;
+		StartTime = Emulator_Clock();
+		for( t=0; t<nSamples; t++ )
+		{
+			for( j=0; j<3; j++ )
+			{
+				sensor.accel[j] = p_input[t][j];
+				sensor.gyro[j]  = p_input[t][j+3];
+			}
+			FIR_Filter( &control, &dsp, &sensor );
+			IIR_Filter( &control, &dsp, &sensor );
+			DSP_Shift( &control, &dsp );
+			for( j=0; j<3; j++ )
+			{
+				p_ref[t][j]   = sensor.accel[j];
+				p_ref[t][j+3] = sensor.gyro[j];
+			}
+		}
+		SampleTime += Emulator_Clock() - StartTime;
+
+		/* Blocks */
+		control = init_control;
+		dsp     = init_dsp;
+		memcpy( p_out, p_input, nSamples*sizeof(*p_out) );
+		StartTime = Emulator_Clock();
+		for( start=0; start<nSamples; start+=n )
+		{
+			n = ( nSamples-start<(unsigned long)BlockSize ) ? nSamples-start : (unsigned long)BlockSize;
+			DSP_Block_Filter( &control, &dsp, &p_out[start], (int)n );
+		}
+		BlockTime += Emulator_Clock() - StartTime;
+
+		nMismatch = 0;
+		for( t=0; t<nSamples; t++ )
+		{
+			if( memcmp( p_ref[t], p_out[t], sizeof(p_ref[t]) )!=0 ) { nMismatch++; }
+		}
+		nTotal += nMismatch;
+
+		fprintf(stderr,"> Accel LPF %d (%d, %.2f), Gyro HPF %d (%d, %.2f): %lu samples differ\n",
+			bank, 2*g_dsp_LPF_banks[bank].nSections, g_dsp_LPF_banks[bank].cutoff,
+			DSP_NUM_BANKS-1-bank, 2*g_dsp_HPF_banks[DSP_NUM_BANKS-1-bank].nSections, g_dsp_HPF_banks[DSP_NUM_BANKS-1-bank].cutoff,
+			nMismatch );
+	}
+
+	fprintf(stderr,"> %lu samples x %d banks: per sample %.0f samples/sec, blocks of %d %.0f samples/sec\n",
+		nSamples, DSP_NUM_BANKS,
+		(SampleTime>0) ? nSamples*DSP_NUM_BANKS/SampleTime : 0.0, BlockSize,
+		(BlockTime>0)  ? nSamples*DSP_NUM_BANKS/BlockTime  : 0.0 );
+
+	free( p_input );
+	free( p_ref );
+	free( p_out );
+	return ( nTotal==0 ) ? 0 : 1;
+} /* End Emulator_DSP_Test */
+
+
+/*************************************************
+** FUNCTION: Emulator_DSP_Fixed_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	float				MaxError
+** RETURN:
+**		int		0:Passed
+**					1:Error over MaxError
+**					-1:Failure
+** DESCRIPTION:
+** 		Filter the samples of a recording with
+** 		the FIR and IIR on, for each IIR bank
+** 		(as Emulator_DSP_Test), in float
+** 		(FIR_Filter/IIR_Filter) and in fixed
+** 		point (DSP_Fixed_Filter). The maximum
+** 		and RMS difference of the fixed point
+** 		outputs (counts) are reported per bank,
+** 		the test fails if any difference is over
+** 		MaxError.
+*/
+int Emulator_DSP_Fixed_Test( const char	*InputPath,
+														 float			MaxError )
+{
+	CONTROL_TYPE      reader, init_control, control;
+	SENSOR_STATE_TYPE sensor, fixed;
+	DSP_STATE_TYPE    init_dsp, dsp, dsp_q;
+	SENSOR_STATE_TYPE *p_input = NULL;
+	unsigned long nSamples = 0, nAlloc = 0, t;
+	double SumSq, Error, MaxBank, MaxAll = 0.0;
+	int    bank, j;
+
+	/* Read the samples (float and raw) */
+	memset( &reader, 0, sizeof(reader) );
+	memset( &sensor, 0, sizeof(sensor) );
+	if( Emulator_Init( &reader, InputPath, NULL )==FALSE ) { return -1; }
+	while( TRUE )
+	{
+		Read_Sensors( &reader, &sensor );
+		if( reader.emu_data.EndOfFile==TRUE ) { break; }
+		if( nSamples==nAlloc )
+		{
+			nAlloc  = ( nAlloc==0 ) ? 4096 : 2*nAlloc;
+			p_input = (SENSOR_STATE_TYPE *)realloc( p_input, nAlloc*sizeof(*p_input) );
+			if( p_input==NULL ) { Emulator_Close( &reader ); return -1; }
+		}
+		p_input[nSamples++] = sensor;
+	}
+	Emulator_Close( &reader );
+	if( nSamples==0 ) { free( p_input ); return -1; }
+
+	memset( &init_control, 0, sizeof(init_control) );
+	DSP_Filter_Init( &init_control, &init_dsp );
+	init_control.dsp_prms.FIR_on = 1;
+	init_control.dsp_prms.IIR_on = 1;
+
+	for( bank=0; bank<DSP_NUM_BANKS; bank++ )
+	{
+		for( j=0; j<3; j++ )
+		{
+			init_control.dsp_prms.IIR_accel_bank[j] = bank;
+			init_control.dsp_prms.IIR_gyro_bank[j]  = DSP_NUM_BANKS-1-bank;
+		}
+
+		control = init_control;
+		dsp     = init_dsp;
+		dsp_q   = init_dsp;
+		SumSq   = 0.0;
+		MaxBank = 0.0;
+		for( t=0; t<nSamples; t++ )
+		{
+			sensor = p_input[t];
+			FIR_Filter( &control, &dsp, &sensor );
+			IIR_Filter( &control, &dsp, &sensor );
+			DSP_Shift( &control, &dsp );
+
+			fixed = p_input[t];
+			DSP_Fixed_Filter( &control, &dsp_q, &fixed );
+			DSP_Shift( &control, &dsp_q );
+
+			for( j=0; j<3; j++ )
+			{
+				Error    = fabs( (double)fixed.accel[j] - (double)sensor.accel[j] );
+				SumSq   += Error*Error;
+				MaxBank  = ( Error>MaxBank ) ? Error : MaxBank;
+				Error    = fabs( (double)fixed.gyro[j] - (double)sensor.gyro[j] );
+				SumSq   += Error*Error;
+				MaxBank  = ( Error>MaxBank ) ? Error : MaxBank;
+			}
+		}
+		MaxAll = ( MaxBank>MaxAll ) ? MaxBank : MaxAll;
+
+		fprintf(stderr,"> Accel LPF %d (%d, %.2f), Gyro HPF %d (%d, %.2f): max error %.4f, rms %.4f counts\n",
+			bank, 2*g_dsp_LPF_banks[bank].nSections, g_dsp_LPF_banks[bank].cutoff,
+			DSP_NUM_BANKS-1-bank, 2*g_dsp_HPF_banks[DSP_NUM_BANKS-1-bank].nSections, g_dsp_HPF_banks[DSP_NUM_BANKS-1-bank].cutoff,
+			MaxBank, sqrt( SumSq/(6.0*nSamples) ) );
+	}
+
+	fprintf(stderr,"> %lu samples x %d banks: max error %.4f counts (bound %.4f)\n",
+		nSamples, DSP_NUM_BANKS, MaxAll, MaxError );
+
+	free( p_input );
+	return ( MaxAll<=MaxError ) ? 0 : 1;
+} /* End Emulator_DSP_Fixed_Test */
@@ -0,0 +1,669 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Functions
+** DESCRIPTION:
+** 		This file contains the host (Linux) emulator functions.
+** 		These functions stand in for the hardware specific
+** 		functions (IMU#_Functions, HW_Functions) and allow
+** 		recorded data to be replayed through the real-time
+** 		algorithms.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* Serial port to the master (see COMM_* in Emulator_Config.h) */
+static EMULATOR_COMM_TYPE g_emu_comm;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Emulator_Init
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+**		[I ]	const char		*InputPath
+**		[I ]	const char		*OutputPath
+** RETURN:
+**		BOOL	1:Successful initialization
+**					0:Failure
+** DESCRIPTION:
+** 		Open the input recording and (optionally)
+** 		the output results file.
+** 		This is the emulator equivalent of Init_IMU.
+** 		The recording format is detected from the first
+** 		4 bytes: binary recordings (RECORDING_MAGIC) are
+** 		memory mapped, anything else is read as text.
+** 		The output file may be NULL, in which case
+** 		no per-sample results are written.
+*/
+bool Emulator_Init( CONTROL_TYPE	*p_control,
+										const char		*InputPath,
+										const char		*OutputPath )
+{
+	uint32_t magic = 0;
+
+	LOG_PRINTLN("> Initializing Emulator");
+
+	p_control->emu_data.timestamp      = 0;
+	p_control->emu_data.timestamp_raw  = 0;
+	p_control->emu_data.timestamp_wrap = 0;
+	p_control->emu_data.EndOfFile      = FALSE;
+	p_control->emu_data.nSamples       = 0;
+	p_control->emu_data.InputFormat    = EMU_FORMAT_CSV;
+	p_control->emu_data.p_map          = NULL;
+	p_control->emu_data.map_nBytes     = 0;
+	p_control->emu_data.p_header       = NULL;
+	p_control->emu_data.p_records      = NULL;
+	p_control->emu_data.p_sample       = NULL;
+	p_control->emu_data.RecordIndex    = 0;
+	p_control->emu_data.InputFID       = NULL;
+	p_control->emu_data.OutputFID      = NULL;
+
+	p_control->emu_data.InputFID = fopen( InputPath, "rb" );
+	if( p_control->emu_data.InputFID==NULL )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Init : Cant open input %s",InputPath);
+		return FALSE;
+	}
+
+	/* Detect the recording format */
+	if( fread( &magic, sizeof(magic), 1, p_control->emu_data.InputFID )==1 && magic==RECORDING_MAGIC )
+	{
+		fclose( p_control->emu_data.InputFID );
+		p_control->emu_data.InputFID = NULL;
+		if( Emulator_Map_Recording( p_control, InputPath )==FALSE ) { return FALSE; }
+	}
+	else
+	{
+		rewind( p_control->emu_data.InputFID );
+	}
+
+	if( OutputPath!=NULL )
+	{
+		p_control->emu_data.OutputFID = fopen( OutputPath, "w" );
+		if( p_control->emu_data.OutputFID==NULL )
+		{
+			LOG_PRINTLN("ERROR : Emulator_Init : Cant open output %s",OutputPath);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+} /* End Emulator_Init */
+
+
+/*************************************************
+** FUNCTION: Emulator_Map_Recording
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+**		[I ]	const char		*InputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Memory map a binary recording and validate
+** 		the header. The sensor parameters stored in
+** 		the header replace the compiled defaults.
+*/
+bool Emulator_Map_Recording( CONTROL_TYPE	*p_control,
+														 const char		*InputPath )
+{
+	int         fd;
+	struct stat st;
+	const RECORDING_HEADER_TYPE *p_header;
+
+	fd = open( InputPath, O_RDONLY );
+	if( fd<0 || fstat( fd, &st )!=0 )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Map_Recording : Cant open %s",InputPath);
+		if( fd>=0 ) { close( fd ); }
+		return FALSE;
+	}
+
+	if( (size_t)st.st_size<sizeof(RECORDING_HEADER_TYPE) )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Map_Recording : Truncated header %s",InputPath);
+		close( fd );
+		return FALSE;
+	}
+
+	p_control->emu_data.map_nBytes = (size_t)st.st_size;
+	p_control->emu_data.p_map = mmap( NULL, p_control->emu_data.map_nBytes, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( p_control->emu_data.p_map==MAP_FAILED )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Map_Recording : mmap failed %s",InputPath);
+		p_control->emu_data.p_map = NULL;
+		return FALSE;
+	}
+
+	/* We step through the records in order */
+	madvise( p_control->emu_data.p_map, p_control->emu_data.map_nBytes, MADV_SEQUENTIAL );
+
+	/* Validate the header */
+	p_header = (const RECORDING_HEADER_TYPE *)p_control->emu_data.p_map;
+	if( p_header->version!=RECORDING_VERSION
+	 || p_header->header_nBytes!=sizeof(RECORDING_HEADER_TYPE)
+	 || p_header->record_nBytes!=sizeof(RECORDING_SAMPLE_TYPE) )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Map_Recording : Unsupported version %d",p_header->version);
+		return FALSE;
+	}
+	if( p_header->nRecords > (p_control->emu_data.map_nBytes-sizeof(RECORDING_HEADER_TYPE))/sizeof(RECORDING_SAMPLE_TYPE) )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Map_Recording : Truncated recording %s",InputPath);
+		return FALSE;
+	}
+
+	p_control->emu_data.InputFormat = EMU_FORMAT_BINARY;
+	p_control->emu_data.p_header    = p_header;
+	p_control->emu_data.p_records   = (const RECORDING_SAMPLE_TYPE *)((const uint8_t *)p_header + p_header->header_nBytes);
+	p_control->emu_data.RecordIndex = 0;
+
+	/* Use the recorded sensor settings */
+	p_control->sensor_prms.gravity     = (int)p_header->gravity;
+	p_control->sensor_prms.sample_rate = (int)p_header->sample_rate;
+
+	LOG_PRINTLN("> Mapped %llu records (G:%.1f SR:%.1f A:%d G:%d)",
+		(unsigned long long)p_header->nRecords, p_header->gravity, p_header->sample_rate,
+		p_header->accel_fsr, p_header->gyro_fsr );
+
+	return TRUE;
+} /* End Emulator_Map_Recording */
+
+
+/*************************************************
+** FUNCTION: Emulator_Close
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Close the emulator input/output files
+*/
+void Emulator_Close( CONTROL_TYPE *p_control )
+{
+	if( p_control->emu_data.InputFID!=NULL )  { fclose( p_control->emu_data.InputFID ); }
+	if( p_control->emu_data.OutputFID!=NULL ) { fclose( p_control->emu_data.OutputFID ); }
+	if( p_control->emu_data.p_map!=NULL )     { munmap( p_control->emu_data.p_map, p_control->emu_data.map_nBytes ); }
+	p_control->emu_data.InputFID  = NULL;
+	p_control->emu_data.OutputFID = NULL;
+	p_control->emu_data.p_map     = NULL;
+	p_control->emu_data.p_header  = NULL;
+	p_control->emu_data.p_records = NULL;
+	p_control->emu_data.p_sample  = NULL;
+} /* End Emulator_Close */
+
+
+/*************************************************
+** FUNCTION: Read_Sensors
+** VARIABLES:
+**		[IO]	CONTROL_TYPE 			*p_control
+**		[IO]	SENSOR_STATE_TYPE *p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Read the next sample from the input recording.
+** 		Once the recording is exhausted, EndOfFile is set
+** 		and the sensor state is left untouched.
+*/
+void Read_Sensors( CONTROL_TYPE				*p_control,
+									 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	if( p_control->emu_data.InputFormat==EMU_FORMAT_BINARY ) { Read_Sensors_Binary( p_control, p_sensor_state ); }
+	else                                                     { Read_Sensors_Csv( p_control, p_sensor_state ); }
+} /* End Read_Sensors */
+
+
+/*************************************************
+** FUNCTION: Read_Sensors_Binary
+** VARIABLES:
+**		[IO]	CONTROL_TYPE 			*p_control
+**		[IO]	SENSOR_STATE_TYPE *p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Step to the next record of a memory mapped
+** 		binary recording. No data is copied other
+** 		than into the sensor state.
+*/
+void Read_Sensors_Binary( CONTROL_TYPE				*p_control,
+													SENSOR_STATE_TYPE		*p_sensor_state )
+{
+	const RECORDING_SAMPLE_TYPE *p_sample;
+
+	if( p_control->emu_data.RecordIndex>=p_control->emu_data.p_header->nRecords )
+	{
+		p_control->emu_data.EndOfFile = TRUE;
+		return;
+	}
+	p_sample = &p_control->emu_data.p_records[p_control->emu_data.RecordIndex++];
+
+	/* Unwrap the 32 bit micros() timestamp */
+	if( p_control->emu_data.nSamples>0 && p_sample->timestamp<p_control->emu_data.timestamp_raw )
+	{
+		p_control->emu_data.timestamp_wrap += 4294967296UL;
+	}
+	p_control->emu_data.timestamp_raw = p_sample->timestamp;
+	p_control->emu_data.timestamp     = p_control->emu_data.timestamp_wrap + p_sample->timestamp;
+
+	p_sensor_state->accel[0] = (float)p_sample->accel[0];
+	p_sensor_state->accel[1] = (float)p_sample->accel[1];
+	p_sensor_state->accel[2] = (float)p_sample->accel[2];
+	p_sensor_state->gyro[0]  = (float)p_sample->gyro[0];
+	p_sensor_state->gyro[1]  = (float)p_sample->gyro[1];
+	p_sensor_state->gyro[2]  = (float)p_sample->gyro[2];
+	memcpy( p_sensor_state->accel_raw, p_sample->accel, sizeof(p_sensor_state->accel_raw) );
+	memcpy( p_sensor_state->gyro_raw,  p_sample->gyro,  sizeof(p_sensor_state->gyro_raw) );
+
+	p_control->emu_data.p_sample = p_sample;
+	p_control->emu_data.nSamples++;
+} /* End Read_Sensors_Binary */
+
+
+/*************************************************
+** FUNCTION: Read_Sensors_Csv
+** VARIABLES:
+**		[IO]	CONTROL_TYPE 			*p_control
+**		[IO]	SENSOR_STATE_TYPE *p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Read the next sample from a text recording.
+** 		The recording is the text output of Debug_LogOut
+** 		in output mode 2:
+** 			timestamp,ax,ay,az,gx,gy,gz[,roll,pitch,yaw]
+** 		Any line which does not start with a digit (log
+** 		messages, headers) is skipped.
+*/
+void Read_Sensors_Csv( CONTROL_TYPE				*p_control,
+											 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	char  line[EMU_LINE_LENGTH];
+	char *p_str;
+	char *p_end;
+	int   i;
+
+	while( fgets( line, EMU_LINE_LENGTH, p_control->emu_data.InputFID )!=NULL )
+	{
+		if( !isdigit( (unsigned char)line[0] ) ) { continue; }
+
+		/* Timestamp (us) */
+		p_control->emu_data.timestamp = strtoul( line, &p_end, 10 );
+
+		/* Accel x/y/z then Gyro x/y/z */
+		p_str = p_end;
+		for( i=0; i<3; i++ )
+		{
+			if( *p_str==',' ) { p_str++; }
+			p_sensor_state->accel[i] = strtof( p_str, &p_end );
+			p_sensor_state->accel_raw[i] = (int16_t)lrintf( FCONSTRAIN( p_sensor_state->accel[i], -32768.0f, 32767.0f ) );
+			p_str = p_end;
+		}
+		for( i=0; i<3; i++ )
+		{
+			if( *p_str==',' ) { p_str++; }
+			p_sensor_state->gyro[i] = strtof( p_str, &p_end );
+			p_sensor_state->gyro_raw[i] = (int16_t)lrintf( FCONSTRAIN( p_sensor_state->gyro[i], -32768.0f, 32767.0f ) );
+			p_str = p_end;
+		}
+
+		p_control->emu_data.nSamples++;
+		return;
+	}
+
+	p_control->emu_data.EndOfFile = TRUE;
+} /* End Read_Sensors_Csv */
+
+
+/*************************************************
+** FUNCTION: Emulator_Convert_Recording
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	const char	*OutputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Convert a text recording into the binary
+** 		recording format (see Recording_Config.h).
+** 		The header stores the compiled sensor settings
+** 		and the sample rate measured from the timestamps.
+*/
+bool Emulator_Convert_Recording( const char *InputPath,
+																 const char *OutputPath )
+{
+	CONTROL_TYPE          control;
+	SENSOR_STATE_TYPE     sensor_state;
+	RECORDING_HEADER_TYPE header;
+	RECORDING_SAMPLE_TYPE sample;
+	FILE         *OutputFID;
+	unsigned long FirstTime = 0;
+	int i;
+
+	memset( &control, 0, sizeof(control) );
+	memset( &sensor_state, 0, sizeof(sensor_state) );
+	memset( &header, 0, sizeof(header) );
+	memset( &sample, 0, sizeof(sample) );
+
+	if( Emulator_Init( &control, InputPath, NULL )==FALSE ) { Emulator_Close( &control ); return FALSE; }
+	if( control.emu_data.InputFormat!=EMU_FORMAT_CSV )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Convert_Recording : %s is not a text recording",InputPath);
+		Emulator_Close( &control );
+		return FALSE;
+	}
+
+	OutputFID = fopen( OutputPath, "wb" );
+	if( OutputFID==NULL )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Convert_Recording : Cant open output %s",OutputPath);
+		Emulator_Close( &control );
+		return FALSE;
+	}
+
+	/* Header is re-written once the record count is known */
+	header.magic         = RECORDING_MAGIC;
+	header.version       = RECORDING_VERSION;
+	header.header_nBytes = sizeof(RECORDING_HEADER_TYPE);
+	header.record_nBytes = sizeof(RECORDING_SAMPLE_TYPE);
+	header.flags         = 0;
+	header.gravity       = GRAVITY;
+	header.sample_rate   = TIME_SR;
+	header.accel_fsr     = IMU_ACCEL_FSR;
+	header.gyro_fsr      = IMU_GYRO_FSR;
+	fwrite( &header, sizeof(header), 1, OutputFID );
+
+	while( TRUE )
+	{
+		Read_Sensors( &control, &sensor_state );
+		if( control.emu_data.EndOfFile==TRUE ) { break; }
+
+		if( header.nRecords==0 ) { FirstTime = control.emu_data.timestamp; }
+
+		sample.timestamp = (uint32_t)control.emu_data.timestamp;
+		for( i=0; i<3; i++ )
+		{
+			sample.accel[i] = (int16_t)FCONSTRAIN( sensor_state.accel[i], -32768.0f, 32767.0f );
+			sample.gyro[i]  = (int16_t)FCONSTRAIN( sensor_state.gyro[i],  -32768.0f, 32767.0f );
+		}
+		fwrite( &sample, sizeof(sample), 1, OutputFID );
+		header.nRecords++;
+	}
+
+	/* Measured sample rate */
+	if( header.nRecords>1 && control.emu_data.timestamp>FirstTime )
+	{
+		header.sample_rate = (float)( (header.nRecords-1)*TIME_RESOLUTION/(control.emu_data.timestamp-FirstTime) );
+	}
+
+	fseek( OutputFID, 0, SEEK_SET );
+	fwrite( &header, sizeof(header), 1, OutputFID );
+	fclose( OutputFID );
+	Emulator_Close( &control );
+
+	LOG_PRINTLN("> Converted %llu records (SR:%.1f)",(unsigned long long)header.nRecords,header.sample_rate);
+	return TRUE;
+} /* End Emulator_Convert_Recording */
+
+
+/*************************************************
+** FUNCTION: Emulator_LogOut
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[I ]	SENSOR_STATE_TYPE	*p_sensor_state
+**		[I ]	GAPA_STATE_TYPE		*p_gapa_state
+**		[I ]	WISE_STATE_TYPE		*p_wise_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Write the per-sample results to the output file.
+** 		This is the emulator equivalent of Debug_LogOut.
+** 		Columns:
+** 			timestamp,roll,pitch,yaw,nu_normalized,vel_ave,incline
+*/
+void Emulator_LogOut( CONTROL_TYPE				*p_control,
+											SENSOR_STATE_TYPE		*p_sensor_state,
+											GAPA_STATE_TYPE			*p_gapa_state,
+											WISE_STATE_TYPE			*p_wise_state )
+{
+	if( p_control->emu_data.OutputFID==NULL ) { return; }
+
+	fprintf( p_control->emu_data.OutputFID, "%lu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+		p_control->timestamp,
+		TO_DEG(Orientation_Roll( p_control, p_sensor_state )), TO_DEG(p_sensor_state->pitch), TO_DEG(Orientation_Yaw( p_control, p_sensor_state )),
+		p_gapa_state->nu_normalized,
+		p_wise_state->vel_ave[0], p_wise_state->Incline_ave );
+} /* End Emulator_LogOut */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Reset
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty both communication queues
+*/
+void Emulator_Comm_Reset( void )
+{
+	memset( &g_emu_comm, 0, sizeof(g_emu_comm) );
+} /* End Emulator_Comm_Reset */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Send
+** VARIABLES:
+**		[I ]	const uint8_t	*p_bytes
+**		[I ]	int						nBytes
+** RETURN:
+**		int		Number of bytes queued
+** DESCRIPTION:
+** 		Queue request bytes from the master,
+** 		to be read by the sketch (COMM_READ).
+** 		Bytes which do not fit are dropped,
+** 		as the serial port would.
+*/
+int Emulator_Comm_Send( const uint8_t	*p_bytes,
+												int						nBytes )
+{
+	int i;
+
+	for( i=0; i<nBytes; i++ )
+	{
+		if( g_emu_comm.rx_head-g_emu_comm.rx_tail>=EMU_COMM_BUFFER ) { break; }
+		g_emu_comm.rx[g_emu_comm.rx_head%EMU_COMM_BUFFER] = p_bytes[i];
+		g_emu_comm.rx_head++;
+	}
+	return i;
+} /* End Emulator_Comm_Send */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Receive
+** VARIABLES:
+**		[O ]	uint8_t	*p_bytes
+**		[I ]	int			MaxBytes
+** RETURN:
+**		int		Number of bytes returned
+** DESCRIPTION:
+** 		Take the response bytes written by
+** 		the sketch (COMM_WRITE/COMM_PRINT),
+** 		oldest first. p_bytes may be NULL to
+** 		discard them.
+*/
+int Emulator_Comm_Receive( uint8_t	*p_bytes,
+													 int			MaxBytes )
+{
+	int n = 0;
+
+	while( n<MaxBytes && g_emu_comm.tx_tail!=g_emu_comm.tx_head )
+	{
+		if( p_bytes!=NULL ) { p_bytes[n] = g_emu_comm.tx[g_emu_comm.tx_tail%EMU_COMM_BUFFER]; }
+		g_emu_comm.tx_tail++;
+		n++;
+	}
+	return n;
+} /* End Emulator_Comm_Receive */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Available
+** VARIABLES:
+**		NONE
+** RETURN:
+**		int		Number of request bytes waiting
+** DESCRIPTION:
+** 		Emulator equivalent of COMM_PORT.available()
+*/
+int Emulator_Comm_Available( void )
+{
+	return (int)( g_emu_comm.rx_head-g_emu_comm.rx_tail );
+} /* End Emulator_Comm_Available */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Read
+** VARIABLES:
+**		NONE
+** RETURN:
+**		int		Next request byte, -1 if none
+** DESCRIPTION:
+** 		Emulator equivalent of COMM_PORT.read()
+*/
+int Emulator_Comm_Read( void )
+{
+	if( g_emu_comm.rx_tail==g_emu_comm.rx_head ) { return -1; }
+	return g_emu_comm.rx[(g_emu_comm.rx_tail++)%EMU_COMM_BUFFER];
+} /* End Emulator_Comm_Read */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Write
+** VARIABLES:
+**		[I ]	const uint8_t	*p_bytes
+**		[I ]	size_t				nBytes
+** RETURN:
+**		size_t	Number of bytes written
+** DESCRIPTION:
+** 		Emulator equivalent of COMM_PORT.write().
+** 		When the tx queue is full the oldest
+** 		unread bytes are overwritten.
+*/
+size_t Emulator_Comm_Write( const uint8_t	*p_bytes,
+														size_t				nBytes )
+{
+	size_t i;
+
+	for( i=0; i<nBytes; i++ )
+	{
+		g_emu_comm.tx[g_emu_comm.tx_head%EMU_COMM_BUFFER] = p_bytes[i];
+		g_emu_comm.tx_head++;
+		if( g_emu_comm.tx_head-g_emu_comm.tx_tail>EMU_COMM_BUFFER ) { g_emu_comm.tx_tail++; }
+	}
+	g_emu_comm.tx_nBytes += nBytes;
+	return nBytes;
+} /* End Emulator_Comm_Write */
+
+
+/*************************************************
+** FUNCTION: Emulator_Comm_Print
+** VARIABLES:
+**		[I ]	char / uint8_t	c
+** RETURN:
+**		size_t	Number of bytes written
+** DESCRIPTION:
+** 		Emulator equivalent of COMM_PORT.print().
+** 		As on the Arduino, a char is sent as is
+** 		and a uint8_t is sent as decimal text.
+*/
+size_t Emulator_Comm_Print( char c )
+{
+	return Emulator_Comm_Write( (const uint8_t*)&c, 1 );
+} /* End Emulator_Comm_Print */
+
+size_t Emulator_Comm_Print( uint8_t c )
+{
+	char text[4];
+	int  n = snprintf( text, sizeof(text), "%u", (unsigned int)c );
+	return Emulator_Comm_Write( (const uint8_t*)text, (size_t)n );
+} /* End Emulator_Comm_Print */
+
+
+/*************************************************
+** FUNCTION: delay
+** VARIABLES:
+**		[I ]	unsigned long	ms
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Stand-in for the Arduino delay().
+** 		The emulator does not run in real time
+** 		and queued requests are available at
+** 		once, so there is nothing to wait for.
+*/
+void delay( unsigned long ms )
+{
+	(void)ms;
+} /* End delay */
+
+
+/*************************************************
+** FUNCTION: Emulator_Clock
+** VARIABLES:
+**		NONE
+** RETURN:
+**		double	Monotonic wall time (s)
+** DESCRIPTION:
+** 		Used to measure emulator throughput
+*/
+double Emulator_Clock( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( (double)ts.tv_sec + (double)ts.tv_nsec*1.0e-9 );
+} /* End Emulator_Clock */
+
+
+/*************************************************
+** FUNCTION: Emulator_Micros
+** VARIABLES:
+**		NONE
+** RETURN:
+**		unsigned long	Monotonic wall time (us)
+** DESCRIPTION:
+** 		Stand-in for the Arduino micros(),
+** 		used by the profiler (PROFILE_TIME).
+** 		Wraps at 32 bits as on the target.
+*/
+unsigned long Emulator_Micros( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (unsigned long)(uint32_t)( (uint64_t)ts.tv_sec*1000000ULL + (uint64_t)ts.tv_nsec/1000 );
+} /* End Emulator_Micros */
@@ -0,0 +1,251 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_MPU9250
+** DESCRIPTION:
+** 		This file contains a host (Linux) stand-in for the
+** 		MPU-9250 FIFO registers, used to test FIFO acquisition
+** 		(ACQ_MODE_INTERRUPT/FIFO, see Acq_FIFO_Read) without the
+** 		device. Samples are written to the FIFO with
+** 		Emulator_MPU_Sample as the device would at each sample
+** 		instant, and read through Emulator_MPU_Read in place of
+** 		the I2C bus (see ACQ_FIFO_READ in Emulator_Config.h).
+** 		Each access holds a lock, as each register access is
+** 		atomic on the device, so the samples can be written
+** 		from another thread (WISE_Emulator -a).
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <mutex>
+
+/* Only link if using IMU9250 */
+#ifdef _IMU9250_
+
+
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* MPU-9250 FIFO registers (see ACQ_FIFO_* in Emulator_Config.h) */
+static EMULATOR_MPU_TYPE g_emu_mpu;
+static std::mutex        g_emu_mpu_lock;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Reset
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty the FIFO and clear the counters
+*/
+void Emulator_MPU_Reset( void )
+{
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+
+	memset( &g_emu_mpu, 0, sizeof(g_emu_mpu) );
+} /* End Emulator_MPU_Reset */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Reset_FIFO
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Reset the FIFO read/write pointers,
+** 		as imu.resetFifo(). The frames in the
+** 		FIFO are lost.
+*/
+void Emulator_MPU_Reset_FIFO( void )
+{
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+
+	g_emu_mpu.nLost     += ( g_emu_mpu.fifo_head-g_emu_mpu.fifo_tail )/ACQ_FIFO_FRAME_SIZE;
+	g_emu_mpu.fifo_tail  = g_emu_mpu.fifo_head;
+	g_emu_mpu.int_status = 0;
+	g_emu_mpu.nTransactions++;
+} /* End Emulator_MPU_Reset_FIFO */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Sample
+** VARIABLES:
+**		[I ]	const ACQ_SAMPLE_TYPE	*p_sample
+** RETURN:
+**		BOOL	1:Frame written
+**					0:FIFO overflow, oldest frame lost
+** DESCRIPTION:
+** 		Write one accel/gyro frame to the FIFO
+** 		(big endian, accel then gyro), as the
+** 		device does at each sample instant.
+*/
+bool Emulator_MPU_Sample( const ACQ_SAMPLE_TYPE *p_sample )
+{
+	unsigned long frame;
+	uint8_t *p_frame;
+	bool ret = TRUE;
+	int i;
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+
+	if( g_emu_mpu.fifo_head-g_emu_mpu.fifo_tail>=sizeof(g_emu_mpu.fifo) )
+	{
+		g_emu_mpu.fifo_tail  += ACQ_FIFO_FRAME_SIZE;
+		g_emu_mpu.int_status |= IMU_INT_FIFO_OFLOW;
+		g_emu_mpu.nLost++;
+		ret = FALSE;
+	}
+
+	frame   = ( g_emu_mpu.fifo_head/ACQ_FIFO_FRAME_SIZE ) % EMU_MPU_FIFO_FRAMES;
+	p_frame = &g_emu_mpu.fifo[frame*ACQ_FIFO_FRAME_SIZE];
+	for( i=0; i<3; i++ )
+	{
+		p_frame[2*i]     = (uint8_t)( (uint16_t)p_sample->accel[i]>>8 );
+		p_frame[2*i+1]   = (uint8_t)( (uint16_t)p_sample->accel[i] );
+		p_frame[2*i+6]   = (uint8_t)( (uint16_t)p_sample->gyro[i]>>8 );
+		p_frame[2*i+7]   = (uint8_t)( (uint16_t)p_sample->gyro[i] );
+	}
+	g_emu_mpu.fifo_time[frame] = p_sample->timestamp;
+
+	g_emu_mpu.fifo_head += ACQ_FIFO_FRAME_SIZE;
+	g_emu_mpu.nSampled++;
+	return ret;
+} /* End Emulator_MPU_Sample */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Read
+** VARIABLES:
+**		[I ]	unsigned char	reg
+**		[I ]	unsigned char	length
+**		[O ]	unsigned char	*p_data
+** RETURN:
+**		int		0:Successful
+**					-1:Unsupported register
+** DESCRIPTION:
+** 		One I2C register read, as arduino_i2c_read.
+** 		Supports FIFO_COUNTH (2 bytes, high first),
+** 		INT_STATUS (cleared on read) and FIFO_R_W.
+** 		Reading FIFO_R_W past the end of the FIFO
+** 		returns 0xFF.
+*/
+int Emulator_MPU_Read( unsigned char	reg,
+											 unsigned char	length,
+											 unsigned char	*p_data )
+{
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+	unsigned long count = g_emu_mpu.fifo_head - g_emu_mpu.fifo_tail;
+	int i;
+
+	g_emu_mpu.nTransactions++;
+	g_emu_mpu.nBytes += length;
+
+	switch( reg )
+	{
+		case IMU_FIFO_COUNTH:
+			p_data[0] = (uint8_t)( count>>8 );
+			if( length>1 ) { p_data[1] = (uint8_t)count; }
+			return 0;
+
+		case IMU_INT_STATUS:
+			p_data[0] = g_emu_mpu.int_status;
+			g_emu_mpu.int_status = 0;
+			return 0;
+
+		case IMU_FIFO_R_W:
+			for( i=0; i<length; i++ )
+			{
+				if( g_emu_mpu.fifo_tail==g_emu_mpu.fifo_head ) { p_data[i] = 0xFF; continue; }
+				p_data[i] = g_emu_mpu.fifo[g_emu_mpu.fifo_tail % sizeof(g_emu_mpu.fifo)];
+				g_emu_mpu.fifo_tail++;
+
+				/* Frame complete, keep its timestamp for checking */
+				if( g_emu_mpu.fifo_tail%ACQ_FIFO_FRAME_SIZE==0 )
+				{
+					g_emu_mpu.read_time[g_emu_mpu.read_head%EMU_MPU_FIFO_FRAMES] =
+						g_emu_mpu.fifo_time[( g_emu_mpu.fifo_tail/ACQ_FIFO_FRAME_SIZE-1 ) % EMU_MPU_FIFO_FRAMES];
+					g_emu_mpu.read_head++;
+				}
+			}
+			return 0;
+
+		default:
+			return -1;
+	}
+} /* End Emulator_MPU_Read */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Read_Time
+** VARIABLES:
+**		[O ]	uint32_t	*p_timestamp
+** RETURN:
+**		BOOL	1:Timestamp returned
+**					0:No frame read out
+** DESCRIPTION:
+** 		Sampled timestamp of the next frame read
+** 		out of the FIFO, in the order read.
+*/
+bool Emulator_MPU_Read_Time( uint32_t *p_timestamp )
+{
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+
+	if( g_emu_mpu.read_tail==g_emu_mpu.read_head ) { return FALSE; }
+
+	*p_timestamp = g_emu_mpu.read_time[g_emu_mpu.read_tail%EMU_MPU_FIFO_FRAMES];
+	g_emu_mpu.read_tail++;
+	return TRUE;
+} /* End Emulator_MPU_Read_Time */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_Frames
+** VARIABLES:
+**		NONE
+** RETURN:
+**		unsigned long	Frames in the FIFO
+** DESCRIPTION:
+** 		Used by an unpaced producer to wait for
+** 		room rather than overflow the FIFO
+*/
+unsigned long Emulator_MPU_Frames( void )
+{
+	std::lock_guard<std::mutex> guard( g_emu_mpu_lock );
+
+	return ( g_emu_mpu.fifo_head - g_emu_mpu.fifo_tail )/ACQ_FIFO_FRAME_SIZE;
+} /* End Emulator_MPU_Frames */
+
+
+/*************************************************
+** FUNCTION: Emulator_MPU_State
+** VARIABLES:
+**		NONE
+** RETURN:
+**		const EMULATOR_MPU_TYPE*	FIFO registers
+**															and counters
+** DESCRIPTION:
+** 		Used to report the bus traffic, once
+** 		no other thread writes the FIFO
+*/
+const EMULATOR_MPU_TYPE *Emulator_MPU_State( void )
+{
+	return &g_emu_mpu;
+} /* End Emulator_MPU_State */
+
+#endif /* End _IMU9250_ */
@@ -0,0 +1,260 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Phase
+** DESCRIPTION:
+** 		This file contains the replay test of the FES trigger
+** 		latency. A recording is replayed through the pipeline
+** 		and a trigger fires when the phase angle crosses the
+** 		trigger phase, once on nu_normalized (current phase)
+** 		and once on nu_predicted (GaPA_Predict). The relay
+** 		switches EMU_FES_RELAY_DELAY_MS after the trigger.
+** 		Each relay switch is compared to the time the gait
+** 		actually crossed the trigger phase: the label phase
+** 		if the labels have one, otherwise nu_normalized
+** 		interpolated between samples.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/* Event times (us) */
+typedef struct
+{
+	unsigned long nEvents;
+	unsigned long nAlloc;
+	double       *time;
+} PHASE_EVENTS_TYPE;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Phase_Test_Crossing
+** VARIABLES:
+**		[I ]	float		prev
+**		[I ]	float		cur
+**		[I ]	float		Phase
+**		[O ]	double	*p_frac
+** RETURN:
+**		BOOL	1:Phase crossed between prev and cur
+**					0:Not crossed
+** DESCRIPTION:
+** 		Forward crossing of Phase from prev to
+** 		cur, across the wrap if needed. Steps of
+** 		half a stride or more are not crossings
+** 		(restarts, not motion). p_frac is where
+** 		the crossing is, from 0 (prev) to 1 (cur).
+*/
+static bool Phase_Test_Crossing( float		prev,
+																 float		cur,
+																 float		Phase,
+																 double	*p_frac )
+{
+	float d, a;
+
+	d = cur - prev;
+	if( d<0.0f ) { d += 1.0f; }
+	if( d<=0.0f || d>=0.5f ) { return FALSE; }
+
+	a = Phase - prev;
+	if( a<=0.0f ) { a += 1.0f; }
+	if( a>d ) { return FALSE; }
+
+	*p_frac = a/d;
+	return TRUE;
+} /* End Phase_Test_Crossing */
+
+
+/*************************************************
+** FUNCTION: Phase_Test_Add
+** VARIABLES:
+**		[IO]	PHASE_EVENTS_TYPE	*p_events
+**		[I ]	double						time
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Append an event time (us)
+*/
+static void Phase_Test_Add( PHASE_EVENTS_TYPE	*p_events,
+														double						time )
+{
+	if( p_events->nEvents==p_events->nAlloc )
+	{
+		p_events->nAlloc = ( p_events->nAlloc==0 ) ? 256 : 2*p_events->nAlloc;
+		p_events->time   = (double *)realloc( p_events->time, p_events->nAlloc*sizeof(double) );
+	}
+	p_events->time[ p_events->nEvents++ ] = time;
+} /* End Phase_Test_Add */
+
+
+/*************************************************
+** FUNCTION: Phase_Test_Report
+** VARIABLES:
+**		[I ]	const char								*Name
+**		[I ]	const PHASE_EVENTS_TYPE	*p_ref
+**		[I ]	const PHASE_EVENTS_TYPE	*p_trig
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Match each reference event to the
+** 		nearest relay switch (trigger plus
+** 		EMU_FES_RELAY_DELAY_MS) within
+** 		EMU_FES_MATCH_MS, and report the
+** 		latency of the switches (ms, positive
+** 		is late) and the unmatched events.
+*/
+static void Phase_Test_Report( const char								*Name,
+															 const PHASE_EVENTS_TYPE	*p_ref,
+															 const PHASE_EVENTS_TYPE	*p_trig )
+{
+	unsigned long i, j = 0, nMatched = 0;
+	double Latency, Best, Sum = 0.0, SumSq = 0.0, Min = 0.0, Max = 0.0, Mean, Std;
+
+	for( i=0; i<p_ref->nEvents; i++ )
+	{
+		/* Triggers are sorted, move to the nearest */
+		while( j+1<p_trig->nEvents &&
+					 fabs( p_trig->time[j+1] - p_ref->time[i] )<=fabs( p_trig->time[j] - p_ref->time[i] ) ) { j++; }
+		if( p_trig->nEvents==0 ) { break; }
+
+		Best = p_trig->time[j] - p_ref->time[i];
+		if( fabs( Best )>EMU_FES_MATCH_MS*1000.0 ) { continue; }
+
+		Latency = Best/1000.0 + EMU_FES_RELAY_DELAY_MS;
+		Min     = ( nMatched==0 || Latency<Min ) ? Latency : Min;
+		Max     = ( nMatched==0 || Latency>Max ) ? Latency : Max;
+		Sum    += Latency;
+		SumSq  += Latency*Latency;
+		nMatched++;
+	}
+
+	if( nMatched==0 )
+	{
+		fprintf(stderr,"> %-13s : %lu triggers, no reference event matched\n", Name, p_trig->nEvents );
+		return;
+	}
+	Mean = Sum/nMatched;
+	Std  = SumSq/nMatched - Mean*Mean;
+	Std  = ( Std>0.0 ) ? sqrt( Std ) : 0.0;
+	fprintf(stderr,"> %-13s : %lu/%lu events matched (%lu triggers), latency mean %.1f, std %.1f, min %.1f, max %.1f ms\n",
+		Name, nMatched, p_ref->nEvents, p_trig->nEvents, Mean, Std, Min, Max );
+} /* End Phase_Test_Report */
+
+
+/*************************************************
+** FUNCTION: Emulator_Phase_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	float				Phase
+**		[I ]	const char	*LabelsPath
+** RETURN:
+**		int		0:Done
+**					-1:Failure
+** DESCRIPTION:
+** 		Replay a recording and report the relay
+** 		latency of the triggers on nu_normalized
+** 		and on nu_predicted at the trigger Phase.
+** 		LabelsPath may be NULL (the reference is
+** 		then nu_normalized itself, so only the
+** 		sampling and relay delays are measured
+** 		for the nu_normalized trigger).
+*/
+int Emulator_Phase_Test( const char	*InputPath,
+												 float			Phase,
+												 const char	*LabelsPath )
+{
+	PIPELINE_STATE_TYPE *p_pipeline;
+	SWEEP_LABELS_TYPE    labels;
+	PHASE_EVENTS_TYPE    ref, trig_norm, trig_pred;
+	GAPA_STATE_TYPE     *p_gapa;
+	bool   UseLabels = FALSE;
+	float  prev_norm = 0.0f, prev_pred = 0.0f;
+	double frac, time, time_old = 0.0;
+	unsigned long i;
+	int    ret = 0;
+
+	memset( &labels, 0, sizeof(labels) );
+	memset( &ref, 0, sizeof(ref) );
+	memset( &trig_norm, 0, sizeof(trig_norm) );
+	memset( &trig_pred, 0, sizeof(trig_pred) );
+
+	if( LabelsPath!=NULL )
+	{
+		if( Sweep_Read_Labels( LabelsPath, &labels )==FALSE ) { return -1; }
+		for( i=1; i<labels.nLabels; i++ )
+		{
+			if( isnan( labels.phase[i-1] ) || isnan( labels.phase[i] ) ) { continue; }
+			if( Phase_Test_Crossing( labels.phase[i-1], labels.phase[i], Phase, &frac ) )
+			{
+				Phase_Test_Add( &ref, labels.timestamp[i-1] + frac*( (double)labels.timestamp[i] - labels.timestamp[i-1] ) );
+			}
+		}
+		UseLabels = ( ref.nEvents>0 ) ? TRUE : FALSE;
+		if( UseLabels==FALSE ) { LOG_PRINTLN("> Emulator_Phase_Test : No phase in %s, reference is nu_normalized",LabelsPath); }
+	}
+
+	p_pipeline = new PIPELINE_STATE_TYPE();
+	if( setup( p_pipeline, InputPath, NULL )==FALSE )
+	{
+		ret = -1;
+	}
+	else
+	{
+		p_gapa = &p_pipeline->gapa_state;
+		while( TRUE )
+		{
+			Read_Sensors( &p_pipeline->control, &p_pipeline->sensor_state );
+			if( p_pipeline->control.emu_data.EndOfFile==TRUE ) { break; }
+			Pipeline_Update( p_pipeline );
+			time = (double)p_pipeline->control.timestamp;
+
+			if( prev_norm>0.0f && p_gapa->nu_normalized>0.0f &&
+					Phase_Test_Crossing( prev_norm, p_gapa->nu_normalized, Phase, &frac ) )
+			{
+				Phase_Test_Add( &trig_norm, time );
+				if( UseLabels==FALSE ) { Phase_Test_Add( &ref, time_old + frac*( time - time_old ) ); }
+			}
+			if( prev_pred>0.0f && p_gapa->nu_predicted>0.0f &&
+					Phase_Test_Crossing( prev_pred, p_gapa->nu_predicted, Phase, &frac ) )
+			{
+				Phase_Test_Add( &trig_pred, time );
+			}
+			prev_norm = p_gapa->nu_normalized;
+			prev_pred = p_gapa->nu_predicted;
+			time_old  = time;
+		}
+
+		fprintf(stderr,"> Trigger phase %.3f, relay delay %.1f ms, prediction %.1f ms, %lu reference events (%s)\n",
+			Phase, (double)EMU_FES_RELAY_DELAY_MS, p_pipeline->control.gapa_prms.predict_time*1000.0,
+			ref.nEvents, ( UseLabels==TRUE ) ? "labels" : "nu_normalized" );
+		Phase_Test_Report( "nu_normalized", &ref, &trig_norm );
+		Phase_Test_Report( "nu_predicted", &ref, &trig_pred );
+	}
+	Emulator_Close( &p_pipeline->control );
+
+	free( ref.time );
+	free( trig_norm.time );
+	free( trig_pred.time );
+	free( labels.timestamp );
+	free( labels.speed );
+	free( labels.incline );
+	free( labels.phase );
+	delete p_pipeline;
+	return ret;
+} /* End Emulator_Phase_Test */
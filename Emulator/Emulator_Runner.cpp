@@ -0,0 +1,274 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Runner
+** DESCRIPTION:
+** 		This file contains the parallel replay runner for the
+** 		host (Linux) emulator. A set of recordings is replayed
+** 		across a pool of worker threads, each worker owning its
+** 		own pipeline instance (PIPELINE_STATE_TYPE).
+** 		Recordings are dealt out to per-worker queues, largest
+** 		first. A worker takes jobs from the front of its own
+** 		queue and, once it is empty, steals from the back of
+** 		the other workers' queues, so a few long recordings do
+** 		not leave the rest of the pool idle.
+** 		Each recording is replayed from a freshly initialized
+** 		pipeline, so the results are identical to replaying
+** 		the recordings one at a time.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/*
+** TYPE: RUNNER_QUEUE_TYPE
+** Per-worker job queue (indices into the recording list).
+** The owner pops from the front, thieves pop from the back */
+typedef struct
+{
+	std::mutex      lock;
+	std::deque<int> jobs;
+} RUNNER_QUEUE_TYPE;
+
+/*
+** TYPE: RUNNER_JOB_TYPE
+** A single recording and its replay results */
+typedef struct
+{
+	std::string   InputPath;
+	std::string   OutputPath;
+	long          nBytes;
+	bool          Success;
+	unsigned long nSamples;
+	double        ElapsedTime;
+} RUNNER_JOB_TYPE;
+
+/*
+** TYPE: RUNNER_TYPE
+** Shared state of the runner */
+typedef struct
+{
+	std::vector<RUNNER_JOB_TYPE>   job;
+	std::deque<RUNNER_QUEUE_TYPE>  queue; /* deque: mutexes cannot move */
+	std::vector<unsigned long>     nStolen;
+} RUNNER_TYPE;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Runner_Next_Job
+** VARIABLES:
+**		[IO]	RUNNER_TYPE	*p_runner
+**		[I ]	int					WorkerId
+** RETURN:
+**		int		Index of the next job, -1 if none left
+** DESCRIPTION:
+** 		Take the next job from the worker's own
+** 		queue, or steal one from another worker.
+** 		No jobs are added once the workers start,
+** 		so a full pass finding every queue empty
+** 		means the run is complete.
+*/
+int Runner_Next_Job( RUNNER_TYPE	*p_runner,
+										 int					WorkerId )
+{
+	int nWorkers = (int)p_runner->queue.size();
+	int i, victim, JobId;
+
+	/* Own queue */
+	{
+		std::lock_guard<std::mutex> guard( p_runner->queue[WorkerId].lock );
+		if( !p_runner->queue[WorkerId].jobs.empty() )
+		{
+			JobId = p_runner->queue[WorkerId].jobs.front();
+			p_runner->queue[WorkerId].jobs.pop_front();
+			return JobId;
+		}
+	}
+
+	/* Steal */
+	for( i=1; i<nWorkers; i++ )
+	{
+		victim = (WorkerId+i) % nWorkers;
+		std::lock_guard<std::mutex> guard( p_runner->queue[victim].lock );
+		if( !p_runner->queue[victim].jobs.empty() )
+		{
+			JobId = p_runner->queue[victim].jobs.back();
+			p_runner->queue[victim].jobs.pop_back();
+			p_runner->nStolen[WorkerId]++;
+			return JobId;
+		}
+	}
+
+	return -1;
+} /* End Runner_Next_Job */
+
+
+/*************************************************
+** FUNCTION: Runner_Worker
+** VARIABLES:
+**		[IO]	RUNNER_TYPE	*p_runner
+**		[I ]	int					WorkerId
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Worker thread body. Replays jobs through
+** 		the worker's own pipeline instance until
+** 		no jobs remain.
+*/
+void Runner_Worker( RUNNER_TYPE	*p_runner,
+										int					WorkerId )
+{
+	PIPELINE_STATE_TYPE *p_pipeline = new PIPELINE_STATE_TYPE();
+	RUNNER_JOB_TYPE     *p_job;
+	double StartTime;
+	int    JobId;
+
+	while( (JobId=Runner_Next_Job( p_runner, WorkerId ))>=0 )
+	{
+		p_job = &p_runner->job[JobId];
+
+		/* Start every recording from a clean state */
+		memset( p_pipeline, 0, sizeof(PIPELINE_STATE_TYPE) );
+
+		StartTime = Emulator_Clock();
+		p_job->Success = Emulator_Replay( p_pipeline, p_job->InputPath.c_str(),
+		                                  p_job->OutputPath.empty() ? NULL : p_job->OutputPath.c_str() );
+		p_job->ElapsedTime = Emulator_Clock() - StartTime;
+		p_job->nSamples    = p_pipeline->control.emu_data.nSamples;
+	}
+
+	delete p_pipeline;
+} /* End Runner_Worker */
+
+
+/*************************************************
+** FUNCTION: Emulator_Run_Parallel
+** VARIABLES:
+**		[I ]	char				**InputPaths
+**		[I ]	int					nInputs
+**		[I ]	const char	*OutputDir
+**		[I ]	int					nWorkers
+** RETURN:
+**		int		Number of recordings which failed
+** DESCRIPTION:
+** 		Replay a set of recordings in parallel.
+** 		The results for each recording are written to
+** 		OutputDir/<recording name>.out (none if OutputDir
+** 		is NULL). Recordings with the same name (e.g. from
+** 		different directories) are written to
+** 		OutputDir/<input index>_<recording name>.out, so no
+** 		two jobs write the same file.
+** 		nWorkers<=0 uses one worker per core.
+*/
+int Emulator_Run_Parallel( char				**InputPaths,
+													 int				nInputs,
+													 const char	*OutputDir,
+													 int				nWorkers )
+{
+	RUNNER_TYPE runner;
+	std::vector<std::thread> workers;
+	std::vector<int> order;
+	std::vector<std::string> names;
+	std::map<std::string,int> nNamed;
+	struct stat st;
+	std::string name;
+	unsigned long nSamples = 0, nStolen = 0;
+	double StartTime, ElapsedTime;
+	int i, nFailed = 0;
+
+	if( nWorkers<=0 ) { nWorkers = (int)std::thread::hardware_concurrency(); }
+	if( nWorkers<=0 ) { nWorkers = 1; }
+	if( nWorkers>nInputs ) { nWorkers = nInputs; }
+	if( nWorkers<=0 ) { return 0; }
+
+	/* Build the job list */
+	runner.job.resize( nInputs );
+	for( i=0; i<nInputs; i++ )
+	{
+		runner.job[i].InputPath   = InputPaths[i];
+		runner.job[i].nBytes      = ( stat( InputPaths[i], &st )==0 ) ? (long)st.st_size : 0;
+		runner.job[i].Success     = FALSE;
+		runner.job[i].nSamples    = 0;
+		runner.job[i].ElapsedTime = 0.0;
+		name = InputPaths[i];
+		name = name.substr( name.find_last_of('/')+1 );
+		name = name.substr( 0, name.find_last_of('.') );
+		names.push_back( name );
+		nNamed[name]++;
+		order.push_back( i );
+	}
+
+	/* Output paths, prefixed with the input index
+	** where recording names collide */
+	if( OutputDir!=NULL )
+	{
+		for( i=0; i<nInputs; i++ )
+		{
+			name = names[i];
+			if( nNamed[name]>1 ) { name = std::to_string( i ) + "_" + name; }
+			runner.job[i].OutputPath = std::string(OutputDir) + "/" + name + ".out";
+		}
+	}
+
+	/* Deal out the jobs, largest first */
+	std::stable_sort( order.begin(), order.end(),
+		[&runner]( int a, int b ) { return runner.job[a].nBytes > runner.job[b].nBytes; } );
+	runner.queue.resize( nWorkers );
+	runner.nStolen.assign( nWorkers, 0 );
+	for( i=0; i<nInputs; i++ ) { runner.queue[i%nWorkers].jobs.push_back( order[i] ); }
+
+	LOG_PRINTLN("> Replaying %d recordings on %d workers",nInputs,nWorkers);
+
+	StartTime = Emulator_Clock();
+	for( i=0; i<nWorkers; i++ ) { workers.push_back( std::thread( Runner_Worker, &runner, i ) ); }
+	for( i=0; i<nWorkers; i++ ) { workers[i].join(); }
+	ElapsedTime = Emulator_Clock() - StartTime;
+
+	/* Report, in input order */
+	for( i=0; i<nInputs; i++ )
+	{
+		if( runner.job[i].Success==FALSE )
+		{
+			nFailed++;
+			fprintf(stderr,"> FAILED %s\n",runner.job[i].InputPath.c_str());
+			continue;
+		}
+		nSamples += runner.job[i].nSamples;
+		fprintf(stderr,"> %s: %lu samples in %.3f s\n",
+			runner.job[i].InputPath.c_str(), runner.job[i].nSamples, runner.job[i].ElapsedTime );
+	}
+	for( i=0; i<nWorkers; i++ ) { nStolen += runner.nStolen[i]; }
+
+	fprintf(stderr,"> Processed %d recordings (%lu samples) in %.3f s (%.0f samples/sec, %d workers, %lu stolen)\n",
+		nInputs-nFailed, nSamples, ElapsedTime,
+		(ElapsedTime>0) ? (nSamples/ElapsedTime) : 0.0, nWorkers, nStolen );
+
+	return nFailed;
+} /* End Emulator_Run_Parallel */
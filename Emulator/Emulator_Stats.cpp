@@ -0,0 +1,209 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Stats
+** DESCRIPTION:
+** 		This file contains the check of the sliding window
+** 		motion statistics (see Stats_Config.h) against a
+** 		brute force window. Each test signal is pushed one
+** 		sample at a time through Stats_Window_Push, and after
+** 		every push the window is read and compared with the
+** 		min, max, mean and sum of squares of the same samples,
+** 		rescanned in double precision. The signals include
+** 		monotone runs longer than the window (ramps up and
+** 		down, a triangle wave) and a constant, which fill the
+** 		min/max deques to the window length.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+
+/*******************************************************************
+** Defines *********************************************************
+********************************************************************/
+
+/* Test signals */
+#define STATS_TEST_RANDOM   0
+#define STATS_TEST_RISING   1
+#define STATS_TEST_FALLING  2
+#define STATS_TEST_CONSTANT 3
+#define STATS_TEST_TRIANGLE 4
+#define STATS_TEST_SIGNALS  5
+
+/* Triangle wave half period (samples), longer
+** than the window so each run spans it */
+#define STATS_TEST_TRIANGLE_RUN (3*STATS_WINDOW)
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/*
+** TYPE: STATS_TEST_RESULT_TYPE
+** Errors of one signal against the brute force window */
+typedef struct
+{
+	unsigned long nMinMax; /* Samples with a wrong min or max */
+	double        MaxMean; /* Max relative error of the mean */
+	double        MaxM2;   /* Max relative error of the sum of squares */
+} STATS_TEST_RESULT_TYPE;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+/*************************************************
+** FUNCTION: Stats_Test_Signal
+** VARIABLES:
+**		[I ]	int						Signal
+**		[I ]	unsigned long	n
+**		[IO]	uint32_t			*p_seed
+** RETURN:
+**		float	Sample n of the signal
+** DESCRIPTION:
+** 		Test signals, in the range of the gyro
+** 		magnitude (dps). The random signal is a
+** 		linear congruential sequence, so every
+** 		run pushes the same samples.
+*/
+static float Stats_Test_Signal( int						Signal,
+																unsigned long	n,
+																uint32_t			*p_seed )
+{
+	unsigned long phase;
+
+	switch( Signal )
+	{
+		case STATS_TEST_RANDOM:
+			*p_seed = *p_seed*1664525UL + 1013904223UL;
+			return (float)( *p_seed>>8 )*( 500.0f/16777216.0f );
+		case STATS_TEST_RISING:
+			return 0.25f*(float)n;
+		case STATS_TEST_FALLING:
+			return 1000.0f - 0.25f*(float)n;
+		case STATS_TEST_CONSTANT:
+			return 9.81f;
+		default:
+			phase = n % (2*STATS_TEST_TRIANGLE_RUN);
+			if( phase>=STATS_TEST_TRIANGLE_RUN ) { phase = 2*STATS_TEST_TRIANGLE_RUN - phase; }
+			return 2.0f*(float)phase;
+	}
+} /* End Stats_Test_Signal */
+
+
+/*************************************************
+** FUNCTION: Stats_Test_Run
+** VARIABLES:
+**		[I ]	int											Signal
+**		[I ]	unsigned long						nSamples
+**		[O ]	STATS_TEST_RESULT_TYPE	*p_result
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Push nSamples of the signal through one
+** 		window and compare every read with the
+** 		brute force window. The mean and sum of
+** 		squares errors are relative to the window
+** 		mean and sum of squares (plus one, so a
+** 		zero reference does not divide by zero).
+*/
+static void Stats_Test_Run( int											Signal,
+														unsigned long						nSamples,
+														STATS_TEST_RESULT_TYPE	*p_result )
+{
+	STATS_WINDOW_TYPE *p_win = new STATS_WINDOW_TYPE();
+	float   *p_x  = new float[nSamples];
+	uint32_t seed = 1;
+	uint32_t count, first, i;
+	unsigned long n;
+	float    mAve, M2, min, max, ref_min, ref_max;
+	double   sum, ref_mAve, ref_M2, d;
+
+	memset( p_result, 0, sizeof(STATS_TEST_RESULT_TYPE) );
+
+	for( n=0; n<nSamples; n++ )
+	{
+		p_x[n] = Stats_Test_Signal( Signal, n, &seed );
+		Stats_Window_Push( p_win, (uint32_t)n, p_x[n] );
+		count = ( n<STATS_WINDOW ) ? (uint32_t)n+1 : STATS_WINDOW;
+		Stats_Window_Read( p_win, count, &mAve, &M2, &min, &max );
+
+		/* Brute force window */
+		first   = (uint32_t)n+1-count;
+		ref_min = p_x[first];
+		ref_max = p_x[first];
+		sum     = 0.0;
+		for( i=first; i<=n; i++ )
+		{
+			if( p_x[i]<ref_min ) { ref_min = p_x[i]; }
+			if( p_x[i]>ref_max ) { ref_max = p_x[i]; }
+			sum += p_x[i];
+		}
+		ref_mAve = sum/count;
+		ref_M2   = 0.0;
+		for( i=first; i<=n; i++ )
+		{
+			d = p_x[i] - ref_mAve;
+			ref_M2 += d*d;
+		}
+
+		if( min!=ref_min || max!=ref_max ) { p_result->nMinMax++; }
+		d = fabs( mAve - ref_mAve )/( fabs( ref_mAve ) + 1.0 );
+		if( d>p_result->MaxMean ) { p_result->MaxMean = d; }
+		d = fabs( M2 - ref_M2 )/( ref_M2 + 1.0 );
+		if( d>p_result->MaxM2 ) { p_result->MaxM2 = d; }
+	}
+
+	delete [] p_x;
+	delete p_win;
+} /* End Stats_Test_Run */
+
+
+/*************************************************
+** FUNCTION: Emulator_Stats_Test
+** VARIABLES:
+**		[I ]	unsigned long	nSamples	: Samples per signal
+** RETURN:
+**		int		0:Passed
+**					1:A window off the brute force window
+**					-1:Failure
+** DESCRIPTION:
+** 		Check the sliding window stats on each
+** 		test signal and report the errors. The
+** 		test fails if a min or max differs from
+** 		the brute force window, or if the mean or
+** 		sum of squares is over STATS_TEST_MAX_ERROR.
+*/
+int Emulator_Stats_Test( unsigned long nSamples )
+{
+	static const char *Names[STATS_TEST_SIGNALS] = { "random", "rising", "falling", "constant", "triangle" };
+	STATS_TEST_RESULT_TYPE result;
+	int nFailed = 0;
+	int Signal;
+
+	if( nSamples<1 ) { return -1; }
+	fprintf(stderr,"> Motion stats, window %d, %lu samples per signal\n", STATS_WINDOW, nSamples );
+	fprintf(stderr,"  signal     min/max errors  max mean error  max M2 error\n");
+
+	for( Signal=0; Signal<STATS_TEST_SIGNALS; Signal++ )
+	{
+		Stats_Test_Run( Signal, nSamples, &result );
+		fprintf(stderr,"  %-9s  %14lu  %14.3e  %12.3e\n", Names[Signal], result.nMinMax, result.MaxMean, result.MaxM2 );
+		if( result.nMinMax>0 || result.MaxMean>STATS_TEST_MAX_ERROR || result.MaxM2>STATS_TEST_MAX_ERROR ) { nFailed++; }
+	}
+
+	if( nFailed>0 ) { fprintf(stderr,"> %d signal(s) off the brute force window\n", nFailed ); }
+	else            { fprintf(stderr,"> Every window matches the brute force window\n" ); }
+
+	return ( nFailed==0 ) ? 0 : 1;
+} /* End Emulator_Stats_Test */
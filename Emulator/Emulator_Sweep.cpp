@@ -0,0 +1,1273 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Sweep
+** DESCRIPTION:
+** 		This file contains the parameter sweep for the host
+** 		(Linux) emulator. One recording is replayed through
+** 		every combination of a grid of DCM/GaPA/WISE gains in a
+** 		single pass, and each configuration is scored against
+** 		reference speed/incline/phase labels.
+** 		The states of all configurations are held structure-of-
+** 		arrays (see Sweep_Config.h). The sensor read, timing and
+** 		DSP stages do not depend on the swept gains and are run
+** 		once per sample; the DCM, GaPA and WISE updates are then
+** 		loops over the configuration "lanes". The arithmetic in
+** 		each lane loop is written branch free so the compiler can
+** 		vectorize it (the lane arrays never overlap, which the
+** 		loops declare with "#pragma GCC ivdep"); the pitch uses
+** 		the batch asin (Trig_Asin_Batch), and the calls to
+** 		atan2/sincos and the phase portrait center are kept in
+** 		separate scalar loops.
+** 		Lane 0 is also run through the regular (scalar) pipeline
+** 		and compared every sample, which guards the lane code
+** 		against drifting from DCM_Filter/GaPA_Update/WISE_Update.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+
+
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* Grid file parameter names, indexed by SWEEP_* */
+const char *Sweep_Prm_Names[SWEEP_N_PRMS] =
+{
+	"Kp_RollPitch",
+	"Ki_RollPitch",
+	"Kp_phi",
+	"Ki_phi",
+	"Kp_PHI",
+	"Ki_PHI",
+	"phimw_alpha",
+	"PHImw_alpha",
+	"correction",
+	"mini_count"
+};
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Sweep_Select
+** VARIABLES:
+**		[I ]	bool	c
+**		[I ]	float	a
+**		[I ]	float	b
+** RETURN:
+**		float	c ? a : b
+** DESCRIPTION:
+** 		Branch free select for the lane loops.
+** 		A plain "x[k] = c ? a : x[k]" is turned into a
+** 		conditional store by the compiler, which stops
+** 		the loop from being vectorized (no masked
+** 		stores on SSE2). Selecting on the bits keeps
+** 		the store unconditional and the result exact.
+*/
+static inline float Sweep_Select( bool	c,
+																	float	a,
+																	float	b )
+{
+	uint32_t ia, ib;
+	uint32_t mask = -(uint32_t)c;
+
+	memcpy( &ia, &a, sizeof(float) );
+	memcpy( &ib, &b, sizeof(float) );
+	ia = (ia & mask) | (ib & ~mask);
+	memcpy( &a, &ia, sizeof(float) );
+	return a;
+} /* End Sweep_Select */
+
+
+/*************************************************
+** FUNCTION: Sweep_Read_Grid
+** VARIABLES:
+**		[I ]	const char				*GridPath
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	SWEEP_GRID_TYPE		*p_grid
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Read the sweep grid. Each line holds a
+** 		parameter name followed by its values:
+** 			Kp_RollPitch 0.0002 0.0008 0.002
+** 		Lines starting with '#' are comments. Parameters
+** 		which are not listed keep the default value
+** 		currently set in p_control.
+*/
+bool Sweep_Read_Grid( const char				*GridPath,
+											CONTROL_TYPE			*p_control,
+											SWEEP_GRID_TYPE		*p_grid )
+{
+	FILE *GridFID;
+	char  line[EMU_LINE_LENGTH];
+	char *p_str;
+	char *p_end;
+	char *p_name;
+	int   i;
+
+	/* Defaults */
+	for( i=0; i<SWEEP_N_PRMS; i++ ) { p_grid->nValues[i] = 1; }
+	p_grid->value[SWEEP_DCM_KP_ROLLPITCH][0] = p_control->dcm_prms.Kp_RollPitch;
+	p_grid->value[SWEEP_DCM_KI_ROLLPITCH][0] = p_control->dcm_prms.Ki_RollPitch;
+	p_grid->value[SWEEP_GAPA_KP_phi][0]      = p_control->gapa_prms.Kp_phi;
+	p_grid->value[SWEEP_GAPA_KI_phi][0]      = p_control->gapa_prms.Ki_phi;
+	p_grid->value[SWEEP_GAPA_KP_PHI][0]      = p_control->gapa_prms.Kp_PHI;
+	p_grid->value[SWEEP_GAPA_KI_PHI][0]      = p_control->gapa_prms.Ki_PHI;
+	p_grid->value[SWEEP_GAPA_phimw_ALPHA][0] = p_control->gapa_prms.phimw_alpha;
+	p_grid->value[SWEEP_GAPA_PHImw_ALPHA][0] = p_control->gapa_prms.PHImw_alpha;
+	p_grid->value[SWEEP_WISE_CORRECTION][0]  = p_control->wise_prms.correction;
+	p_grid->value[SWEEP_WISE_MINCOUNT][0]    = p_control->wise_prms.mini_count;
+
+	GridFID = fopen( GridPath, "r" );
+	if( GridFID==NULL )
+	{
+		LOG_PRINTLN("ERROR : Sweep_Read_Grid : Cant open %s",GridPath);
+		return FALSE;
+	}
+
+	while( fgets( line, EMU_LINE_LENGTH, GridFID )!=NULL )
+	{
+		/* Parameter name */
+		p_str = line;
+		while( isspace( (unsigned char)*p_str ) ) { p_str++; }
+		if( *p_str=='#' || *p_str=='\0' ) { continue; }
+		p_name = p_str;
+		while( *p_str!='\0' && !isspace( (unsigned char)*p_str ) ) { p_str++; }
+		if( *p_str!='\0' ) { *p_str++ = '\0'; }
+
+		for( i=0; i<SWEEP_N_PRMS; i++ ) { if( strcmp( p_name, Sweep_Prm_Names[i] )==0 ) { break; } }
+		if( i==SWEEP_N_PRMS )
+		{
+			LOG_PRINTLN("ERROR : Sweep_Read_Grid : Unknown parameter %s",p_name);
+			fclose( GridFID );
+			return FALSE;
+		}
+
+		/* Values */
+		p_grid->nValues[i] = 0;
+		while( p_grid->nValues[i]<SWEEP_MAX_VALUES )
+		{
+			p_grid->value[i][p_grid->nValues[i]] = strtof( p_str, &p_end );
+			if( p_end==p_str ) { break; }
+			p_grid->nValues[i]++;
+			p_str = p_end;
+		}
+		if( p_grid->nValues[i]==0 )
+		{
+			LOG_PRINTLN("ERROR : Sweep_Read_Grid : No values for %s",p_name);
+			fclose( GridFID );
+			return FALSE;
+		}
+	}
+
+	fclose( GridFID );
+	return TRUE;
+} /* End Sweep_Read_Grid */
+
+
+/*************************************************
+** FUNCTION: Sweep_Read_Labels
+** VARIABLES:
+**		[I ]	const char				*LabelsPath
+**		[IO]	SWEEP_LABELS_TYPE	*p_labels
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Read the reference labels:
+** 			timestamp,speed,incline[,phase]
+** 		Timestamps must be increasing. Lines which do
+** 		not start with a digit are skipped. Empty or
+** 		missing fields are stored as NaN (not scored).
+*/
+bool Sweep_Read_Labels( const char					*LabelsPath,
+												SWEEP_LABELS_TYPE		*p_labels )
+{
+	FILE         *LabelsFID;
+	char          line[EMU_LINE_LENGTH];
+	char         *p_str;
+	char         *p_end;
+	float         field[3];
+	unsigned long nAlloc = 0;
+	int           i;
+
+	memset( p_labels, 0, sizeof(SWEEP_LABELS_TYPE) );
+
+	LabelsFID = fopen( LabelsPath, "r" );
+	if( LabelsFID==NULL )
+	{
+		LOG_PRINTLN("ERROR : Sweep_Read_Labels : Cant open %s",LabelsPath);
+		return FALSE;
+	}
+
+	while( fgets( line, EMU_LINE_LENGTH, LabelsFID )!=NULL )
+	{
+		if( !isdigit( (unsigned char)line[0] ) ) { continue; }
+
+		if( p_labels->nLabels==nAlloc )
+		{
+			nAlloc = (nAlloc==0) ? 1024 : 2*nAlloc;
+			p_labels->timestamp = (unsigned long *)realloc( p_labels->timestamp, nAlloc*sizeof(unsigned long) );
+			p_labels->speed     = (float *)realloc( p_labels->speed,   nAlloc*sizeof(float) );
+			p_labels->incline   = (float *)realloc( p_labels->incline, nAlloc*sizeof(float) );
+			p_labels->phase     = (float *)realloc( p_labels->phase,   nAlloc*sizeof(float) );
+		}
+
+		p_labels->timestamp[p_labels->nLabels] = strtoul( line, &p_end, 10 );
+		p_str = p_end;
+		for( i=0; i<3; i++ )
+		{
+			field[i] = NAN;
+			if( *p_str!=',' ) { continue; }
+			p_str++;
+			field[i] = strtof( p_str, &p_end );
+			if( p_end==p_str ) { field[i] = NAN; }
+			p_str = p_end;
+		}
+		p_labels->speed[p_labels->nLabels]   = field[0];
+		p_labels->incline[p_labels->nLabels] = field[1];
+		p_labels->phase[p_labels->nLabels]   = field[2];
+		p_labels->nLabels++;
+	}
+
+	fclose( LabelsFID );
+
+	if( p_labels->nLabels==0 )
+	{
+		LOG_PRINTLN("ERROR : Sweep_Read_Labels : No labels in %s",LabelsPath);
+		return FALSE;
+	}
+	return TRUE;
+} /* End Sweep_Read_Labels */
+
+
+/*************************************************
+** FUNCTION: Sweep_Alloc
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	size_t						ElementSize
+** RETURN:
+**		void*	Zeroed, aligned array of nLanes elements
+** DESCRIPTION:
+** 		Allocate a lane array. All arrays are freed
+** 		by Sweep_Free.
+*/
+void* Sweep_Alloc( SWEEP_STATE_TYPE	*p_sweep,
+									 size_t						ElementSize )
+{
+	size_t nBytes = p_sweep->nLanes*ElementSize;
+	void  *p_array;
+
+	if( p_sweep->nAlloc>=SWEEP_MAX_ARRAYS ) { return NULL; }
+
+	p_array = aligned_alloc( 64, nBytes );
+	if( p_array!=NULL ) { memset( p_array, 0, nBytes ); }
+	p_sweep->p_alloc[p_sweep->nAlloc++] = p_array;
+	return p_array;
+} /* End Sweep_Alloc */
+
+
+/*************************************************
+** FUNCTION: Sweep_Free
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Free all lane arrays
+*/
+void Sweep_Free( SWEEP_STATE_TYPE *p_sweep )
+{
+	int i;
+	for( i=0; i<p_sweep->nAlloc; i++ ) { free( p_sweep->p_alloc[i] ); }
+	p_sweep->nAlloc = 0;
+} /* End Sweep_Free */
+
+
+/*************************************************
+** FUNCTION: Sweep_Init
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE		*p_sweep
+**		[I ]	SWEEP_GRID_TYPE			*p_grid
+**		[I ]	PIPELINE_STATE_TYPE	*p_pipeline
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Allocate the lane arrays, expand the grid into one
+** 		configuration per lane and initialize the lane states
+** 		from the (already initialized) scalar pipeline, i.e.
+** 		the equivalent of DCM_Init, GaPA_Init and WISE_Init.
+** 		Configuration c takes value (c / stride) % nValues of
+** 		each parameter, so config 0 is the first value of
+** 		every parameter.
+*/
+bool Sweep_Init( SWEEP_STATE_TYPE			*p_sweep,
+								 SWEEP_GRID_TYPE			*p_grid,
+								 PIPELINE_STATE_TYPE	*p_pipeline )
+{
+	long nConfigs = 1;
+	long stride;
+	int  c, i, j;
+
+	for( i=0; i<SWEEP_N_PRMS; i++ ) { nConfigs *= p_grid->nValues[i]; }
+	if( nConfigs>SWEEP_MAX_CONFIGS )
+	{
+		LOG_PRINTLN("ERROR : Sweep_Init : %ld configurations (max %d)",nConfigs,SWEEP_MAX_CONFIGS);
+		return FALSE;
+	}
+
+	memset( p_sweep, 0, sizeof(SWEEP_STATE_TYPE) );
+	p_sweep->nConfigs = (int)nConfigs;
+	p_sweep->nLanes   = ( (p_sweep->nConfigs+SWEEP_LANE_ALIGN-1)/SWEEP_LANE_ALIGN )*SWEEP_LANE_ALIGN;
+
+	/* Parameters */
+	for( i=0; i<SWEEP_N_PRMS; i++ ) { p_sweep->prm[i] = (float *)Sweep_Alloc( p_sweep, sizeof(float) ); }
+
+	/* DCM */
+	for( i=0; i<3; i++ )
+	{
+		p_sweep->Omega_P[i] = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->Omega_I[i] = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		for( j=0; j<3; j++ ) { p_sweep->DCM_Matrix[i][j] = (float *)Sweep_Alloc( p_sweep, sizeof(float) ); }
+	}
+	p_sweep->pitch = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+
+	/* GaPA */
+	p_sweep->phi           = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PHI           = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->phi_max       = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PHI_max       = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->z_phi         = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->z_PHI         = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PErr_phi      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->IErr_phi      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PErr_PHI      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->IErr_PHI      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->phi_mw        = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PHI_mw        = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->phin          = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->PHIn          = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->gamma         = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->GAMMA         = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->nu            = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->nu_prev       = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->nu_normalized = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->circle        = (GAPA_CIRCLE_FIT_TYPE *)Sweep_Alloc( p_sweep, sizeof(GAPA_CIRCLE_FIT_TYPE) );
+	for( i=0; i<2; i++ )
+	{
+		p_sweep->prev_phi[i] = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->prev_PHI[i] = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	}
+
+	/* WISE */
+	for( i=0; i<2; i++ )
+	{
+		p_sweep->accel[i]               = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->vel[i]                 = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->vel_ave[i]             = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->dist[i]                = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->fit_v[i]               = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->fit_tv[i]              = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->GaitEnd_fit_v[i]       = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+		p_sweep->GaitEnd_fit_tv[i]      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	}
+	p_sweep->rot                = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->Incline_ave        = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->Nsamples           = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->Ncycles            = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->CrossingP          = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->fit_n              = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->fit_t              = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->fit_tt             = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->fit_Time0          = (unsigned long *)Sweep_Alloc( p_sweep, sizeof(unsigned long) );
+	p_sweep->GaitEnd_fit_n      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->GaitEnd_fit_t      = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->GaitEnd_fit_tt     = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+	p_sweep->GaitEnd_Nsamples   = (float *)Sweep_Alloc( p_sweep, sizeof(float) );
+
+	/* Scoring */
+	p_sweep->speed_sse   = (double *)Sweep_Alloc( p_sweep, sizeof(double) );
+	p_sweep->incline_sse = (double *)Sweep_Alloc( p_sweep, sizeof(double) );
+	p_sweep->phase_sse   = (double *)Sweep_Alloc( p_sweep, sizeof(double) );
+
+	if( p_sweep->nAlloc>=SWEEP_MAX_ARRAYS || p_sweep->phase_sse==NULL )
+	{
+		LOG_PRINTLN("ERROR : Sweep_Init : Allocation failed");
+		return FALSE;
+	}
+
+	/* Expand the grid
+	** Padding lanes repeat the last configuration */
+	for( c=0; c<p_sweep->nLanes; c++ )
+	{
+		stride = 1;
+		for( i=0; i<SWEEP_N_PRMS; i++ )
+		{
+			p_sweep->prm[i][c] = p_grid->value[i][ ( MIN( c, p_sweep->nConfigs-1 )/stride ) % p_grid->nValues[i] ];
+			stride *= p_grid->nValues[i];
+		}
+	}
+
+	/* Initial states (see DCM_Init, GaPA_Init and WISE_Init) */
+	for( c=0; c<p_sweep->nLanes; c++ )
+	{
+		for( i=0; i<3; i++ )
+		{
+			for( j=0; j<3; j++ ) { p_sweep->DCM_Matrix[i][j][c] = p_pipeline->dcm_state.DCM_Matrix[i][j]; }
+		}
+		p_sweep->pitch[c] = p_pipeline->sensor_state.pitch;
+
+		p_sweep->z_phi[c] = p_pipeline->control.gapa_prms.default_z_phi;
+		p_sweep->z_PHI[c] = p_pipeline->control.gapa_prms.default_z_PHI;
+
+		p_sweep->Nsamples[c]           = 2.0f;
+		p_sweep->vel_ave[0][c]         = 1.0f;
+		p_sweep->vel_ave[1][c]         = 1.0f;
+		p_sweep->GaitEnd_Nsamples[c]   = 999;
+	}
+
+	LOG_PRINTLN("> Sweep: %d configurations (%d lanes)",p_sweep->nConfigs,p_sweep->nLanes);
+	return TRUE;
+} /* End Sweep_Init */
+
+
+/*************************************************
+** FUNCTION: Sweep_DCM_Update
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	CONTROL_TYPE			*p_control
+**		[I ]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		DCM_Filter for every lane. The accel weight and
+** 		scaled gyro are the same for all lanes and are
+** 		computed once. Only the pitch is extracted (the
+** 		roll/yaw do not feed GaPA or WISE).
+*/
+void Sweep_DCM_Update( SWEEP_STATE_TYPE		*p_sweep,
+											 CONTROL_TYPE				*p_control,
+											 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	const int   n    = p_sweep->nLanes;
+	const float G_Dt = p_control->G_Dt;
+	float  Accel_Vector[3];
+	float  Accel_magnitude;
+	float  Accel_weight;
+	double Gyro_Scaled[3];
+	float  PitchConv;
+	float *M2;
+	int    k;
+
+	float * __restrict Kp   = p_sweep->prm[SWEEP_DCM_KP_ROLLPITCH];
+	float * __restrict Ki   = p_sweep->prm[SWEEP_DCM_KI_ROLLPITCH];
+	float * __restrict OP0  = p_sweep->Omega_P[0];
+	float * __restrict OP1  = p_sweep->Omega_P[1];
+	float * __restrict OP2  = p_sweep->Omega_P[2];
+	float * __restrict OI0  = p_sweep->Omega_I[0];
+	float * __restrict OI1  = p_sweep->Omega_I[1];
+	float * __restrict OI2  = p_sweep->Omega_I[2];
+	float * __restrict M00  = p_sweep->DCM_Matrix[0][0];
+	float * __restrict M01  = p_sweep->DCM_Matrix[0][1];
+	float * __restrict M02  = p_sweep->DCM_Matrix[0][2];
+	float * __restrict M10  = p_sweep->DCM_Matrix[1][0];
+	float * __restrict M11  = p_sweep->DCM_Matrix[1][1];
+	float * __restrict M12  = p_sweep->DCM_Matrix[1][2];
+	float * __restrict M20  = p_sweep->DCM_Matrix[2][0];
+	float * __restrict M21  = p_sweep->DCM_Matrix[2][1];
+	float * __restrict M22  = p_sweep->DCM_Matrix[2][2];
+
+	/* Shared inputs
+	** Copied to locals so the lane loop sees them as invariant */
+	Accel_Vector[0] = ( p_sensor_state->accel[0] );
+	Accel_Vector[1] = ( p_sensor_state->accel[1] );
+	Accel_Vector[2] = ( p_sensor_state->accel[2] );
+	Gyro_Scaled[0]  = GYRO_X_SCALED( p_sensor_state->gyro[0] );
+	Gyro_Scaled[1]  = GYRO_Y_SCALED( p_sensor_state->gyro[1] );
+	Gyro_Scaled[2]  = GYRO_Z_SCALED( p_sensor_state->gyro[2] );
+
+	Accel_magnitude = f_sqrt( Vector_Dot_Product( &Accel_Vector[0], &Accel_Vector[0] ) ) / p_control->sensor_prms.gravity;
+	Accel_weight    = FCONSTRAIN( 1.0-2.0*FABS(1-Accel_magnitude), 0.0, 1.0 ) ;
+
+	const float  A0 = Accel_Vector[0], A1 = Accel_Vector[1], A2 = Accel_Vector[2];
+	const double G0 = Gyro_Scaled[0],  G1 = Gyro_Scaled[1],  G2 = Gyro_Scaled[2];
+
+	#pragma GCC ivdep
+	for( k=0; k<n; k++ )
+	{
+		float o0, o1, o2;
+		float T00, T01, T02, T10, T11, T12;
+		float U00, U01, U02, U10, U11, U12, U20, U21, U22;
+		float dot, error, renorm;
+		float e0, e1, e2, Kp_w, Ki_w;
+
+		/* 1. Update */
+		o0 = G0 + OI0[k] + OP0[k];
+		o1 = G1 + OI1[k] + OP1[k];
+		o2 = G2 + OI2[k] + OP2[k];
+
+		T00 = G_Dt * (M01[k]*o2 - M02[k]*o1) + M00[k];
+		T01 = G_Dt * (M02[k]*o0 - M00[k]*o2) + M01[k];
+		T02 = G_Dt * (M00[k]*o1 - M01[k]*o0) + M02[k];
+		T10 = G_Dt * (M11[k]*o2 - M12[k]*o1) + M10[k];
+		T11 = G_Dt * (M12[k]*o0 - M10[k]*o2) + M11[k];
+		T12 = G_Dt * (M10[k]*o1 - M11[k]*o0) + M12[k];
+
+		/* 2. Normalize */
+		dot = 0.0f; dot += T00*T10; dot += T01*T11; dot += T02*T12;
+		error = -dot * 0.5;
+
+		U00 = T10*error + T00;  U01 = T11*error + T01;  U02 = T12*error + T02;
+		U10 = T00*error + T10;  U11 = T01*error + T11;  U12 = T02*error + T12;
+
+		U20 = (U01 * U12) - (U02 * U11);
+		U21 = (U02 * U10) - (U00 * U12);
+		U22 = (U00 * U11) - (U01 * U10);
+
+		dot = 0.0f; dot += U00*U00; dot += U01*U01; dot += U02*U02;
+		renorm = .5 *(3 - dot);
+		M00[k] = U00*renorm; M01[k] = U01*renorm; M02[k] = U02*renorm;
+
+		dot = 0.0f; dot += U10*U10; dot += U11*U11; dot += U12*U12;
+		renorm = .5 *(3 - dot);
+		M10[k] = U10*renorm; M11[k] = U11*renorm; M12[k] = U12*renorm;
+
+		dot = 0.0f; dot += U20*U20; dot += U21*U21; dot += U22*U22;
+		renorm = .5 *(3 - dot);
+		M20[k] = U20*renorm; M21[k] = U21*renorm; M22[k] = U22*renorm;
+
+		/* 3. Drift correction (roll/pitch) */
+		e0 = (A1 * M22[k]) - (A2 * M21[k]);
+		e1 = (A2 * M20[k]) - (A0 * M22[k]);
+		e2 = (A0 * M21[k]) - (A1 * M20[k]);
+
+		Kp_w = Kp[k]*Accel_weight;
+		Ki_w = Ki[k]*Accel_weight;
+		OP0[k] = e0*Kp_w;  OP1[k] = e1*Kp_w;  OP2[k] = e2*Kp_w;
+		OI0[k] = OI0[k] + e0*Ki_w;
+		OI1[k] = OI1[k] + e1*Ki_w;
+		OI2[k] = OI2[k] + e2*Ki_w;
+	}
+
+	/* 4. Pitch (batch asin, DCM_ANGLE_TIER) */
+	switch ( p_control->dcm_prms.PitchOrientation )
+	{
+		case 1 :  M2 = M20; break;
+		case 2 :  M2 = M21; break;
+		default : M2 = M22; break;
+	}
+	PitchConv = -p_control->dcm_prms.PitchRotationConv;
+	Trig_Asin_Batch( M2, p_sweep->pitch, n, DCM_ANGLE_TIER );
+	for( k=0; k<n; k++ ) { p_sweep->pitch[k] = PitchConv*p_sweep->pitch[k]; }
+} /* End Sweep_DCM_Update */
+
+
+/*************************************************
+** FUNCTION: Sweep_GaPA_Update
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	CONTROL_TYPE			*p_control
+**		[I ]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		GaPA_Update for every lane. The iteration count
+** 		and the no-motion test are the same for all lanes.
+*/
+void Sweep_GaPA_Update( SWEEP_STATE_TYPE	*p_sweep,
+												CONTROL_TYPE			*p_control,
+												SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	const int   n        = p_sweep->nLanes;
+	const float G_Dt     = p_control->G_Dt;
+	const float z_phi0   = p_control->gapa_prms.default_z_phi;
+	const float z_PHI0   = p_control->gapa_prms.default_z_PHI;
+	const float EndThres = p_control->gapa_prms.gait_end_threshold;
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_3POINT
+	float p1[2], p2[2], p3[2];
+#endif
+	float center[2], R;
+	int   k;
+
+	float * __restrict pitch    = p_sweep->pitch;
+	float * __restrict Kp_phi   = p_sweep->prm[SWEEP_GAPA_KP_phi];
+	float * __restrict Ki_phi   = p_sweep->prm[SWEEP_GAPA_KI_phi];
+	float * __restrict Kp_PHI   = p_sweep->prm[SWEEP_GAPA_KP_PHI];
+	float * __restrict Ki_PHI   = p_sweep->prm[SWEEP_GAPA_KI_PHI];
+	float * __restrict a_phi    = p_sweep->prm[SWEEP_GAPA_phimw_ALPHA];
+	float * __restrict a_PHI    = p_sweep->prm[SWEEP_GAPA_PHImw_ALPHA];
+	float * __restrict phi      = p_sweep->phi;
+	float * __restrict PHI      = p_sweep->PHI;
+	float * __restrict phi_max  = p_sweep->phi_max;
+	float * __restrict PHI_max  = p_sweep->PHI_max;
+	float * __restrict z_phi    = p_sweep->z_phi;
+	float * __restrict z_PHI    = p_sweep->z_PHI;
+	float * __restrict PErr_phi = p_sweep->PErr_phi;
+	float * __restrict IErr_phi = p_sweep->IErr_phi;
+	float * __restrict PErr_PHI = p_sweep->PErr_PHI;
+	float * __restrict IErr_PHI = p_sweep->IErr_PHI;
+	float * __restrict phi_mw   = p_sweep->phi_mw;
+	float * __restrict PHI_mw   = p_sweep->PHI_mw;
+	float * __restrict phin     = p_sweep->phin;
+	float * __restrict PHIn     = p_sweep->PHIn;
+	float * __restrict prev_phi1= p_sweep->prev_phi[0];
+	float * __restrict prev_phi2= p_sweep->prev_phi[1];
+	float * __restrict prev_PHI1= p_sweep->prev_PHI[0];
+	float * __restrict prev_PHI2= p_sweep->prev_PHI[1];
+	float * __restrict nu       = p_sweep->nu;
+	float * __restrict nu_prev  = p_sweep->nu_prev;
+	float * __restrict nu_norm  = p_sweep->nu_normalized;
+
+	p_sweep->gapa_iteration++;
+
+	#pragma GCC ivdep
+	for( k=0; k<n; k++ )
+	{
+		/* Store previous nu, phi and PHI */
+		nu_prev[k]   = nu[k];
+		prev_phi1[k] = prev_phi2[k];
+		prev_PHI1[k] = prev_PHI2[k];
+		prev_phi2[k] = phin[k];
+		prev_PHI2[k] = PHIn[k];
+
+		/* Phase variables (PHI version) */
+		phi[k]  = pitch[k] - PErr_phi[k] - IErr_phi[k];
+		PHI[k] += phi[k]*G_Dt - PErr_PHI[k] - IErr_PHI[k];
+
+		/* Windowed moving average */
+		phi_mw[k] = phi_mw[k]*(1-a_phi[k]) + phi[k]*(a_phi[k]);
+		PHI_mw[k] = PHI_mw[k]*(1-a_PHI[k]) + PHI[k]*(a_PHI[k]);
+
+		/* Feedback error */
+		PErr_phi[k]  = phi_mw[k] * Kp_phi[k];
+		IErr_phi[k] += phi_mw[k] * Ki_phi[k];
+		PErr_PHI[k]  = PHI_mw[k] * Kp_PHI[k];
+		IErr_PHI[k] += PHI_mw[k] * Ki_PHI[k];
+
+		/* Min/max */
+		phi_max[k] = MAX( phi_max[k], phi[k] );
+		PHI_max[k] = MAX( PHI_max[k], PHI[k] );
+
+		/* Scale by z */
+		z_phi[k] = (z_phi[k]==0) ? z_phi0 : z_phi[k];
+		z_PHI[k] = (z_PHI[k]==0) ? z_PHI0 : z_PHI[k];
+		phin[k]  = (phi[k]/z_phi[k]);
+		PHIn[k]  = (PHI[k]/z_PHI[k]);
+
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_3POINT
+		/* Normalize to 1 */
+		R        = sqrt( phin[k]*phin[k] + PHIn[k]*PHIn[k] );
+		phin[k]  = phin[k]/R;
+		PHIn[k]  = PHIn[k]/R;
+#endif
+	}
+
+#if GAPA_CIRCLE_FIT!=GAPA_CIRCLE_3POINT
+	/* Phase portrait fit on the z scaled points, shift
+	** to the center and normalize to 1 (scalar) */
+	for( k=0; k<n; k++ )
+	{
+		GaPA_Circle_Push( &p_sweep->circle[k], phin[k], PHIn[k] );
+		if( p_sweep->gapa_iteration>=10 )
+		{
+			GaPA_Circle_Center( &p_sweep->circle[k], center );
+			p_sweep->gamma[k] = -center[0];
+			p_sweep->GAMMA[k] = -center[1];
+		}
+		phin[k] += p_sweep->gamma[k];
+		PHIn[k] += p_sweep->GAMMA[k];
+		R        = sqrt( phin[k]*phin[k] + PHIn[k]*PHIn[k] );
+		phin[k]  = phin[k]/R;
+		PHIn[k]  = PHIn[k]/R;
+	}
+#endif
+
+	if( p_sweep->gapa_iteration<10 ) { return; }
+
+	/* Phase portrait center and phase angle (scalar) */
+	for( k=0; k<n; k++ )
+	{
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_3POINT
+		p1[0] = prev_phi1[k]; p1[1] = prev_PHI1[k];
+		p2[0] = prev_phi2[k]; p2[1] = prev_PHI2[k];
+		p3[0] = phin[k];      p3[1] = PHIn[k];
+		calc_circle_center( p1, p2, p3, &center[0] );
+		p_sweep->gamma[k] = -center[0];
+		p_sweep->GAMMA[k] = -center[1];
+		nu[k] = F_ATAN2( GAPA_ANGLE_TIER, -1 * (PHIn[k]+p_sweep->GAMMA[k]), -1 * (phin[k]+p_sweep->gamma[k]) );
+#else
+		nu[k] = F_ATAN2( GAPA_ANGLE_TIER, -1 * PHIn[k], -1 * phin[k] );
+#endif
+	}
+
+	if( (p_sensor_state->gyro_mAve<p_control->gapa_prms.min_gyro) )
+	{
+		/* No motion, reset phase variables */
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			phi[k]     = 0.0; phin[k] = 0.0; phi_max[k] = 0.0; z_phi[k] = z_phi0;
+			PHI[k]     = 0.0; PHIn[k] = 0.0; PHI_max[k] = 0.0; z_PHI[k] = z_PHI0;
+			nu_norm[k] = 0.0;
+		}
+#if GAPA_CIRCLE_FIT!=GAPA_CIRCLE_3POINT
+		for( k=0; k<n; k++ ) { GaPA_Circle_Init( &p_sweep->circle[k] ); }
+#endif
+	}
+	else
+	{
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			bool  GaitEnd = ( FABS(nu[k]-nu_prev[k])>EndThres );
+			float p_max = phi_max[k], P_max = PHI_max[k];
+			float zp = z_phi[k], zP = z_PHI[k];
+			float z;
+
+			/* End of gait, update the "z" scaling parameters */
+			z          = (p_max==0) ? z_phi0 : p_max;
+			z_phi[k]   = Sweep_Select( GaitEnd, z, zp );
+			phi_max[k] = Sweep_Select( GaitEnd, FABS( phi[k] ), p_max );
+
+			z          = (P_max==0) ? z_PHI0 : P_max;
+			z_PHI[k]   = Sweep_Select( GaitEnd, z, zP );
+			PHI_max[k] = Sweep_Select( GaitEnd, FABS( PHI[k] ), P_max );
+
+			nu_norm[k] = (nu[k]+PI)/(TWOPI);
+		}
+#if GAPA_CIRCLE_FIT!=GAPA_CIRCLE_3POINT
+		/* End of gait, restart the fit on the new z scaling */
+		for( k=0; k<n; k++ )
+		{
+			if( FABS(nu[k]-nu_prev[k])>EndThres ) { GaPA_Circle_Init( &p_sweep->circle[k] ); }
+		}
+#endif
+	}
+} /* End Sweep_GaPA_Update */
+
+
+/*************************************************
+** FUNCTION: Sweep_WISE_Update
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	CONTROL_TYPE			*p_control
+**		[I ]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		WISE_Update (Map_Accel_2D, Integrate_Accel_2D,
+** 		Adjust_Velocity, Adjust_Incline, WISE_Reset)
+** 		for every lane. The caller applies the same
+** 		gating as Pipeline_Update (Sweep_WISE_Reset
+** 		while the subject is stopped).
+*/
+void Sweep_WISE_Update( SWEEP_STATE_TYPE	*p_sweep,
+												CONTROL_TYPE			*p_control,
+												SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	const int   n    = p_sweep->nLanes;
+	const float G_Dt = p_control->G_Dt;
+	const unsigned long timestamp = p_control->timestamp;
+	float Ax, Az, R;
+	int   k;
+
+	float * __restrict pitch = p_sweep->pitch;
+	float * __restrict corr  = p_sweep->prm[SWEEP_WISE_CORRECTION];
+	float * __restrict minc  = p_sweep->prm[SWEEP_WISE_MINCOUNT];
+	float * __restrict a0    = p_sweep->accel[0];
+	float * __restrict a1    = p_sweep->accel[1];
+	float * __restrict v0    = p_sweep->vel[0];
+	float * __restrict v1    = p_sweep->vel[1];
+	float * __restrict va0   = p_sweep->vel_ave[0];
+	float * __restrict va1   = p_sweep->vel_ave[1];
+	float * __restrict rot   = p_sweep->rot;
+	float * __restrict d0    = p_sweep->dist[0];
+	float * __restrict d1    = p_sweep->dist[1];
+	float * __restrict inc   = p_sweep->Incline_ave;
+	float * __restrict Ns    = p_sweep->Nsamples;
+	float * __restrict Nc    = p_sweep->Ncycles;
+	float * __restrict CP    = p_sweep->CrossingP;
+	float * __restrict Fn    = p_sweep->fit_n;
+	float * __restrict Ft    = p_sweep->fit_t;
+	float * __restrict Ftt   = p_sweep->fit_tt;
+	float * __restrict Fv0   = p_sweep->fit_v[0];
+	float * __restrict Fv1   = p_sweep->fit_v[1];
+	float * __restrict Ftv0  = p_sweep->fit_tv[0];
+	float * __restrict Ftv1  = p_sweep->fit_tv[1];
+	unsigned long * __restrict FT0 = p_sweep->fit_Time0;
+	float * __restrict GEn   = p_sweep->GaitEnd_fit_n;
+	float * __restrict GEt   = p_sweep->GaitEnd_fit_t;
+	float * __restrict GEtt  = p_sweep->GaitEnd_fit_tt;
+	float * __restrict GEv0  = p_sweep->GaitEnd_fit_v[0];
+	float * __restrict GEv1  = p_sweep->GaitEnd_fit_v[1];
+	float * __restrict GEtv0 = p_sweep->GaitEnd_fit_tv[0];
+	float * __restrict GEtv1 = p_sweep->GaitEnd_fit_tv[1];
+	float * __restrict GEN   = p_sweep->GaitEnd_Nsamples;
+
+	/* Map_Accel_2D inputs (same for all lanes) */
+	Ax = p_sensor_state->accel[DCM_PITCH_POLICY<PITCH_O>::ACCEL_X];
+	Az = p_sensor_state->accel[DCM_PITCH_POLICY<PITCH_O>::ACCEL_Z];
+	R  = p_sensor_state->gyro[DCM_PITCH_POLICY<PITCH_O>::GYRO];
+
+	/* Map_Accel_2D (scalar: f_sincos) */
+	for( k=0; k<n; k++ )
+	{
+		float sp, cp;
+
+		f_sincos( pitch[k], &sp, &cp );
+		a0[k] = (Ax*cp - Az*sp) * GTOMPS2/GRAVITY * MPSTOMPH * corr[k];
+		a1[k] = -(Ax*sp - Az*cp  - GRAVITY) * GTOMPS2/GRAVITY * MPSTOMPH;
+	}
+
+	/* The lane state is loaded into locals and stored back
+	** unconditionally, see Sweep_Select */
+	#pragma GCC ivdep
+	for( k=0; k<n; k++ )
+	{
+		bool   Start, Cross, ToeOff, Drift, Slope;
+		float  den, drift, tempi, Nsamples, ave0, ave1, Incline, t;
+		float  vel0 = v0[k], vel1 = v1[k], r = rot[k];
+		float  N = Ns[k], Ncyc = Nc[k], Cp = CP[k];
+		float  f_n = Fn[k], f_t = Ft[k], f_tt = Ftt[k], f_v0 = Fv0[k], f_v1 = Fv1[k], f_tv0 = Ftv0[k], f_tv1 = Ftv1[k];
+		float  E_n = GEn[k], E_t = GEt[k], E_tt = GEtt[k], E_v0 = GEv0[k], E_v1 = GEv1[k], E_tv0 = GEtv0[k], E_tv1 = GEtv1[k], E_N = GEN[k];
+		float  dist0 = d0[k], dist1 = d1[k];
+		float  vave0 = va0[k], vave1 = va1[k], inc_prev = inc[k];
+
+		N++;
+
+		/* Integrate_Accel_2D */
+		vel0  = vel0 + a0[k]*G_Dt;
+		vel1  = vel1 + a1[k]*G_Dt;
+		r     = r + R*G_Dt;
+
+		/* Line fit sums */
+		FT0[k] = ( f_n==0.0f ) ? timestamp : FT0[k];
+		t      = (float)( timestamp - FT0[k] )/TIME_RESOLUTION;
+		f_n   += 1.0f;
+		f_t   += t;
+		f_tt  += t*t;
+		f_v0  += vel0;
+		f_v1  += vel1;
+		f_tv0 += t*vel0;
+		f_tv1 += t*vel1;
+
+		/* Adjust_Velocity Part 0 : Gait start for first cycle */
+		Start = (Ncyc==0) & (N==1);
+		Cp    = Start ? r    : Cp;
+
+		/* Rotational maximum */
+		Cross = r>Cp;
+		Cp    = Cross ? r     : Cp;
+		E_n   = Cross ? f_n   : E_n;
+		E_t   = Cross ? f_t   : E_t;
+		E_tt  = Cross ? f_tt  : E_tt;
+		E_v0  = Cross ? f_v0  : E_v0;
+		E_v1  = Cross ? f_v1  : E_v1;
+		E_tv0 = Cross ? f_tv0 : E_tv0;
+		E_tv1 = Cross ? f_tv1 : E_tv1;
+		E_N   = Cross ? N     : E_N;
+
+		/* Part I : Toe-off, correct the velocity
+		** (WISE_Drift_Fit) */
+		ToeOff = (N-E_N)>( (float)(int)minc[k] );
+		den    = E_n*E_tt - E_t*E_t;
+		Slope  = den>WISE_FIT_MIN_DEN*E_n*E_tt;
+		Drift  = ToeOff & (Ncyc>=1) & (E_n>=2.0f);
+
+		drift = Slope ? ( E_n*E_tv0 - E_t*E_v0 )/den : 0.0f;
+		ave0  = ( E_v0 - drift*E_t )/E_n;
+		drift = Slope ? ( E_n*E_tv1 - E_t*E_v1 )/den : 0.0f;
+		ave1  = ( E_v1 - drift*E_t )/E_n;
+		va0[k] = Sweep_Select( Drift, ave0, vave0 );
+		va1[k] = Sweep_Select( Drift, ave1, vave1 );
+
+		Ncyc  = ToeOff ? Ncyc+1 : Ncyc;
+		E_n   = ToeOff ? 0.0f   : E_n;
+		E_t   = ToeOff ? 0.0f   : E_t;
+		E_tt  = ToeOff ? 0.0f   : E_tt;
+		E_v0  = ToeOff ? 0.0f   : E_v0;
+		E_v1  = ToeOff ? 0.0f   : E_v1;
+		E_tv0 = ToeOff ? 0.0f   : E_tv0;
+		E_tv1 = ToeOff ? 0.0f   : E_tv1;
+		E_N   = ToeOff ? 999    : E_N;
+		Cp    = ToeOff ? r      : Cp;
+
+		/* Adjust_Incline */
+		dist0   += vel0*(G_Dt);
+		dist1   += vel1*(G_Dt);
+		tempi    = (dist1/dist0)*100;
+		Nsamples = (float)(int)N;
+		Incline  = inc_prev + (tempi-inc_prev)/Nsamples;
+		inc[k]   = Sweep_Select( (dist0!=0), Incline, inc_prev );
+
+		/* WISE_Reset at toe-off */
+		Ns[k]   = ToeOff ? 1.0f : N;
+		v0[k]   = ToeOff ? 0.0f : vel0;
+		v1[k]   = ToeOff ? 0.0f : vel1;
+		rot[k]  = ToeOff ? 0.0f : r;
+		d0[k]   = ToeOff ? 0.0f : dist0;
+		d1[k]   = ToeOff ? 0.0f : dist1;
+		Nc[k]   = Ncyc;
+		CP[k]   = Cp;
+		Fn[k]   = ToeOff ? 0.0f : f_n;
+		Ft[k]   = ToeOff ? 0.0f : f_t;
+		Ftt[k]  = ToeOff ? 0.0f : f_tt;
+		Fv0[k]  = ToeOff ? 0.0f : f_v0;
+		Fv1[k]  = ToeOff ? 0.0f : f_v1;
+		Ftv0[k] = ToeOff ? 0.0f : f_tv0;
+		Ftv1[k] = ToeOff ? 0.0f : f_tv1;
+		GEn[k]  = E_n;   GEt[k]  = E_t;   GEtt[k]  = E_tt;
+		GEv0[k] = E_v0;  GEv1[k] = E_v1;  GEtv0[k] = E_tv0;  GEtv1[k] = E_tv1;  GEN[k] = E_N;
+	}
+} /* End Sweep_WISE_Update */
+
+
+/*************************************************
+** FUNCTION: Sweep_WISE_Reset
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		WISE_Reset for every lane: restart the
+** 		integration segment (the gait detection
+** 		state and the estimates are kept).
+*/
+void Sweep_WISE_Reset( SWEEP_STATE_TYPE *p_sweep )
+{
+	const size_t Size = p_sweep->nLanes*sizeof(float);
+	int i, k;
+
+	for( k=0; k<p_sweep->nLanes; k++ ) { p_sweep->Nsamples[k] = 1.0f; }
+	for( i=0; i<2; i++ )
+	{
+		memset( p_sweep->vel[i],    0, Size );
+		memset( p_sweep->dist[i],   0, Size );
+		memset( p_sweep->fit_v[i],  0, Size );
+		memset( p_sweep->fit_tv[i], 0, Size );
+	}
+	memset( p_sweep->rot,    0, Size );
+	memset( p_sweep->fit_n,  0, Size );
+	memset( p_sweep->fit_t,  0, Size );
+	memset( p_sweep->fit_tt, 0, Size );
+} /* End Sweep_WISE_Reset */
+
+
+/*************************************************
+** FUNCTION: Sweep_Score
+** VARIABLES:
+**		[IO]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	SWEEP_LABELS_TYPE	*p_labels
+**		[I ]	unsigned long			timestamp
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Accumulate the squared error of each lane
+** 		against the label in effect at timestamp.
+** 		The phase error is wrapped to [-0.5,0.5).
+*/
+void Sweep_Score( SWEEP_STATE_TYPE		*p_sweep,
+									SWEEP_LABELS_TYPE		*p_labels,
+									unsigned long				timestamp )
+{
+	const int n = p_sweep->nLanes;
+	unsigned long i;
+	float label;
+	int   k;
+
+	/* Label in effect */
+	if( timestamp<p_labels->timestamp[0] ) { return; }
+	while( p_sweep->LabelIndex+1<p_labels->nLabels && p_labels->timestamp[p_sweep->LabelIndex+1]<=timestamp )
+	{
+		p_sweep->LabelIndex++;
+	}
+	i = p_sweep->LabelIndex;
+
+	label = p_labels->speed[i];
+	if( !isnan( label ) )
+	{
+		for( k=0; k<n; k++ ) { p_sweep->speed_sse[k] += (double)(p_sweep->vel_ave[0][k]-label)*(p_sweep->vel_ave[0][k]-label); }
+		p_sweep->nSpeed++;
+	}
+
+	label = p_labels->incline[i];
+	if( !isnan( label ) )
+	{
+		for( k=0; k<n; k++ ) { p_sweep->incline_sse[k] += (double)(p_sweep->Incline_ave[k]-label)*(p_sweep->Incline_ave[k]-label); }
+		p_sweep->nIncline++;
+	}
+
+	label = p_labels->phase[i];
+	if( !isnan( label ) )
+	{
+		for( k=0; k<n; k++ )
+		{
+			double d = p_sweep->nu_normalized[k] - label;
+			d -= floor( d+0.5 );
+			p_sweep->phase_sse[k] += d*d;
+		}
+		p_sweep->nPhase++;
+	}
+} /* End Sweep_Score */
+
+
+/*************************************************
+** FUNCTION: Sweep_Check
+** VARIABLES:
+**		[I ]	SWEEP_STATE_TYPE		*p_sweep
+**		[I ]	PIPELINE_STATE_TYPE	*p_pipeline
+** RETURN:
+**		BOOL	1:Lane 0 matches the scalar pipeline
+**					0:Mismatch
+** DESCRIPTION:
+** 		Compare lane 0 against the scalar pipeline,
+** 		which runs with the lane 0 parameters.
+** 		The comparison is exact (NaN matches NaN).
+*/
+bool Sweep_Check( SWEEP_STATE_TYPE			*p_sweep,
+									PIPELINE_STATE_TYPE		*p_pipeline )
+{
+	float lane[4], scalar[4];
+	int   i;
+
+	lane[0]   = p_sweep->pitch[0];
+	lane[1]   = p_sweep->nu_normalized[0];
+	lane[2]   = p_sweep->vel_ave[0][0];
+	lane[3]   = p_sweep->Incline_ave[0];
+	scalar[0] = p_pipeline->sensor_state.pitch;
+	scalar[1] = p_pipeline->gapa_state.nu_normalized;
+	scalar[2] = p_pipeline->wise_state.vel_ave[0];
+	scalar[3] = p_pipeline->wise_state.Incline_ave;
+
+	for( i=0; i<4; i++ )
+	{
+		if( lane[i]!=scalar[i] && !( isnan( lane[i] ) && isnan( scalar[i] ) ) ) { return FALSE; }
+	}
+	return TRUE;
+} /* End Sweep_Check */
+
+
+/*************************************************
+** FUNCTION: Sweep_Report
+** VARIABLES:
+**		[I ]	SWEEP_STATE_TYPE	*p_sweep
+**		[I ]	const char				*OutputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Write one line per configuration:
+** 			config,<parameters>,speed_rmse,incline_rmse,phase_rmse
+** 		(OutputPath may be NULL) and log the best
+** 		configuration for each score.
+*/
+bool Sweep_Report( SWEEP_STATE_TYPE	*p_sweep,
+									 const char				*OutputPath )
+{
+	FILE  *OutputFID = NULL;
+	double rmse[3];
+	double best[3]     = { INFINITY, INFINITY, INFINITY };
+	int    BestId[3]   = { -1, -1, -1 };
+	const char *Name[3] = { "speed", "incline", "phase" };
+	int    c, i;
+
+	if( OutputPath!=NULL )
+	{
+		OutputFID = fopen( OutputPath, "w" );
+		if( OutputFID==NULL )
+		{
+			LOG_PRINTLN("ERROR : Sweep_Report : Cant open output %s",OutputPath);
+			return FALSE;
+		}
+		fprintf( OutputFID, "config" );
+		for( i=0; i<SWEEP_N_PRMS; i++ ) { fprintf( OutputFID, ",%s", Sweep_Prm_Names[i] ); }
+		fprintf( OutputFID, ",speed_rmse,incline_rmse,phase_rmse\n" );
+	}
+
+	for( c=0; c<p_sweep->nConfigs; c++ )
+	{
+		rmse[0] = (p_sweep->nSpeed>0)   ? sqrt( p_sweep->speed_sse[c]/p_sweep->nSpeed )     : NAN;
+		rmse[1] = (p_sweep->nIncline>0) ? sqrt( p_sweep->incline_sse[c]/p_sweep->nIncline ) : NAN;
+		rmse[2] = (p_sweep->nPhase>0)   ? sqrt( p_sweep->phase_sse[c]/p_sweep->nPhase )     : NAN;
+
+		for( i=0; i<3; i++ )
+		{
+			if( rmse[i]<best[i] ) { best[i] = rmse[i]; BestId[i] = c; }
+		}
+
+		if( OutputFID!=NULL )
+		{
+			fprintf( OutputFID, "%d", c );
+			for( i=0; i<SWEEP_N_PRMS; i++ ) { fprintf( OutputFID, ",%g", p_sweep->prm[i][c] ); }
+			fprintf( OutputFID, ",%.6g,%.6g,%.6g\n", rmse[0], rmse[1], rmse[2] );
+		}
+	}
+
+	if( OutputFID!=NULL ) { fclose( OutputFID ); }
+
+	for( i=0; i<3; i++ )
+	{
+		if( BestId[i]<0 ) { fprintf(stderr,"> Best %s: none (no finite score)\n",Name[i]); continue; }
+		fprintf(stderr,"> Best %s: config %d rmse %.6g (",Name[i],BestId[i],best[i]);
+		for( c=0; c<SWEEP_N_PRMS; c++ ) { fprintf(stderr,"%s%s=%g",(c>0)?" ":"",Sweep_Prm_Names[c],p_sweep->prm[c][BestId[i]]); }
+		fprintf(stderr,")\n");
+	}
+	return TRUE;
+} /* End Sweep_Report */
+
+
+/*************************************************
+** FUNCTION: Emulator_Sweep
+** VARIABLES:
+**		[I ]	const char	*GridPath
+**		[I ]	const char	*LabelsPath
+**		[I ]	const char	*InputPath
+**		[I ]	const char	*OutputPath
+** RETURN:
+**		BOOL	1:Successful
+**					0:Failure
+** DESCRIPTION:
+** 		Replay a recording through every configuration
+** 		of the grid and score each against the labels.
+** 		DCM, GaPA and WISE are all run, whatever their
+** 		default on/off settings.
+** 		Fails if lane 0 differs from the scalar
+** 		pipeline, or if the scalar vel_ave never
+** 		changes while the subject is moving.
+*/
+bool Emulator_Sweep( const char	*GridPath,
+										 const char	*LabelsPath,
+										 const char	*InputPath,
+										 const char	*OutputPath )
+{
+	PIPELINE_STATE_TYPE *p_pipeline = new PIPELINE_STATE_TYPE();
+	SWEEP_GRID_TYPE     *p_grid     = new SWEEP_GRID_TYPE();
+	SWEEP_STATE_TYPE     sweep;
+	SWEEP_LABELS_TYPE    labels;
+	CONTROL_TYPE        *p_control  = &p_pipeline->control;
+	unsigned long nMismatch = 0, FirstMismatch = 0;
+	unsigned long nMoving = 0, nVelUpdates = 0;
+	float  vel_ave_prev;
+	double StartTime, ElapsedTime;
+	bool   ret = FALSE;
+
+	memset( &sweep, 0, sizeof(sweep) );
+	memset( &labels, 0, sizeof(labels) );
+
+	/* Scalar pipeline (also runs lane 0 for Sweep_Check) */
+	Common_Init( p_control, &p_pipeline->sensor_state );
+	if( Emulator_Init( p_control, InputPath, NULL )==FALSE ) { goto done; }
+	Read_Sensors( p_control, &p_pipeline->sensor_state );
+	if( p_control->emu_data.EndOfFile==TRUE )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Sweep : Empty recording %s",InputPath);
+		goto done;
+	}
+	p_control->DCM_on  = 1;
+	p_control->GaPA_on = 1;
+	p_control->WISE_on = 1;
+	Pipeline_Init( p_pipeline );
+
+	if( Sweep_Read_Grid( GridPath, p_control, p_grid )==FALSE ) { goto done; }
+	if( Sweep_Read_Labels( LabelsPath, &labels )==FALSE ) { goto done; }
+	if( Sweep_Init( &sweep, p_grid, p_pipeline )==FALSE ) { goto done; }
+
+	/* Scalar pipeline runs the lane 0 configuration */
+	p_control->dcm_prms.Kp_RollPitch = sweep.prm[SWEEP_DCM_KP_ROLLPITCH][0];
+	p_control->dcm_prms.Ki_RollPitch = sweep.prm[SWEEP_DCM_KI_ROLLPITCH][0];
+	p_control->gapa_prms.Kp_phi      = sweep.prm[SWEEP_GAPA_KP_phi][0];
+	p_control->gapa_prms.Ki_phi      = sweep.prm[SWEEP_GAPA_KI_phi][0];
+	p_control->gapa_prms.Kp_PHI      = sweep.prm[SWEEP_GAPA_KP_PHI][0];
+	p_control->gapa_prms.Ki_PHI      = sweep.prm[SWEEP_GAPA_KI_PHI][0];
+	p_control->gapa_prms.phimw_alpha = sweep.prm[SWEEP_GAPA_phimw_ALPHA][0];
+	p_control->gapa_prms.PHImw_alpha = sweep.prm[SWEEP_GAPA_PHImw_ALPHA][0];
+	p_control->wise_prms.correction  = sweep.prm[SWEEP_WISE_CORRECTION][0];
+	p_control->wise_prms.mini_count  = sweep.prm[SWEEP_WISE_MINCOUNT][0];
+	p_pipeline->wise_state.minCount  = p_control->wise_prms.mini_count;
+	vel_ave_prev = p_pipeline->wise_state.vel_ave[0];
+
+	StartTime = Emulator_Clock();
+	while( TRUE )
+	{
+		Read_Sensors( p_control, &p_pipeline->sensor_state );
+		if( p_control->emu_data.EndOfFile==TRUE ) { break; }
+
+		/* Scalar pipeline, this also runs the shared
+		** stages (timing, calibration, DSP) */
+		Pipeline_Update( p_pipeline );
+
+		/* All configurations */
+		Sweep_DCM_Update( &sweep, p_control, &p_pipeline->sensor_state );
+		Sweep_GaPA_Update( &sweep, p_control, &p_pipeline->sensor_state );
+		if( (p_pipeline->sensor_state.gyro_mAve>=p_control->gapa_prms.min_gyro) )
+		{
+			Sweep_WISE_Update( &sweep, p_control, &p_pipeline->sensor_state );
+			nMoving++;
+		}
+		else
+		{
+			Sweep_WISE_Reset( &sweep );
+		}
+		if( p_pipeline->wise_state.vel_ave[0]!=vel_ave_prev ) { nVelUpdates++; }
+		vel_ave_prev = p_pipeline->wise_state.vel_ave[0];
+		Sweep_Score( &sweep, &labels, p_control->timestamp );
+
+		if( Sweep_Check( &sweep, p_pipeline )==FALSE )
+		{
+			if( nMismatch==0 ) { FirstMismatch = p_control->emu_data.nSamples; }
+			nMismatch++;
+		}
+	}
+	ElapsedTime = Emulator_Clock() - StartTime;
+
+	fprintf(stderr,"> Swept %d configurations over %lu samples in %.3f s (%.0f config-samples/sec)\n",
+		sweep.nConfigs, p_control->emu_data.nSamples, ElapsedTime,
+		(ElapsedTime>0) ? ((double)sweep.nConfigs*p_control->emu_data.nSamples/ElapsedTime) : 0.0 );
+	if( nMismatch>0 )
+	{
+		fprintf(stderr,"> WARNING: lane 0 differs from the scalar pipeline on %lu samples (first: %lu)\n",nMismatch,FirstMismatch);
+	}
+	else
+	{
+		fprintf(stderr,"> Lane 0 matches the scalar pipeline on every sample\n");
+	}
+
+	/* WISE must update the speed during gait */
+	fprintf(stderr,"> WISE: %lu moving samples, vel_ave updated %lu times, %lu strides\n",
+		nMoving, nVelUpdates, (unsigned long)p_pipeline->wise_state.nStrides );
+	if( nMoving>0 && nVelUpdates==0 )
+	{
+		fprintf(stderr,"> WARNING: vel_ave never changed during gait\n");
+	}
+
+	ret = Sweep_Report( &sweep, OutputPath ) && (nMismatch==0) && ( nMoving==0 || nVelUpdates>0 );
+
+done:
+	Emulator_Close( p_control );
+	Sweep_Free( &sweep );
+	free( labels.timestamp );
+	free( labels.speed );
+	free( labels.incline );
+	free( labels.phase );
+	delete p_grid;
+	delete p_pipeline;
+	return ret;
+} /* End Emulator_Sweep */
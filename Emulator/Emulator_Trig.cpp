@@ -0,0 +1,737 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Trig
+** DESCRIPTION:
+** 		This file contains the accuracy test and benchmark of
+** 		the trig tiers (see Math.h), and the batch (vectorized)
+** 		host versions of f_atan2 and f_asin.
+** 		Every Stride-th float bit pattern is run through
+** 		each tier and compared to the double precision libm
+** 		result: sin and cos over [-4pi,4pi] (absolute
+** 		error), rsqrt and sqrt over all positive normal
+** 		floats (relative error), atan2 over every ratio y/x
+** 		in the upper half plane and asin over [-1,1] (absolute
+** 		error). A stride of 1 is the exhaustive test.
+** 		The batch functions are loops over arrays written
+** 		branch free, so the compiler vectorizes them (this
+** 		file is built with -O3, see the Makefile). They
+** 		repeat the arithmetic of the scalar tiers and are
+** 		checked bit for bit against them on every input of
+** 		the sweep.
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+
+/*******************************************************************
+** Defines *********************************************************
+********************************************************************/
+
+/* Sweep ranges (float bit patterns)
+** sin/cos: +0 to 4pi (and the negatives)
+** rsqrt/sqrt: FLT_MIN to FLT_MAX */
+#define TRIG_TEST_SINCOS_END 0x41490FDBUL
+#define TRIG_TEST_RSQRT_BEGIN 0x00800000UL
+#define TRIG_TEST_RSQRT_END   0x7F7FFFFFUL
+
+/* atan2: y over +0 to FLT_MAX, x=+-1
+** asin: +0 to 1 (and the negatives) */
+#define TRIG_TEST_ATAN2_END 0x7F7FFFFFUL
+#define TRIG_TEST_ASIN_END  0x3F800000UL
+
+/* Smallest fixed point input tested (Q30 lsb) */
+#define TRIG_TEST_Q30_MIN 9.31322574615478515625e-10f
+
+/* Inputs per block (sweep and benchmark) */
+#define TRIG_TEST_BLOCK 1024
+
+/* Benchmark passes over one block */
+#define TRIG_TEST_BENCH_REPEAT 2000
+
+
+/*******************************************************************
+** Typedefs ********************************************************
+********************************************************************/
+
+/*
+** TYPE: TRIG_TEST_TIER_TYPE
+** One tier under test and its error bounds */
+typedef struct
+{
+	const char *Name;
+	void  (*SinCos)( float x, float *p_sin, float *p_cos );
+	float (*Rsqrt)( float x );
+	double MaxSin, MaxCos, MaxRsqrt;
+} TRIG_TEST_TIER_TYPE;
+
+/*
+** TYPE: TRIG_TEST_ANGLE_TYPE
+** One atan2/asin tier under test and its error bounds */
+typedef struct
+{
+	const char *Name;
+	float (*Atan2)( float y, float x );
+	float (*Asin)( float x );
+	double MaxAtan2, MaxAsin;
+} TRIG_TEST_ANGLE_TYPE;
+
+/*
+** TYPE: TRIG_TEST_BLOCK_TYPE
+** One block of atan2/asin inputs and results */
+typedef struct
+{
+	float  y[TRIG_TEST_BLOCK], x[TRIG_TEST_BLOCK];
+	float  out[TRIG_TEST_BLOCK], batch[TRIG_TEST_BLOCK];
+	double ref[TRIG_TEST_BLOCK];
+	int    n;
+} TRIG_TEST_BLOCK_TYPE;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Libm_SinCos
+** VARIABLES:
+**		[I ]	float	x
+**		[O ]	float	*p_sin
+**		[O ]	float	*p_cos
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		libm tier of f_sincos (sinf, cosf)
+*/
+static void Trig_Test_Libm_SinCos( float x, float *p_sin, float *p_cos )
+{
+	*p_sin = sinf( x );
+	*p_cos = cosf( x );
+} /* End Trig_Test_Libm_SinCos */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Libm_Rsqrt
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float	x^-0.5
+** DESCRIPTION:
+** 		libm tier of f_rsqrt (1/sqrtf)
+*/
+static float Trig_Test_Libm_Rsqrt( float x )
+{
+	return 1.0f/sqrtf( x );
+} /* End Trig_Test_Libm_Rsqrt */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Libm_Atan2
+** VARIABLES:
+**		[I ]	float	y
+**		[I ]	float	x
+** RETURN:
+**		float	atan2(y,x)
+** DESCRIPTION:
+** 		libm tier of F_ATAN2 (atan2f)
+*/
+static float Trig_Test_Libm_Atan2( float y, float x )
+{
+	return atan2f( y, x );
+} /* End Trig_Test_Libm_Atan2 */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Libm_Asin
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float	asin(x)
+** DESCRIPTION:
+** 		libm tier of F_ASIN (asinf)
+*/
+static float Trig_Test_Libm_Asin( float x )
+{
+	return asinf( x );
+} /* End Trig_Test_Libm_Asin */
+
+
+/*************************************************
+** FUNCTION: Trig_Atan2_Batch
+** VARIABLES:
+**		[I ]	const float	*y
+**		[I ]	const float	*x
+**		[O ]	float				*out
+**		[I ]	int					n
+**		[I ]	int					tier	: TRIG_TIER_LIBM/PRECISE/FAST
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		out[k] = F_ATAN2( tier, y[k], x[k] ), bit for
+** 		bit. The precise and fast loops are the scalar
+** 		functions (f_atan2_precise, f_atan2) with the
+** 		branches written as selects, so they vectorize.
+** 		out must not overlap the inputs.
+*/
+void Trig_Atan2_Batch( const float *y, const float *x, float *out, int n, int tier )
+{
+	int k;
+
+	if( tier==TRIG_TIER_LIBM )
+	{
+		for( k=0; k<n; k++ ) { out[k] = atan2f( y[k], x[k] ); }
+	}
+	else if( tier==TRIG_TIER_PRECISE )
+	{
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			float ax, ay, hi, t, z, base;
+
+			ax = fabsf( x[k] );
+			ay = fabsf( y[k] );
+			hi = MAX( ax, ay );
+			t  = ( hi>0.0f ) ? MIN( ax, ay )/hi : 0.0f;
+
+			base = ( t>0.414213562f ) ? 0.785398163f : 0.0f;
+			t    = ( t>0.414213562f ) ? (t-1.0f)/(t+1.0f) : t;
+
+			z = t * t;
+			t = base + ((( 8.05374449538e-2f*z - 1.38776856032e-1f)*z + 1.99777106478e-1f)*z - 3.33329491539e-1f)*z*t + t;
+
+			t = ( ay>ax ) ? 1.570796327f - t : t;
+			t = ( x[k]<0 ) ? 3.141592654f - t : t;
+			out[k] = ( y[k]<0 ) ? -t : t;
+		}
+	}
+	else
+	{
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			float ax, ay, t0, t3, t4;
+
+			ax = fabsf( x[k] );
+			ay = fabsf( y[k] );
+			t0 = MAX( ax, ay );
+			t3 = ( t0>0.0f ) ? 1.0f/t0 : 0.0f;
+			t3 = MIN( ax, ay ) * t3;
+
+			t4 = t3 * t3;
+			t0 = -0.013480470f;
+			t0 = t0 * t4 + 0.057477314f;
+			t0 = t0 * t4 - 0.121239071f;
+			t0 = t0 * t4 + 0.195635925f;
+			t0 = t0 * t4 - 0.332994597f;
+			t0 = t0 * t4 + 0.999995630f;
+			t3 = t0 * t3;
+
+			t3 = ( ay>ax ) ? 1.570796327f - t3 : t3;
+			t3 = ( x[k]<0 ) ? 3.141592654f - t3 : t3;
+			out[k] = ( y[k]<0 ) ? -t3 : t3;
+		}
+	}
+} /* End Trig_Atan2_Batch */
+
+
+/*************************************************
+** FUNCTION: Trig_Asin_Batch
+** VARIABLES:
+**		[I ]	const float	*x
+**		[O ]	float				*out
+**		[I ]	int					n
+**		[I ]	int					tier	: TRIG_TIER_LIBM/PRECISE/FAST
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		out[k] = F_ASIN( tier, x[k] ), bit for bit,
+** 		as Trig_Atan2_Batch
+*/
+void Trig_Asin_Batch( const float *x, float *out, int n, int tier )
+{
+	int k;
+
+	if( tier==TRIG_TIER_LIBM )
+	{
+		for( k=0; k<n; k++ ) { out[k] = asinf( x[k] ); }
+	}
+	else if( tier==TRIG_TIER_PRECISE )
+	{
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			float negate = (float)( x[k]<0 );
+			float a      = MIN( fabsf( x[k] ), 1.0f );
+			float ret;
+
+			ret = -0.0012624911f;
+			ret = ret*a + 0.0066700901f;
+			ret = ret*a - 0.0170881256f;
+			ret = ret*a + 0.0308918810f;
+			ret = ret*a - 0.0501743046f;
+			ret = ret*a + 0.0889789874f;
+			ret = ret*a - 0.2145988016f;
+			ret = ret*a + 1.5707963050f;
+			ret = 1.57079632679f - sqrtf( 1.0f - a )*ret;
+			out[k] = ret - 2.0f * negate * ret;
+		}
+	}
+	else
+	{
+		#pragma GCC ivdep
+		for( k=0; k<n; k++ )
+		{
+			float negate = (float)( x[k]<0 );
+			float a      = MIN( fabsf( x[k] ), 1.0f );
+			float ret    = -0.0187293f;
+
+			ret *= a;
+			ret += 0.0742610f;
+			ret *= a;
+			ret -= 0.2121144f;
+			ret *= a;
+			ret += 1.5707288f;
+			ret = 1.57079632679f - sqrtf( 1.0f - a )*ret;
+			out[k] = ret - 2.0f * negate * ret;
+		}
+	}
+} /* End Trig_Asin_Batch */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Float
+** VARIABLES:
+**		[I ]	uint32_t	bits
+** RETURN:
+**		float	The float with these bits
+** DESCRIPTION:
+** 		Bit pattern to float (no aliasing)
+*/
+static float Trig_Test_Float( uint32_t bits )
+{
+	float x;
+
+	memcpy( &x, &bits, sizeof(x) );
+	return x;
+} /* End Trig_Test_Float */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_SinCos
+** VARIABLES:
+**		[I ]	unsigned long	Stride	: Bit pattern step (1: every float)
+** RETURN:
+**		int		Number of tiers over their bounds
+** DESCRIPTION:
+** 		Sweep the f_sincos and f_rsqrt tiers
+** 		against double precision libm and report
+** 		the max error of sin, cos, rsqrt and sqrt
+** 		and where it occurs.
+*/
+static int Trig_Test_SinCos( unsigned long Stride )
+{
+	const TRIG_TEST_TIER_TYPE Tiers[NUM_TRIG_TIERS] =
+	{
+		{ "libm",    Trig_Test_Libm_SinCos, Trig_Test_Libm_Rsqrt, TRIG_LIBM_SIN_ERROR,    TRIG_LIBM_COS_ERROR,    TRIG_LIBM_RSQRT_ERROR    },
+		{ "precise", f_sincos_precise,      f_rsqrt_precise,      TRIG_PRECISE_SIN_ERROR, TRIG_PRECISE_COS_ERROR, TRIG_PRECISE_RSQRT_ERROR },
+		{ "fast",    f_sincos_fast,         f_rsqrt_fast,         TRIG_FAST_SIN_ERROR,    TRIG_FAST_COS_ERROR,    TRIG_FAST_RSQRT_ERROR    }
+	};
+	const TRIG_TEST_TIER_TYPE *p_tier;
+	unsigned long nSinCos = 0, nRsqrt = 0;
+	uint64_t bits;
+	float  x, s, c, y;
+	double Error, MaxSin, MaxCos, MaxRsqrt, MaxSqrt, xd;
+	float  AtSin = 0.0f, AtCos = 0.0f, AtRsqrt = 0.0f, AtSqrt = 0.0f;
+	double StartTime;
+	int    nFailed = 0;
+	int    t, sign;
+
+	for( t=0; t<NUM_TRIG_TIERS; t++ )
+	{
+		p_tier    = &Tiers[t];
+		MaxSin    = MaxCos = MaxRsqrt = MaxSqrt = 0.0;
+		nSinCos   = nRsqrt = 0;
+		StartTime = Emulator_Clock();
+
+		/* sin/cos over [-4pi,4pi], absolute error */
+		for( bits=0; bits<=TRIG_TEST_SINCOS_END; bits+=Stride )
+		{
+			for( sign=0; sign<2; sign++ )
+			{
+				x = Trig_Test_Float( (uint32_t)bits | ( sign ? 0x80000000UL : 0 ) );
+				p_tier->SinCos( x, &s, &c );
+				Error = fabs( (double)s - sin( (double)x ) );
+				if( Error>MaxSin ) { MaxSin = Error; AtSin = x; }
+				Error = fabs( (double)c - cos( (double)x ) );
+				if( Error>MaxCos ) { MaxCos = Error; AtCos = x; }
+				nSinCos++;
+			}
+		}
+
+		/* rsqrt and sqrt over the positive normals,
+		** relative error (f_sqrt is x*rsqrt(x) on
+		** the polynomial tiers) */
+		for( bits=TRIG_TEST_RSQRT_BEGIN; bits<=TRIG_TEST_RSQRT_END; bits+=Stride )
+		{
+			x  = Trig_Test_Float( (uint32_t)bits );
+			xd = (double)x;
+			y  = p_tier->Rsqrt( x );
+			Error = fabs( (double)y*sqrt( xd ) - 1.0 );
+			if( Error>MaxRsqrt ) { MaxRsqrt = Error; AtRsqrt = x; }
+			y  = ( t==TRIG_TIER_LIBM ) ? sqrtf( x ) : x*y;
+			Error = fabs( (double)y/sqrt( xd ) - 1.0 );
+			if( Error>MaxSqrt ) { MaxSqrt = Error; AtSqrt = x; }
+			nRsqrt++;
+		}
+
+		fprintf(stderr,"> %-7s : sin   max error %.3g at %.9g (bound %.3g)\n", p_tier->Name, MaxSin, AtSin, p_tier->MaxSin );
+		fprintf(stderr,"> %-7s : cos   max error %.3g at %.9g (bound %.3g)\n", p_tier->Name, MaxCos, AtCos, p_tier->MaxCos );
+		fprintf(stderr,"> %-7s : rsqrt max rel. error %.3g at %.9g (bound %.3g)\n", p_tier->Name, MaxRsqrt, AtRsqrt, p_tier->MaxRsqrt );
+		fprintf(stderr,"> %-7s : sqrt  max rel. error %.3g at %.9g (bound %.3g)\n", p_tier->Name, MaxSqrt, AtSqrt, p_tier->MaxRsqrt );
+		fprintf(stderr,"> %-7s : %lu sin/cos and %lu rsqrt/sqrt inputs in %.1f s\n", p_tier->Name, nSinCos, nRsqrt, Emulator_Clock() - StartTime );
+
+		if( MaxSin>p_tier->MaxSin || MaxCos>p_tier->MaxCos || MaxRsqrt>p_tier->MaxRsqrt || MaxSqrt>p_tier->MaxRsqrt )
+		{
+			LOG_PRINTLN("> %s tier over its error bounds",p_tier->Name);
+			nFailed++;
+		}
+	}
+
+	return nFailed;
+} /* End Trig_Test_SinCos */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Block
+** VARIABLES:
+**		[IO]	TRIG_TEST_BLOCK_TYPE				*p_block
+**		[I ]	const TRIG_TEST_ANGLE_TYPE	*Tiers
+**		[I ]	bool												IsAsin
+**		[IO]	double											MaxError[]	: Per tier
+**		[IO]	float												At[]				: Per tier
+** RETURN:
+**		unsigned long	Batch results which differ from the scalar ones
+** DESCRIPTION:
+** 		Run one block of atan2 (y,x) or asin (x)
+** 		inputs through each float tier, scalar
+** 		and batch, and update the max error
+** 		against p_block->ref. Angles are compared
+** 		modulo 2pi.
+*/
+static unsigned long Trig_Test_Block( TRIG_TEST_BLOCK_TYPE				*p_block,
+																			const TRIG_TEST_ANGLE_TYPE	*Tiers,
+																			bool												IsAsin,
+																			double											MaxError[],
+																			float												At[] )
+{
+	unsigned long nMismatch = 0;
+	double Error;
+	int t, k;
+
+	for( t=0; t<NUM_TRIG_TIERS; t++ )
+	{
+		if( IsAsin==TRUE ) { Trig_Asin_Batch( p_block->x, p_block->batch, p_block->n, t ); }
+		else               { Trig_Atan2_Batch( p_block->y, p_block->x, p_block->batch, p_block->n, t ); }
+
+		for( k=0; k<p_block->n; k++ )
+		{
+			p_block->out[k] = ( IsAsin==TRUE ) ? Tiers[t].Asin( p_block->x[k] ) : Tiers[t].Atan2( p_block->y[k], p_block->x[k] );
+			Error = fabs( (double)p_block->out[k] - p_block->ref[k] );
+			Error = ( Error>PI ) ? TWOPI - Error : Error; /* -pi and pi (atan2(-0,x<0)) */
+			if( Error>MaxError[t] ) { MaxError[t] = Error; At[t] = ( IsAsin==TRUE ) ? p_block->x[k] : p_block->y[k]/p_block->x[k]; }
+			if( memcmp( &p_block->out[k], &p_block->batch[k], sizeof(float) )!=0 ) { nMismatch++; }
+		}
+	}
+	return nMismatch;
+} /* End Trig_Test_Block */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Fixed
+** VARIABLES:
+**		[I ]	float		y
+**		[I ]	float		x
+**		[IO]	double	*p_MaxError
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		q_atan2 of (y,x) in Q30 (|y|,|x|<=1)
+** 		against atan2 of the same Q30 values
+** 		(modulo 2pi)
+*/
+static void Trig_Test_Fixed( float y, float x, double *p_MaxError )
+{
+	int32_t qy = Q_FROM_FLOAT( y, 30 ), qx = Q_FROM_FLOAT( x, 30 );
+	double  Error;
+
+	if( qy==0 && qx==0 ) { return; }
+	Error = fabs( (double)q_atan2( qy, qx )/(double)( 1L<<Q_ANGLE_SHIFT ) - atan2( (double)qy, (double)qx ) );
+	Error = ( Error>PI ) ? TWOPI - Error : Error;
+	*p_MaxError = ( Error>*p_MaxError ) ? Error : *p_MaxError;
+} /* End Trig_Test_Fixed */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Angles
+** VARIABLES:
+**		[I ]	unsigned long	Stride	: Bit pattern step (1: every float)
+** RETURN:
+**		int		Number of tiers over their bounds
+**					(or with batch mismatches)
+** DESCRIPTION:
+** 		Sweep the atan2 and asin tiers (float
+** 		and fixed point) against double precision
+** 		libm and report the max error, and check
+** 		the batch versions against the scalar ones
+*/
+static int Trig_Test_Angles( unsigned long Stride )
+{
+	const TRIG_TEST_ANGLE_TYPE Tiers[NUM_TRIG_TIERS] =
+	{
+		{ "libm",    Trig_Test_Libm_Atan2, Trig_Test_Libm_Asin, TRIG_LIBM_ATAN2_ERROR,    TRIG_LIBM_ASIN_ERROR    },
+		{ "precise", f_atan2_precise,      f_asin_precise,      TRIG_PRECISE_ATAN2_ERROR, TRIG_PRECISE_ASIN_ERROR },
+		{ "fast",    f_atan2,              f_asin,              TRIG_FAST_ATAN2_ERROR,    TRIG_FAST_ASIN_ERROR    }
+	};
+	TRIG_TEST_BLOCK_TYPE *p_block;
+	double MaxAtan2[NUM_TRIG_TIERS] = { 0.0 }, MaxAsin[NUM_TRIG_TIERS] = { 0.0 };
+	float  AtAtan2[NUM_TRIG_TIERS]  = { 0.0f }, AtAsin[NUM_TRIG_TIERS] = { 0.0f };
+	double MaxFixedAtan2 = 0.0, MaxFixedAsin = 0.0, Error;
+	unsigned long nMismatch = 0, nAtan2 = 0, nAsin = 0;
+	uint64_t bits;
+	float  v;
+	int32_t qx;
+	double StartTime;
+	int    nFailed = 0;
+	int    t, q;
+
+	p_block   = new TRIG_TEST_BLOCK_TYPE;
+	StartTime = Emulator_Clock();
+
+	/* atan2: y=v, x=+-1 covers every ratio in the upper
+	** half plane (both octants of each quadrant). Every
+	** tier negates the result for y<0, so the lower half
+	** plane has the same errors */
+	p_block->n = 0;
+	for( bits=0; bits<=TRIG_TEST_ATAN2_END; bits+=Stride )
+	{
+		v = Trig_Test_Float( (uint32_t)bits );
+		for( q=0; q<2; q++ )
+		{
+			p_block->y[p_block->n]   = v;
+			p_block->x[p_block->n]   = ( q ) ? -1.0f : 1.0f;
+			p_block->ref[p_block->n] = atan2( (double)p_block->y[p_block->n], (double)p_block->x[p_block->n] );
+			p_block->n++;
+			/* Fixed point (Q30, from 2^-30, smaller values
+			** all round to 0 or 1 lsb) */
+			if( v<=1.0f && v>=TRIG_TEST_Q30_MIN )
+			{
+				Trig_Test_Fixed( p_block->y[p_block->n-1], p_block->x[p_block->n-1], &MaxFixedAtan2 );
+			}
+		}
+		if( p_block->n==TRIG_TEST_BLOCK || bits+Stride>TRIG_TEST_ATAN2_END )
+		{
+			nMismatch += Trig_Test_Block( p_block, Tiers, FALSE, MaxAtan2, AtAtan2 );
+			nAtan2    += p_block->n;
+			p_block->n = 0;
+		}
+	}
+
+	/* asin over [-1,1] */
+	for( bits=0; bits<=TRIG_TEST_ASIN_END; bits+=Stride )
+	{
+		v = Trig_Test_Float( (uint32_t)bits );
+		for( q=0; q<2; q++ )
+		{
+			p_block->x[p_block->n]   = ( q ) ? -v : v;
+			p_block->ref[p_block->n] = asin( (double)p_block->x[p_block->n] );
+			p_block->n++;
+
+		}
+
+		/* Fixed point, x>=2^-30 (q_asin is q_atan2 in the
+		** right half plane, the sign of x only flips
+		** the CORDIC rotations) */
+		if( v>=TRIG_TEST_Q30_MIN )
+		{
+			qx    = Q_FROM_FLOAT( v, 30 );
+			Error = fabs( (double)q_asin( qx )/(double)( 1L<<Q_ANGLE_SHIFT ) - asin( (double)qx/(double)( 1L<<30 ) ) );
+			MaxFixedAsin = ( Error>MaxFixedAsin ) ? Error : MaxFixedAsin;
+		}
+		if( p_block->n==TRIG_TEST_BLOCK || bits+Stride>TRIG_TEST_ASIN_END )
+		{
+			nMismatch += Trig_Test_Block( p_block, Tiers, TRUE, MaxAsin, AtAsin );
+			nAsin     += p_block->n;
+			p_block->n = 0;
+		}
+	}
+	delete p_block;
+
+	for( t=0; t<NUM_TRIG_TIERS; t++ )
+	{
+		fprintf(stderr,"> %-7s : atan2 max error %.3g at y/x %.9g (bound %.3g)\n", Tiers[t].Name, MaxAtan2[t], AtAtan2[t], Tiers[t].MaxAtan2 );
+		fprintf(stderr,"> %-7s : asin  max error %.3g at %.9g (bound %.3g)\n", Tiers[t].Name, MaxAsin[t], AtAsin[t], Tiers[t].MaxAsin );
+		if( MaxAtan2[t]>Tiers[t].MaxAtan2 || MaxAsin[t]>Tiers[t].MaxAsin )
+		{
+			LOG_PRINTLN("> %s tier over its error bounds",Tiers[t].Name);
+			nFailed++;
+		}
+	}
+	fprintf(stderr,"> fixed   : atan2 max error %.3g (bound %.3g)\n", MaxFixedAtan2, TRIG_FIXED_ATAN2_ERROR );
+	fprintf(stderr,"> fixed   : asin  max error %.3g (bound %.3g)\n", MaxFixedAsin, TRIG_FIXED_ASIN_ERROR );
+	if( MaxFixedAtan2>TRIG_FIXED_ATAN2_ERROR || MaxFixedAsin>TRIG_FIXED_ASIN_ERROR )
+	{
+		LOG_PRINTLN("> fixed tier over its error bounds");
+		nFailed++;
+	}
+	fprintf(stderr,"> %lu atan2 and %lu asin inputs in %.1f s, %lu batch mismatches\n", nAtan2, nAsin, Emulator_Clock() - StartTime, nMismatch );
+	if( nMismatch>0 )
+	{
+		LOG_PRINTLN("> Batch results differ from the scalar tiers");
+		nFailed++;
+	}
+
+	return nFailed;
+} /* End Trig_Test_Angles */
+
+
+/*************************************************
+** FUNCTION: Trig_Test_Bench
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Time each atan2/asin tier, scalar, batch
+** 		and fixed point, over one block of inputs
+** 		(ns per call). Host timings, for comparing
+** 		the tiers with each other.
+*/
+static void Trig_Test_Bench( void )
+{
+	const char *Names[NUM_TRIG_TIERS] = { "libm", "precise", "fast" };
+	TRIG_TEST_BLOCK_TYPE *p_block;
+	int32_t qy[TRIG_TEST_BLOCK], qx[TRIG_TEST_BLOCK];
+	volatile float   Sink  = 0.0f;
+	volatile int32_t qSink = 0;
+	double  StartTime, Scalar, Batch, nCalls;
+	uint32_t seed = 12345;
+	float   acc;
+	int32_t qacc;
+	int     t, r, k;
+
+	p_block = new TRIG_TEST_BLOCK_TYPE;
+	p_block->n = TRIG_TEST_BLOCK;
+	for( k=0; k<TRIG_TEST_BLOCK; k++ )
+	{
+		seed = seed*1664525UL + 1013904223UL;
+		p_block->y[k] = (float)( seed>>8 )/(float)( 1UL<<24 )*2.0f - 1.0f;
+		seed = seed*1664525UL + 1013904223UL;
+		p_block->x[k] = (float)( seed>>8 )/(float)( 1UL<<24 )*2.0f - 1.0f;
+		qy[k] = Q_FROM_FLOAT( p_block->y[k], 30 );
+		qx[k] = Q_FROM_FLOAT( p_block->x[k], 30 );
+	}
+	nCalls = (double)TRIG_TEST_BENCH_REPEAT*TRIG_TEST_BLOCK;
+
+	for( t=0; t<NUM_TRIG_TIERS; t++ )
+	{
+		/* atan2 */
+		acc = 0.0f;
+		StartTime = Emulator_Clock();
+		for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+		{
+			for( k=0; k<TRIG_TEST_BLOCK; k++ )
+			{
+				acc += ( t==TRIG_TIER_LIBM ) ? atan2f( p_block->y[k], p_block->x[k] ) : ( ( t==TRIG_TIER_PRECISE ) ? f_atan2_precise( p_block->y[k], p_block->x[k] ) : f_atan2( p_block->y[k], p_block->x[k] ) );
+			}
+		}
+		Scalar = Emulator_Clock() - StartTime;
+		StartTime = Emulator_Clock();
+		for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+		{
+			Trig_Atan2_Batch( p_block->y, p_block->x, p_block->batch, TRIG_TEST_BLOCK, t );
+			acc += p_block->batch[r%TRIG_TEST_BLOCK];
+		}
+		Batch = Emulator_Clock() - StartTime;
+		fprintf(stderr,"> %-7s : atan2 %6.2f ns/call, batch %6.2f ns/call\n", Names[t], Scalar*1.0e9/nCalls, Batch*1.0e9/nCalls );
+
+		/* asin */
+		StartTime = Emulator_Clock();
+		for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+		{
+			for( k=0; k<TRIG_TEST_BLOCK; k++ )
+			{
+				acc += ( t==TRIG_TIER_LIBM ) ? asinf( p_block->x[k] ) : ( ( t==TRIG_TIER_PRECISE ) ? f_asin_precise( p_block->x[k] ) : f_asin( p_block->x[k] ) );
+			}
+		}
+		Scalar = Emulator_Clock() - StartTime;
+		StartTime = Emulator_Clock();
+		for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+		{
+			Trig_Asin_Batch( p_block->x, p_block->batch, TRIG_TEST_BLOCK, t );
+			acc += p_block->batch[r%TRIG_TEST_BLOCK];
+		}
+		Batch = Emulator_Clock() - StartTime;
+		fprintf(stderr,"> %-7s : asin  %6.2f ns/call, batch %6.2f ns/call\n", Names[t], Scalar*1.0e9/nCalls, Batch*1.0e9/nCalls );
+		Sink = Sink + acc;
+	}
+
+	/* Fixed point (CORDIC) */
+	qacc = 0;
+	StartTime = Emulator_Clock();
+	for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+	{
+		for( k=0; k<TRIG_TEST_BLOCK; k++ ) { qacc += q_atan2( qy[k], qx[k] ); }
+	}
+	Scalar = Emulator_Clock() - StartTime;
+	StartTime = Emulator_Clock();
+	for( r=0; r<TRIG_TEST_BENCH_REPEAT; r++ )
+	{
+		for( k=0; k<TRIG_TEST_BLOCK; k++ ) { qacc += q_asin( qx[k] ); }
+	}
+	Batch = Emulator_Clock() - StartTime;
+	fprintf(stderr,"> fixed   : atan2 %6.2f ns/call, asin %6.2f ns/call\n", Scalar*1.0e9/nCalls, Batch*1.0e9/nCalls );
+	qSink = qSink + qacc;
+
+	delete p_block;
+} /* End Trig_Test_Bench */
+
+
+/*************************************************
+** FUNCTION: Emulator_Trig_Test
+** VARIABLES:
+**		[I ]	unsigned long	Stride	: Bit pattern step (1: every float)
+** RETURN:
+**		int		0:Passed
+**					1:An error over its bound
+**					-1:Failure
+** DESCRIPTION:
+** 		Sweep each trig tier against double
+** 		precision libm and report the max
+** 		errors, then time the atan2/asin tiers.
+** 		The test fails if a tier is over the
+** 		bounds in Math.h, or if a batch result
+** 		differs from its scalar tier.
+*/
+int Emulator_Trig_Test( unsigned long Stride )
+{
+	int nFailed;
+
+	if( Stride<1 ) { return -1; }
+	fprintf(stderr,"> Trig tiers, every %lu float(s), selected tier %d (DCM angles %d, GaPA angles %d)\n",
+		Stride, TRIG_TIER, DCM_ANGLE_TIER, GAPA_ANGLE_TIER );
+
+	nFailed  = Trig_Test_SinCos( Stride );
+	nFailed += Trig_Test_Angles( Stride );
+	Trig_Test_Bench();
+
+	return ( nFailed==0 ) ? 0 : 1;
+} /* End Emulator_Trig_Test */
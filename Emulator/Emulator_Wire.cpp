@@ -0,0 +1,356 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Wire
+** DESCRIPTION:
+** 		This file contains a host (Linux) stand-in for the
+** 		Arduino Wire (I2C) object, used to test the batched
+** 		I2C transaction layer (I2C_Functions) without the
+** 		board. Each device is a register file with an auto
+** 		incrementing register pointer. The bus time is counted
+** 		in SCL clocks, so the time per sample can be measured
+** 		and checked against a threshold (WISE_Emulator -w).
+**		These functions can only be used in emulation mode.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#include "../Include/Emulator_Protos.h"
+
+
+/*******************************************************************
+** Defines *********************************************************
+********************************************************************/
+
+/* IMU10736 data registers (see IMU10736_Config.h)
+** The sample reads are queued as in Init_IMU */
+#define EMU_WIRE_GYRO_ADDRESS  0x68
+#define EMU_WIRE_GYRO_DATA     0x1D
+#define EMU_WIRE_ACCEL_ADDRESS 0x53
+#define EMU_WIRE_ACCEL_DATA    0x32
+#define EMU_WIRE_MAGN_ADDRESS  0x1E
+#define EMU_WIRE_MAGN_DATA     0x03
+
+
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* The I2C bus (see EMULATOR_WIRE_TYPE in Emulator_Config.h) */
+EMULATOR_WIRE_TYPE Wire;
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Device
+** VARIABLES:
+**		[I ]	uint8_t	address
+** RETURN:
+**		EMULATOR_I2C_DEVICE_TYPE*	The device,
+**															NULL if none
+** DESCRIPTION:
+** 		Find the device at an address
+*/
+EMULATOR_I2C_DEVICE_TYPE *Emulator_Wire_Device( uint8_t address )
+{
+	int i;
+
+	for( i=0; i<Wire.nDevices; i++ )
+	{
+		if( Wire.device[i].address==address ) { return &Wire.device[i]; }
+	}
+	return NULL;
+} /* End Emulator_Wire_Device */
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Reset
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Remove all devices and clear the
+** 		bus counters
+*/
+void Emulator_Wire_Reset( void )
+{
+	memset( &Wire, 0, sizeof(Wire) );
+	Wire.clock = 100000; /* Wire default */
+} /* End Emulator_Wire_Reset */
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Add_Device
+** VARIABLES:
+**		[I ]	uint8_t	address
+** RETURN:
+**		BOOL	1:Successful
+**					0:No room
+** DESCRIPTION:
+** 		Attach a device (registers all 0)
+** 		to the bus
+*/
+bool Emulator_Wire_Add_Device( uint8_t address )
+{
+	if( Wire.nDevices>=EMU_WIRE_DEVICES ) { return FALSE; }
+
+	memset( &Wire.device[Wire.nDevices], 0, sizeof(EMULATOR_I2C_DEVICE_TYPE) );
+	Wire.device[Wire.nDevices].address = address;
+	Wire.nDevices++;
+	return TRUE;
+} /* End Emulator_Wire_Add_Device */
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Load
+** VARIABLES:
+**		[I ]	uint8_t				address
+**		[I ]	uint8_t				reg
+**		[I ]	const uint8_t	*p_data
+**		[I ]	int						length
+** RETURN:
+**		BOOL	1:Successful
+**					0:No such device
+** DESCRIPTION:
+** 		Set device registers directly (a new
+** 		sample), without any bus traffic
+*/
+bool Emulator_Wire_Load( uint8_t				address,
+												 uint8_t				reg,
+												 const uint8_t	*p_data,
+												 int						length )
+{
+	EMULATOR_I2C_DEVICE_TYPE *p_device = Emulator_Wire_Device( address );
+	int i;
+
+	if( p_device==NULL ) { return FALSE; }
+	for( i=0; i<length; i++ ) { p_device->reg[(uint8_t)(reg+i)] = p_data[i]; }
+	return TRUE;
+} /* End Emulator_Wire_Load */
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Time
+** VARIABLES:
+**		[I ]	unsigned long	nBits
+** RETURN:
+**		double	Bus time (us)
+** DESCRIPTION:
+** 		Convert SCL clocks to time at the
+** 		current bus clock
+*/
+double Emulator_Wire_Time( unsigned long nBits )
+{
+	return (double)nBits*1.0e6/Wire.clock;
+} /* End Emulator_Wire_Time */
+
+
+/*************************************************
+** EMULATOR_WIRE_TYPE (TwoWire stand-in)
+** Same calls and return values as the Arduino
+** Wire library (endTransmission: 0 success,
+** 2 address NACK)
+*/
+void EMULATOR_WIRE_TYPE::begin( void )
+{
+	tx_length = 0;
+	rx_length = 0;
+	rx_index  = 0;
+}
+
+void EMULATOR_WIRE_TYPE::setClock( uint32_t frequency )
+{
+	clock = frequency;
+}
+
+void EMULATOR_WIRE_TYPE::beginTransmission( uint8_t address )
+{
+	tx_address = address;
+	tx_length  = 0;
+}
+
+size_t EMULATOR_WIRE_TYPE::write( uint8_t data )
+{
+	if( tx_length>=EMU_WIRE_BUFFER ) { return 0; }
+	tx[tx_length++] = data;
+	return 1;
+}
+
+uint8_t EMULATOR_WIRE_TYPE::endTransmission( uint8_t stop )
+{
+	EMULATOR_I2C_DEVICE_TYPE *p_device = Emulator_Wire_Device( tx_address );
+	int i;
+
+	/* START, address, data bytes */
+	nTransactions++;
+	nBits += 1 + 9;
+	if( p_device==NULL )
+	{
+		nStops++;
+		nBits += 1;
+		return 2;
+	}
+	nBits += 9*tx_length;
+	if( stop ) { nStops++; nBits += 1; }
+
+	/* First byte sets the register pointer,
+	** the rest are written from there */
+	if( tx_length>0 ) { p_device->pointer = tx[0]; }
+	for( i=1; i<tx_length; i++ ) { p_device->reg[p_device->pointer++] = tx[i]; }
+
+	tx_length = 0;
+	return 0;
+}
+
+uint8_t EMULATOR_WIRE_TYPE::requestFrom( uint8_t address, uint8_t quantity, uint8_t stop )
+{
+	EMULATOR_I2C_DEVICE_TYPE *p_device = Emulator_Wire_Device( address );
+	int i;
+
+	rx_length = 0;
+	rx_index  = 0;
+	if( quantity>EMU_WIRE_BUFFER ) { quantity = EMU_WIRE_BUFFER; }
+
+	/* (repeated) START, address */
+	nTransactions++;
+	nBits += 1 + 9;
+	if( p_device==NULL )
+	{
+		nStops++;
+		nBits += 1;
+		return 0;
+	}
+	nBits += 9*quantity;
+	if( stop ) { nStops++; nBits += 1; }
+
+	for( i=0; i<quantity; i++ ) { rx[i] = p_device->reg[p_device->pointer++]; }
+	rx_length = quantity;
+	return quantity;
+}
+
+int EMULATOR_WIRE_TYPE::available( void )
+{
+	return rx_length - rx_index;
+}
+
+int EMULATOR_WIRE_TYPE::read( void )
+{
+	if( rx_index>=rx_length ) { return -1; }
+	return rx[rx_index++];
+}
+
+
+/*************************************************
+** FUNCTION: Emulator_Wire_Test
+** VARIABLES:
+**		[I ]	const char	*InputPath
+**		[I ]	double			MaxBusTime
+** RETURN:
+**		int		0:Passed
+**					1:Bus time per sample over MaxBusTime
+**					-1:Failure (or data read back wrong)
+** DESCRIPTION:
+** 		Read every sample of a recording through
+** 		the IMU10736 read set (I2C_Run) on the Wire
+** 		stand-in, check the bytes read back and
+** 		report the bus time per sample. The same
+** 		reads, each released with a STOP, are timed
+** 		for comparison. A MaxBusTime of 0 (us)
+** 		disables the threshold.
+*/
+int Emulator_Wire_Test( const char	*InputPath,
+												double			MaxBusTime )
+{
+	CONTROL_TYPE      reader;
+	SENSOR_STATE_TYPE reader_sensor;
+	I2C_SET_TYPE      set;
+	uint8_t           data[I2C_MAX_READS][I2C_MAX_LENGTH];
+	unsigned long     nSamples = 0, nMismatch = 0, nBits;
+	unsigned long     Set_bits = 0, Set_transactions = 0, Single_bits = 0;
+	double            Set_time;
+	int               i;
+
+	memset( &reader, 0, sizeof(reader) );
+	memset( &reader_sensor, 0, sizeof(reader_sensor) );
+	if( Emulator_Init( &reader, InputPath, NULL )==FALSE ) { return -1; }
+
+	Emulator_Wire_Reset();
+	Emulator_Wire_Add_Device( EMU_WIRE_GYRO_ADDRESS );
+	Emulator_Wire_Add_Device( EMU_WIRE_ACCEL_ADDRESS );
+	Emulator_Wire_Add_Device( EMU_WIRE_MAGN_ADDRESS );
+	Wire.begin();
+	Wire.setClock( I2C_CLOCK );
+
+	I2C_Set_Init( &set );
+	I2C_Queue_Read( &set, EMU_WIRE_GYRO_ADDRESS, EMU_WIRE_GYRO_DATA, 6 );
+	I2C_Queue_Read( &set, EMU_WIRE_ACCEL_ADDRESS, EMU_WIRE_ACCEL_DATA, 6 );
+	I2C_Queue_Read( &set, EMU_WIRE_MAGN_ADDRESS, EMU_WIRE_MAGN_DATA, 6 );
+
+	while( TRUE )
+	{
+		Read_Sensors( &reader, &reader_sensor );
+		if( reader.emu_data.EndOfFile==TRUE ) { break; }
+
+		/* New sample in the data registers
+		** (gyro and magn big endian, accel little endian) */
+		for( i=0; i<3; i++ )
+		{
+			data[0][2*i]   = (uint8_t)( (uint16_t)lrintf( reader_sensor.gyro[i] )>>8 );
+			data[0][2*i+1] = (uint8_t)( (uint16_t)lrintf( reader_sensor.gyro[i] ) );
+			data[1][2*i]   = (uint8_t)( (uint16_t)lrintf( reader_sensor.accel[i] ) );
+			data[1][2*i+1] = (uint8_t)( (uint16_t)lrintf( reader_sensor.accel[i] )>>8 );
+			data[2][2*i]   = (uint8_t)( (uint16_t)lrintf( reader_sensor.mag[i] )>>8 );
+			data[2][2*i+1] = (uint8_t)( (uint16_t)lrintf( reader_sensor.mag[i] ) );
+		}
+		for( i=0; i<set.nReads; i++ ) { Emulator_Wire_Load( set.read[i].address, set.read[i].reg, data[i], set.read[i].length ); }
+
+		/* Batched */
+		nBits = Wire.nBits;
+		Set_transactions -= Wire.nTransactions;
+		if( I2C_Run( &set )==FALSE ) { break; }
+		Set_transactions += Wire.nTransactions;
+		Set_bits += Wire.nBits - nBits;
+
+		for( i=0; i<set.nReads; i++ )
+		{
+			if( memcmp( set.read[i].data, data[i], set.read[i].length )!=0 ) { nMismatch++; }
+		}
+
+		/* One read at a time */
+		nBits = Wire.nBits;
+		for( i=0; i<set.nReads; i++ ) { I2C_Read_Block( &set.read[i], TRUE ); }
+		Single_bits += Wire.nBits - nBits;
+
+		nSamples++;
+	}
+	Emulator_Close( &reader );
+
+	if( nSamples==0 || set.nErrors>0 || nMismatch>0 )
+	{
+		LOG_PRINTLN("ERROR : Emulator_Wire_Test : %lu samples, %u bus errors, %lu read back wrong",nSamples,set.nErrors,nMismatch);
+		return -1;
+	}
+
+	Set_time = Emulator_Wire_Time( Set_bits )/nSamples;
+	fprintf(stderr,"> %lu samples at %u Hz: %d reads, %.1f transactions, %.1f us bus time per sample\n",
+		nSamples, Wire.clock, set.nReads, (double)Set_transactions/nSamples, Set_time );
+	fprintf(stderr,"> One read at a time (STOP after each): %.1f us per sample\n",
+		Emulator_Wire_Time( Single_bits )/nSamples );
+
+	if( MaxBusTime>0.0 && Set_time>MaxBusTime )
+	{
+		fprintf(stderr,"> Bus time %.1f us per sample is over %.1f us\n",Set_time,MaxBusTime);
+		return 1;
+	}
+	return 0;
+} /* End Emulator_Wire_Test */
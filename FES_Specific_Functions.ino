@@ -125,7 +125,11 @@ void FES_Update (
     LED_DF_SET_LOW;
     LED_PF_SET_LOW;
    
-  /* At given event, trigger relay */
+  /* At given event, trigger relay
+  ** The PHASE_ANGLE_SWITCH_ON_EVENT* conditions should test
+  ** p_gapa_state->nu_predicted rather than nu_normalized, so
+  ** the relays switch at the phase they are set for despite
+  ** the processing and relay delays (see GAPA_PREDICT_MS) */
 	if( PHASE_ANGLE_SWITCH_ON_EVENT )
 	{
 		/* Relay : On (High), update state variables */
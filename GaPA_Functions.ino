@@ -59,6 +59,7 @@ void GaPA_Init( CONTROL_TYPE			*p_control,
 	p_control->gapa_prms.gait_end_threshold = GAPA_GAIT_END_THRESH;
 	p_control->gapa_prms.default_z_phi      = GAPA_DEFAULT_Z_phi;
 	p_control->gapa_prms.default_z_PHI      = GAPA_DEFAULT_Z_PHI;
+	p_control->gapa_prms.predict_time       = GAPA_PREDICT_MS/1000.0f;
 	
 		
 	/*
@@ -92,6 +93,14 @@ void GaPA_Init( CONTROL_TYPE			*p_control,
 	p_gapa_state->PErr_PHI     = 0.0f;
 	p_gapa_state->IErr_PHI     = 0.0f;
 	p_gapa_state->nu           = 0.0f;
+	p_gapa_state->nu_predicted = 0.0f;
+	p_gapa_state->nu_rate      = 0.0f;
+	p_gapa_state->nu_normalized_prev = 0.0f;
+	p_gapa_state->stride_phase = 0.0f;
+	p_gapa_state->stride_time  = 0.0f;
+	p_gapa_state->stride_rate  = 0.0f;
+
+	GaPA_Circle_Init( &p_gapa_state->circle );
 }/* End GaPA_Init */
 
 
@@ -116,9 +125,154 @@ void GaPA_Reset( CONTROL_TYPE			*p_control,
 	p_gapa_state->GAMMA        = 0.0f;
 	p_gapa_state->z_phi        = p_control->gapa_prms.default_z_phi;
 	p_gapa_state->z_PHI        = p_control->gapa_prms.default_z_PHI;
+
+	GaPA_Circle_Init( &p_gapa_state->circle );
 }/* End GaPA_Reset */
 
 
+/*****************************************************************
+** FUNCTION: GaPA_Circle_Init
+** VARIABLES:
+**		[O ]	GAPA_CIRCLE_FIT_TYPE	*p_circle
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty the circle fit, the center starts at 0
+*/
+void GaPA_Circle_Init( GAPA_CIRCLE_FIT_TYPE *p_circle )
+{
+	memset( p_circle, 0, sizeof(GAPA_CIRCLE_FIT_TYPE) );
+}/* End GaPA_Circle_Init */
+
+
+/*****************************************************************
+** FUNCTION: GaPA_Circle_Push
+** VARIABLES:
+**		[IO]	GAPA_CIRCLE_FIT_TYPE	*p_circle
+**		[I ]	float									x
+**		[I ]	float									y
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Add a phase portrait point to the moment sums.
+** 		Sliding: the point leaving the window is
+** 		subtracted, and the sums are rebuilt from
+** 		the kept points once per window.
+** 		Exponential: the sums decay by
+** 		GAPA_CIRCLE_LAMBDA first.
+** 		The origin and non finite points (the
+** 		normalization of a zero point) are skipped,
+** 		as in calc_circle_center.
+*/
+void GaPA_Circle_Push( GAPA_CIRCLE_FIT_TYPE	*p_circle,
+											 float								x,
+											 float								y )
+{
+	float z;
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_SLIDING
+	uint32_t slot, i;
+	float    xo, yo, zo;
+#endif
+
+	if( ( x==0.0f && y==0.0f ) || x!=x || y!=y ) { return; }
+	z = x*x + y*y;
+
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_SLIDING
+	slot = p_circle->n & GAPA_CIRCLE_MASK;
+	if( p_circle->n>=GAPA_CIRCLE_WINDOW )
+	{
+		xo = p_circle->x[slot];
+		yo = p_circle->y[slot];
+		zo = xo*xo + yo*yo;
+		p_circle->S1  -= 1.0f;
+		p_circle->Sx  -= xo;     p_circle->Sy  -= yo;
+		p_circle->Sxx -= xo*xo;  p_circle->Sxy -= xo*yo;  p_circle->Syy -= yo*yo;
+		p_circle->Sxz -= xo*zo;  p_circle->Syz -= yo*zo;  p_circle->Sz  -= zo;
+	}
+	p_circle->x[slot] = x;
+	p_circle->y[slot] = y;
+	p_circle->n++;
+
+	if( slot==GAPA_CIRCLE_MASK )
+	{
+		/* Rebuild (the window is full here) */
+		p_circle->S1 = p_circle->Sx = p_circle->Sy = 0.0f;
+		p_circle->Sxx = p_circle->Sxy = p_circle->Syy = 0.0f;
+		p_circle->Sxz = p_circle->Syz = p_circle->Sz = 0.0f;
+		for( i=0; i<GAPA_CIRCLE_WINDOW; i++ )
+		{
+			xo = p_circle->x[i];
+			yo = p_circle->y[i];
+			zo = xo*xo + yo*yo;
+			p_circle->S1  += 1.0f;
+			p_circle->Sx  += xo;     p_circle->Sy  += yo;
+			p_circle->Sxx += xo*xo;  p_circle->Sxy += xo*yo;  p_circle->Syy += yo*yo;
+			p_circle->Sxz += xo*zo;  p_circle->Syz += yo*zo;  p_circle->Sz  += zo;
+		}
+		return;
+	}
+#elif GAPA_CIRCLE_FIT==GAPA_CIRCLE_EXPONENTIAL
+	p_circle->S1  *= GAPA_CIRCLE_LAMBDA;
+	p_circle->Sx  *= GAPA_CIRCLE_LAMBDA;  p_circle->Sy  *= GAPA_CIRCLE_LAMBDA;
+	p_circle->Sxx *= GAPA_CIRCLE_LAMBDA;  p_circle->Sxy *= GAPA_CIRCLE_LAMBDA;  p_circle->Syy *= GAPA_CIRCLE_LAMBDA;
+	p_circle->Sxz *= GAPA_CIRCLE_LAMBDA;  p_circle->Syz *= GAPA_CIRCLE_LAMBDA;  p_circle->Sz  *= GAPA_CIRCLE_LAMBDA;
+#endif
+
+	p_circle->S1  += 1.0f;
+	p_circle->Sx  += x;    p_circle->Sy  += y;
+	p_circle->Sxx += x*x;  p_circle->Sxy += x*y;  p_circle->Syy += y*y;
+	p_circle->Sxz += x*z;  p_circle->Syz += y*z;  p_circle->Sz  += z;
+}/* End GaPA_Circle_Push */
+
+
+/*****************************************************************
+** FUNCTION: GaPA_Circle_Center
+** VARIABLES:
+**		[IO]	GAPA_CIRCLE_FIT_TYPE	*p_circle
+**		[O ]	float									xcyc[2]
+** RETURN:
+**		bool	TRUE:  New center
+**					FALSE: Ill conditioned, the previous center
+** DESCRIPTION:
+** 		Kasa fit: the center minimizes
+** 			sum( (x-xc)^2 + (y-yc)^2 - r^2 )^2
+** 		over xc, yc, r. With C the covariance of
+** 		(x,y) and z=x^2+y^2, this is the 2x2 system
+** 			C [xc yc]' = 1/2 [cov(x,z) cov(y,z)]'
+** 		from the moment sums (Cramer's rule).
+*/
+bool GaPA_Circle_Center( GAPA_CIRCLE_FIT_TYPE	*p_circle,
+												 float								xcyc[2] )
+{
+	float inv, mx, my, mz;
+	float Cxx, Cxy, Cyy, Cxz, Cyz, det, trace;
+
+	xcyc[0] = p_circle->center[0];
+	xcyc[1] = p_circle->center[1];
+	if( p_circle->S1<3.0f ) { return FALSE; }
+
+	inv = 1.0f/p_circle->S1;
+	mx  = p_circle->Sx*inv;
+	my  = p_circle->Sy*inv;
+	mz  = p_circle->Sz*inv;
+	Cxx = p_circle->Sxx*inv - mx*mx;
+	Cxy = p_circle->Sxy*inv - mx*my;
+	Cyy = p_circle->Syy*inv - my*my;
+	Cxz = p_circle->Sxz*inv - mx*mz;
+	Cyz = p_circle->Syz*inv - my*mz;
+
+	det   = Cxx*Cyy - Cxy*Cxy;
+	trace = Cxx + Cyy;
+	if( !( det>GAPA_CIRCLE_MIN_DET*trace*trace ) ) { return FALSE; }
+
+	p_circle->center[0] = 0.5f*( Cxz*Cyy - Cyz*Cxy )/det;
+	p_circle->center[1] = 0.5f*( Cyz*Cxx - Cxz*Cxy )/det;
+	xcyc[0] = p_circle->center[0];
+	xcyc[1] = p_circle->center[1];
+	return TRUE;
+}/* End GaPA_Circle_Center */
+
+
 
 /*****************************************************************
 ** FUNCTION: GaPA_Update
@@ -143,7 +297,9 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 	int i;
 
 	float R;
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_3POINT
 	float p1[3], p2[3], p3[3];
+#endif
 	float center[2];
 
 	float leftParam, rightParam;
@@ -209,6 +365,22 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 	if(p_gapa_state->z_PHI==0){ p_gapa_state->z_PHI=p_control->gapa_prms.default_z_PHI; }
 	p_gapa_state->PHIn = (p_gapa_state->PHI/p_gapa_state->z_PHI);
 
+#if GAPA_CIRCLE_FIT!=GAPA_CIRCLE_3POINT
+	/* Fit the phase portrait center on the z scaled
+	** points (after the normalization below every point
+	** is on the unit circle, so the center would be 0),
+	** and shift the point to it before normalizing */
+	GaPA_Circle_Push( &p_gapa_state->circle, p_gapa_state->phin, p_gapa_state->PHIn );
+	if( p_gapa_state->iteration>=10 )
+	{
+		GaPA_Circle_Center( &p_gapa_state->circle, center );
+		p_gapa_state->gamma = -center[0];
+		p_gapa_state->GAMMA = -center[1];
+	}
+	p_gapa_state->phin += p_gapa_state->gamma;
+	p_gapa_state->PHIn += p_gapa_state->GAMMA;
+#endif
+
 	/* Normalize to 1 */
 	R = sqrt( p_gapa_state->phin*p_gapa_state->phin + p_gapa_state->PHIn*p_gapa_state->PHIn );
 	p_gapa_state->phin = p_gapa_state->phin/R;
@@ -220,6 +392,7 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 		return;
 	}
 
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_3POINT
 	/* Get the shift variables by determining the phase portrait center */
 	p1[0] = p_gapa_state->prev_phi[1]; p1[1] = p_gapa_state->prev_PHI[1];
 	p2[0] = p_gapa_state->prev_phi[2]; p2[1] = p_gapa_state->prev_PHI[2];
@@ -231,9 +404,14 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 	/* Get the input to the atan2 calc */
 	leftParam  = -1 * (p_gapa_state->PHIn+p_gapa_state->GAMMA);
 	rightParam = -1 * (p_gapa_state->phin+p_gapa_state->gamma);
+#else
+	/* Get the input to the atan2 calc (already shifted) */
+	leftParam  = -1 * p_gapa_state->PHIn;
+	rightParam = -1 * p_gapa_state->phin;
+#endif
 
 	/* Get the phase angle */
-	p_gapa_state->nu = f_atan2( leftParam, rightParam );
+	p_gapa_state->nu = F_ATAN2( GAPA_ANGLE_TIER, leftParam, rightParam );
 
 	/* No Motion detected (subject assumed stopped)
 	** Reset phase variables to prepare for motion */
@@ -248,6 +426,9 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 		p_gapa_state->PHIn    = 0.0;
 		p_gapa_state->PHI_max = 0.0;
 		p_gapa_state->z_PHI   = p_control->gapa_prms.default_z_PHI;
+
+		/* The fit was of the points scaled by the old z */
+		GaPA_Circle_Init( &p_gapa_state->circle );
 				
 		p_gapa_state->nu_normalized = 0.0;
 	}
@@ -268,6 +449,9 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 			if(p_gapa_state->z_PHI==0){ p_gapa_state->z_PHI=p_control->gapa_prms.default_z_PHI; }
 			p_gapa_state->PHI_max = FABS( p_gapa_state->PHI );
 
+			/* Restart the fit on the new z scaling */
+			GaPA_Circle_Init( &p_gapa_state->circle );
+
 			/* Mark the end of gain flag
 			** This will indicate when we believe we have completed a cycle. */
 			p_gapa_state->Gait_End = TRUE;
@@ -279,6 +463,73 @@ void GaPA_Update( CONTROL_TYPE			*p_control,
 
 }/* End GaPA_Update */
 
+
+/*****************************************************************
+** FUNCTION: GaPA_Predict
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	GAPA_STATE_TYPE		*p_gapa_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Extrapolate the gait phase predict_time ahead
+** 		(run after GaPA_Update):
+** 			nu_predicted = nu_normalized + rate*predict_time
+** 		wrapped to [0,1). The phase advance of each
+** 		sample is unwrapped at the stride boundary
+** 		(nu_normalized back to about 0), where the
+** 		mean rate of the stride is kept for the start
+** 		of the next one (see GAPA_PREDICT_*).
+** 		Without motion (nu_normalized held at 0 by
+** 		GaPA_Update) there is nothing to predict and
+** 		the stride tracking starts over.
+*/
+void GaPA_Predict( CONTROL_TYPE			*p_control,
+									 GAPA_STATE_TYPE	*p_gapa_state )
+{
+	float nu = p_gapa_state->nu_normalized;
+	float d, rate, pred;
+
+	if( nu==0.0f )
+	{
+		p_gapa_state->nu_predicted       = 0.0f;
+		p_gapa_state->nu_rate            = 0.0f;
+		p_gapa_state->nu_normalized_prev = 0.0f;
+		p_gapa_state->stride_phase       = 0.0f;
+		p_gapa_state->stride_time        = 0.0f;
+		p_gapa_state->stride_rate        = 0.0f;
+		return;
+	}
+
+	/* Phase advance, stride boundary */
+	d = ( p_gapa_state->nu_normalized_prev==0.0f ) ? 0.0f : nu - p_gapa_state->nu_normalized_prev;
+	if( d<-0.5f )
+	{
+		/* New stride, keep the rate of the last one
+		** if it was (nearly) complete */
+		d += 1.0f;
+		if( p_gapa_state->stride_time>0.0f && p_gapa_state->stride_phase>0.5f )
+		{
+			p_gapa_state->stride_rate = p_gapa_state->stride_phase/p_gapa_state->stride_time;
+		}
+		p_gapa_state->stride_phase = 0.0f;
+		p_gapa_state->stride_time  = 0.0f;
+	}
+	else if( d>0.5f ) { d -= 1.0f; }
+	p_gapa_state->stride_phase += d;
+	p_gapa_state->stride_time  += p_control->G_Dt;
+	p_gapa_state->nu_normalized_prev = nu;
+
+	/* Rate of the current stride, or of the last one early on */
+	rate = ( p_gapa_state->stride_phase>=GAPA_PREDICT_MIN_PHASE && p_gapa_state->stride_time>0.0f ) ?
+		p_gapa_state->stride_phase/p_gapa_state->stride_time : p_gapa_state->stride_rate;
+	rate = MIN( MAX( rate, 0.0f ), GAPA_PREDICT_MAX_RATE );
+	p_gapa_state->nu_rate = rate;
+
+	pred = nu + rate*p_control->gapa_prms.predict_time;
+	p_gapa_state->nu_predicted = pred - floorf( pred );
+}/* End GaPA_Predict */
+
 /*****************************************************************
 ** FUNCTION: TrackPhiVariables
 ** VARIABLES:
@@ -391,7 +642,7 @@ void calc_ScaleFactor( float *z, float phi_max, float phi_min, float PHI_max, fl
 */
 void calc_PhaseAngle( float* nu, float z, float PHI, float GAMMA, float phi, float gamma )
 {
-	(*nu) = f_atan2( (-z*(PHI+GAMMA)) , (-phi+gamma) );
+	(*nu) = F_ATAN2( GAPA_ANGLE_TIER, (-z*(PHI+GAMMA)) , (-phi+gamma) );
 }/* End calc_PhaseAngle */
 
 
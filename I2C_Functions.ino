@@ -0,0 +1,139 @@
+/*******************************************************************
+** FILE:
+**   	I2C_Functions
+** DESCRIPTION:
+** 		This file contains the batched I2C transaction layer
+** 		(see I2C_Config.h). The reads for one sample are queued
+** 		once with I2C_Queue_Read and run with I2C_Run.
+** 		These functions are platform independent; in emulation
+** 		mode Wire is a stand-in for the bus (Emulator_Wire.cpp).
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#if EXE_MODE==1 /* Emulator Mode */
+	/* In emulation mode, "Emulator_Protos" is needed to
+	** use functions in other files.
+	** NOTE: This header should contain the function
+	** 			 prototypes for all execution functions */
+	#include "../Include/Emulator_Protos.h"
+#endif  /* End Emulator Mode */
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: I2C_Set_Init
+** VARIABLES:
+**		[O ]	I2C_SET_TYPE	*p_set
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty the set and clear the error count
+*/
+void I2C_Set_Init( I2C_SET_TYPE *p_set )
+{
+	p_set->nReads  = 0;
+	p_set->nErrors = 0;
+} /* End I2C_Set_Init */
+
+
+/*************************************************
+** FUNCTION: I2C_Queue_Read
+** VARIABLES:
+**		[IO]	I2C_SET_TYPE	*p_set
+**		[I ]	uint8_t				address
+**		[I ]	uint8_t				reg
+**		[I ]	uint8_t				length
+** RETURN:
+**		int		Index of the read in the set
+**					(where to find the data),
+**					-1 if the set is full
+** DESCRIPTION:
+** 		Add a block read to the set. The device
+** 		must auto increment the register address.
+*/
+int I2C_Queue_Read( I2C_SET_TYPE	*p_set,
+										uint8_t				address,
+										uint8_t				reg,
+										uint8_t				length )
+{
+	I2C_READ_TYPE *p_read;
+
+	if( p_set->nReads>=I2C_MAX_READS || length>I2C_MAX_LENGTH ) { return -1; }
+
+	p_read = &p_set->read[p_set->nReads];
+	p_read->address = address;
+	p_read->reg     = reg;
+	p_read->length  = length;
+
+	return p_set->nReads++;
+} /* End I2C_Queue_Read */
+
+
+/*************************************************
+** FUNCTION: I2C_Read_Block
+** VARIABLES:
+**		[IO]	I2C_READ_TYPE	*p_read
+**		[I ]	bool					stop
+** RETURN:
+**		BOOL	1:All bytes read
+**					0:NACK or short read
+** DESCRIPTION:
+** 		One burst read: write the register address
+** 		and read the block back after a repeated
+** 		START. The bus is released (STOP) only if
+** 		stop is set.
+*/
+bool I2C_Read_Block( I2C_READ_TYPE	*p_read,
+										 bool						stop )
+{
+	uint8_t i;
+
+	Wire.beginTransmission( p_read->address );
+	WIRE_SEND( p_read->reg );
+	if( Wire.endTransmission( false )!=0 ) { return FALSE; }
+
+	if( Wire.requestFrom( (uint8_t)p_read->address, (uint8_t)p_read->length, (uint8_t)stop )!=p_read->length ) { return FALSE; }
+	for( i=0; i<p_read->length; i++ ) { p_read->data[i] = WIRE_RECEIVE(); }
+
+	return TRUE;
+} /* End I2C_Read_Block */
+
+
+/*************************************************
+** FUNCTION: I2C_Run
+** VARIABLES:
+**		[IO]	I2C_SET_TYPE	*p_set
+** RETURN:
+**		BOOL	1:All reads done
+**					0:Failure (counted in nErrors)
+** DESCRIPTION:
+** 		Run the reads in the set back to back,
+** 		holding the bus between them (repeated
+** 		START) and releasing it after the last.
+** 		On failure the remaining reads are skipped
+** 		(Wire sends the STOP on a NACK).
+*/
+bool I2C_Run( I2C_SET_TYPE *p_set )
+{
+	int i;
+
+	for( i=0; i<p_set->nReads; i++ )
+	{
+		if( I2C_Read_Block( &p_set->read[i], (i==p_set->nReads-1) )==FALSE )
+		{
+			p_set->nErrors++;
+			return FALSE;
+		}
+	}
+	return TRUE;
+} /* End I2C_Run */
@@ -43,6 +43,16 @@
 /* Only link if using IMU10736 */
 #ifdef _IMU10736_
 
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* Sample reads, queued in Init_IMU and run by Read_Sensors
+** The indices locate each sensor's data in the set */
+I2C_SET_TYPE g_imu_reads;
+int g_imu_gyro, g_imu_accel, g_imu_magn;
+
+
 /*******************************************************************
 ** Functions *******************************************************
 ********************************************************************/
@@ -85,6 +95,18 @@ bool Init_IMU( CONTROL_TYPE				*p_control,
   	Magn_Init( p_control );
   #endif
 
+  /* Queue the data block reads (one burst per sensor) */
+  I2C_Set_Init( &g_imu_reads );
+  #if GYRO_ON==1
+  	g_imu_gyro  = I2C_Queue_Read( &g_imu_reads, GYRO_ADDRESS, GYRO_DATA, 6 );
+  #endif
+  #if ACCEL_ON==1
+  	g_imu_accel = I2C_Queue_Read( &g_imu_reads, ACCEL_ADDRESS, ACCEL_DATA, 6 );
+  #endif
+  #if MAGN_ON==1
+  	g_imu_magn  = I2C_Queue_Read( &g_imu_reads, MAGN_ADDRESS, MAGN_DATA_MSBX, 6 );
+  #endif
+
   return TRUE;
 } /* End Init_IMU */
 
@@ -97,26 +119,32 @@ bool Init_IMU( CONTROL_TYPE				*p_control,
 ** RETURN:
 **		NONE
 ** DESCRIPTION: 
-** 		This function calls the read functions
-** 		which read the data registers from the
-** 		sensors.
+** 		This function reads the data registers of
+** 		all the sensors as one set of burst reads
+** 		(see I2C_Run) and unpacks them.
 */
 void Read_Sensors( CONTROL_TYPE				*p_control,
 								 	 SENSOR_STATE_TYPE	*p_sensor_state )
 {
-	/* Read Gyroscope */
+	if( I2C_Run( &g_imu_reads )==FALSE )
+	{
+		LOG_PRINTLN("ERROR : Read_Sensors : I2C Read Failed");
+		return;
+	}
+
+	/* Unpack Gyroscope */
 	#if GYRO_ON==1
-		Read_Gyro( p_control, p_sensor_state );
+		Unpack_Gyro( g_imu_reads.read[g_imu_gyro].data, p_sensor_state );
 	#endif
 	
-	/* Read Accelerometer */
+	/* Unpack Accelerometer */
   #if ACCEL_ON==1
-  	Read_Accel( p_control, p_sensor_state );
+  	Unpack_Accel( g_imu_reads.read[g_imu_accel].data, p_sensor_state );
   #endif
   
-  /* Read Magnometer */
+  /* Unpack Magnometer */
   #if MAGN_ON==1
-  	Read_Magn( p_control, p_sensor_state );
+  	Unpack_Magn( g_imu_reads.read[g_imu_magn].data, p_sensor_state );
   #endif
 } /* End Read_Sensors */
 
@@ -131,11 +159,12 @@ void Read_Sensors( CONTROL_TYPE				*p_control,
 ** 		This function initiates I2C communication
 ** 		with the gyro/magn/accel. This board only
 ** 		has the one wire port available, so here we
-** 		simply initate wire.
+** 		simply initate wire, in fast mode.
 */
 void I2C_Init( CONTROL_TYPE *p_control )
 { 
 	Wire.begin(); 
+	Wire.setClock( I2C_CLOCK );
 } /* End I2C_Init */
 
 
@@ -179,56 +208,33 @@ void Accel_Init( CONTROL_TYPE *p_control )
 
 
 /*************************************************
-** FUNCTION: Read_Accel
+** FUNCTION: Unpack_Accel
 ** VARIABLES:
-**		[I ]	CONTROL_TYPE 			*p_control
+**		[I ]	const uint8_t			*buff
 **		[IO]	SENSOR_STATE_TYPE *p_sensor_state
 ** RETURN:
 **		NONE
 ** DESCRIPTION: 
-** 		This function reads x/y/z data from the
-** 		accelerometer
+** 		This function unpacks the x/y/z data read
+** 		from the accelerometer (6 bytes from
+** 		ACCEL_DATA, see Read_Sensors)
 */
-void Read_Accel( CONTROL_TYPE				*p_control,
-								 SENSOR_STATE_TYPE	*p_sensor_state )
+void Unpack_Accel( const uint8_t			*buff,
+									 SENSOR_STATE_TYPE	*p_sensor_state )
 {
-  int i = 0;
-  uint8_t buff[6];
-
-  /* Send address to read from */
-  Wire.beginTransmission(ACCEL_ADDRESS);
-  WIRE_SEND(ACCEL_DATA);
-  Wire.endTransmission();
-
-  /* Read 6 bytes */
-  Wire.beginTransmission(ACCEL_ADDRESS);
-  Wire.requestFrom(ACCEL_ADDRESS, 6);
-  while(Wire.available())
-  {
-    buff[i] = WIRE_RECEIVE();
-    i++;
-    if ( i>6 )
-    {
-    	LOG_PRINTLN("ERROR : Reading Accelerometer : Buffer Overflow");
-    	return;
-    }
-  }
-  Wire.endTransmission();
-
-  /* Unpack Data */
-  if (i == 6)
-  {
-    /* No multiply by -1 for coordinate system transformation here, because of double negation:
-    ** We want the gravity vector, which is negated acceleration vector. */
-    p_sensor_state->accel[0] = (int16_t)((((uint16_t) buff[3]) << 8) | buff[2]);  // X axis (internal sensor y axis)
-    p_sensor_state->accel[1] = (int16_t)((((uint16_t) buff[1]) << 8) | buff[0]);  // Y axis (internal sensor x axis)
-    p_sensor_state->accel[2] = (int16_t)((((uint16_t) buff[5]) << 8) | buff[4]);  // Z axis (internal sensor z axis)
-  }
-  else
-  {
-    Serial.println("ERROR : Reading Accelerometer : Lost Bytes");
-  }
-} /* End Read_Accel */
+  /* No multiply by -1 for coordinate system transformation here, because of double negation:
+  ** We want the gravity vector, which is negated acceleration vector. */
+#if DSP_FIXED==1
+  /* Raw only, DSP_Fixed_Filter writes the floats */
+  p_sensor_state->accel_raw[0] = (int16_t)((((uint16_t) buff[3]) << 8) | buff[2]);  // X axis (internal sensor y axis)
+  p_sensor_state->accel_raw[1] = (int16_t)((((uint16_t) buff[1]) << 8) | buff[0]);  // Y axis (internal sensor x axis)
+  p_sensor_state->accel_raw[2] = (int16_t)((((uint16_t) buff[5]) << 8) | buff[4]);  // Z axis (internal sensor z axis)
+#else
+  p_sensor_state->accel[0] = (int16_t)((((uint16_t) buff[3]) << 8) | buff[2]);  // X axis (internal sensor y axis)
+  p_sensor_state->accel[1] = (int16_t)((((uint16_t) buff[1]) << 8) | buff[0]);  // Y axis (internal sensor x axis)
+  p_sensor_state->accel[2] = (int16_t)((((uint16_t) buff[5]) << 8) | buff[4]);  // Z axis (internal sensor z axis)
+#endif
+} /* End Unpack_Accel */
 
 
 /*************************************************
@@ -265,61 +271,31 @@ void Magn_Init( CONTROL_TYPE *p_control )
 
 
 /*************************************************
-** FUNCTION: Read_Magn
+** FUNCTION: Unpack_Magn
 ** VARIABLES:
-**		[I ]	CONTROL_TYPE 			*p_control
+**		[I ]	const uint8_t			*buff
 **		[IO]	SENSOR_STATE_TYPE *p_sensor_state
 ** RETURN:
 **		NONE
 ** DESCRIPTION: 
-** 		This function reads x/y/z data from the
-** 		magnetometer.
+** 		This function unpacks the x/y/z data read
+** 		from the magnetometer (6 bytes from
+** 		MAGN_DATA_MSBX, see Read_Sensors)
 */
-void Read_Magn( CONTROL_TYPE 			*p_control,
-								SENSOR_STATE_TYPE *p_sensor_state )
+void Unpack_Magn( const uint8_t			*buff,
+									SENSOR_STATE_TYPE *p_sensor_state )
 {
-  int i = 0;
-  uint8_t buff[6];
-
-  /* Send address to read from */
-  Wire.beginTransmission(MAGN_ADDRESS);
-  WIRE_SEND(MAGN_DATA_MSBX);
-  Wire.endTransmission();
-
-  /* Read 6 bytes */
-  Wire.beginTransmission(MAGN_ADDRESS);
-  Wire.requestFrom(MAGN_ADDRESS, 6);
-  while(Wire.available())
-  {
-    buff[i] = WIRE_RECEIVE();
-    i++;
-    if ( i>6 )
-    {
-    	LOG_PRINTLN("ERROR : Reading Magnetometer : Buffer Overflow");
-    	return;
-    }
-  }
-  Wire.endTransmission();
-
-  /* Unpack data */
-  if ( i==6 )
-  {
-    /* 9DOF Razor IMU SEN-10736 using HMC5883L magnetometer
-    ** Data 2 byte width, MSB byte first then LSB; 
-    ** Y and Z reversed: X, Z, Y */
-    
-    /* X axis (internal sensor -y axis) */
-    p_sensor_state->mag[0] = -1 * (int16_t)(((((uint16_t) buff[4]) << 8) | buff[5]));  
-    /* Y axis (internal sensor -x axis) */
-    p_sensor_state->mag[1] = -1 * (int16_t)(((((uint16_t) buff[0]) << 8) | buff[1]));  
-    /* Z axis (internal sensor -z axis) */
-    p_sensor_state->mag[2] = -1 * (int16_t)(((((uint16_t) buff[2]) << 8) | buff[3]));  
-  }
-  else
-  {
-    LOG_PRINTLN("ERROR : Reading Magnetometer : Lost Bytes");
-  }
-} /* End Read_Magn */
+  /* 9DOF Razor IMU SEN-10736 using HMC5883L magnetometer
+  ** Data 2 byte width, MSB byte first then LSB; 
+  ** Y and Z reversed: X, Z, Y */
+  
+  /* X axis (internal sensor -y axis) */
+  p_sensor_state->mag[0] = -1 * (int16_t)(((((uint16_t) buff[4]) << 8) | buff[5]));  
+  /* Y axis (internal sensor -x axis) */
+  p_sensor_state->mag[1] = -1 * (int16_t)(((((uint16_t) buff[0]) << 8) | buff[1]));  
+  /* Z axis (internal sensor -z axis) */
+  p_sensor_state->mag[2] = -1 * (int16_t)(((((uint16_t) buff[2]) << 8) | buff[3]));  
+} /* End Unpack_Magn */
 
 
 /*************************************************
@@ -375,57 +351,40 @@ void Gyro_Init( CONTROL_TYPE *p_control )
 
 
 /*************************************************
-** FUNCTION: Read_Gyro
+** FUNCTION: Unpack_Gyro
 ** VARIABLES:
-**		[I ]	CONTROL_TYPE 			*p_control 
+**		[I ]	const uint8_t			*buff
 **		[IO]	SENSOR_STATE_TYPE *p_sensor_state
 ** RETURN:
 **		NONE
 ** DESCRIPTION: 
-** 		This function reads x/y/z data from the
-** 		gyroscope.
+** 		This function unpacks the x/y/z data read
+** 		from the gyroscope (6 bytes from GYRO_DATA,
+** 		see Read_Sensors)
 */
-void Read_Gyro( CONTROL_TYPE 			*p_control, 
-								SENSOR_STATE_TYPE *p_sensor_state )
+void Unpack_Gyro( const uint8_t			*buff,
+									SENSOR_STATE_TYPE *p_sensor_state )
 {
-  int i = 0;
-  uint8_t buff[7];
-
-  /* Send address to read from */
-  Wire.beginTransmission(GYRO_ADDRESS);
-  WIRE_SEND(GYRO_DATA);
-  Wire.endTransmission();
-
-  /* Read 6 bytes */
-  Wire.beginTransmission(GYRO_ADDRESS);
-  Wire.requestFrom(GYRO_ADDRESS, 6);
-  while ( Wire.available() )
-  {
-    buff[i] = WIRE_RECEIVE();
-    i++;
-    if ( i>6 )
-    {
-    	LOG_PRINTLN("ERROR : Reading Gyroscope : Buffer Overflow");
-    	return;
-    }
-  }
-  Wire.endTransmission();
-
-  /* Unpack Data */
-  if ( i==6 )
-  {
-		/* X axis (internal sensor -y axis) */
-    p_sensor_state->gyro[0] = -1 * (int16_t)(((((uint16_t) buff[2]) << 8) | buff[3]));   
-    /* Y axis (internal sensor -x axis) */
-    p_sensor_state->gyro[1] = -1 * (int16_t)(((((uint16_t) buff[0]) << 8) | buff[1]));    
-    /* Z axis (internal sensor -z axis) */
-    p_sensor_state->gyro[2] = -1 * (int16_t)(((((uint16_t) buff[4]) << 8) | buff[5]));    
-  }
-  else
-  {
-    LOG_PRINTLN("ERROR : Reading Gyroscope : Lost Bytes");
-  }
-} /* End Read_Gyro */
+#if DSP_FIXED==1
+	int32_t gyro[3];
+
+	/* Raw only, DSP_Fixed_Filter writes the floats.
+	** -(-32768) does not fit in 16 bits, saturate it */
+  gyro[0] = -1 * (int32_t)(int16_t)(((((uint16_t) buff[2]) << 8) | buff[3]));
+  gyro[1] = -1 * (int32_t)(int16_t)(((((uint16_t) buff[0]) << 8) | buff[1]));
+  gyro[2] = -1 * (int32_t)(int16_t)(((((uint16_t) buff[4]) << 8) | buff[5]));
+  p_sensor_state->gyro_raw[0] = (int16_t)( ( gyro[0]>32767 ) ? 32767 : gyro[0] );
+  p_sensor_state->gyro_raw[1] = (int16_t)( ( gyro[1]>32767 ) ? 32767 : gyro[1] );
+  p_sensor_state->gyro_raw[2] = (int16_t)( ( gyro[2]>32767 ) ? 32767 : gyro[2] );
+#else
+	/* X axis (internal sensor -y axis) */
+  p_sensor_state->gyro[0] = -1 * (int16_t)(((((uint16_t) buff[2]) << 8) | buff[3]));   
+  /* Y axis (internal sensor -x axis) */
+  p_sensor_state->gyro[1] = -1 * (int16_t)(((((uint16_t) buff[0]) << 8) | buff[1]));    
+  /* Z axis (internal sensor -z axis) */
+  p_sensor_state->gyro[2] = -1 * (int16_t)(((((uint16_t) buff[4]) << 8) | buff[5]));    
+#endif
+} /* End Unpack_Gyro */
 
 
 #endif /* End _IMU10736_ */
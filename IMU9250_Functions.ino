@@ -125,17 +125,29 @@ void Read_Sensors( CONTROL_TYPE				*p_control,
   /* Read the Accelerometer */
   #if ACCEL_ON==1
   	imu.updateAccel();
-  	p_sensor_state->accel[0] = (float)imu.ax;
-  	p_sensor_state->accel[1] = (float)imu.ay;
-  	p_sensor_state->accel[2] = (float)imu.az;
+  	#if DSP_FIXED==1
+  		p_sensor_state->accel_raw[0] = (int16_t)imu.ax;
+  		p_sensor_state->accel_raw[1] = (int16_t)imu.ay;
+  		p_sensor_state->accel_raw[2] = (int16_t)imu.az;
+  	#else
+  		p_sensor_state->accel[0] = (float)imu.ax;
+  		p_sensor_state->accel[1] = (float)imu.ay;
+  		p_sensor_state->accel[2] = (float)imu.az;
+  	#endif
   #endif 
   
  	/* Read the Gyroscope */
   #if GYRO_ON==1
   	imu.updateGyro();
-  	p_sensor_state->gyro[0] = (float)imu.gx;
-  	p_sensor_state->gyro[1] = (float)imu.gy;
-  	p_sensor_state->gyro[2] = (float)imu.gz;
+  	#if DSP_FIXED==1
+  		p_sensor_state->gyro_raw[0] = (int16_t)imu.gx;
+  		p_sensor_state->gyro_raw[1] = (int16_t)imu.gy;
+  		p_sensor_state->gyro_raw[2] = (int16_t)imu.gz;
+  	#else
+  		p_sensor_state->gyro[0] = (float)imu.gx;
+  		p_sensor_state->gyro[1] = (float)imu.gy;
+  		p_sensor_state->gyro[2] = (float)imu.gz;
+  	#endif
   #endif 
   
   /* Read the Magnometer */
@@ -144,6 +156,67 @@ void Read_Sensors( CONTROL_TYPE				*p_control,
   
 } /* End Read_Sensors */
 
+/*************************************************
+** FUNCTION: Start_Acquisition
+** VARIABLES:
+**		[I ]	CONTROL_TYPE 			*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION: 
+** 		Route the accel and gyro samples to the
+** 		MPU-9250 FIFO. loop() burst reads them into
+** 		g_acq_ring (Acq_FIFO_Read).
+** 		ACQ_MODE_INTERRUPT: Also enable the MPU-9250
+** 		data ready interrupt and attach IMU_Data_Ready
+** 		to it, before the FIFO is reset, so every
+** 		frame queued from then on has its stamp.
+*/
+void Start_Acquisition( CONTROL_TYPE *p_control )
+{
+	Acq_Ring_Init( &g_acq_ring );
+
+	#if ACQ_MODE==ACQ_MODE_INTERRUPT
+		LOG_PRINTLN("> Starting Interrupt Acquisition");
+
+		/* 50us active low pulse per sample
+		** (nothing to clear in the interrupt) */
+		imu.setIntLevel( INT_ACTIVE_LOW );
+		imu.setIntLatched( INT_50US_PULSE );
+		imu.enableInterrupt();
+
+		attachInterrupt( digitalPinToInterrupt(MPU9250_INT_PIN), IMU_Data_Ready, FALLING );
+	#else
+		LOG_PRINTLN("> Starting FIFO Acquisition");
+	#endif
+
+	/* The sample rate is clamped by the driver (4Hz-1kHz),
+	** the FIFO timestamps use the rate actually set */
+	imu.configureFifo( INV_XYZ_ACCEL | INV_XYZ_GYRO );
+	imu.resetFifo();
+	Acq_FIFO_Init( &g_acq_fifo, 1000000UL/imu.getSampleRate(), ( ACQ_MODE==ACQ_MODE_INTERRUPT ) );
+} /* End Start_Acquisition */
+
+/*************************************************
+** FUNCTION: IMU_Data_Ready
+** VARIABLES:
+**		NONE
+** RETURN:
+**		NONE
+** DESCRIPTION: 
+** 		Data ready interrupt handler.
+** 		Only records the time of the sample the
+** 		IMU just queued in its FIFO. The frames
+** 		are read from loop() (blocking Wire
+** 		transfers cannot run in an ISR), and take
+** 		these stamps (Acq_FIFO_Read), so the read
+** 		can come late without skewing the sample
+** 		times.
+*/
+void IMU_Data_Ready( void )
+{
+	Acq_Ring_Stamp( &g_acq_ring, micros() );
+} /* End IMU_Data_Ready */
+
 #endif /* End _IMU9250_ */
 
 
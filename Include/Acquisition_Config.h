@@ -0,0 +1,145 @@
+/*******************************************************************
+** FILE:
+**   	Acquisition_Config.h
+** DESCRIPTION:
+** 		Header for interrupt driven sample acquisition.
+** 		In both the interrupt and FIFO modes, the IMU queues
+** 		the samples in its own FIFO and loop() drains all the
+** 		frames waiting in a few burst reads into a single
+** 		producer/single consumer ring (see Acq_FIFO_Read), then
+** 		runs the processing stages on each sample. This takes
+** 		one bus transaction per ACQ_FIFO_BURST_FRAMES samples
+** 		rather than two per sample, and the sample rate is no
+** 		longer limited by the loop rate.
+** 		In interrupt mode, the IMU data ready interrupt also
+** 		records the time of each sample in the ring (no bus
+** 		access in the interrupt). The FIFO frames are dated
+** 		from these stamps, newest frame to newest stamp, so a
+** 		sample and its timestamp never depend on how long the
+** 		processing takes. In FIFO mode the frames are dated
+** 		back from the time of the read, one period each.
+** 		The ring is lock free: the interrupt only writes the
+** 		stamps and nStamped, loop() writes the samples, head
+** 		and tail. The index updates are release/acquire
+** 		ordered against the data.
+** 		The acquisition mode (ACQ_MODE) is set in the IMU
+** 		header, since it depends on the IMU wiring.
+********************************************************************/
+#ifndef ACQUISITION_CONFIG_H
+#define ACQUISITION_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Acquisition modes (ACQ_MODE)
+** 0: Read_Sensors polls the IMU, Update_Time paces the loop
+** 1: loop() burst reads the IMU FIFO into the sample ring,
+**    dated by the data ready interrupt
+** 2: loop() burst reads the IMU FIFO into the sample ring,
+**    dated from the time of the read */
+#define ACQ_MODE_POLL      0
+#define ACQ_MODE_INTERRUPT 1
+#define ACQ_MODE_FIFO      2
+
+/* Ring size (samples), must be a power of 2
+** 64 samples is 320 ms at 200 Hz, and holds a full
+** MPU-9250 FIFO (42 frames). The stamps of every frame
+** still in the FIFO are then kept (interrupt mode) */
+#define ACQ_RING_SIZE 64
+#define ACQ_RING_MASK (ACQ_RING_SIZE-1)
+
+/* Maximum number of samples processed per loop()
+** Bounds the time between comm port checks */
+#define ACQ_MAX_BATCH ACQ_RING_SIZE
+
+/* Ordered access to the ring indices
+** (GCC builtins, plain loads/stores plus a barrier
+** on the Cortex-M0) */
+#define ACQ_LOAD(p_index)         __atomic_load_n( p_index, __ATOMIC_ACQUIRE )
+#define ACQ_STORE(p_index,value)  __atomic_store_n( p_index, value, __ATOMIC_RELEASE )
+
+/* IMU FIFO frame (interrupt and FIFO modes)
+** Accel x,y,z then gyro x,y,z, big endian int16 */
+#define ACQ_FIFO_FRAME_SIZE 12
+
+/* Frames per burst read
+** Limited by the Wire receive buffer (64 bytes on the SAMD21)
+** NOTE: The MPU-9250 FIFO holds 42 frames (512 bytes), 210 ms at
+** 200 Hz. If loop() takes longer than that between reads, the
+** FIFO overflows and Acq_FIFO_Read resets it: every frame queued
+** is lost, not just the oldest. A loop that is always that slow
+** loses every sample. Check nOverflows when using FIFO mode */
+#define ACQ_FIFO_BURST_FRAMES 5
+
+/* The register access is IMU specific, see ACQ_FIFO_READ
+** and ACQ_FIFO_RESET in the IMU header (Emulator_Config.h
+** in emulation mode) */
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: ACQ_SAMPLE_TYPE
+** A single raw sample */
+typedef struct
+{
+	uint32_t timestamp; /* micros() at the data ready interrupt (or rebuilt) */
+	int16_t  accel[3];
+	int16_t  gyro[3];
+} ACQ_SAMPLE_TYPE;
+
+/*
+** TYPE: ACQ_RING_TYPE
+** Single producer/single consumer sample ring.
+** head and tail are free running counters, the
+** ring holds head-tail samples. A sample arriving
+** while the ring is full is dropped (the producer
+** cannot move tail) and counted in nDropped.
+** In interrupt mode the data ready interrupt writes
+** the time of sample n to stamp[n&ACQ_RING_MASK]
+** (nStamped free running). It never waits for loop(),
+** the oldest stamps are overwritten */
+typedef struct
+{
+	ACQ_SAMPLE_TYPE sample[ACQ_RING_SIZE];
+
+	/* Producer */
+	uint32_t head;
+	uint32_t nPushed;
+	uint32_t nDropped;
+
+	/* Data ready interrupt (interrupt mode) */
+	uint32_t stamp[ACQ_RING_SIZE];
+	uint32_t nStamped;
+
+	/* Consumer (loop) */
+	uint32_t tail;
+	uint32_t nPopped;
+	uint32_t nBatches;
+	uint32_t MaxDepth;
+} ACQ_RING_TYPE;
+
+/*
+** TYPE: ACQ_FIFO_TYPE
+** IMU FIFO reader state.
+** The FIFO frames have no timestamp. With Stamped
+** (interrupt mode) they take the data ready stamps,
+** otherwise the newest frame is stamped with the
+** time of the read and the older ones are dated
+** back one period each */
+typedef struct
+{
+	uint32_t period;     /* IMU sample period (us) */
+	bool     Stamped;    /* Date the frames from the ring stamps */
+
+	uint32_t nReads;     /* Bus transactions */
+	uint32_t nFrames;    /* Frames read */
+	uint32_t nOverflows; /* FIFO overflows (the FIFO is reset) */
+} ACQ_FIFO_TYPE;
+
+
+#endif /* End ACQUISITION_CONFIG_H */
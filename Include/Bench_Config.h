@@ -0,0 +1,99 @@
+/*******************************************************************
+** FILE:
+**   	Bench_Config.h
+** DESCRIPTION:
+** 		Header for the emulator per-stage benchmark.
+** 		The benchmark replays a recording and times each
+** 		processing stage separately, once per sample, so that
+** 		the cost of every stage (and any change to it) can be
+** 		given as a number. Results are written as JSON and can
+** 		be checked against a thresholds file.
+** 		This file should only be included when EXE_MODE==1.
+********************************************************************/
+#ifndef BENCH_CONFIG_H
+#define BENCH_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Timed stages
+** Index into BENCH_STATE_TYPE::stage (see Bench_Stage_Names) */
+#define BENCH_FIR_FILTER       0
+#define BENCH_IIR_FILTER       1
+#define BENCH_DSP_SHIFT        2
+#define BENCH_STATS_UPDATE     3
+#define BENCH_DCM_FILTER       4
+#define BENCH_GAPA_UPDATE      5
+#define BENCH_WISE_UPDATE      6
+#define BENCH_DEBUG_LOGOUT     7
+#define BENCH_RESPOND_TO_INPUT 8
+#define BENCH_TOTAL            9 /* Sum of the stages above */
+#define BENCH_N_STAGES        10
+
+/* Number of replays of the recording
+** Latencies are pooled over all replays,
+** ns/sample is the best replay (least disturbed) */
+#define BENCH_REPEATS 5
+
+/* Number of timer reads used to measure the
+** timer overhead, which is removed from every
+** measured latency */
+#define BENCH_CAL_READS 100000
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: BENCH_STAGE_TYPE
+** Measurements and thresholds for one stage.
+** Latencies are in ns per call (one call per sample) */
+typedef struct
+{
+	/* Per call latency of every call, all replays */
+	uint32_t      *latency;
+	unsigned long  nCalls;
+	unsigned long  nAlloc;
+
+	/* Total time per replay */
+	double total_ns[BENCH_REPEATS];
+
+	/* Results */
+	double ns_per_sample; /* Best replay */
+	double mean_ns;       /* All replays */
+	double p50_ns;
+	double p99_ns;
+	double max_ns;
+	double throughput;    /* Samples/sec at ns_per_sample */
+
+	/* Regression thresholds, <=0 when not checked */
+	double max_ns_per_sample;
+	double max_p99_ns;
+	bool   Regressed;
+} BENCH_STAGE_TYPE;
+
+/*
+** TYPE: BENCH_STATE_TYPE
+** Benchmark state and results */
+typedef struct
+{
+	BENCH_STAGE_TYPE stage[BENCH_N_STAGES];
+
+	/* Samples per replay */
+	unsigned long nSamples;
+
+	/* Mean recorded sample period (ns)
+	** The real-time budget per sample */
+	double SamplePeriod_ns;
+
+	/* Measured timer overhead (ns), removed from each latency */
+	double TimerOverhead_ns;
+
+	int nRegressed;
+} BENCH_STATE_TYPE;
+
+
+#endif /* End BENCH_CONFIG_H */
@@ -12,8 +12,12 @@
 
 
 /* 0: IMU
-** 1: Emulator */
-#define EXE_MODE 0
+** 1: Emulator
+** The emulator build sets this from the
+** command line (see Emulator/Makefile) */
+#ifndef EXE_MODE
+	#define EXE_MODE 0
+#endif
 
 //#define _IMU10736_ /* Using IMU10736 */
 #define _IMU9250_ /* Using IMU9250 */
@@ -35,6 +39,10 @@
 	#include "../Include/GaPA_Config.h"
 	#include "../Include/WISE_Config.h"
 	#include "../Include/Communication_Config.h"
+	#include "../Include/Profile_Config.h"
+	#include "../Include/Acquisition_Config.h"
+	#include "../Include/I2C_Config.h"
+	#include "../Include/Stats_Config.h"
 	#include "../Include/Math.h"
 
 	#include "../Include/Emulator_Config.h"
@@ -53,6 +61,10 @@
 	#include "./GaPA_Config.h"
 	#include "./WISE_Config.h"
 	#include "./Communication_Config.h"
+	#include "./Profile_Config.h"
+	#include "./Acquisition_Config.h"
+	#include "./I2C_Config.h"
+	#include "./Stats_Config.h"
 	#include "./Math.h"
 
 	#ifdef _IMU10736_
@@ -117,11 +129,20 @@ typedef struct
   float pitch_prev;
   float roll_prev;
 
+  /* Roll and yaw sources, read roll and yaw
+  ** through Orientation_Roll/Orientation_Yaw */
+  DCM_EULER_TYPE euler;
+
   /* Accel x:Fore y:Port z:Zenith */
   float accel[3];
   float gyro[3];
   float mag[3]; /* not used */
 
+  /* Raw readings (counts), the input of the
+  ** fixed point DSP filters (see DSP_FIXED) */
+  int16_t accel_raw[3];
+  int16_t gyro_raw[3];
+
 	/* Stats are computed from
 	** magnitudes */
   float gyro_Ave;
@@ -135,6 +156,12 @@ typedef struct
   float accel_M2;
   float accel_sVar;
   float accel_pVar;
+
+  /* Window min/max (see Stats_Config.h) */
+  float gyro_min;
+  float gyro_max;
+  float accel_min;
+  float accel_max;
   
   float std_time;
 
@@ -175,6 +202,10 @@ typedef struct
   unsigned long timestamp_old;
   float G_Dt;
 
+	/* Timestamp of the sample taken from the
+	** acquisition ring (see Acq_Load_Sample) */
+	unsigned long acq_timestamp;
+
 	/* If in Emulation mode,
   ** include the emulation structure */
   #if EXE_MODE==1
@@ -219,9 +250,53 @@ typedef struct
   ** include calibration struct */
   CALIBRATION_PRMS_TYPE calibration_prms;
 
+	/* Profiler counters (see Profile_Config.h) */
+	PROFILE_STATE_TYPE profile;
+
 } CONTROL_TYPE;
 
 
+/*
+** TYPE: PIPELINE_STATE_TYPE
+** This type bundles the control structure and
+** all of the algorithm state structures.
+** It holds everything needed to run one instance
+** of the processing pipeline (see Pipeline_Update),
+** so several instances can exist in one process
+** (e.g. the emulator replaying recordings in parallel). */
+typedef struct
+{
+	/* Control structure
+	** Contains all the various settings */
+	CONTROL_TYPE      control;
+
+	/* Input data
+	** In emulation mode, this is read from a recording
+	** In real-time mode, this will be from the sensors */
+	SENSOR_STATE_TYPE sensor_state;
+
+	/* Calibration state
+	** Not used in normal processing */
+	CALIBRATION_TYPE  calibration;
+
+	/* Digital Signal Processing filter state */
+	DSP_STATE_TYPE    dsp;
+
+	/* Directional Cosine Matrix state */
+	DCM_STATE_TYPE    dcm_state;
+
+	/* Gait Phase Angle estimator state */
+	GAPA_STATE_TYPE   gapa_state;
+
+	/* Walking Incline and Speed Estimator state */
+	WISE_STATE_TYPE   wise_state;
+
+	/* Sliding window motion statistics */
+	STATS_STATE_TYPE  stats;
+
+} PIPELINE_STATE_TYPE;
+
+
 
 
 
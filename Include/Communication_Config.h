@@ -21,10 +21,15 @@ typedef struct
 {
   uint16_t       Packet_nBytes;  /* Length of entire packet, minus this variable, in bytes */
   uint16_t       PacketType;     /* Type code of packet */
-  uint16_t       Buffer_nBytes;  /* Length of data buffer in bytes (0-50) */
-  unsigned char  Buffer[50];     /* Data buffer */
+  uint16_t       Buffer_nBytes;  /* Length of data buffer in bytes (0-72) */
+  unsigned char  Buffer[72];     /* Data buffer */
   unsigned char  CheckSum;       /* CheckSum of data buffer only */
 } COMMUNICATION_PACKET_TYPE;
 
+/* The stride history packet (f_SendStrides) must fit the buffer:
+** 4 bytes of header, 16 bytes per stride */
+static_assert( sizeof(uint16_t)*2 + WISE_STRIDE_PACKET*( sizeof(uint32_t)+sizeof(uint16_t)*6 ) <= sizeof(COMMUNICATION_PACKET_TYPE::Buffer),
+               "WISE_STRIDE_PACKET strides do not fit in a packet" );
+
 
 #endif /* CCOMMUNICATION_CONFIG_H */
@@ -37,6 +37,53 @@
 //#define Ki_YAW 0.00002f
 //#define Ki_YAW 0.00005f
 
+/* Orientation engines (dcm_prms.Engine), selected at runtime
+** DCM:        DCM_Filter (or DCM_Filter_Fixed, see DCM_FIXED)
+** QUATERNION: Quaternion_Filter, Mahony complementary filter
+**             with the same accel weighting and PI gains */
+#define ORIENTATION_DCM        0
+#define ORIENTATION_QUATERNION 1
+#define NUM_ORIENTATION_ENGINES 2
+
+#define ORIENTATION_ENGINE ORIENTATION_DCM
+
+/* atan2/asin tier of the Euler angles (see Math.h)
+** Roll and yaw are only logged, and pitch is only
+** used to a few mrad */
+#define DCM_ANGLE_TIER TRIG_TIER_FAST
+
+/* Lazy Euler angles
+** 0: Roll and yaw are extracted with pitch, every sample
+** 1: Pitch is extracted every sample (GaPA and WISE use
+**    it), roll and yaw only when they are read (see
+**    Orientation_Roll, Orientation_Yaw), at most once
+**    per sample */
+#define DCM_LAZY_EULER 1
+
+/* Fixed point DCM
+** 0: DCM_Filter, in float
+** 1: DCM_Filter_Fixed, the same filter in integer
+**    (the yaw correction is not applied, as in DCM_Filter).
+**    Only the inputs (sensor state, G_Dt, gravity, gains)
+**    and the Euler angles are converted from/to float. */
+#define DCM_FIXED 0
+
+/* Fixed point formats (fraction bits)
+** Matrix and rotation per sample  Q30 (+-2)
+** Accel/gyro (counts)             Q8
+** Omega_P/Omega_I (rad/s)         Q24 (+-128)
+** Drift error (counts)            Q12 */
+#define DCM_Q_MATRIX 30
+#define DCM_Q_SENSOR 8
+#define DCM_Q_OMEGA  24
+#define DCM_Q_ERROR  12
+
+/* Gyro gain (rad/s per count) in Q(DCM_Q_OMEGA+DCM_GYRO_SHIFT-DCM_Q_SENSOR)
+** and offsets (counts) in Q(DCM_Q_SENSOR), see GYRO_X_SCALED */
+#define DCM_GYRO_SHIFT 24
+#define DCM_GYRO_GAIN_Q  ( (int64_t)( TO_RAD(GYRO_GAIN)*(double)( (int64_t)1<<(DCM_Q_OMEGA+DCM_GYRO_SHIFT-DCM_Q_SENSOR) ) + 0.5 ) )
+#define DCM_GYRO_OFFSET_Q(offset) ( (int32_t)( (offset)*(1L<<DCM_Q_SENSOR) ) )
+
 /*******************************************************************
 ** Typedefs *********************************************************
 ********************************************************************/
@@ -58,9 +105,62 @@ typedef struct
   float std_time;
 
   long int SampleNumber;
+
+  /* Quaternion (w,x,y,z), body to earth, the
+  ** state of Quaternion_Filter */
+  float Quaternion[4];
+
+  /* Engine the state was last updated by
+  ** (see Orientation_Update) */
+  int Engine;
+
+#if DCM_FIXED==1 || EXE_MODE==1
+  /* Fixed point state (DCM_Filter_Fixed) */
+  int32_t DCM_Matrix_q[3][3];
+  int32_t Omega_P_q[3];
+  int32_t Omega_I_q[3];
+#endif
 } DCM_STATE_TYPE;
 
 
+/*
+** TYPE: DCM_EULER_TYPE
+** The matrix entries roll and yaw are extracted
+** from, kept from the last orientation update
+** until they are read (see DCM_LAZY_EULER) */
+typedef struct
+{
+  float Row2[3]; /* DCM[2][:] */
+  float m10;     /* DCM[1][0] */
+  float m00;     /* DCM[0][0] */
+
+#if DCM_FIXED==1 || EXE_MODE==1
+  /* Q30 entries (DCM_Filter_Fixed) */
+  int32_t Row2_q[3];
+  int32_t m10_q;
+  int32_t m00_q;
+  bool    Fixed; /* The Q30 entries are the source */
+#endif
+
+  bool RollDirty; /* roll is older than the entries */
+  bool YawDirty;  /* yaw is older than the entries */
+} DCM_EULER_TYPE;
+
+
+/*
+** TYPE: DCM_ANGLE_STAGE_TYPE
+** Pitch or roll from DCM[2][:], specialized on the
+** mounting (see DCM_Kernels.h, Orientation_Select_Stages) */
+typedef float (*DCM_ANGLE_STAGE_TYPE)( const float Row2[3] );
+
+#if DCM_FIXED==1 || EXE_MODE==1
+/*
+** TYPE: DCM_ANGLE_STAGE_Q_TYPE
+** Same, from the Q30 DCM[2][:] (DCM_Filter_Fixed) */
+typedef float (*DCM_ANGLE_STAGE_Q_TYPE)( const int32_t Row2_q[3] );
+#endif
+
+
 /*
 ** TYPE: DCM_PRMS_TYPE
 ** This type is used to hold the DCM
@@ -80,8 +180,21 @@ typedef struct
   int RollRotationConv;
   int RollRotationRef;
 
+  int Engine; /* ORIENTATION_* */
+
+  /* Euler angle stages for the orientations
+  ** and conventions above (set in DCM_Init) */
+  DCM_ANGLE_STAGE_TYPE PitchStage;
+  DCM_ANGLE_STAGE_TYPE RollStage;
+#if DCM_FIXED==1 || EXE_MODE==1
+  DCM_ANGLE_STAGE_Q_TYPE PitchStage_q;
+  DCM_ANGLE_STAGE_Q_TYPE RollStage_q;
+#endif
+
 } DCM_PRMS_TYPE;
 
 
+#include "DCM_Kernels.h"
+
 
 #endif /* End DCM_CONFIG_H */
@@ -0,0 +1,189 @@
+/*******************************************************************
+** FILE:
+**   	DCM_Kernels.h
+** DESCRIPTION:
+** 		Compile time mounting conventions.
+** 		The pitch and roll orientations (PITCH_O, ROLL_O, see
+** 		the IMU header) select the DCM entries the angles are
+** 		extracted from, and the axes Map_Accel_2D reads. Each
+** 		orientation is a policy holding these as constants.
+** 		The extraction stages below are specialized on the
+** 		policy and on the rotation conventions (*_ROT_CONV,
+** 		ROLL_ZREF), so a stage has no switch and no run time
+** 		index or sign. DCM_Init picks the stages for dcm_prms
+** 		once, from the stage tables of all the supported
+** 		mountings (see Orientation_Select_Stages).
+** 		An orientation with no policy does not compile.
+** 		C++11, same as DSP_Kernels.h.
+********************************************************************/
+#ifndef DCM_KERNELS_H
+#define DCM_KERNELS_H
+
+#include "Math.h"
+
+
+/*******************************************************************
+** Pitch orientations (PITCH_O)
+********************************************************************/
+
+/*
+** TYPE: DCM_PITCH_POLICY
+** ROW              - pitch = -conv*asin( DCM[2][ROW] )
+** ACCEL_X, ACCEL_Z - Map_Accel_2D movement and gravity axes
+** GYRO             - Map_Accel_2D rotation axis */
+template< int O > struct DCM_PITCH_POLICY;
+
+template<> struct DCM_PITCH_POLICY<1> /* 0:Nadir0/Zenith down  +90:Aft down   -90:Fore down */
+{
+	static const int ROW = 0;
+	static const int ACCEL_X = 0, ACCEL_Z = 2, GYRO = 1;
+};
+
+template<> struct DCM_PITCH_POLICY<2> /* 0:Fore/Aft down       +90:Port down  -90:Starboard down */
+{
+	static const int ROW = 1;
+	static const int ACCEL_X = 1, ACCEL_Z = 0, GYRO = 2;
+};
+
+template<> struct DCM_PITCH_POLICY<3> /* 0:Fore/Aft down       +90:Nadir down -90:Zenith down */
+{
+	static const int ROW = 2;
+	static const int ACCEL_X = 2, ACCEL_Z = 0, GYRO = 1;
+};
+
+
+/*******************************************************************
+** Roll orientations (ROLL_O)
+********************************************************************/
+
+/*
+** TYPE: DCM_ROLL_POLICY
+** roll = SIGN*conv*atan2( DCM[2][Y], -zref*DCM[2][X] ) */
+template< int O > struct DCM_ROLL_POLICY;
+
+template<> struct DCM_ROLL_POLICY<1> { static const int Y = 0, X = 1, SIGN = -1; }; /* z-axis, 0:Port down */
+template<> struct DCM_ROLL_POLICY<2> { static const int Y = 0, X = 2, SIGN = -1; }; /* y-axis, 0:Nadir down */
+template<> struct DCM_ROLL_POLICY<3> { static const int Y = 1, X = 2, SIGN = -1; }; /* x-axis, 0:Nadir down */
+template<> struct DCM_ROLL_POLICY<4> { static const int Y = 1, X = 0, SIGN =  1; }; /* z-axis, 0:Aft down */
+template<> struct DCM_ROLL_POLICY<5> { static const int Y = 2, X = 0, SIGN =  1; }; /* y-axis, 0:Aft down */
+template<> struct DCM_ROLL_POLICY<6> { static const int Y = 2, X = 1, SIGN =  1; }; /* x-axis, 0:Port down */
+
+
+
+/*******************************************************************
+** Stages
+********************************************************************/
+
+/* Math functions used by the stages (Math.ino) */
+float   f_asin( float x );
+float   f_asin_precise( float x );
+float   f_atan2( float y, float x );
+float   f_atan2_precise( float y, float x );
+int32_t q_atan2( int32_t y, int32_t x );
+int32_t q_asin( int32_t x );
+
+
+/*************************************************
+** FUNCTION: DCM_Pitch_Stage
+** VARIABLES:
+**		[I ]	const float				Row2[3]
+** RETURN:
+**		float	pitch (rad)
+** DESCRIPTION:
+** 		Pitch for orientation O and rotation
+** 		convention CONV (see the policies above).
+** 		Range: -90:90
+** 		With PITCH_ROT_CONV==1 :
+** 		PITCH_O:1 - Angle x-axis w/ Horizontal Plane  +Rot:Aft-Down    0:Nadir0/Zenith down. +90:Aft down   -90:Fore down
+** 		PITCH_O:2 - Angle y-axis w/ Horizontal Plane  +Rot:Port-Down   0:Fore/Aft down       +90:Port down  -90:Starboard down
+** 		PITCH_O:3 - Angle z-axis w/ Horizontal Plane  +Rot:Nadir-Down  0:Fore/Aft down       +90:Nadir down -90:Zenith down
+*/
+template< int O, int CONV >
+float DCM_Pitch_Stage( const float Row2[3] )
+{
+	return -CONV*F_ASIN( DCM_ANGLE_TIER, Row2[DCM_PITCH_POLICY<O>::ROW] );
+} /* End DCM_Pitch_Stage */
+
+
+/*************************************************
+** FUNCTION: DCM_Roll_Stage
+** VARIABLES:
+**		[I ]	const float				Row2[3]
+** RETURN:
+**		float	roll (rad)
+** DESCRIPTION:
+** 		Roll for orientation O, rotation
+** 		convention CONV and reference ZREF
+** 		(see the policies above).
+** 		We should only be using 3,4,5 orientations, but they are all available for hacking.
+** 		Range: -180:180
+** 		With ROLL_ROT_CONV==1  ROLL_ZREF==1
+** 		ROLL_O:1 - Rotation around z-axis (Nadir-Zenith) +Rot:Aft-Port    0:Port down     +-180:stbd down
+** 		ROLL_O:2 - Rotation around y-axis (Port-Stbd)    +Rot:Aft-Nadir   0:Nadir down    +-180:Zenith down
+** 		ROLL_O:3 - Rotation around x-axis (Fore-Aft)     +Rot:Port-Nadir  0:Nadir down    +-180:Zenith down
+** 		ROLL_O:4 - Rotation around z-axis (Nadir-Zenith) +Rot:Aft-Port    0:Aft down      +-180:Fore down
+** 		ROLL_O:5 - Rotation around y-axis (Port-Stbd)    +Rot:Aft-Nadir   0:Aft down      +-180:Fore down
+** 		ROLL_O:6 - Rotation around x-axis (Fore-Aft)     +Rot:Port-Nadir  0:Port down     +-180:Stbd down
+*/
+template< int O, int CONV, int ZREF >
+float DCM_Roll_Stage( const float Row2[3] )
+{
+	return DCM_ROLL_POLICY<O>::SIGN*CONV*F_ATAN2( DCM_ANGLE_TIER, Row2[DCM_ROLL_POLICY<O>::Y], -ZREF*Row2[DCM_ROLL_POLICY<O>::X] );
+} /* End DCM_Roll_Stage */
+
+
+#if DCM_FIXED==1 || EXE_MODE==1
+/*************************************************
+** FUNCTION: DCM_Pitch_Stage_q
+** VARIABLES:
+**		[I ]	const int32_t			Row2_q[3]
+** RETURN:
+**		float	pitch (rad)
+** DESCRIPTION:
+** 		DCM_Pitch_Stage on the Q30 entries (q_asin)
+*/
+template< int O, int CONV >
+float DCM_Pitch_Stage_q( const int32_t Row2_q[3] )
+{
+	return Q_TO_FLOAT( -CONV*q_asin( Row2_q[DCM_PITCH_POLICY<O>::ROW] ), Q_ANGLE_SHIFT );
+} /* End DCM_Pitch_Stage_q */
+
+
+/*************************************************
+** FUNCTION: DCM_Roll_Stage_q
+** VARIABLES:
+**		[I ]	const int32_t			Row2_q[3]
+** RETURN:
+**		float	roll (rad)
+** DESCRIPTION:
+** 		DCM_Roll_Stage on the Q30 entries (q_atan2)
+*/
+template< int O, int CONV, int ZREF >
+float DCM_Roll_Stage_q( const int32_t Row2_q[3] )
+{
+	return Q_TO_FLOAT( DCM_ROLL_POLICY<O>::SIGN*CONV*q_atan2( Row2_q[DCM_ROLL_POLICY<O>::Y], -ZREF*Row2_q[DCM_ROLL_POLICY<O>::X] ), Q_ANGLE_SHIFT );
+} /* End DCM_Roll_Stage_q */
+#endif /* End DCM_FIXED */
+
+
+/* Stage tables, one entry per supported mounting
+** Pitch: [conv -1/+1][PITCH_O-1]
+** Roll:  [conv -1/+1][zref -1/+1][ROLL_O-1] */
+#define DCM_PITCH_STAGES(STAGE,CONV) { STAGE<1,CONV>, STAGE<2,CONV>, STAGE<3,CONV> }
+#define DCM_ROLL_STAGES(STAGE,CONV,ZREF) { STAGE<1,CONV,ZREF>, STAGE<2,CONV,ZREF>, STAGE<3,CONV,ZREF>, \
+                                           STAGE<4,CONV,ZREF>, STAGE<5,CONV,ZREF>, STAGE<6,CONV,ZREF> }
+
+static const DCM_ANGLE_STAGE_TYPE DCM_Pitch_Stages[2][3] =
+	{ DCM_PITCH_STAGES( DCM_Pitch_Stage, -1 ), DCM_PITCH_STAGES( DCM_Pitch_Stage, 1 ) };
+static const DCM_ANGLE_STAGE_TYPE DCM_Roll_Stages[2][2][6] =
+	{ { DCM_ROLL_STAGES( DCM_Roll_Stage, -1, -1 ), DCM_ROLL_STAGES( DCM_Roll_Stage, -1, 1 ) },
+	  { DCM_ROLL_STAGES( DCM_Roll_Stage,  1, -1 ), DCM_ROLL_STAGES( DCM_Roll_Stage,  1, 1 ) } };
+#if DCM_FIXED==1 || EXE_MODE==1
+static const DCM_ANGLE_STAGE_Q_TYPE DCM_Pitch_Stages_q[2][3] =
+	{ DCM_PITCH_STAGES( DCM_Pitch_Stage_q, -1 ), DCM_PITCH_STAGES( DCM_Pitch_Stage_q, 1 ) };
+static const DCM_ANGLE_STAGE_Q_TYPE DCM_Roll_Stages_q[2][2][6] =
+	{ { DCM_ROLL_STAGES( DCM_Roll_Stage_q, -1, -1 ), DCM_ROLL_STAGES( DCM_Roll_Stage_q, -1, 1 ) },
+	  { DCM_ROLL_STAGES( DCM_Roll_Stage_q,  1, -1 ), DCM_ROLL_STAGES( DCM_Roll_Stage_q,  1, 1 ) } };
+#endif
+
+#endif /* End DCM_KERNELS_H */
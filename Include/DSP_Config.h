@@ -5,6 +5,16 @@
 ** DESCRIPTION:
 ** 		Header for common Digital Signal Processing (DSP) algorithms.
 ** 		These definitions are used for all FIR and IIR applications.
+** 		The FIR histories are ring buffers: a new sample is
+** 		written once (at head, and mirrored at head+NTAPS) and
+** 		head moves back one slot per sample (DSP_Shift), so the
+** 		last NTAPS samples are always contiguous from head:
+** 			x[n-k] = mem[head+k], k=0..NTAPS-1
+** 		The taps are read without any wrap test and the history
+** 		update costs the same for any NTAPS.
+** 		The IIR filters are cascades of biquads whose coefficients
+** 		come from banks selected per channel at run time, so the
+** 		order and cutoff can change without a reflash.
 ********************************************************************/
 #ifndef DSP_CONFIG_H
 #define DSP_CONFIG_H
@@ -38,6 +48,16 @@
 #define FIR_HPF_5 {-0.007550,-0.053584,0.907931,-0.053584,-0.007550}
 #define FIR_HPF_3 {-0.008593,0.982814,-0.008593}
 
+/* FIR kernel (see DSP_Kernels.h)
+** 0: Loop over the coefficients in DSP_STATE_TYPE
+** 1: Unrolled, bit for bit the same as the loop
+** 2: Unrolled, symmetric taps folded (about half
+** 	  the multiplies) */
+#define DSP_FIR_LOOP   0
+#define DSP_FIR_UNROLL 1
+#define DSP_FIR_FOLD   2
+#define DSP_FIR_KERNEL DSP_FIR_FOLD
+
 #if NTAPS==3
 	#define FIR_LPF FIR_LPF_3
 	#define FIR_HPF FIR_HPF_3
@@ -51,59 +71,153 @@
 
 
 /*
-** IIR Fitler Coeffs
-** All IIR Filters are Butterworth by design
-** with a cutoff of 0.1
-** Equation:
-**	 y[n] = (1/a[0]) * ( b[0]*x[n] + ... + b[P]*x[n-P] - a[1]*y[n-1] - ... - a[Q]*y[n-Q] )
+** IIR Filter Coeffs
+** All IIR Filters are Butterworth by design, built as
+** cascades of second order sections (biquads) so any
+** order stays stable in float. Each section is normalized
+** (a[0]=1) and has unity gain in its pass band.
+** Banks are named IIR_<type>_<order>_<cutoff (% of nyq)>,
+** one {b0,b1,b2,a1,a2} per section.
+** Section equation (transposed direct form II):
+**	 y[n]  = b0*x[n] + z1
+**	 z1    = b1*x[n] - a1*y[n] + z2
+**	 z2    = b2*x[n] - a2*y[n]
 */
-#define IIR_LPF_3a {1.000000,-1.561018,0.641352}
-#define IIR_LPF_3b {0.020083,0.040167,0.020083}
-#define IIR_LPF_5a {1.000000,-3.180639,3.861194,-2.112155,0.438265}
-#define IIR_LPF_5b {0.000417,0.001666,0.002500,0.001666,0.000417}
-#define IIR_LPF_9a {1.000000,-6.390365,18.000338,-29.171099,29.731375,-19.505632,8.040996,-1.903669,0.198100}
-#define IIR_LPF_9b {0.000000,0.000001,0.000005,0.000010,0.000012,0.000010,0.000005,0.000001,0.000000}
-
-#define IIR_HPF_3a {1.000000,-1.561018,0.641352}
-#define IIR_HPF_3b {0.800592,-1.601185,0.800592}
-#define IIR_HPF_5a {1.000000,-3.180639,3.861194,-2.112155,0.438265}
-#define IIR_HPF_5b {0.662016,-2.648063,3.972095,-2.648063,0.662016}
-#define IIR_HPF_9a {1.000000,-6.390365,18.000338,-29.171099,29.731375,-19.505632,8.040996,-1.903669,0.198100}
-#define IIR_HPF_9b {0.445084,-3.560674,12.462360,-24.924719,31.155899,-24.924719,12.462360,-3.560674,0.445084}
+#define IIR_LPF_2_05 {{0.005542717,0.011085434,0.005542717,-1.778631778,0.800802647}}
+#define IIR_LPF_2_10 {{0.020083366,0.040166731,0.020083366,-1.561018076,0.641351538}}
+#define IIR_LPF_2_20 {{0.067455274,0.134910548,0.067455274,-1.142980503,0.412801598}}
+#define IIR_LPF_4_05 {{0.005808127,0.011616254,0.005808127,-1.863800492,0.887033000},{0.005378494,0.010756988,0.005378494,-1.725933395,0.747447372}}
+#define IIR_LPF_4_10 {{0.021883852,0.043767704,0.021883852,-1.700964332,0.788499740},{0.019036832,0.038073663,0.019036832,-1.479674217,0.555821543}}
+#define IIR_LPF_4_20 {{0.077956341,0.155912681,0.077956341,-1.320913431,0.632738793},{0.061885195,0.123770391,0.061885195,-1.048599576,0.296140358}}
+#define IIR_LPF_8_05 {{0.005973525,0.011947049,0.005973525,-1.916875835,0.940769933},{0.005663604,0.011327208,0.005663604,-1.817423777,0.840078193},{0.005447297,0.010894594,0.005447297,-1.748011893,0.769801081},{0.005336984,0.010673967,0.005336984,-1.712612853,0.733960788}}
+#define IIR_LPF_8_10 {{0.023080317,0.046160633,0.023080317,-1.793961845,0.886283112},{0.020886017,0.041772034,0.020886017,-1.623405698,0.706949766},{0.019469327,0.038938654,0.019469327,-1.513290766,0.591168075},{0.018779933,0.037559865,0.018779933,-1.459706254,0.534825985}}
+#define IIR_LPF_8_20 {{0.085667865,0.171335729,0.085667865,-1.451579594,0.794251053},{0.071984525,0.143969050,0.071984525,-1.219725365,0.507663465},{0.064143120,0.128286239,0.064143120,-1.086858461,0.343430940},{0.060572179,0.121144358,0.060572179,-1.026351474,0.268640191}}
+
+#define IIR_HPF_2_05 {{0.894858606,-1.789717212,0.894858606,-1.778631778,0.800802647}}
+#define IIR_HPF_2_10 {{0.800592403,-1.601184807,0.800592403,-1.561018076,0.641351538}}
+#define IIR_HPF_2_20 {{0.638945525,-1.277891050,0.638945525,-1.142980503,0.412801598}}
+#define IIR_HPF_4_05 {{0.937708373,-1.875416746,0.937708373,-1.863800492,0.887033000},{0.868345192,-1.736690383,0.868345192,-1.725933395,0.747447372}}
+#define IIR_HPF_4_10 {{0.872366018,-1.744732036,0.872366018,-1.700964332,0.788499740},{0.758873940,-1.517747880,0.758873940,-1.479674217,0.555821543}}
+#define IIR_HPF_4_20 {{0.738413056,-1.476826112,0.738413056,-1.320913431,0.632738793},{0.586184983,-1.172369967,0.586184983,-1.048599576,0.296140358}}
+#define IIR_HPF_8_05 {{0.964411442,-1.928822884,0.964411442,-1.916875835,0.940769933},{0.914375492,-1.828750985,0.914375492,-1.817423777,0.840078193},{0.879453244,-1.758906487,0.879453244,-1.748011893,0.769801081},{0.861643410,-1.723286821,0.861643410,-1.712612853,0.733960788}}
+#define IIR_HPF_8_10 {{0.920061239,-1.840122479,0.920061239,-1.793961845,0.886283112},{0.832588866,-1.665177732,0.832588866,-1.623405698,0.706949766},{0.776114710,-1.552229420,0.776114710,-1.513290766,0.591168075},{0.748633060,-1.497266120,0.748633060,-1.459706254,0.534825985}}
+#define IIR_HPF_8_20 {{0.811457662,-1.622915324,0.811457662,-1.451579594,0.794251053},{0.681847208,-1.363694415,0.681847208,-1.219725365,0.507663465},{0.607572350,-1.215144701,0.607572350,-1.086858461,0.343430940},{0.573747916,-1.147495833,0.573747916,-1.026351474,0.268640191}}
+
+/* Maximum number of sections per bank (8th order) */
+#define DSP_MAX_SECTIONS 4
+
+/* Number of banks per filter type (see DSP_Functions.ino)
+** and the default banks (2nd order, 0.1*nyq)
+** The bank of each channel can be changed at run time
+** (dsp_prms.IIR_accel_bank/IIR_gyro_bank) */
+#define DSP_NUM_BANKS    9
+#define DSP_LPF_BANK     1
+#define DSP_HPF_BANK     1
 
-#if NTAPS==3
-	#define IIR_LPF_a IIR_LPF_3a
-	#define IIR_LPF_b IIR_LPF_3b
-	#define IIR_HPF_a IIR_HPF_3a
-	#define IIR_HPF_b IIR_HPF_3b
-#elif NTAPS==5
-	#define IIR_LPF_a IIR_LPF_5a
-	#define IIR_LPF_b IIR_LPF_5b
-	#define IIR_HPF_a IIR_HPF_5a
-	#define IIR_HPF_b IIR_HPF_5b
-#elif NTAPS==9
-	#define IIR_LPF_a IIR_LPF_9a
-	#define IIR_LPF_b IIR_LPF_9b
-	#define IIR_HPF_a IIR_HPF_9a
-	#define IIR_HPF_b IIR_HPF_9b
-#endif
+/*
+** Fixed point front end
+** 0: The filters run in float on the sensor state
+** 1: The filters run in integer on the raw readings
+**    (accel_raw/gyro_raw) and the filtered values are
+**    converted to float once, for the later stages
+**    (DCM, GaPA, WISE), see DSP_Fixed_Filter
+** Formats:
+**	 FIR coefficients  Q15 (int16)
+**	 IIR coefficients  Q30 (int32, range +-2)
+**	 Signal and states int32, counts with DSP_Q_SHIFT
+**	                   fraction bits (range +-4x int16)
+** The products are summed in 64 bits and saturated
+** to 32 bits (DSP_SAT32), so an overflow clips rather
+** than wraps. Only integer multiplies are needed.
+*/
+#define DSP_FIXED 0
+
+#define DSP_Q15_SHIFT 15
+#define DSP_Q30_SHIFT 30
+#define DSP_Q_SHIFT   14
+
+/* Float to Q format (used at init only) */
+#define DSP_TO_Q(value,shift) ( (int32_t)lrintf( (value)*(float)(1L<<(shift)) ) )
+
+/* Saturate a 64 bit sum to 32 bits */
+#define DSP_SAT32(x) ( ( (x)>INT32_MAX ) ? INT32_MAX : ( ( (x)<INT32_MIN ) ? INT32_MIN : (int32_t)(x) ) )
+
+/* Round and drop shift fraction bits of a 64 bit sum */
+#define DSP_ROUND_SHIFT(x,shift) ( ( (x) + ((int64_t)1<<((shift)-1)) ) >> (shift) )
 
 /*******************************************************************
 ** Typedefs
 ********************************************************************/
 
+/*
+** TYPE: DSP_BIQUAD_TYPE
+** One second order section, normalized (a[0]=1) */
 typedef struct
 {
-	float IIR_coeffs_La[NTAPS];
-	float IIR_coeffs_Lb[NTAPS];
-	float IIR_coeffs_Ha[NTAPS];
-	float IIR_coeffs_Hb[NTAPS];
+	float b0, b1, b2;
+	float a1, a2;
+} DSP_BIQUAD_TYPE;
 
+/*
+** TYPE: DSP_BIQUAD_Q_TYPE
+** One second order section in Q30 (DSP_FIXED) */
+typedef struct
+{
+	int32_t b0, b1, b2;
+	int32_t a1, a2;
+} DSP_BIQUAD_Q_TYPE;
+
+/*
+** TYPE: DSP_BANK_TYPE
+** A cascade of second order sections */
+typedef struct
+{
+	float cutoff;    /* Fraction of nyq */
+	int   nSections; /* Order/2 */
+	DSP_BIQUAD_TYPE section[DSP_MAX_SECTIONS];
+} DSP_BANK_TYPE;
+
+/*
+** TYPE: DSP_STATE_TYPE
+** Filter coefficients and histories.
+** Each FIR filter keeps its input (x) history, the
+** FIR histories share head (see DSP_Shift).
+** Each IIR channel keeps the state (z1,z2) of each
+** section of its current bank */
+typedef struct
+{
 	float FIR_coeffs_L[NTAPS];
 	float FIR_coeffs_H[NTAPS];
 
-	float accel_mem[3][NTAPS];
-	float gyro_mem[3][NTAPS];
+	/* FIR: x */
+	float FIR_accel_x[3][2*NTAPS];
+	float FIR_gyro_x[3][2*NTAPS];
+
+	/* Slot of the current sample, 0..NTAPS-1 */
+	int head;
+
+	/* IIR: bank in use and section states, per channel */
+	int   IIR_accel_bank[3];
+	int   IIR_gyro_bank[3];
+	float IIR_accel_z[3][DSP_MAX_SECTIONS][2];
+	float IIR_gyro_z[3][DSP_MAX_SECTIONS][2];
+
+#if DSP_FIXED==1 || EXE_MODE==1
+	/* Fixed point (DSP_FIXED): FIR coefficients and raw
+	** histories (same head), IIR bank in use, its section
+	** coefficients and states, per channel */
+	int16_t FIR_coeffs_Lq[NTAPS];
+	int16_t FIR_coeffs_Hq[NTAPS];
+	int16_t FIR_accel_xq[3][2*NTAPS];
+	int16_t FIR_gyro_xq[3][2*NTAPS];
+
+	int     IIR_accel_bank_q[3];
+	int     IIR_gyro_bank_q[3];
+	DSP_BIQUAD_Q_TYPE IIR_accel_q[3][DSP_MAX_SECTIONS];
+	DSP_BIQUAD_Q_TYPE IIR_gyro_q[3][DSP_MAX_SECTIONS];
+	int32_t IIR_accel_zq[3][DSP_MAX_SECTIONS][2];
+	int32_t IIR_gyro_zq[3][DSP_MAX_SECTIONS][2];
+#endif
 } DSP_STATE_TYPE;
 
 
@@ -113,9 +227,21 @@ typedef struct
 
 	int FIR_on;
 	int	IIR_on;
+
+	/* IIR bank selected per channel
+	** Accel: LPF banks, Gyro: HPF banks */
+	int IIR_accel_bank[3];
+	int IIR_gyro_bank[3];
 }	DSP_PRMS_TYPE;
 
 
+/*******************************************************************
+** Kernels
+********************************************************************/
+
+#include "DSP_Kernels.h"
+
+
 #endif /* End DSP_CONFIG_H */
 
 
@@ -0,0 +1,109 @@
+/*******************************************************************
+** FILE:
+**   	DSP_Kernels.h
+** DESCRIPTION:
+** 		Compile time FIR kernels.
+** 		The tap count and the coefficients are template
+** 		parameters, so each kernel is fully unrolled with its
+** 		coefficients as constants (no coefficient loads and
+** 		no loop overhead).
+** 		Symmetric coefficient sets (b[i]==b[N-1-i], all of the
+** 		FIR tables in DSP_Config.h) fold each pair of taps into
+** 		one multiply:
+** 			b[i]*x[i] + b[N-1-i]*x[N-1-i] = b[i]*(x[i]+x[N-1-i])
+** 		which takes (N+1)/2 multiplies instead of N. Folding
+** 		changes the float rounding (within a few ulp of the
+** 		loop). The unfolded kernel adds the taps in the same
+** 		order as the loop in FIR_Filter and is bit for bit
+** 		identical to it; it is the fallback for coefficient
+** 		sets that are not symmetric.
+** 		The kernel used is set by DSP_FIR_KERNEL (DSP_Config.h).
+** 		C++11 (no fold expressions or <type_traits>, so it
+** 		also builds for the AVR boards).
+********************************************************************/
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+
+/*******************************************************************
+** Coefficients
+********************************************************************/
+
+/* Compile time copies of the FIR tables used by FIR_Filter */
+constexpr float DSP_FIR_LPF_taps[NTAPS] = FIR_LPF;
+constexpr float DSP_FIR_HPF_taps[NTAPS] = FIR_HPF;
+
+
+/*******************************************************************
+** Kernels
+********************************************************************/
+
+/*
+** FUNCTION: DSP_FIR_Symmetric
+** Compile time test of b[i]==b[n-1-i], from tap i */
+constexpr bool DSP_FIR_Symmetric( const float *b, int n, int i )
+{
+	return ( i>=n/2 ) ? true : ( b[i]==b[n-1-i] && DSP_FIR_Symmetric( b, n, i+1 ) );
+}
+
+/*
+** TYPE: DSP_FIR_Unroll
+** Taps I..N-1, added in order:
+**	 acc + b[I]*x[I] + b[I+1]*x[I+1] + ... */
+template< int N, const float (&B)[N], int I >
+struct DSP_FIR_Unroll
+{
+	static inline float Sum( float acc, const float *x )
+	{
+		return DSP_FIR_Unroll<N,B,I+1>::Sum( acc + B[I]*x[I], x );
+	}
+};
+
+template< int N, const float (&B)[N] >
+struct DSP_FIR_Unroll<N,B,N>
+{
+	static inline float Sum( float acc, const float *x ) { return acc; }
+};
+
+/*
+** TYPE: DSP_FIR_Fold
+** Tap pairs I..HALF-1, then the centre tap (odd N):
+**	 acc + b[I]*(x[I]+x[N-1-I]) + ... + b[HALF]*x[HALF]
+** HALF is N/2 */
+template< int N, const float (&B)[N], int I, int HALF >
+struct DSP_FIR_Fold
+{
+	static inline float Sum( float acc, const float *x )
+	{
+		return DSP_FIR_Fold<N,B,I+1,HALF>::Sum( acc + B[I]*( x[I]+x[N-1-I] ), x );
+	}
+};
+
+template< int N, const float (&B)[N], int HALF >
+struct DSP_FIR_Fold<N,B,HALF,HALF>
+{
+	static inline float Sum( float acc, const float *x )
+	{
+		return ( N%2==1 ) ? acc + B[N/2]*x[N/2] : acc;
+	}
+};
+
+/*
+** TYPE: DSP_FIR_Kernel
+** y[n] = b[0]*x[n] + ... + b[N-1]*x[n-N+1], with x[i]=x[n-i]
+** Folds the taps when the coefficients are symmetric
+** (FOLD defaults to the compile time test) */
+template< int N, const float (&B)[N], bool FOLD = DSP_FIR_Symmetric( B, N, 0 ) >
+struct DSP_FIR_Kernel
+{
+	static inline float Run( const float *x ) { return DSP_FIR_Unroll<N,B,0>::Sum( 0.0f, x ); }
+};
+
+template< int N, const float (&B)[N] >
+struct DSP_FIR_Kernel<N,B,true>
+{
+	static inline float Run( const float *x ) { return DSP_FIR_Fold<N,B,0,N/2>::Sum( 0.0f, x ); }
+};
+
+
+#endif /* End DSP_KERNELS_H */
@@ -0,0 +1,284 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Config.h
+** DESCRIPTION:
+** 		Header for the host (Linux) emulator build.
+** 		The emulator replays recorded accel/gyro/timestamp samples
+** 		through the same stage sequence as the real-time loop().
+** 		This file stands in for the hardware specific port and
+** 		timing macros defined in the IMU#_Config.h headers, and
+** 		should only be included when EXE_MODE==1.
+********************************************************************/
+#ifndef EMULATOR_CONFIG_H
+#define EMULATOR_CONFIG_H
+
+#include "../Include/Recording_Config.h"
+#include "../Include/Sweep_Config.h"
+#include "../Include/Bench_Config.h"
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Log port
+** In emulation mode, all log output is sent to stderr.
+** The per-sample results are written to the output file
+** (see Emulator_LogOut) */
+#define LOG_PORT stderr
+
+#define LOG_PRINTLN(...) { if(DEBUG){ fprintf(LOG_PORT,__VA_ARGS__); fprintf(LOG_PORT,"\n"); } }
+#define LOG_PRINT(...)   { if(DEBUG){ fprintf(LOG_PORT,__VA_ARGS__); } }
+
+/* Maximum length of a line in a text (csv) recording */
+#define EMU_LINE_LENGTH 256
+
+/* Input recording formats
+** 0: Text (Debug_LogOut output mode 2)
+** 1: Binary (see Recording_Config.h) */
+#define EMU_FORMAT_CSV    0
+#define EMU_FORMAT_BINARY 1
+
+/* Communication port
+** The serial port to the master is replaced by a pair of
+** byte queues (see Emulator_Comm_*). The emulator plays the
+** master: requests are queued with Emulator_Comm_Send and
+** the responses collected with Emulator_Comm_Receive */
+#define COMM_PRINT     Emulator_Comm_Print
+#define COMM_WRITE     Emulator_Comm_Write
+#define COMM_AVAILABLE Emulator_Comm_Available()
+#define COMM_READ      Emulator_Comm_Read()
+
+/* Size of each communication queue (bytes) */
+#define EMU_COMM_BUFFER 1024
+
+/* MPU-9250 FIFO (ACQ_MODE_INTERRUPT/FIFO)
+** The I2C register access in Acq_FIFO_Read is replaced by
+** a register/FIFO model of the MPU-9250 (see Emulator_MPU_*),
+** fed with recorded samples by WISE_Emulator -a and -f */
+#define ACQ_FIFO_READ(reg,len,p_data) Emulator_MPU_Read( reg, len, p_data )
+#define ACQ_FIFO_RESET()              Emulator_MPU_Reset_FIFO()
+
+/* FIFO capacity in whole frames (512 bytes on the MPU-9250) */
+#define EMU_MPU_FIFO_FRAMES (512/ACQ_FIFO_FRAME_SIZE)
+
+/* Sample period of the recordings (us), 200 Hz */
+#define EMU_MPU_PERIOD 5000
+
+/* I2C bus (see I2C_Config.h)
+** Wire is replaced by a stand-in with a register file per
+** device and a bus time model (see Emulator_Wire.cpp) */
+#define EMU_WIRE_DEVICES 4
+#define EMU_WIRE_BUFFER  32 /* As the AVR Wire buffer */
+
+/* Block DSP (see Emulator_DSP.cpp)
+** A block is nSamples x DSP_BLOCK_CHANNELS, one row per
+** sample: accel x,y,z then gyro x,y,z. The FIR runs up to
+** DSP_BLOCK_SIZE samples per pass, the IIR runs the
+** channels as DSP_BLOCK_LANES lanes (padded), in vectors
+** of DSP_BLOCK_WIDTH lanes (SSE, the emulator default
+** target) */
+#define DSP_BLOCK_CHANNELS 6
+#define DSP_BLOCK_LANES    8
+#define DSP_BLOCK_WIDTH    4
+#define DSP_BLOCK_VECTORS  (DSP_BLOCK_LANES/DSP_BLOCK_WIDTH)
+#define DSP_BLOCK_SIZE     256
+
+/* FIR kernel test (WISE_Emulator -d)
+** Bound on the difference between the folded and loop
+** FIR kernels, in units of FLT_EPSILON*sum(|b[i]*x[i]|).
+** Each of the at most NTAPS additions rounds once, so
+** NTAPS is a bound on either sum. The unrolled kernel
+** must match the loop bit for bit */
+#define DSP_FIR_FOLD_MAX_ERROR ((float)NTAPS)
+
+/* Fixed point DSP test (WISE_Emulator -q)
+** Default bound on the difference between the fixed
+** point and float filter outputs (counts) */
+#define DSP_FIXED_MAX_ERROR 0.25f
+
+/* Fixed point DCM test (WISE_Emulator -o)
+** Default bound on the difference between the fixed
+** point and float Euler angles (deg) */
+#define DCM_FIXED_MAX_ERROR 0.1f
+
+/* Quaternion engine test (WISE_Emulator -e)
+** Default bound on the difference between the quaternion
+** and DCM Euler angles (deg) */
+#define QUATERNION_MAX_ERROR 0.05f
+
+/* Trig tier test (WISE_Emulator -t)
+** Default float bit pattern step (1 is exhaustive) */
+#define TRIG_TEST_STRIDE 64
+
+/* Motion stats test (WISE_Emulator -m)
+** Default samples per test signal, and bound on the
+** relative error of the window mean and sum of squares */
+#define STATS_TEST_SAMPLES   4096
+#define STATS_TEST_MAX_ERROR 1.0e-4
+
+/* FES trigger latency test (WISE_Emulator -l)
+** Default trigger phase, delay from the trigger to the
+** relay switching (ms), and the largest distance from a
+** reference event that still matches a trigger (ms).
+** The relay delay plus the sampling delay (up to one
+** sample) is what GAPA_PREDICT_MS makes up for */
+#define PHASE_TEST_PHASE       0.6f
+#define EMU_FES_RELAY_DELAY_MS 35
+#define EMU_FES_MATCH_MS       300
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: EMULATION_TYPE
+** This type holds the emulator file handles
+** and the current timestamp read from the
+** input recording */
+typedef struct
+{
+	/* Input recording and output results */
+	FILE *InputFID;
+	FILE *OutputFID;
+
+	/* Input recording format (EMU_FORMAT_*) */
+	int InputFormat;
+
+	/* Memory mapped binary recording
+	** p_sample points at the record most recently
+	** read by Read_Sensors (e.g. for foot sensors) */
+	void                        *p_map;
+	size_t                       map_nBytes;
+	const RECORDING_HEADER_TYPE *p_header;
+	const RECORDING_SAMPLE_TYPE *p_records;
+	const RECORDING_SAMPLE_TYPE *p_sample;
+	uint64_t                     RecordIndex;
+
+	/* Used to unwrap the 32 bit recorded timestamps */
+	uint32_t      timestamp_raw;
+	unsigned long timestamp_wrap;
+
+	/* Timestamp of the current sample (us)
+	** Read from file, see Update_Time */
+	unsigned long timestamp;
+
+	/* Set once the input recording is exhausted */
+	bool EndOfFile;
+
+	/* Number of samples read from the recording */
+	unsigned long nSamples;
+} EMULATION_TYPE;
+
+/*
+** TYPE: EMULATOR_COMM_TYPE
+** Stand-in for the serial port to the master.
+** rx holds the requests waiting to be read by the sketch,
+** tx the response bytes written by the sketch. Both are
+** circular, tx overwrites its oldest bytes when full */
+typedef struct
+{
+	uint8_t       rx[EMU_COMM_BUFFER];
+	unsigned long rx_head, rx_tail;
+
+	uint8_t       tx[EMU_COMM_BUFFER];
+	unsigned long tx_head, tx_tail;
+
+	/* Total bytes written by the sketch */
+	unsigned long tx_nBytes;
+} EMULATOR_COMM_TYPE;
+
+/*
+** TYPE: EMULATOR_MPU_TYPE
+** Stand-in for the MPU-9250 FIFO registers.
+** The FIFO holds whole frames; when it is full the
+** oldest frame is overwritten and the overflow bit
+** set in int_status (cleared when read), as on the
+** device. The sampled timestamp of each frame is
+** kept beside it, so the timestamps rebuilt by
+** Acq_FIFO_Read can be checked (Emulator_MPU_Read_Time) */
+typedef struct
+{
+	uint8_t       fifo[EMU_MPU_FIFO_FRAMES*ACQ_FIFO_FRAME_SIZE];
+	uint32_t      fifo_time[EMU_MPU_FIFO_FRAMES];
+	unsigned long fifo_head, fifo_tail; /* bytes */
+	uint8_t       int_status;
+
+	/* Timestamps of the frames read out */
+	uint32_t      read_time[EMU_MPU_FIFO_FRAMES];
+	unsigned long read_head, read_tail;
+
+	/* Bus transactions and bytes transferred */
+	unsigned long nTransactions;
+	unsigned long nBytes;
+
+	/* Frames sampled, and lost to overflow or reset */
+	unsigned long nSampled;
+	unsigned long nLost;
+} EMULATOR_MPU_TYPE;
+
+/* Arduino byte type (WIRE_SEND) */
+typedef uint8_t byte;
+
+/*
+** TYPE: EMULATOR_I2C_DEVICE_TYPE
+** One I2C device: 256 registers, the register
+** address pointer auto increments on each byte */
+typedef struct
+{
+	uint8_t address;
+	uint8_t reg[256];
+	uint8_t pointer;
+} EMULATOR_I2C_DEVICE_TYPE;
+
+/*
+** TYPE: DSP_LANES_TYPE, DSP_MASK_TYPE
+** DSP_BLOCK_WIDTH block DSP lanes, one float (int
+** mask) each, as GCC vectors: element-wise arithmetic
+** in the same IEEE single precision as the scalar code,
+** compiled to SIMD instructions (see DSP_Block_IIR) */
+typedef float   DSP_LANES_TYPE __attribute__(( vector_size( DSP_BLOCK_WIDTH*sizeof(float) ) ));
+typedef int32_t DSP_MASK_TYPE  __attribute__(( vector_size( DSP_BLOCK_WIDTH*sizeof(int32_t) ) ));
+
+/*
+** TYPE: EMULATOR_WIRE_TYPE
+** Stand-in for the Arduino Wire (TwoWire) object.
+** The bus time is counted in SCL clocks: 1 per
+** START/repeated START and STOP, 9 per byte
+** (8 bits and ACK), see Emulator_Wire_Time */
+typedef struct EMULATOR_WIRE_TYPE
+{
+	EMULATOR_I2C_DEVICE_TYPE device[EMU_WIRE_DEVICES];
+	int                      nDevices;
+
+	/* Pending write (beginTransmission) */
+	uint8_t tx_address;
+	uint8_t tx[EMU_WIRE_BUFFER];
+	int     tx_length;
+
+	/* Bytes read (requestFrom) */
+	uint8_t rx[EMU_WIRE_BUFFER];
+	int     rx_length, rx_index;
+
+	/* Bus traffic */
+	uint32_t      clock; /* Hz */
+	unsigned long nTransactions; /* START and repeated START */
+	unsigned long nStops;
+	unsigned long nBits;
+
+	void    begin( void );
+	void    setClock( uint32_t frequency );
+	void    beginTransmission( uint8_t address );
+	size_t  write( uint8_t data );
+	uint8_t endTransmission( uint8_t stop=1 );
+	uint8_t requestFrom( uint8_t address, uint8_t quantity, uint8_t stop=1 );
+	int     available( void );
+	int     read( void );
+} EMULATOR_WIRE_TYPE;
+
+/* The I2C bus (Emulator_Wire.cpp) */
+extern EMULATOR_WIRE_TYPE Wire;
+
+
+#endif /* End EMULATOR_CONFIG_H */
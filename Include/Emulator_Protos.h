@@ -0,0 +1,355 @@
+/*******************************************************************
+** FILE:
+**   	Emulator_Protos.h
+** DESCRIPTION:
+** 		Function prototypes for the emulator build.
+** 		The Arduino IDE generates prototypes for every
+** 		function in the sketch. When the same files are
+** 		compiled separately on the host (EXE_MODE==1) this
+** 		header provides them instead.
+** 		NOTE: This header should contain the function
+** 		      prototypes for all execution functions
+********************************************************************/
+#ifndef EMULATOR_PROTOS_H
+#define EMULATOR_PROTOS_H
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+
+
+/*******************************************************************
+** Common_Functions
+********************************************************************/
+void Common_Init ( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void Update_Time( CONTROL_TYPE *p_control );
+void Pipeline_Init( PIPELINE_STATE_TYPE *p_pipeline );
+void Pipeline_Update( PIPELINE_STATE_TYPE *p_pipeline );
+
+
+/*******************************************************************
+** Calibration_Functions
+********************************************************************/
+void Calibration_Init ( CONTROL_TYPE *p_control, CALIBRATION_TYPE *p_calibration );
+void Calibrate ( CONTROL_TYPE *p_control, CALIBRATION_TYPE *p_calibration, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** DSP_Functions
+********************************************************************/
+void DSP_Filter_Init ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state );
+void DSP_Update ( DSP_STATE_TYPE *p_dsp_state, float mem[3][2*NTAPS], const float *p_value );
+void DSP_Shift ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state );
+extern const DSP_BANK_TYPE g_dsp_LPF_banks[DSP_NUM_BANKS];
+extern const DSP_BANK_TYPE g_dsp_HPF_banks[DSP_NUM_BANKS];
+void DSP_Biquad_Reset ( float z[DSP_MAX_SECTIONS][2] );
+void DSP_Biquad_Select ( int bank, int *p_bank, float z[DSP_MAX_SECTIONS][2] );
+float DSP_Biquad ( const DSP_BANK_TYPE *p_bank, float z[DSP_MAX_SECTIONS][2], float x );
+void IIR_Filter ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, SENSOR_STATE_TYPE *p_sensor_state );
+void FIR_Filter ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, SENSOR_STATE_TYPE *p_sensor_state );
+void DSP_Fixed_Init ( DSP_STATE_TYPE *p_dsp_state );
+void DSP_Fixed_Select ( int bank, int *p_bank, const DSP_BANK_TYPE *p_banks, DSP_BIQUAD_Q_TYPE sec[DSP_MAX_SECTIONS], int32_t z[DSP_MAX_SECTIONS][2] );
+int32_t DSP_Fixed_Biquad ( const DSP_BIQUAD_Q_TYPE sec[DSP_MAX_SECTIONS], int nSections, int32_t z[DSP_MAX_SECTIONS][2], int32_t x );
+void FIR_Filter_Fixed ( DSP_STATE_TYPE *p_dsp_state, SENSOR_STATE_TYPE *p_sensor_state, int32_t accel[3], int32_t gyro[3] );
+void IIR_Filter_Fixed ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, int32_t accel[3], int32_t gyro[3] );
+void DSP_Fixed_Load ( SENSOR_STATE_TYPE *p_sensor_state );
+void DSP_Fixed_Filter ( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** DCM_Functions
+********************************************************************/
+void DCM_Init( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+void Reset_Sensor_Fusion( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+void Set_Sensor_Fusion( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void Init_Rotation_Matrix( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+void Orientation_Update( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+void Orientation_Switch( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state );
+void DCM_Filter( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+void Orientation_Select_Stages( CONTROL_TYPE *p_control );
+void Orientation_Euler_Angles( CONTROL_TYPE *p_control, const float Row2[3], float m10, float m00, SENSOR_STATE_TYPE *p_sensor_state );
+float Orientation_Roll( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+float Orientation_Yaw( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+int  DCM_Fixed_Gain( float gain, int32_t *p_mant );
+int32_t DCM_Fixed_Feedback( int32_t error, int32_t mant, int exponent );
+void DCM_Filter_Fixed( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** Quaternion_Functions
+********************************************************************/
+void Quaternion_From_DCM( DCM_STATE_TYPE *p_dcm_state );
+void Quaternion_To_DCM( DCM_STATE_TYPE *p_dcm_state );
+void Quaternion_Filter( CONTROL_TYPE *p_control, DCM_STATE_TYPE *p_dcm_state, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** GaPA_Functions
+********************************************************************/
+void GaPA_Init( CONTROL_TYPE *p_control, GAPA_STATE_TYPE *p_gapa_state );
+void GaPA_Reset( CONTROL_TYPE *p_control, GAPA_STATE_TYPE *p_gapa_state );
+void GaPA_Circle_Init( GAPA_CIRCLE_FIT_TYPE *p_circle );
+void GaPA_Circle_Push( GAPA_CIRCLE_FIT_TYPE *p_circle, float x, float y );
+bool GaPA_Circle_Center( GAPA_CIRCLE_FIT_TYPE *p_circle, float xcyc[2] );
+void GaPA_Update( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, GAPA_STATE_TYPE *p_gapa_state );
+void GaPA_Predict( CONTROL_TYPE *p_control, GAPA_STATE_TYPE *p_gapa_state );
+void TrackPhiVariables( GAPA_STATE_TYPE *p_gapa_state );
+void calc_SftPrmLeft( float *GAMMA, float PHI_max, float PHI_min );
+void calc_SftPrmRight( float *gamma, float phi_max, float phi_min );
+void calc_ScaleFactor( float *z, float phi_max, float phi_min, float PHI_max, float PHI_min );
+void calc_PhaseAngle( float *nu, float z, float PHI, float GAMMA, float phi, float gamma );
+
+
+/*******************************************************************
+** WISE_Functions
+********************************************************************/
+void WISE_Init ( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+void WISE_Update ( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+void WISE_Reset ( CONTROL_TYPE *p_control, WISE_STATE_TYPE *p_wise_state );
+void Map_Accel_2D ( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+void Integrate_Accel_2D ( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+void Adjust_Velocity( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+bool WISE_Drift_Fit( const WISE_FIT_TYPE *p_fit, int i, float *p_drift, float *p_vel_ave );
+void WISE_Stride_Push( WISE_STATE_TYPE *p_wise_state );
+void Adjust_Incline( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+void Estimate_Error( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, WISE_STATE_TYPE *p_wise_state );
+
+
+/*******************************************************************
+** Logging_Functions
+********************************************************************/
+void Debug_LogOut( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, GAPA_STATE_TYPE *p_gapa_state, WISE_STATE_TYPE *p_wise_state );
+void Cal_LogOut( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, CALIBRATION_TYPE *p_calibration );
+void FltToStr( float value, int precision, char *StrBuffer );
+
+
+/*******************************************************************
+** Communication_Functions
+********************************************************************/
+void    f_RespondToInput( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, CALIBRATION_TYPE *p_calibration, WISE_STATE_TYPE *p_wise_state, int nBytesIn );
+void    f_SendPacket( COMMUNICATION_PACKET_TYPE Response );
+void    f_SendProfile( CONTROL_TYPE *p_control );
+void    f_SendStrides( WISE_STATE_TYPE *p_wise_state );
+void    f_WriteIToPacket( uint8_t *Packet, uint16_t InputBuffer );
+void    f_WriteLToPacket( uint8_t *Packet, uint32_t InputBuffer );
+void    f_WriteFToPacket_u16( unsigned char *Packet, float Input );
+void    f_WriteFToPacket_s16( unsigned char *Packet, float Input );
+void    f_WriteFToPacket_s32( unsigned char *Packet, float Input );
+void    f_Handshake( CONTROL_TYPE *p_control );
+uint8_t f_CheckSum( unsigned char *p_Buffer, uint16_t nBytes );
+
+
+/*******************************************************************
+** Profile_Functions
+********************************************************************/
+void Profile_Init( CONTROL_TYPE *p_control );
+void Profile_Reset( CONTROL_TYPE *p_control );
+void Profile_Record( CONTROL_TYPE *p_control, int stage, uint32_t time );
+void Profile_Lap( CONTROL_TYPE *p_control, int stage );
+void Profile_Loop_Begin( CONTROL_TYPE *p_control );
+void Profile_Loop_End( CONTROL_TYPE *p_control );
+void Profile_Update_Time( CONTROL_TYPE *p_control, unsigned long idle );
+
+
+/*******************************************************************
+** Stats_Functions
+********************************************************************/
+void Stats_Init( STATS_STATE_TYPE *p_stats );
+void Stats_Window_Push( STATS_WINDOW_TYPE *p_win, uint32_t n, float x );
+void Stats_Window_Read( const STATS_WINDOW_TYPE *p_win, uint32_t count, float *p_mAve, float *p_M2, float *p_min, float *p_max );
+void Stats_Update( STATS_STATE_TYPE *p_stats, SENSOR_STATE_TYPE *p_sensor_state );
+
+
+/*******************************************************************
+** Acquisition_Functions
+********************************************************************/
+void Acq_Ring_Init( ACQ_RING_TYPE *p_ring );
+bool Acq_Ring_Push( ACQ_RING_TYPE *p_ring, const ACQ_SAMPLE_TYPE *p_sample );
+void Acq_Ring_Stamp( ACQ_RING_TYPE *p_ring, uint32_t timestamp );
+bool Acq_Ring_Pop( ACQ_RING_TYPE *p_ring, ACQ_SAMPLE_TYPE *p_sample );
+int  Acq_Begin_Batch( ACQ_RING_TYPE *p_ring );
+void Acq_Load_Sample( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, const ACQ_SAMPLE_TYPE *p_sample );
+int  Acq_Process( PIPELINE_STATE_TYPE *p_pipeline, ACQ_RING_TYPE *p_ring );
+void Acq_FIFO_Init( ACQ_FIFO_TYPE *p_fifo, uint32_t period, bool Stamped );
+int  Acq_FIFO_Read( ACQ_FIFO_TYPE *p_fifo, ACQ_RING_TYPE *p_ring, uint32_t now );
+
+
+/*******************************************************************
+** I2C_Functions
+********************************************************************/
+void I2C_Set_Init( I2C_SET_TYPE *p_set );
+int  I2C_Queue_Read( I2C_SET_TYPE *p_set, uint8_t address, uint8_t reg, uint8_t length );
+bool I2C_Read_Block( I2C_READ_TYPE *p_read, bool stop );
+bool I2C_Run( I2C_SET_TYPE *p_set );
+
+
+/*******************************************************************
+** Math
+********************************************************************/
+float Vector_Magnitude ( const float v1[3] );
+float Vector_Dot_Product ( const float v1[3], const float v2[3] );
+void  Vector_Cross_Product( const float v1[3], const float v2[3], float out[3] );
+void  Vector_Scale( const float v[3], const float scalar, float out[3] );
+void  Vector_Add( const float v1[3], const float v2[3], float out[3] );
+void  Matrix_Matrix_Multiply( const float m1[3][3], const float m2[3][3], float out[3][3] );
+void  Matrix_Vector_Multiply( const float m[3][3], const float v[3], float out[3] );
+float Rolling_Mean( const int n, const float m, const float x );
+float Windowed_Mean( float m, float x, int n, float a );
+float Rolling_SumOfSquares( const float m_prev, const float m, const float x, const float M2 );
+float Rolling_Sample_Variance( const int N, const float M2 );
+float Rolling_Population_Variance( const int N, const float M2 );
+float f_asin( float x );
+float f_asin_precise( float x );
+float f_atan2( float y, float x );
+float f_atan2_precise( float y, float x );
+void  f_sincos_quadrant( int q, float s, float c, float *p_sin, float *p_cos );
+void  f_sincos_precise( float x, float *p_sin, float *p_cos );
+void  f_sincos_fast( float x, float *p_sin, float *p_cos );
+void  f_sincos( float x, float *p_sin, float *p_cos );
+float f_rsqrt_fast( float x );
+float f_rsqrt_precise( float x );
+float f_rsqrt( float x );
+float f_sqrt( float x );
+extern const int32_t q_atan_table[Q_CORDIC_ITER];
+uint32_t q_sqrt( uint64_t x );
+int32_t q_atan2( int32_t y, int32_t x );
+int32_t q_asin( int32_t x );
+void  calc_circle_center( float p1[2], float p2[2], float p3[2], float xcyc[2] );
+
+
+/*******************************************************************
+** Emulator_Functions (Emulator/Emulator_Functions.cpp)
+********************************************************************/
+bool Emulator_Init( CONTROL_TYPE *p_control, const char *InputPath, const char *OutputPath );
+void Emulator_Close( CONTROL_TYPE *p_control );
+bool Emulator_Map_Recording( CONTROL_TYPE *p_control, const char *InputPath );
+void Read_Sensors( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void Read_Sensors_Binary( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void Read_Sensors_Csv( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+bool Emulator_Convert_Recording( const char *InputPath, const char *OutputPath );
+void Emulator_LogOut( CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state, GAPA_STATE_TYPE *p_gapa_state, WISE_STATE_TYPE *p_wise_state );
+void   Emulator_Comm_Reset( void );
+int    Emulator_Comm_Send( const uint8_t *p_bytes, int nBytes );
+int    Emulator_Comm_Receive( uint8_t *p_bytes, int MaxBytes );
+int    Emulator_Comm_Available( void );
+int    Emulator_Comm_Read( void );
+size_t Emulator_Comm_Write( const uint8_t *p_bytes, size_t nBytes );
+size_t Emulator_Comm_Print( char c );
+size_t Emulator_Comm_Print( uint8_t c );
+void   delay( unsigned long ms );
+double Emulator_Clock( void );
+unsigned long Emulator_Micros( void );
+
+
+/*******************************************************************
+** Emulator (Emulator/Emulator.cpp)
+********************************************************************/
+bool setup( PIPELINE_STATE_TYPE *p_pipeline, const char *InputPath, const char *OutputPath );
+void loop( PIPELINE_STATE_TYPE *p_pipeline );
+bool Emulator_Replay( PIPELINE_STATE_TYPE *p_pipeline, const char *InputPath, const char *OutputPath );
+
+
+/*******************************************************************
+** Emulator_Runner (Emulator/Emulator_Runner.cpp)
+********************************************************************/
+int  Emulator_Run_Parallel( char **InputPaths, int nInputs, const char *OutputDir, int nWorkers );
+
+
+/*******************************************************************
+** Emulator_Sweep (Emulator/Emulator_Sweep.cpp)
+********************************************************************/
+bool  Sweep_Read_Grid( const char *GridPath, CONTROL_TYPE *p_control, SWEEP_GRID_TYPE *p_grid );
+bool  Sweep_Read_Labels( const char *LabelsPath, SWEEP_LABELS_TYPE *p_labels );
+void* Sweep_Alloc( SWEEP_STATE_TYPE *p_sweep, size_t ElementSize );
+void  Sweep_Free( SWEEP_STATE_TYPE *p_sweep );
+bool  Sweep_Init( SWEEP_STATE_TYPE *p_sweep, SWEEP_GRID_TYPE *p_grid, PIPELINE_STATE_TYPE *p_pipeline );
+void  Sweep_DCM_Update( SWEEP_STATE_TYPE *p_sweep, CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void  Sweep_GaPA_Update( SWEEP_STATE_TYPE *p_sweep, CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void  Sweep_WISE_Update( SWEEP_STATE_TYPE *p_sweep, CONTROL_TYPE *p_control, SENSOR_STATE_TYPE *p_sensor_state );
+void  Sweep_WISE_Reset( SWEEP_STATE_TYPE *p_sweep );
+void  Sweep_Score( SWEEP_STATE_TYPE *p_sweep, SWEEP_LABELS_TYPE *p_labels, unsigned long timestamp );
+bool  Sweep_Check( SWEEP_STATE_TYPE *p_sweep, PIPELINE_STATE_TYPE *p_pipeline );
+bool  Sweep_Report( SWEEP_STATE_TYPE *p_sweep, const char *OutputPath );
+bool  Emulator_Sweep( const char *GridPath, const char *LabelsPath, const char *InputPath, const char *OutputPath );
+
+
+/*******************************************************************
+** Emulator_Bench (Emulator/Emulator_Bench.cpp)
+********************************************************************/
+double Bench_Timer_Overhead( void );
+bool   Bench_Record( BENCH_STAGE_TYPE *p_stage, int Repeat, double latency );
+bool   Bench_Read_Thresholds( const char *ThresholdsPath, BENCH_STATE_TYPE *p_bench );
+bool   Bench_Replay( BENCH_STATE_TYPE *p_bench, PIPELINE_STATE_TYPE *p_pipeline, const char *InputPath, int Repeat );
+void   Bench_Results( BENCH_STATE_TYPE *p_bench );
+bool   Bench_Report( BENCH_STATE_TYPE *p_bench, const char *InputPath, const char *OutputPath );
+int    Emulator_Bench( const char *InputPath, const char *OutputPath, const char *ThresholdsPath );
+
+
+/*******************************************************************
+** Emulator_Acquire (Emulator/Emulator_Acquire.cpp)
+********************************************************************/
+bool Emulator_Acquire( const char *InputPath, const char *OutputPath, double Speed );
+bool Emulator_Acquire_FIFO( const char *InputPath, const char *OutputPath, int FramesPerLoop );
+
+
+/*******************************************************************
+** Emulator_DSP (Emulator/Emulator_DSP.cpp)
+********************************************************************/
+void DSP_Block_FIR( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, float block[][DSP_BLOCK_CHANNELS], int nSamples );
+void DSP_Block_IIR( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, float block[][DSP_BLOCK_CHANNELS], int nSamples );
+void DSP_Block_Filter( CONTROL_TYPE *p_control, DSP_STATE_TYPE *p_dsp_state, float block[][DSP_BLOCK_CHANNELS], int nSamples );
+int  Emulator_DSP_Test( const char *InputPath, int BlockSize );
+int  Emulator_DSP_Fixed_Test( const char *InputPath, float MaxError );
+
+
+/*******************************************************************
+** Emulator_DCM (Emulator/Emulator_DCM.cpp)
+********************************************************************/
+int  Emulator_DCM_Fixed_Test( const char *InputPath, float MaxError );
+int  Emulator_Quaternion_Test( const char *InputPath, float MaxError );
+
+
+/*******************************************************************
+** Emulator_Trig (Emulator/Emulator_Trig.cpp)
+********************************************************************/
+void Trig_Atan2_Batch( const float *y, const float *x, float *out, int n, int tier );
+void Trig_Asin_Batch( const float *x, float *out, int n, int tier );
+int  Emulator_Trig_Test( unsigned long Stride );
+
+
+/*******************************************************************
+** Emulator_Stats (Emulator/Emulator_Stats.cpp)
+********************************************************************/
+int  Emulator_Stats_Test( unsigned long nSamples );
+
+
+/*******************************************************************
+** Emulator_Phase (Emulator/Emulator_Phase.cpp)
+********************************************************************/
+int  Emulator_Phase_Test( const char *InputPath, float Phase, const char *LabelsPath );
+
+
+/*******************************************************************
+** Emulator_MPU9250 (Emulator/Emulator_MPU9250.cpp)
+********************************************************************/
+void Emulator_MPU_Reset( void );
+void Emulator_MPU_Reset_FIFO( void );
+bool Emulator_MPU_Sample( const ACQ_SAMPLE_TYPE *p_sample );
+int  Emulator_MPU_Read( unsigned char reg, unsigned char length, unsigned char *p_data );
+bool Emulator_MPU_Read_Time( uint32_t *p_timestamp );
+unsigned long Emulator_MPU_Frames( void );
+const EMULATOR_MPU_TYPE *Emulator_MPU_State( void );
+
+
+/*******************************************************************
+** Emulator_Wire (Emulator/Emulator_Wire.cpp)
+********************************************************************/
+EMULATOR_I2C_DEVICE_TYPE *Emulator_Wire_Device( uint8_t address );
+void   Emulator_Wire_Reset( void );
+bool   Emulator_Wire_Add_Device( uint8_t address );
+bool   Emulator_Wire_Load( uint8_t address, uint8_t reg, const uint8_t *p_data, int length );
+double Emulator_Wire_Time( unsigned long nBits );
+int    Emulator_Wire_Test( const char *InputPath, double MaxBusTime );
+
+
+#endif /* End EMULATOR_PROTOS_H */
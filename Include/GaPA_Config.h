@@ -35,11 +35,79 @@
 #define GAPA_DEFAULT_Z_phi 0.5f
 #define GAPA_DEFAULT_Z_PHI 1.0f
 
+/* atan2 tier of the phase angle nu (see Math.h)
+** nu is integrated into the gait phase and the
+** gait end test, so it gets the precise tier */
+#define GAPA_ANGLE_TIER TRIG_TIER_PRECISE
+
+/* Phase portrait center (gamma, GAMMA)
+** 3POINT:      Circle through the last 3 points (calc_circle_center)
+** SLIDING:     Least squares (Kasa) circle fit over the last
+**              GAPA_CIRCLE_WINDOW points
+** EXPONENTIAL: Least squares circle fit, the points weighted
+**              by GAPA_CIRCLE_LAMBDA^age (no point history)
+** The fits keep running moment sums, so an update costs
+** the same for any window length */
+#define GAPA_CIRCLE_3POINT     0
+#define GAPA_CIRCLE_SLIDING    1
+#define GAPA_CIRCLE_EXPONENTIAL 2
+
+#define GAPA_CIRCLE_FIT GAPA_CIRCLE_SLIDING
+
+/* Sliding window (points), must be a power of 2
+** 128 points is 640 ms at 200 Hz, about a stride */
+#define GAPA_CIRCLE_WINDOW 128
+#define GAPA_CIRCLE_MASK   (GAPA_CIRCLE_WINDOW-1)
+
+/* Exponential forgetting factor, same memory as the window */
+#define GAPA_CIRCLE_LAMBDA (1.0f-1.0f/GAPA_CIRCLE_WINDOW)
+
+/* Conditioning limit of the fit
+** The fit is kept only if det(C) > GAPA_CIRCLE_MIN_DET*trace(C)^2
+** (C the point covariance), i.e. the points are not bunched
+** along a line. Otherwise the previous center is kept */
+#define GAPA_CIRCLE_MIN_DET 1e-3f
+
+/* Phase prediction (GaPA_Predict)
+** nu_predicted is nu_normalized extrapolated GAPA_PREDICT_MS
+** ahead, at the phase rate of the current stride, so the FES
+** triggers make up for the delay of the processing chain and
+** of the relays. The rate is the mean over the current stride
+** once it has covered GAPA_PREDICT_MIN_PHASE, before that the
+** mean of the last full stride, limited to GAPA_PREDICT_MAX_RATE
+** (strides/s). 0 ms predicts nothing */
+#define GAPA_PREDICT_MS        40
+#define GAPA_PREDICT_MIN_PHASE 0.1f
+#define GAPA_PREDICT_MAX_RATE  3.0f
+
 
 /*******************************************************************
 ** Tyedefs
 ********************************************************************/
 
+/*
+** TYPE: GAPA_CIRCLE_FIT_TYPE
+** Streaming circle fit of the phase portrait.
+** The moments are (weighted) sums over the window of
+** 1, x, y, xx, xy, yy and, with z=x^2+y^2, xz, yz, z.
+** In sliding mode the points are kept (x,y) to be
+** dropped when they leave the window, and the sums
+** are rebuilt once per window (bounds the rounding
+** drift of the running updates) */
+typedef struct
+{
+	float S1, Sx, Sy, Sxx, Sxy, Syy, Sxz, Syz, Sz;
+
+#if GAPA_CIRCLE_FIT==GAPA_CIRCLE_SLIDING
+	float    x[GAPA_CIRCLE_WINDOW];
+	float    y[GAPA_CIRCLE_WINDOW];
+	uint32_t n; /* Points pushed */
+#endif
+
+	float center[2]; /* Last valid center */
+} GAPA_CIRCLE_FIT_TYPE;
+
+
 /*
 ** TYPE: GAPA_STATE_TYPE
 ** This holds the state variables
@@ -71,9 +139,20 @@ typedef struct
 
 	float prev_phi[3], prev_PHI[3];
 
+	/* Phase portrait center fit (see GAPA_CIRCLE_FIT) */
+	GAPA_CIRCLE_FIT_TYPE circle;
+
 	float nu;	/* The Phase Angle */
 	float nu_prev;	/* The previous Phase Angle */
 	float nu_normalized;	/* The phase angle on the region [0,1] */
+
+	/* Phase prediction (see GaPA_Predict) */
+	float nu_predicted;       /* nu_normalized, predict_time ahead */
+	float nu_rate;            /* Phase rate used (strides/s) */
+	float nu_normalized_prev;
+	float stride_phase;       /* Phase covered in this stride */
+	float stride_time;        /* Time in this stride (s) */
+	float stride_rate;        /* Mean rate of the last full stride */
 	
 	/* Boolean to mark the end of a gait cycle */
 	bool Gait_End;
@@ -98,6 +177,8 @@ typedef struct
 
 	float min_gyro;
 	float gait_end_threshold;
+
+	float predict_time; /* Phase prediction horizon (s) */
 } GAPA_PERMS_TYPE;
 
 /*
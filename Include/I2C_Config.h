@@ -0,0 +1,67 @@
+/*******************************************************************
+** FILE:
+**   	I2C_Config.h
+** DESCRIPTION:
+** 		Header for the batched I2C transaction layer.
+** 		The register reads needed for one sample are queued in
+** 		an I2C_SET_TYPE and run back to back (I2C_Run): each
+** 		device's data block is read in one auto-increment
+** 		burst, with a repeated START between the register
+** 		address write and the read and between devices, and a
+** 		single STOP at the end of the set.
+** 		In emulation mode, Wire is a stand-in for the bus with
+** 		register files for the devices and a bus time model
+** 		(see Emulator_Wire.cpp).
+********************************************************************/
+#ifndef I2C_CONFIG_H
+#define I2C_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Bus clock (Hz)
+** Fast mode, supported by all the IMU10736 sensors
+** (the Wire default is 100 kHz) */
+#define I2C_CLOCK 400000
+
+/* Maximum number of reads in a set */
+#define I2C_MAX_READS 4
+
+/* Maximum length of a single read (bytes)
+** Enough for a 3 axis 16 bit sample. Must not exceed
+** the Wire receive buffer (32 bytes on the AVR) */
+#define I2C_MAX_LENGTH 8
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: I2C_READ_TYPE
+** One block read: length bytes from register
+** reg onwards (auto increment) */
+typedef struct
+{
+	uint8_t address;
+	uint8_t reg;
+	uint8_t length;
+	uint8_t data[I2C_MAX_LENGTH];
+} I2C_READ_TYPE;
+
+/*
+** TYPE: I2C_SET_TYPE
+** Reads run together by I2C_Run */
+typedef struct
+{
+	I2C_READ_TYPE read[I2C_MAX_READS];
+	int           nReads;
+
+	/* Failed runs (NACK or short read) */
+	uint32_t nErrors;
+} I2C_SET_TYPE;
+
+
+#endif /* End I2C_CONFIG_H */
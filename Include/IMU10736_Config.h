@@ -149,6 +149,10 @@
 /* Set the system sampling rate */
 #define TIME_SR         200.0f    /* Warning: depends on sensor values! */
 
+/* Sample acquisition (see Acquisition_Config.h)
+** No data ready interrupt is wired, the sensors are polled */
+#define ACQ_MODE ACQ_MODE_POLL
+
 /* Resolution of system time
 ** Used to set delta T - see Update_Time */
 //#define TIME_RESOLUTION 1000.0f
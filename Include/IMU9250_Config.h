@@ -134,6 +134,16 @@
 #define MPU9250_INT_PIN 4
 #define MPU9250_INT_ACTIVE LOW
 
+/* Sample acquisition (see Acquisition_Config.h)
+** The sensors are polled by default. ACQ_MODE_INTERRUPT and
+** ACQ_MODE_FIFO queue the samples in the IMU FIFO for loop() to
+** burst read (ACQ_MODE_INTERRUPT dates them by the data ready
+** interrupt); loop() must then come back within the FIFO depth
+** (see ACQ_FIFO_BURST_FRAMES) */
+#define ACQ_MODE ACQ_MODE_POLL
+//#define ACQ_MODE ACQ_MODE_INTERRUPT
+//#define ACQ_MODE ACQ_MODE_FIFO
+
 
 /* Communication Parameters
 *******************************************************************/
@@ -165,6 +175,11 @@
 	#define COMM_WRITE COMM_PORT.write
 	#define COMM_AVAILABLE COMM_PORT.available()
 	#define COMM_READ COMM_PORT.read()
+
+	/* FIFO register access (ACQ_MODE_FIFO)
+	** Returns 0 on success */
+	#define ACQ_FIFO_READ(reg,len,p_data) arduino_i2c_read( IMU_I2C_ADDR, reg, len, p_data )
+	#define ACQ_FIFO_RESET()              imu.resetFifo()
 #endif
 
 /* Sampling resolution
@@ -195,6 +210,16 @@
 #define IMU_AG_LPF         5 // Accel/Gyro LPF corner frequency (5, 10, 20, 42, 98, or 188 Hz)
 
 
+/* FIFO I2C addresses (Register Map)
+******************************************************************/
+#define IMU_I2C_ADDR        0x68
+#define IMU_INT_STATUS      0x3A
+#define IMU_INT_FIFO_OFLOW  0x10 // INT_STATUS FIFO overflow bit
+#define IMU_FIFO_COUNTH     0x72 // FIFO count, high byte first
+#define IMU_FIFO_R_W        0x74
+#define IMU_FIFO_SIZE       512  // bytes
+
+
 /* Magnetometer I2C addresses (Register Map)
 ******************************************************************/
 
@@ -48,5 +48,92 @@
 #define MAX( a, b ) ( ( (a) > (b) ) ? (a) : (b) )
 #define MIN( a, b ) ( ( (a) < (b) ) ? (a) : (b) )
 
+/* Fixed point
+** Qn: int32_t with n fraction bits (Q30: +-2) */
+
+/* Angles (q_atan2, q_asin): radians in Q29 (+-4) */
+#define Q_ANGLE_SHIFT 29
+#define Q_PI          1686629713L /* pi in Q29 */
+
+/* CORDIC iterations (q_atan2), one bit each */
+#define Q_CORDIC_ITER 30
+
+/* Float to Qn (constants and init) and Qn to float */
+#define Q_FROM_FLOAT(x,n) ( (int32_t)lrintf( (x)*(float)(1L<<(n)) ) )
+#define Q_TO_FLOAT(x,n)   ( (float)(x)*( 1.0f/(float)(1L<<(n)) ) )
+
+/* Saturate a 64 bit value to 32 bits */
+#define Q_SAT32(x) ( ( (x)>INT32_MAX ) ? INT32_MAX : ( ( (x)<INT32_MIN ) ? INT32_MIN : (int32_t)(x) ) )
+
+/* a*b with n fraction bits dropped (rounded)
+** Qa * Qb -> Q(a+b-n) */
+#define Q_MUL(a,b,n) ( (int32_t)( ( (int64_t)(a)*(b) + ((int64_t)1<<((n)-1)) ) >> (n) ) )
+
+/* Trig tiers (f_sincos, f_rsqrt, f_sqrt)
+** 0: libm (sinf, cosf, sqrtf)
+** 1: Precise polynomials
+** 2: Fast polynomials */
+#define TRIG_TIER_LIBM    0
+#define TRIG_TIER_PRECISE 1
+#define TRIG_TIER_FAST    2
+#define NUM_TRIG_TIERS    3
+
+/* Max error bound of each tier, checked over every
+** float input by WISE_Emulator -t 1
+** sin/cos: absolute, |x|<=4pi
+** rsqrt/sqrt: relative, all positive normals
+** Measured:  sin      cos      rsqrt    sqrt
+**   libm     3.3e-8   3.3e-8   8.9e-8   6.0e-8
+**   precise  8.7e-8   9.3e-8   8.0e-7   8.4e-7
+**   fast     1.24e-5  1.24e-5  6.5e-4   6.5e-4
+** (the fast sin error is its cosine polynomial,
+** used past pi/4) */
+#define TRIG_LIBM_SIN_ERROR      4.0e-8
+#define TRIG_LIBM_COS_ERROR      4.0e-8
+#define TRIG_LIBM_RSQRT_ERROR    1.0e-7
+#define TRIG_PRECISE_SIN_ERROR   1.0e-7
+#define TRIG_PRECISE_COS_ERROR   1.0e-7
+#define TRIG_PRECISE_RSQRT_ERROR 1.0e-6
+#define TRIG_FAST_SIN_ERROR      1.5e-5
+#define TRIG_FAST_COS_ERROR      1.5e-5
+#define TRIG_FAST_RSQRT_ERROR    7.0e-4
+
+/* Tier used by the per-sample callers (DCM, WISE) */
+#define TRIG_TIER TRIG_TIER_PRECISE
+
+/* pi/2 split for the range reduction (Cody-Waite),
+** the first two parts have short mantissas so that
+** k*part is exact for |k|<2^11 (|x|<~3200 rad) */
+#define TRIG_PIO2_1 1.5703125f
+#define TRIG_PIO2_2 4.837512969970703125e-4f
+#define TRIG_PIO2_3 7.54978995489188216e-8f
+#define TRIG_2OPI   0.636619772367581343f
+
+/* Angle tiers (f_atan2, f_asin), picked per caller
+** with the tier constants above (DCM_ANGLE_TIER,
+** GAPA_ANGLE_TIER). The fixed point versions (q_atan2,
+** q_asin, Q30 in) are used by DCM_Filter_Fixed.
+** Max error bound (rad, absolute), checked over every
+** float input by WISE_Emulator -t 1
+** Measured:  atan2    asin     host ns/call (-t)
+**   libm     2.3e-7   9.1e-8   24.4   6.4
+**   precise  2.9e-7   3.0e-7    6.1   4.3
+**   fast     3.7e-6   6.8e-5    4.6   3.2
+**   fixed    7.1e-8   2.8e-8    226   416
+** (float errors near +-pi include the float rounding
+** of the result, 1.2e-7) */
+#define TRIG_LIBM_ATAN2_ERROR    2.5e-7
+#define TRIG_LIBM_ASIN_ERROR     1.0e-7
+#define TRIG_PRECISE_ATAN2_ERROR 3.5e-7
+#define TRIG_PRECISE_ASIN_ERROR  3.5e-7
+#define TRIG_FAST_ATAN2_ERROR    4.0e-6
+#define TRIG_FAST_ASIN_ERROR     7.0e-5
+#define TRIG_FIXED_ATAN2_ERROR   1.0e-7
+#define TRIG_FIXED_ASIN_ERROR    5.0e-8
+
+/* atan2 and asin at a compile time tier */
+#define F_ATAN2(tier,y,x) ( ( (tier)==TRIG_TIER_LIBM ) ? atan2f( (y), (x) ) : ( ( (tier)==TRIG_TIER_PRECISE ) ? f_atan2_precise( (y), (x) ) : f_atan2( (y), (x) ) ) )
+#define F_ASIN(tier,x)    ( ( (tier)==TRIG_TIER_LIBM ) ? asinf( (x) ) : ( ( (tier)==TRIG_TIER_PRECISE ) ? f_asin_precise( (x) ) : f_asin( (x) ) ) )
+
 
 #endif /* End MATH_H */
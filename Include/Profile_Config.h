@@ -0,0 +1,117 @@
+/*******************************************************************
+** FILE:
+**   	Profile_Config.h
+** DESCRIPTION:
+** 		Header for the on-device profiler.
+** 		The profiler times each stage of loop() into fixed
+** 		bucket histograms and tracks loop overruns, the
+** 		min/max sample period and the time spent waiting in
+** 		Update_Time. The results are read by the master over
+** 		the comm port (see f_RespondToInput, request 0xC1).
+** 		Set PROFILE_ON to 0 to compile the profiler out.
+********************************************************************/
+#ifndef PROFILE_CONFIG_H
+#define PROFILE_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Compile the profiler in (1) or out (0)
+** Off by default in the emulator, which times the
+** stages with the benchmark instead (WISE_Emulator -b).
+** Build with -DPROFILE_ON=1 to run it on the host */
+#ifndef PROFILE_ON
+	#if EXE_MODE==1
+		#define PROFILE_ON 0
+	#else
+		#define PROFILE_ON 1
+	#endif
+#endif
+
+/* Profiled stages
+** Index into PROFILE_STATE_TYPE::hist/max */
+#define PROFILE_READ_SENSORS 0
+#define PROFILE_CALIBRATE    1
+#define PROFILE_DSP          2
+#define PROFILE_DCM          3
+#define PROFILE_GAPA         4
+#define PROFILE_WISE         5
+#define PROFILE_COMM         6 /* f_RespondToInput */
+#define PROFILE_LOG          7 /* Debug_LogOut */
+#define PROFILE_LOOP         8 /* Whole loop, less the Update_Time wait */
+#define PROFILE_N_STAGES     9
+
+/* Histogram buckets
+** Bucket 0 holds 0-1 us, bucket k holds [2^k, 2^(k+1)) us,
+** the last bucket holds everything above */
+#define PROFILE_N_BUCKETS 16
+
+/* Loop budget (us)
+** A loop taking longer than this is counted as an overrun.
+** TIME_SR does not give the sample rate (the pacing in
+** Update_Time is effectively off on the 9250), so the
+** budget is set here: 5000 us is 200 Hz */
+#define PROFILE_BUDGET 5000
+
+/* Time source (us) */
+#if EXE_MODE==1 /* Emulator Mode */
+	#define PROFILE_TIME Emulator_Micros()
+#else
+	#define PROFILE_TIME micros()
+#endif
+
+/* Instrumentation
+** PROFILE_MARK restarts the stage timer, PROFILE_LAP
+** records the time since the last mark/lap to a stage */
+#if PROFILE_ON==1
+	#define PROFILE_LOOP_BEGIN(p_control)       Profile_Loop_Begin( p_control )
+	#define PROFILE_LOOP_END(p_control)         Profile_Loop_End( p_control )
+	#define PROFILE_MARK(p_control)             { (p_control)->profile.mark = PROFILE_TIME; }
+	#define PROFILE_LAP(p_control,stage)        Profile_Lap( p_control, stage )
+	#define PROFILE_UPDATE_TIME(p_control,idle) Profile_Update_Time( p_control, idle )
+#else
+	#define PROFILE_LOOP_BEGIN(p_control)       {}
+	#define PROFILE_LOOP_END(p_control)         {}
+	#define PROFILE_MARK(p_control)             {}
+	#define PROFILE_LAP(p_control,stage)        {}
+	#define PROFILE_UPDATE_TIME(p_control,idle) { (void)(idle); }
+#endif
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: PROFILE_STATE_TYPE
+** Profiler counters, all times in us.
+** Counted since Profile_Reset */
+typedef struct
+{
+	/* Per stage latency histograms and maxima */
+	uint32_t hist[PROFILE_N_STAGES][PROFILE_N_BUCKETS];
+	uint32_t max[PROFILE_N_STAGES];
+
+	/* Loops, and loops over budget */
+	uint32_t nLoops;
+	uint32_t nOverruns;
+	uint32_t budget;
+
+	/* Sample period (timestamp - timestamp_old) */
+	uint32_t Dt_min;
+	uint32_t Dt_max;
+
+	/* Time spent waiting in Update_Time */
+	uint32_t idle;
+	uint32_t loop_idle; /* Current loop */
+
+	/* Timers */
+	unsigned long reset_time;
+	unsigned long loop_start;
+	unsigned long mark;
+} PROFILE_STATE_TYPE;
+
+
+#endif /* End PROFILE_CONFIG_H */
@@ -0,0 +1,76 @@
+/*******************************************************************
+** FILE:
+**   	Recording_Config.h
+** DESCRIPTION:
+** 		Header for the binary recording format.
+** 		A recording is a fixed size header followed by a
+** 		packed array of fixed size sample records. The layout
+** 		is fixed so that a recording can be memory mapped and
+** 		stepped through directly (no per-sample parsing).
+** 		All fields are little-endian (native on both the
+** 		SAMD21 and x86/ARM hosts).
+********************************************************************/
+#ifndef RECORDING_CONFIG_H
+#define RECORDING_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* File identifier ("WREC" read as a little-endian uint32) */
+#define RECORDING_MAGIC   0x43455257
+
+/* Format version
+** Increment whenever the header or record layout changes */
+#define RECORDING_VERSION 1
+
+/* Number of foot sensor channels stored in each record */
+#define RECORDING_N_FOOT  4
+
+/* Header flags */
+#define RECORDING_FLAG_FOOT 0x0001 /* Foot sensor channels are valid */
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: RECORDING_HEADER_TYPE
+** Recording file header (64 bytes)
+** Stores the sensor settings needed to replay
+** the raw data */
+typedef struct
+{
+	uint32_t magic;          /* RECORDING_MAGIC */
+	uint16_t version;        /* RECORDING_VERSION */
+	uint16_t header_nBytes;  /* sizeof(RECORDING_HEADER_TYPE) */
+	uint16_t record_nBytes;  /* sizeof(RECORDING_SAMPLE_TYPE) */
+	uint16_t flags;          /* RECORDING_FLAG_* */
+	float    gravity;        /* "1G reference" in raw accel units (GRAVITY) */
+	float    sample_rate;    /* Nominal sample rate (Hz) */
+	uint16_t accel_fsr;      /* Accel full-scale range (g) */
+	uint16_t gyro_fsr;       /* Gyro full-scale range (deg/s) */
+	uint64_t nRecords;       /* Number of records following the header */
+	uint8_t  reserved[32];
+} RECORDING_HEADER_TYPE;
+
+/*
+** TYPE: RECORDING_SAMPLE_TYPE
+** A single raw sample (24 bytes)
+** The timestamp is the 32 bit micros() value and
+** will wrap every ~71 minutes, the reader must unwrap it */
+typedef struct
+{
+	uint32_t timestamp;              /* us */
+	int16_t  accel[3];               /* Raw accel x/y/z */
+	int16_t  gyro[3];                /* Raw gyro x/y/z */
+	int16_t  foot[RECORDING_N_FOOT]; /* Raw foot sensor ADC values */
+} RECORDING_SAMPLE_TYPE;
+
+static_assert( sizeof(RECORDING_HEADER_TYPE)==64, "Recording header layout changed" );
+static_assert( sizeof(RECORDING_SAMPLE_TYPE)==24, "Recording sample layout changed" );
+
+
+#endif /* End RECORDING_CONFIG_H */
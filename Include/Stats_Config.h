@@ -0,0 +1,78 @@
+/*******************************************************************
+** FILE:
+**   	Stats_Config.h
+** DESCRIPTION:
+** 		Header for the sliding window motion statistics.
+** 		The gyro and accel magnitudes are kept over the last
+** 		STATS_WINDOW samples. The mean and sum of squares come
+** 		from running sums (one add and one subtract per sample)
+** 		and the min/max from monotonic deques (amortized O(1)),
+** 		so no stage rescans the window. The results fill the
+** 		stats of SENSOR_STATE_TYPE (gyro_mAve is the motion
+** 		gate of GaPA and WISE, see gapa_prms.min_gyro).
+** 		NOTE: Only gyro_mAve is needed by the gate, the rest
+** 		is for logging. The full update (two f_sqrt, four
+** 		deques and two variance divides per sample) costs
+** 		about as much as DCM_Filter (see WISE_Emulator -b),
+** 		and the rebuild of the sums once per window sets
+** 		its p99 (about 3x the mean). Set STATS_ON to 0 if
+** 		the gate is not used.
+********************************************************************/
+#ifndef STATS_CONFIG_H
+#define STATS_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Compute the stats (1), or leave them at 0 (0)
+** With 0 the motion gate always reads "no motion" */
+#define STATS_ON 1
+
+/* Window length (samples), must be a power of 2
+** 64 samples is 320 ms at 200 Hz, about half a stride */
+#define STATS_WINDOW 64
+#define STATS_MASK   (STATS_WINDOW-1)
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: STATS_WINDOW_TYPE
+** Sliding window of one signal.
+** Sample n is in x[n&STATS_MASK]. The sums are of
+** x-ref, with ref near the mean so the sum of squares
+** does not lose the variance to cancellation. They
+** are rebuilt from x once per window, which bounds
+** the rounding drift of the running updates.
+** The deques hold sample numbers, oldest first, with
+** increasing (min) or decreasing (max) values: the
+** head is the window min/max */
+typedef struct
+{
+	float    x[STATS_WINDOW];
+	float    ref;
+	float    sum;   /* sum of x-ref */
+	float    sumsq; /* sum of (x-ref)^2 */
+
+	uint32_t min_q[STATS_WINDOW];
+	uint32_t min_head, min_tail;
+	uint32_t max_q[STATS_WINDOW];
+	uint32_t max_head, max_tail;
+} STATS_WINDOW_TYPE;
+
+/*
+** TYPE: STATS_STATE_TYPE
+** Motion statistics state */
+typedef struct
+{
+	uint32_t          n; /* Samples pushed */
+	STATS_WINDOW_TYPE gyro;
+	STATS_WINDOW_TYPE accel;
+} STATS_STATE_TYPE;
+
+
+#endif /* End STATS_CONFIG_H */
@@ -0,0 +1,146 @@
+/*******************************************************************
+** FILE:
+**   	Sweep_Config.h
+** DESCRIPTION:
+** 		Header for the emulator parameter sweep.
+** 		The sweep replays one recording through many gain
+** 		configurations at once. The DCM, GaPA and WISE states of
+** 		all configurations are held structure-of-arrays (one array
+** 		per state variable, one element "lane" per configuration)
+** 		so that each update is a loop over lanes which the
+** 		compiler can vectorize.
+** 		This file should only be included when EXE_MODE==1.
+********************************************************************/
+#ifndef SWEEP_CONFIG_H
+#define SWEEP_CONFIG_H
+
+
+/*******************************************************************
+** Defines
+********************************************************************/
+
+/* Swept parameters
+** Index into SWEEP_STATE_TYPE::prm (see Sweep_Prm_Names) */
+#define SWEEP_DCM_KP_ROLLPITCH  0 /* dcm_prms.Kp_RollPitch */
+#define SWEEP_DCM_KI_ROLLPITCH  1 /* dcm_prms.Ki_RollPitch */
+#define SWEEP_GAPA_KP_phi       2 /* gapa_prms.Kp_phi */
+#define SWEEP_GAPA_KI_phi       3 /* gapa_prms.Ki_phi */
+#define SWEEP_GAPA_KP_PHI       4 /* gapa_prms.Kp_PHI */
+#define SWEEP_GAPA_KI_PHI       5 /* gapa_prms.Ki_PHI */
+#define SWEEP_GAPA_phimw_ALPHA  6 /* gapa_prms.phimw_alpha */
+#define SWEEP_GAPA_PHImw_ALPHA  7 /* gapa_prms.PHImw_alpha */
+#define SWEEP_WISE_CORRECTION   8 /* wise_prms.correction */
+#define SWEEP_WISE_MINCOUNT     9 /* wise_prms.mini_count */
+#define SWEEP_N_PRMS           10
+
+/* Maximum number of values per parameter in the grid file */
+#define SWEEP_MAX_VALUES 64
+
+/* Maximum number of configurations (product of the grid) */
+#define SWEEP_MAX_CONFIGS 1000000
+
+/* Lanes are padded to a multiple of this (floats)
+** so every lane loop runs on whole vectors */
+#define SWEEP_LANE_ALIGN 16
+
+/* Maximum number of lane arrays (see Sweep_Alloc) */
+#define SWEEP_MAX_ARRAYS 128
+
+
+/*******************************************************************
+** Typedefs
+********************************************************************/
+
+/*
+** TYPE: SWEEP_GRID_TYPE
+** The values taken by each parameter.
+** The sweep runs every combination (Cartesian product).
+** Parameters not listed in the grid file keep their
+** default value (nValues==1) */
+typedef struct
+{
+	int   nValues[SWEEP_N_PRMS];
+	float value[SWEEP_N_PRMS][SWEEP_MAX_VALUES];
+} SWEEP_GRID_TYPE;
+
+/*
+** TYPE: SWEEP_LABELS_TYPE
+** Reference labels for scoring, read from a text file:
+** 	timestamp,speed,incline[,phase]
+** speed/incline are in the units of vel_ave[0]/Incline_ave,
+** phase is the normalized gait phase [0,1). A label holds
+** until the next label's timestamp; empty fields are not scored */
+typedef struct
+{
+	unsigned long  nLabels;
+	unsigned long *timestamp;
+	float         *speed;
+	float         *incline;
+	float         *phase;
+} SWEEP_LABELS_TYPE;
+
+/*
+** TYPE: SWEEP_STATE_TYPE
+** Structure-of-arrays state for all configurations.
+** Each pointer is an array of nLanes elements. Only the state
+** which feeds the scored outputs (pitch, nu_normalized,
+** vel_ave[0], Incline_ave) is held. The algorithms are the
+** same as DCM_Filter, GaPA_Update and WISE_Update, evaluated
+** in the same order so lane results match the scalar code */
+typedef struct
+{
+	int nConfigs;
+	int nLanes;
+
+	/* Parameter values per lane */
+	float *prm[SWEEP_N_PRMS];
+
+	/* DCM */
+	float *Omega_P[3];
+	float *Omega_I[3];
+	float *DCM_Matrix[3][3];
+	float *pitch;
+
+	/* GaPA */
+	float *phi, *PHI;
+	float *phi_max, *PHI_max;
+	float *z_phi, *z_PHI;
+	float *PErr_phi, *IErr_phi;
+	float *PErr_PHI, *IErr_PHI;
+	float *phi_mw, *PHI_mw;
+	float *phin, *PHIn;
+	float *prev_phi[2], *prev_PHI[2];
+	float *gamma, *GAMMA;
+	GAPA_CIRCLE_FIT_TYPE *circle; /* Per lane, zeroed is empty */
+	float *nu, *nu_prev, *nu_normalized;
+	int    gapa_iteration; /* Same for all lanes */
+
+	/* WISE */
+	float *accel[2];
+	float *vel[2];
+	float *vel_ave[2];
+	float *rot;
+	float *dist[2];
+	float *Incline_ave;
+	float *Nsamples;
+	float *Ncycles;
+	float *CrossingP;
+	float *fit_n, *fit_t, *fit_tt, *fit_v[2], *fit_tv[2];  /* WISE_FIT_TYPE */
+	unsigned long *fit_Time0;
+	float *GaitEnd_fit_n, *GaitEnd_fit_t, *GaitEnd_fit_tt, *GaitEnd_fit_v[2], *GaitEnd_fit_tv[2];
+	float *GaitEnd_Nsamples;
+
+	/* Scoring (sum of squared errors) */
+	double        *speed_sse;
+	double        *incline_sse;
+	double        *phase_sse;
+	unsigned long  nSpeed, nIncline, nPhase;
+	unsigned long  LabelIndex;
+
+	/* Allocated arrays (see Sweep_Alloc) */
+	void *p_alloc[SWEEP_MAX_ARRAYS];
+	int   nAlloc;
+} SWEEP_STATE_TYPE;
+
+
+#endif /* End SWEEP_CONFIG_H */
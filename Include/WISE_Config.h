@@ -29,11 +29,48 @@
 
 #define WISE_MINCOUNT 50
 
+/* Drift fit (see WISE_Drift_Fit)
+** Below this fraction of n*Stt, the denominator of the
+** slope is rounding noise (all the samples at about the
+** same t): no drift is removed, vel_ave is the plain mean */
+#define WISE_FIT_MIN_DEN 1.0e-4f
+
+/* Stride history (see WISE_STRIDE_TYPE)
+** Length of the ring, must be a power of 2, and the
+** number of strides sent per request (0xA3, one packet) */
+#define WISE_STRIDE_RING   16
+#define WISE_STRIDE_MASK   (WISE_STRIDE_RING-1)
+#define WISE_STRIDE_PACKET 4
+
 /*******************************************************************
 ** Typedefs
 ********************************************************************/
 
 
+/*
+** TYPE: WISE_FIT_TYPE
+** Sums of the least-squares line fit of the velocity
+** over the samples of an integration segment (since
+** the last reset, where the velocity is 0).
+** t is the time since the first sample (s), from the
+** sample timestamps: relative to Time0 so t*t keeps its
+** precision in float, and jitter in the sample times
+** (interrupt or FIFO acquisition) does not bias the fit.
+** The velocity drift (per second) is the slope:
+** 	drift = ( n*Stv - St*Sv )/( n*Stt - St*St )
+*/
+typedef struct
+{
+	float n;
+	float t;     /* Sum of t */
+	float tt;    /* Sum of t^2 */
+	float v[2];  /* Sum of vel */
+	float tv[2]; /* Sum of t*vel */
+
+	unsigned long Time0; /* Timestamp of the first sample */
+} WISE_FIT_TYPE;
+
+
 /*
 ** TYPE: WISE_GATE_TYPE
 ** This holds the state variables
@@ -46,9 +83,29 @@ typedef struct
 	float drift[3];
 	long int Time;
 	float Nsamples;
+	WISE_FIT_TYPE fit;
 } WISE_GATE_TYPE;
 
 
+/*
+** TYPE: WISE_STRIDE_TYPE
+** Summary of one completed stride (toe-off to toe-off),
+** recorded by WISE_Update. The strides are kept in
+** a ring so the master can poll the history instead of
+** the per sample values
+*/
+typedef struct
+{
+	unsigned long StartTime;  /* Timestamp of the first sample (after toe-off) */
+	unsigned long EndTime;    /* Timestamp of the last sample (rotational maximum) */
+	float Nsamples;           /* Samples from StartTime to EndTime */
+	float vel_ave[2];         /* Drift corrected mean velocity */
+	float Incline_gait;       /* Incline at the end of the stride */
+	float drift[2];           /* Velocity drift per second */
+	float cycle_time;         /* GaPA stride period (s), 0 if unknown */
+} WISE_STRIDE_TYPE;
+
+
 /*
 ** TYPE: WISE_STATE_TYPE
 ** This holds all the state variables
@@ -58,6 +115,7 @@ typedef struct
 {
   bool swing_state; // 0:down 1:up
   bool toe_off;
+  bool stride_end; /* Toe-off with a drift fit, record the stride */
   int minCount;
 
 	WISE_GATE_TYPE GaitStart;
@@ -91,6 +149,9 @@ typedef struct
   float omega_vd[3];
   float omega_vp[3];
 
+  /* Velocity line fit of the current segment */
+  WISE_FIT_TYPE fit;
+
 
   /* [r_x, r_y, r_Z]
   ** Integral of gyro data
@@ -114,6 +175,14 @@ typedef struct
 	float Time;
   float Nsamples;
   float Ncycles;
+
+  /* Stride history
+  ** Stride n is in strides[n&WISE_STRIDE_MASK]
+  ** gapa_cycle_time is the GaPA stride period,
+  ** set before each update (see Pipeline_Update) */
+  WISE_STRIDE_TYPE strides[WISE_STRIDE_RING];
+  uint32_t nStrides;
+  float gapa_cycle_time;
 } WISE_STATE_TYPE;
 
 
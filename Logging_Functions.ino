@@ -65,11 +65,11 @@ void Debug_LogOut( CONTROL_TYPE				*p_control,
       FltToStr((1/p_control->G_Dt),4,LogBuffer);  LOG_PRINT( LogBuffer );
 
       sprintf(LogBuffer,", R:");LOG_PRINT( LogBuffer );
-      FltToStr(TO_DEG(p_sensor_state->roll),4,LogBuffer);  LOG_PRINT( LogBuffer );
+      FltToStr(TO_DEG(Orientation_Roll( p_control, p_sensor_state )),4,LogBuffer);  LOG_PRINT( LogBuffer );
       sprintf(LogBuffer,", P:");LOG_PRINT( LogBuffer );
       FltToStr(TO_DEG(p_sensor_state->pitch),4,LogBuffer); LOG_PRINT( LogBuffer );
       sprintf(LogBuffer,", Y:");LOG_PRINT( LogBuffer );
-      FltToStr(TO_DEG(p_sensor_state->yaw),4,LogBuffer);   LOG_PRINT( LogBuffer );
+      FltToStr(TO_DEG(Orientation_Yaw( p_control, p_sensor_state )),4,LogBuffer);   LOG_PRINT( LogBuffer );
       
       //sprintf(LogBuffer,", A:%06d,%06d,%06d",
       //  (int)p_sensor_state->accel[0], (int)p_sensor_state->accel[1], (int)p_sensor_state->accel[2] );
@@ -96,13 +96,13 @@ void Debug_LogOut( CONTROL_TYPE				*p_control,
       LOG_PRINT( LogBuffer );
 
       LOG_PRINT(",");
-      FltToStr(TO_DEG(p_sensor_state->roll),3,LogBuffer);
+      FltToStr(TO_DEG(Orientation_Roll( p_control, p_sensor_state )),3,LogBuffer);
       LOG_PRINT( LogBuffer );
       LOG_PRINT(",");
       FltToStr(TO_DEG(p_sensor_state->pitch),3,LogBuffer);
       LOG_PRINT( LogBuffer );
       LOG_PRINT(",");
-      FltToStr(TO_DEG(p_sensor_state->yaw),3,LogBuffer);
+      FltToStr(TO_DEG(Orientation_Yaw( p_control, p_sensor_state )),3,LogBuffer);
       LOG_PRINT( LogBuffer );
 
       LOG_PRINTLN(" ");
@@ -24,6 +24,23 @@
 	#include "../Include/Emulator_Protos.h"
 #endif  /* End Emulator Mode */
 
+/*******************************************************************
+** Globals *********************************************************
+********************************************************************/
+
+/* CORDIC angles (q_atan2)
+** atan(2^-i) in Q29 */
+const int32_t q_atan_table[Q_CORDIC_ITER] =
+{
+	421657428, 248918915, 131521918, 66762579, 33510843,
+	16771758,  8387925,   4194219,   2097141,  1048575,
+	524288,    262144,    131072,    65536,    32768,
+	16384,     8192,      4096,      2048,     1024,
+	512,       256,       128,       64,       32,
+	16,        8,         4,         2,        1
+};
+
+
 /*******************************************************************
 ** Functions *******************************************************
 ********************************************************************/
@@ -274,24 +291,56 @@ float Rolling_Population_Variance( const int N, const float M2 )
 ** RETURN:
 **		float return
 ** DESCRIPTION:
-** 		A faster arcsin
+** 		A faster arcsin (fast tier)
+** 		asin(x) = pi/2 - (1-x)^0.5*p(x), p of degree 3
+** 		(Abramowitz & Stegun 4.4.45), all in float.
+** 		|x| is clamped to 1.
 */
 float f_asin( float x )
 {
   float negate = (float)(x < 0);
-  float ret = -0.0187293;
-  x = fabs(x);
+  float ret = -0.0187293f;
+  x = MIN( fabsf(x), 1.0f );
   ret *= x;
-  ret += 0.0742610;
+  ret += 0.0742610f;
   ret *= x;
-  ret -= 0.2121144;
+  ret -= 0.2121144f;
   ret *= x;
-  ret += 1.5707288;
-  ret = 3.14159265358979*0.5 - sqrt(1.0 - x)*ret;
-  return ret - 2 * negate * ret;
+  ret += 1.5707288f;
+  ret = 1.57079632679f - sqrtf(1.0f - x)*ret;
+  return ret - 2.0f * negate * ret;
 } /* End f_asin */
 
 
+/*************************************************
+** FUNCTION: f_asin_precise
+** VARIABLES:
+**		[I ]	const float x
+** RETURN:
+**		float return
+** DESCRIPTION:
+** 		Arcsin (precise tier), as f_asin with
+** 		p of degree 7 (Abramowitz & Stegun 4.4.46)
+*/
+float f_asin_precise( float x )
+{
+  float negate = (float)(x < 0);
+  float ret;
+
+  x   = MIN( fabsf(x), 1.0f );
+  ret = -0.0012624911f;
+  ret = ret*x + 0.0066700901f;
+  ret = ret*x - 0.0170881256f;
+  ret = ret*x + 0.0308918810f;
+  ret = ret*x - 0.0501743046f;
+  ret = ret*x + 0.0889789874f;
+  ret = ret*x - 0.2145988016f;
+  ret = ret*x + 1.5707963050f;
+  ret = 1.57079632679f - sqrtf(1.0f - x)*ret;
+  return ret - 2.0f * negate * ret;
+} /* End f_asin_precise */
+
+
 /*************************************************
 ** FUNCTION: f_atan2
 ** VARIABLES:
@@ -300,35 +349,390 @@ float f_asin( float x )
 ** RETURN:
 **		float return
 ** DESCRIPTION:
-** 		A faster arctan2
+** 		A faster arctan2 (fast tier)
+** 		atan(t), t=min/max of |x|,|y| in [0,1], is an
+** 		odd polynomial of degree 11, then the octant is
+** 		restored. All in float, no libm calls.
+** 		atan2(0,0) is 0.
 */
 float f_atan2( float y, float x )
 {
   float t0, t1, t3, t4;
 
-  t3 = fabs(x);
-  t1 = fabs(y);
-  t0 = fmax(t3, t1);
-  t1 = fmin(t3, t1);
-  t3 = (1.0/t0);
+  t3 = fabsf(x);
+  t1 = fabsf(y);
+  t0 = MAX(t3, t1);
+  t1 = MIN(t3, t1);
+  t3 = ( t0>0.0f ) ? (1.0f/t0) : 0.0f;
   t3 = t1 * t3;
 
   t4 = t3 * t3;
-  t0 = (-0.013480470);
-  t0 = t0 * t4 + (0.057477314);
-  t0 = t0 * t4 - (0.121239071);
-  t0 = t0 * t4 + (0.195635925);
-  t0 = t0 * t4 - (0.332994597);
-  t0 = t0 * t4 + (0.999995630);
+  t0 = (-0.013480470f);
+  t0 = t0 * t4 + (0.057477314f);
+  t0 = t0 * t4 - (0.121239071f);
+  t0 = t0 * t4 + (0.195635925f);
+  t0 = t0 * t4 - (0.332994597f);
+  t0 = t0 * t4 + (0.999995630f);
   t3 = t0 * t3;
 
-  t3 = (fabs(y) > fabs(x)) ? (1.570796327) - t3 : t3;
-  t3 = (x < 0) ?  (3.141592654) - t3 : t3;
+  t3 = (fabsf(y) > fabsf(x)) ? (1.570796327f) - t3 : t3;
+  t3 = (x < 0) ?  (3.141592654f) - t3 : t3;
   t3 = (y < 0) ? -t3 : t3;
 
   return t3;
 } /* End f_atan2 */
 
+
+/*************************************************
+** FUNCTION: f_atan2_precise
+** VARIABLES:
+**		[I ]	const float x
+**		[I ]	const float y
+** RETURN:
+**		float return
+** DESCRIPTION:
+** 		Arctan2 (precise tier)
+** 		As f_atan2, with t above tan(pi/8) reduced by
+** 		atan(t) = pi/4 + atan((t-1)/(t+1)) and a degree
+** 		9 polynomial on [0,tan(pi/8)] (Cephes atanf).
+*/
+float f_atan2_precise( float y, float x )
+{
+  float ax, ay, hi, t, z, base;
+
+  ax = fabsf(x);
+  ay = fabsf(y);
+  hi = MAX(ax, ay);
+  t  = ( hi>0.0f ) ? MIN(ax, ay)/hi : 0.0f;
+
+  base = ( t>0.414213562f ) ? 0.785398163f : 0.0f;
+  t    = ( t>0.414213562f ) ? (t-1.0f)/(t+1.0f) : t;
+
+  z = t * t;
+  t = base + ((( 8.05374449538e-2f*z - 1.38776856032e-1f)*z + 1.99777106478e-1f)*z - 3.33329491539e-1f)*z*t + t;
+
+  t = (ay > ax) ? (1.570796327f) - t : t;
+  t = (x < 0) ?  (3.141592654f) - t : t;
+  t = (y < 0) ? -t : t;
+
+  return t;
+} /* End f_atan2_precise */
+
+
+/*************************************************
+** FUNCTION: f_sincos_quadrant
+** VARIABLES:
+**		[I ]	int		q			: Quadrant (any integer)
+**		[I ]	float	s			: sin(r)
+**		[I ]	float	c			: cos(r)
+**		[O ]	float	*p_sin
+**		[O ]	float	*p_cos
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		sin and cos of q*pi/2 + r
+*/
+void f_sincos_quadrant( int q, float s, float c, float *p_sin, float *p_cos )
+{
+	switch( q & 3 )
+	{
+		case 0:  *p_sin =  s; *p_cos =  c; break;
+		case 1:  *p_sin =  c; *p_cos = -s; break;
+		case 2:  *p_sin = -s; *p_cos = -c; break;
+		default: *p_sin = -c; *p_cos =  s; break;
+	}
+} /* End f_sincos_quadrant */
+
+
+/*************************************************
+** FUNCTION: f_sincos_precise
+** VARIABLES:
+**		[I ]	float	x			: Angle (rad)
+**		[O ]	float	*p_sin
+**		[O ]	float	*p_cos
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Sine and cosine from one range reduction.
+** 		x = k*pi/2 + r, |r|<=pi/4 (Cody-Waite, so r
+** 		keeps its precision for large k), then the
+** 		degree 7 sine and degree 8 cosine polynomials
+** 		of r (Cephes coefficients), swapped and signed
+** 		by the quadrant k mod 4.
+*/
+void f_sincos_precise( float x, float *p_sin, float *p_cos )
+{
+	float k, r, r2, s, c;
+	int   q;
+
+	k  = rintf( x*TRIG_2OPI );
+	q  = (int)k;
+	r  = ( ( x - k*TRIG_PIO2_1 ) - k*TRIG_PIO2_2 ) - k*TRIG_PIO2_3;
+	r2 = r*r;
+
+	s = r + r*r2*( -1.6666654611e-1f + r2*( 8.3321608736e-3f + r2*-1.9515295891e-4f ) );
+	c = 1.0f - 0.5f*r2 + r2*r2*( 4.166664568298827e-2f + r2*( -1.388731625493765e-3f + r2*2.443315711809948e-5f ) );
+
+	f_sincos_quadrant( q, s, c, p_sin, p_cos );
+} /* End f_sincos_precise */
+
+
+/*************************************************
+** FUNCTION: f_sincos_fast
+** VARIABLES:
+**		[I ]	float	x			: Angle (rad)
+**		[O ]	float	*p_sin
+**		[O ]	float	*p_cos
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		As f_sincos_precise, with a two part pi/2
+** 		and degree 5 sine and degree 4 cosine
+** 		polynomials (minimax on [-pi/4,pi/4]).
+** 		Two multiplies fewer per output.
+*/
+void f_sincos_fast( float x, float *p_sin, float *p_cos )
+{
+	float k, r, r2, s, c;
+	int   q;
+
+	k  = rintf( x*TRIG_2OPI );
+	q  = (int)k;
+	r  = ( x - k*TRIG_PIO2_1 ) - k*( TRIG_PIO2_2 + TRIG_PIO2_3 );
+	r2 = r*r;
+
+	s = r + r*r2*( -1.6662835297e-1f + r2*8.1530271737e-3f );
+	c = 1.0f + r2*( -4.9977639500e-1f + r2*4.0489165339e-2f );
+
+	f_sincos_quadrant( q, s, c, p_sin, p_cos );
+} /* End f_sincos_fast */
+
+
+/*************************************************
+** FUNCTION: f_sincos
+** VARIABLES:
+**		[I ]	float	x			: Angle (rad)
+**		[O ]	float	*p_sin
+**		[O ]	float	*p_cos
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Sine and cosine at the TRIG_TIER accuracy
+** 		(see Math.h for the error of each tier)
+*/
+void f_sincos( float x, float *p_sin, float *p_cos )
+{
+#if TRIG_TIER==TRIG_TIER_LIBM
+	*p_sin = sinf( x );
+	*p_cos = cosf( x );
+#elif TRIG_TIER==TRIG_TIER_FAST
+	f_sincos_fast( x, p_sin, p_cos );
+#else
+	f_sincos_precise( x, p_sin, p_cos );
+#endif
+} /* End f_sincos */
+
+
+/*************************************************
+** FUNCTION: f_rsqrt_fast
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float return	~x^-0.5
+** DESCRIPTION:
+** 		Inverse square root from the float bits:
+** 		halving the exponent with an integer shift
+** 		gives the first guess, one tuned Newton
+** 		like step refines it. x must be a positive
+** 		normal float.
+*/
+float f_rsqrt_fast( float x )
+{
+	float    y;
+	uint32_t i;
+
+	memcpy( &i, &x, sizeof(i) );
+	i = 0x5F1FFFF9UL - ( i>>1 );
+	memcpy( &y, &i, sizeof(y) );
+	return y*0.703952253f*( 2.38924456f - x*y*y );
+} /* End f_rsqrt_fast */
+
+
+/*************************************************
+** FUNCTION: f_rsqrt_precise
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float return	~x^-0.5
+** DESCRIPTION:
+** 		f_rsqrt_fast plus one Newton step
+** 		(squares the relative error)
+*/
+float f_rsqrt_precise( float x )
+{
+	float y = f_rsqrt_fast( x );
+
+	return y*( 1.5f - 0.5f*x*y*y );
+} /* End f_rsqrt_precise */
+
+
+/*************************************************
+** FUNCTION: f_rsqrt
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float return	x^-0.5
+** DESCRIPTION:
+** 		Inverse square root at the TRIG_TIER
+** 		accuracy. x must be a positive normal float.
+*/
+float f_rsqrt( float x )
+{
+#if TRIG_TIER==TRIG_TIER_LIBM
+	return 1.0f/sqrtf( x );
+#elif TRIG_TIER==TRIG_TIER_FAST
+	return f_rsqrt_fast( x );
+#else
+	return f_rsqrt_precise( x );
+#endif
+} /* End f_rsqrt */
+
+
+/*************************************************
+** FUNCTION: f_sqrt
+** VARIABLES:
+**		[I ]	float	x
+** RETURN:
+**		float return	x^0.5 (0 for x<=0)
+** DESCRIPTION:
+** 		Square root at the TRIG_TIER accuracy,
+** 		x*x^-0.5 (no divide)
+*/
+float f_sqrt( float x )
+{
+#if TRIG_TIER==TRIG_TIER_LIBM
+	return ( x>0.0f ) ? sqrtf( x ) : 0.0f;
+#else
+	return ( x>0.0f ) ? x*f_rsqrt( x ) : 0.0f;
+#endif
+} /* End f_sqrt */
+
+
+/*************************************************
+** FUNCTION: q_sqrt
+** VARIABLES:
+**		[I ]	uint64_t x
+** RETURN:
+**		uint32_t return
+** DESCRIPTION:
+** 		Integer square root, floor(x^0.5),
+** 		one result bit per iteration (shifts
+** 		and adds only). The square root of a
+** 		Q2n value is Qn.
+*/
+uint32_t q_sqrt( uint64_t x )
+{
+	uint64_t bit = (uint64_t)1 << 62;
+	uint64_t ret = 0;
+
+	while( bit>x ) { bit >>= 2; }
+	while( bit!=0 )
+	{
+		if( x>=ret+bit )
+		{
+			x  -= ret+bit;
+			ret = ( ret>>1 ) + bit;
+		}
+		else
+		{
+			ret >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)ret;
+} /* End q_sqrt */
+
+
+/*************************************************
+** FUNCTION: q_atan2
+** VARIABLES:
+**		[I ]	int32_t y
+**		[I ]	int32_t x
+** RETURN:
+**		int32_t return (rad, Q29)
+** DESCRIPTION:
+** 		Integer arctan2 (CORDIC, vectoring mode).
+** 		x and y may be in any (common) format.
+** 		They are scaled to 28 bits, the left
+** 		half plane is rotated by pi, then each
+** 		iteration rotates (x,y) towards the x
+** 		axis by +-atan(2^-i), adding up the
+** 		angle. About 1 lsb (Q29) of error.
+*/
+int32_t q_atan2( int32_t y, int32_t x )
+{
+	int32_t angle = 0;
+	int32_t xt;
+	int64_t x64 = x, y64 = y;
+	uint64_t m;
+	int i;
+
+	if( x==0 && y==0 ) { return 0; }
+
+	/* Left half plane: atan2(y,x) = atan2(-y,-x) +- pi */
+	if( x64<0 )
+	{
+		angle = ( y64>=0 ) ? Q_PI : -Q_PI;
+		x64 = -x64;
+		y64 = -y64;
+	}
+
+	/* Scale to [2^27,2^28), room for the CORDIC gain (1.65)
+	** and the rotated magnitude (2^0.5) */
+	m = (uint64_t)( x64 | ( ( y64<0 ) ? -y64 : y64 ) );
+	while( m>=( (uint64_t)1<<28 ) ) { m >>= 1; x64 >>= 1; y64 >>= 1; }
+	while( m< ( (uint64_t)1<<27 ) ) { m <<= 1; x64 <<= 1; y64 <<= 1; }
+	x = (int32_t)x64;
+	y = (int32_t)y64;
+
+	for( i=0; i<Q_CORDIC_ITER; i++ )
+	{
+		xt = x;
+		if( y>0 )
+		{
+			x     += y>>i;
+			y     -= xt>>i;
+			angle += q_atan_table[i];
+		}
+		else
+		{
+			x     -= y>>i;
+			y     += xt>>i;
+			angle -= q_atan_table[i];
+		}
+	}
+	return angle;
+} /* End q_atan2 */
+
+
+/*************************************************
+** FUNCTION: q_asin
+** VARIABLES:
+**		[I ]	int32_t x (Q30)
+** RETURN:
+**		int32_t return (rad, Q29)
+** DESCRIPTION:
+** 		Integer arcsin
+** 		asin(x) = atan2( x, (1-x^2)^0.5 )
+*/
+int32_t q_asin( int32_t x )
+{
+	int64_t one = (int64_t)1 << 30;
+
+	x = (int32_t)MAX( MIN( (int64_t)x, one ), -one );
+	return q_atan2( x, (int32_t)q_sqrt( (uint64_t)( one*one - (int64_t)x*x ) ) );
+} /* End q_asin */
+
 /*************************************************
 ** FUNCTION: calc_circle_center
 ** VARIABLES:
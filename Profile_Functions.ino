@@ -0,0 +1,206 @@
+/*******************************************************************
+** FILE:
+**   	Profile_Functions
+** DESCRIPTION:
+** 		This file contains the on-device profiler.
+** 		Each stage of loop() is timed (us) into a fixed bucket
+** 		histogram, and loop overruns, the min/max sample period
+** 		and the time spent waiting in Update_Time are counted.
+** 		The counters are read by the master over the comm port
+** 		(see f_RespondToInput). The calls are made through the
+** 		PROFILE_* macros so the profiler can be compiled out
+** 		(see Profile_Config.h).
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#if EXE_MODE==1 /* Emulator Mode */
+	/* In emulation mode, "Emulator_Protos" is needed to
+	** use functions in other files.
+	** NOTE: This header should contain the function
+	** 			 prototypes for all execution functions */
+	#include "../Include/Emulator_Protos.h"
+#endif  /* End Emulator Mode */
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Profile_Init
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Set the profiler parameters and
+** 		clear the counters
+*/
+void Profile_Init( CONTROL_TYPE *p_control )
+{
+	p_control->profile.budget = PROFILE_BUDGET;
+	Profile_Reset( p_control );
+} /* End Profile_Init */
+
+
+/*************************************************
+** FUNCTION: Profile_Reset
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Clear the counters. The master resets
+** 		the profiler to start a new measurement
+** 		window (request 0xC2).
+*/
+void Profile_Reset( CONTROL_TYPE *p_control )
+{
+	PROFILE_STATE_TYPE *p_profile = &p_control->profile;
+	int i, j;
+
+	for( i=0; i<PROFILE_N_STAGES; i++ )
+	{
+		for( j=0; j<PROFILE_N_BUCKETS; j++ ) { p_profile->hist[i][j] = 0; }
+		p_profile->max[i] = 0;
+	}
+
+	p_profile->nLoops     = 0;
+	p_profile->nOverruns  = 0;
+	p_profile->Dt_min     = 0xFFFFFFFF;
+	p_profile->Dt_max     = 0;
+	p_profile->idle       = 0;
+	p_profile->loop_idle  = 0;
+	p_profile->reset_time = PROFILE_TIME;
+	p_profile->loop_start = p_profile->reset_time;
+	p_profile->mark       = p_profile->reset_time;
+} /* End Profile_Reset */
+
+
+/*************************************************
+** FUNCTION: Profile_Record
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+**		[I ]	int						stage
+**		[I ]	uint32_t			time
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Add one stage time (us) to the stage
+** 		histogram. The bucket is the position of
+** 		the highest set bit (the M0 has no clz,
+** 		so it is found by shifting).
+*/
+void Profile_Record( CONTROL_TYPE	*p_control,
+										 int					stage,
+										 uint32_t			time )
+{
+	PROFILE_STATE_TYPE *p_profile = &p_control->profile;
+	uint32_t t = time;
+	int bucket = 0;
+
+	while( t>1 && bucket<PROFILE_N_BUCKETS-1 ) { t >>= 1; bucket++; }
+
+	p_profile->hist[stage][bucket]++;
+	if( time>p_profile->max[stage] ) { p_profile->max[stage] = time; }
+} /* End Profile_Record */
+
+
+/*************************************************
+** FUNCTION: Profile_Lap
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+**		[I ]	int						stage
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Record the time since the last mark/lap
+** 		to a stage and restart the stage timer
+*/
+void Profile_Lap( CONTROL_TYPE	*p_control,
+									int						stage )
+{
+	unsigned long now = PROFILE_TIME;
+
+	Profile_Record( p_control, stage, (uint32_t)(now - p_control->profile.mark) );
+	p_control->profile.mark = now;
+} /* End Profile_Lap */
+
+
+/*************************************************
+** FUNCTION: Profile_Loop_Begin
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Start timing one pass of loop()
+*/
+void Profile_Loop_Begin( CONTROL_TYPE *p_control )
+{
+	p_control->profile.loop_start = PROFILE_TIME;
+	p_control->profile.mark       = p_control->profile.loop_start;
+	p_control->profile.loop_idle  = 0;
+} /* End Profile_Loop_Begin */
+
+
+/*************************************************
+** FUNCTION: Profile_Loop_End
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Record the loop time, less the time
+** 		spent waiting in Update_Time, and count
+** 		an overrun if it is over budget
+*/
+void Profile_Loop_End( CONTROL_TYPE *p_control )
+{
+	PROFILE_STATE_TYPE *p_profile = &p_control->profile;
+	uint32_t busy = (uint32_t)(PROFILE_TIME - p_profile->loop_start) - p_profile->loop_idle;
+
+	Profile_Record( p_control, PROFILE_LOOP, busy );
+	p_profile->nLoops++;
+	if( busy>p_profile->budget ) { p_profile->nOverruns++; }
+} /* End Profile_Loop_End */
+
+
+/*************************************************
+** FUNCTION: Profile_Update_Time
+** VARIABLES:
+**		[IO]	CONTROL_TYPE	*p_control
+**		[I ]	unsigned long	idle
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Called at the end of Update_Time with
+** 		the time spent waiting for the sample
+** 		period. Tracks the min/max period.
+*/
+void Profile_Update_Time( CONTROL_TYPE	*p_control,
+													unsigned long	idle )
+{
+	PROFILE_STATE_TYPE *p_profile = &p_control->profile;
+	uint32_t Dt;
+
+	p_profile->idle      += (uint32_t)idle;
+	p_profile->loop_idle += (uint32_t)idle;
+
+	if( p_control->timestamp_old > 0 )
+	{
+		Dt = (uint32_t)(p_control->timestamp - p_control->timestamp_old);
+		if( Dt<p_profile->Dt_min ) { p_profile->Dt_min = Dt; }
+		if( Dt>p_profile->Dt_max ) { p_profile->Dt_max = Dt; }
+	}
+
+	/* Do not count the wait in the next stage */
+	p_profile->mark = PROFILE_TIME;
+} /* End Profile_Update_Time */
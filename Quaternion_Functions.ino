@@ -0,0 +1,209 @@
+/*******************************************************************
+** FILE:
+**   	Quaternion_Functions
+** DESCRIPTION:
+**		The quaternion orientation engine.
+** 		A Mahony style complementary filter, the alternative
+** 		to the DCM filter (see dcm_prms.Engine). It uses the
+** 		same gyro input, the same accelerometer reliability
+** 		weighting and the same PI drift correction (Kp/Ki
+** 		from DCM_PRMS_TYPE), on a unit quaternion instead of
+** 		the 3x3 matrix:
+** 			- The update is one quaternion product (12
+** 			  multiply-adds rather than 18)
+** 			- The renormalization is one scale of 4 values,
+** 			  there is no orthogonality to restore
+** 			- Pitch and roll only need the last row of the
+** 			  matrix, built from the quaternion on the fly
+** 		The state lives in DCM_STATE_TYPE next to the DCM, so
+** 		the engines can be swapped at runtime.
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#if EXE_MODE==1 /* Emulator Mode */
+	/* In emulation mode, "Emulator_Protos" is needed to
+	** use functions in other files.
+	** NOTE: This header should contain the function
+	** 			 prototypes for all execution functions */
+	#include "../Include/Emulator_Protos.h"
+#endif  /* End Emulator Mode */
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+
+/*************************************************
+** FUNCTION: Quaternion_From_DCM
+** VARIABLES:
+**		[IO]	DCM_STATE_TYPE		*p_dcm_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Set the quaternion from the DCM matrix.
+** 		The largest of w,x,y,z is found from the
+** 		diagonal first, so the division is always
+** 		well conditioned.
+*/
+void Quaternion_From_DCM( DCM_STATE_TYPE *p_dcm_state )
+{
+	float (*m)[3] = p_dcm_state->DCM_Matrix;
+	float *q      = p_dcm_state->Quaternion;
+	float trace   = m[0][0] + m[1][1] + m[2][2];
+	float s;
+
+	if( trace>0.0f )
+	{
+		s    = 0.5f/f_sqrt( trace+1.0f );
+		q[0] = 0.25f/s;
+		q[1] = ( m[2][1] - m[1][2] )*s;
+		q[2] = ( m[0][2] - m[2][0] )*s;
+		q[3] = ( m[1][0] - m[0][1] )*s;
+	}
+	else if( m[0][0]>m[1][1] && m[0][0]>m[2][2] )
+	{
+		s    = 2.0f*f_sqrt( 1.0f + m[0][0] - m[1][1] - m[2][2] );
+		q[0] = ( m[2][1] - m[1][2] )/s;
+		q[1] = 0.25f*s;
+		q[2] = ( m[0][1] + m[1][0] )/s;
+		q[3] = ( m[0][2] + m[2][0] )/s;
+	}
+	else if( m[1][1]>m[2][2] )
+	{
+		s    = 2.0f*f_sqrt( 1.0f + m[1][1] - m[0][0] - m[2][2] );
+		q[0] = ( m[0][2] - m[2][0] )/s;
+		q[1] = ( m[0][1] + m[1][0] )/s;
+		q[2] = 0.25f*s;
+		q[3] = ( m[1][2] + m[2][1] )/s;
+	}
+	else
+	{
+		s    = 2.0f*f_sqrt( 1.0f + m[2][2] - m[0][0] - m[1][1] );
+		q[0] = ( m[1][0] - m[0][1] )/s;
+		q[1] = ( m[0][2] + m[2][0] )/s;
+		q[2] = ( m[1][2] + m[2][1] )/s;
+		q[3] = 0.25f*s;
+	}
+} /* End Quaternion_From_DCM */
+
+
+/*************************************************
+** FUNCTION: Quaternion_To_DCM
+** VARIABLES:
+**		[IO]	DCM_STATE_TYPE		*p_dcm_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Set the DCM matrix from the quaternion
+*/
+void Quaternion_To_DCM( DCM_STATE_TYPE *p_dcm_state )
+{
+	float (*m)[3] = p_dcm_state->DCM_Matrix;
+	const float *q = p_dcm_state->Quaternion;
+
+	m[0][0] = 1.0f - 2.0f*( q[2]*q[2] + q[3]*q[3] );
+	m[0][1] = 2.0f*( q[1]*q[2] - q[0]*q[3] );
+	m[0][2] = 2.0f*( q[1]*q[3] + q[0]*q[2] );
+
+	m[1][0] = 2.0f*( q[1]*q[2] + q[0]*q[3] );
+	m[1][1] = 1.0f - 2.0f*( q[1]*q[1] + q[3]*q[3] );
+	m[1][2] = 2.0f*( q[2]*q[3] - q[0]*q[1] );
+
+	m[2][0] = 2.0f*( q[1]*q[3] - q[0]*q[2] );
+	m[2][1] = 2.0f*( q[2]*q[3] + q[0]*q[1] );
+	m[2][2] = 1.0f - 2.0f*( q[1]*q[1] + q[2]*q[2] );
+} /* End Quaternion_To_DCM */
+
+
+/******************************************************************
+** FUNCTION: Quaternion_Filter
+** VARIABLES:
+**		[I ]	CONTROL_TYPE			*p_control
+**		[IO]	DCM_STATE_TYPE		*p_dcm_state
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** The 4 parts of DCM_Filter, on the quaternion
+**   1. Update           - q = q * (1, Omega*G_Dt/2)
+**   2. Normalize        - q = q * (3 - |q|^2)/2
+**   3. Drift_Correction - As DCM_Filter, with the last row
+**                         of the matrix from the quaternion
+**   4. Get_Euler_Angles - As DCM_Filter (Orientation_Euler_Angles)
+*/
+void Quaternion_Filter( CONTROL_TYPE				*p_control,
+												DCM_STATE_TYPE			*p_dcm_state,
+												SENSOR_STATE_TYPE		*p_sensor_state )
+{
+	float *q = p_dcm_state->Quaternion;
+	float qw, qx, qy, qz;
+	float Half[3];
+	float renorm;
+
+	float Row2[3];
+	float Accel_magnitude;
+	float Accel_weight;
+	float errorRollPitch[3];
+	float ErrorGain[3];
+
+	/******************************************************************
+	** 1. Update the quaternion
+	** Rotation over this sample (body frame), with the
+	** feedback gains from the last iteration
+	******************************************************************/
+
+	Half[0] = 0.5f*p_control->G_Dt*( GYRO_X_SCALED( p_sensor_state->gyro[0] ) + p_dcm_state->Omega_I[0] + p_dcm_state->Omega_P[0] );
+	Half[1] = 0.5f*p_control->G_Dt*( GYRO_Y_SCALED( p_sensor_state->gyro[1] ) + p_dcm_state->Omega_I[1] + p_dcm_state->Omega_P[1] );
+	Half[2] = 0.5f*p_control->G_Dt*( GYRO_Z_SCALED( p_sensor_state->gyro[2] ) + p_dcm_state->Omega_I[2] + p_dcm_state->Omega_P[2] );
+
+	qw = q[0] - q[1]*Half[0] - q[2]*Half[1] - q[3]*Half[2];
+	qx = q[1] + q[0]*Half[0] + q[2]*Half[2] - q[3]*Half[1];
+	qy = q[2] + q[0]*Half[1] - q[1]*Half[2] + q[3]*Half[0];
+	qz = q[3] + q[0]*Half[2] + q[1]*Half[1] - q[2]*Half[0];
+
+	/******************************************************************
+	** 2. Normalize
+	** First order, as the DCM rows (the norm
+	** is within a few 1E-6 of 1 each sample)
+	******************************************************************/
+
+	renorm = 0.5f*( 3.0f - ( qw*qw + qx*qx + qy*qy + qz*qz ) );
+	q[0] = qw*renorm;
+	q[1] = qx*renorm;
+	q[2] = qy*renorm;
+	q[3] = qz*renorm;
+
+	/******************************************************************
+	** 3. Drift correction (roll and pitch)
+	** errorRP = accel x DCM[2][:], weighted as in DCM_Filter
+	******************************************************************/
+
+	Row2[0] = 2.0f*( q[1]*q[3] - q[0]*q[2] );
+	Row2[1] = 2.0f*( q[2]*q[3] + q[0]*q[1] );
+	Row2[2] = 1.0f - 2.0f*( q[1]*q[1] + q[2]*q[2] );
+
+	Accel_magnitude = f_sqrt( Vector_Dot_Product( p_sensor_state->accel, p_sensor_state->accel ) ) / p_control->sensor_prms.gravity;
+	Accel_weight    = FCONSTRAIN( 1.0-2.0*FABS(1-Accel_magnitude), 0.0, 1.0 );
+
+	Vector_Cross_Product( p_sensor_state->accel, Row2, errorRollPitch );
+	Vector_Scale( errorRollPitch, p_control->dcm_prms.Kp_RollPitch*Accel_weight, p_dcm_state->Omega_P );
+	Vector_Scale( errorRollPitch, p_control->dcm_prms.Ki_RollPitch*Accel_weight, ErrorGain );
+	Vector_Add( p_dcm_state->Omega_I, ErrorGain, p_dcm_state->Omega_I );
+
+	/******************************************************************
+	** 4. Euler angles
+	** Yaw needs two more matrix entries
+	******************************************************************/
+
+	Orientation_Euler_Angles( p_control, Row2,
+														2.0f*( q[1]*q[2] + q[0]*q[3] ),
+														1.0f - 2.0f*( q[2]*q[2] + q[3]*q[3] ),
+														p_sensor_state );
+} /* End Quaternion_Filter */
@@ -27,6 +27,7 @@
 
 #ifdef _IMU9250_
 	#include <SparkFunMPU9250-DMP.h>
+	#include <util/arduino_mpu9250_i2c.h> /* FIFO burst reads */
 	#include "./Include/IMU9250_Config.h"
 #endif
 
@@ -39,55 +40,21 @@
 	MPU9250_DMP imu; 
 #endif
 
-/* Control Structure
-** This will contain all the various settings */
-CONTROL_TYPE        g_control;
-
-/* Input data structure
-** This will contain the input data
-** In emulation mode, this is read from a binary file
-** In real-time mode, this will be from the sensors. */
-SENSOR_STATE_TYPE   g_sensor_state;
-
-/* Calibration Structure
-** This structure is used to aid in calibrating the sensor
-** This is not used in normal processing */
-CALIBRATION_TYPE  g_calibration;
-
-
-/* DSP state
-** The Digital Signal Processing algorithms
-** are filters which are applied to the individual
-** data feeds. This structure holds the state variables
-** for the algorithm.
-** NOTE: At the moment, this is a very simple FIR and IIR
-**			 filter set. Could easily be expanded. */
-DSP_STATE_TYPE   g_dsp;
-
-
-/* DCM variables
-** The Directional cosine matrix is one
-** method of determining the orientation of the
-** IMU. This matrix holds the state information of
-** the DCM algorithm. */
-DCM_STATE_TYPE      g_dcm_state;
-
-
-/* GaPA state
-** The Gait Phase Angle estimator is an algorithm
-** (or set of algorithms) which will determine the
-** current gait phase angle of the user. This
-** structure holds the state variables of the algorithm */
-GAPA_STATE_TYPE   g_gapa_state;
-
-
-/* WISE state
-** The Walking Incline and Speed Estimator is
-** an algorithm (or set of algorithms) which
-** estimates the walking speed and the incline
-** of motion of the user. This structure holds
-** the state variables for the algorithm. */
-WISE_STATE_TYPE   g_wise_state;
+/* Pipeline state
+** This contains the control structure (all the
+** various settings), the input data read from the
+** sensors and the state of each of the algorithms
+** (DSP, DCM, GaPA, WISE). See PIPELINE_STATE_TYPE */
+PIPELINE_STATE_TYPE g_pipeline;
+
+/* Sample ring
+** Filled from the IMU FIFO (and stamped by the IMU
+** data ready interrupt), drained by loop().
+** See Acquisition_Config.h */
+#if ACQ_MODE!=ACQ_MODE_POLL
+	ACQ_RING_TYPE g_acq_ring;
+	ACQ_FIFO_TYPE g_acq_fifo;
+#endif
 
 
 /*******************************************************************
@@ -111,13 +78,13 @@ void setup( void )
 	bool ret;
 	
 	/* Initialize the hardware */
-  Init_Hardware( &g_control );
+  Init_Hardware( &g_pipeline.control );
   
 	/* Initialize the control structure */
-  Common_Init( &g_control, &g_sensor_state );
+  Common_Init( &g_pipeline.control, &g_pipeline.sensor_state );
   
   /* Initialize the IMU sensors*/
-	ret = Init_IMU( &g_control, &g_sensor_state );
+	ret = Init_IMU( &g_pipeline.control, &g_pipeline.sensor_state );
 	if ( ret==0 ) 
 	{
   	LOG_PRINTLN("ERROR : Setup : Cant Connect to IMU");
@@ -128,22 +95,18 @@ void setup( void )
   ** initial accel/gyro */
   
   /* Read all active sensors */
-  Read_Sensors( &g_control, &g_sensor_state );
+  Read_Sensors( &g_pipeline.control, &g_pipeline.sensor_state );
+  #if DSP_FIXED==1
+  	DSP_Fixed_Load( &g_pipeline.sensor_state );
+  #endif
   
-  /* Initialize Freq. Filter */
-  if( g_control.DSP_on==1 ){ DSP_Filter_Init( &g_control, &g_dsp ); }
-
-	/* Initialize calibration parameters */
-  if( g_control.calibration_on==1 ){ Calibration_Init( &g_control, &g_calibration ); }
+  /* Initialize the algorithms */
+  Pipeline_Init( &g_pipeline );
 
-	/* Initialize the Directional Cosine Matrix algorithm parameters */
-  if( g_control.DCM_on==1 ){ DCM_Init( &g_control, &g_dcm_state, &g_sensor_state ); }
-
-	/* Initialize GaPA parameters */
-  if( g_control.GaPA_on==1 ){ GaPA_Init( &g_control, &g_gapa_state ); }
-
-  /* Initialize Walking Incline and Speed Estimator */
-  if( g_control.WISE_on==1 ){ WISE_Init( &g_control, &g_sensor_state, &g_wise_state ); }
+  /* Start filling the sample ring */
+  #if ACQ_MODE!=ACQ_MODE_POLL
+  	Start_Acquisition( &g_pipeline.control );
+  #endif
   	
   LOG_PRINTLN("> IMU Setup Done");
   
@@ -163,52 +126,43 @@ void setup( void )
 */
 void loop( void )
 { 
-  /* Update sensor readings */
-  Read_Sensors( &g_control, &g_sensor_state );
-  
-  /* Update the timestamp */
-  Update_Time( &g_control );
+  PROFILE_LOOP_BEGIN( &g_pipeline.control );
+
+  #if ACQ_MODE!=ACQ_MODE_POLL
+  	/* Burst read the samples queued in the IMU FIFO */
+  	Acq_FIFO_Read( &g_acq_fifo, &g_acq_ring, micros() );
+  	PROFILE_LAP( &g_pipeline.control, PROFILE_READ_SENSORS );
+
+  	/* Run the processing stages on each sample
+  	** acquired since the last pass */
+  	Acq_Process( &g_pipeline, &g_acq_ring );
+  #else
+    /* Update sensor readings */
+    Read_Sensors( &g_pipeline.control, &g_pipeline.sensor_state );
+    PROFILE_LAP( &g_pipeline.control, PROFILE_READ_SENSORS );
   
-	/* If in calibration mode,
-	** call calibration function */
-	if( g_control.calibration_on==1 ){ Calibrate( &g_control, &g_calibration, &g_sensor_state ); }
-
-	/* Apply Freq Filter to Input */
-	if( g_control.DSP_on==1 )
-	{
-		if( g_control.dsp_prms.IIR_on==1 ){ FIR_Filter( &g_control, &g_dsp, &g_sensor_state ); }
-		if( g_control.dsp_prms.IIR_on==1 ){ IIR_Filter( &g_control, &g_dsp, &g_sensor_state ); }
-		DSP_Shift( &g_control, &g_dsp );
-	}
-
-	/* Apply the DCM Filter */
-	if( g_control.DCM_on==1 ){ DCM_Filter( &g_control, &g_dcm_state, &g_sensor_state ); }
-
-	/* Estimate the Gait Phase Angle */
-	if( g_control.GaPA_on==1 ){ GaPA_Update( &g_control, &g_sensor_state, &g_gapa_state ); }
-
-	/* Estimate Walking Speed and Incline */
-	if( g_control.WISE_on==1 )
-	{
-		if( (g_sensor_state.gyro_mAve<g_control.gapa_prms.min_gyro) )
-		{
-			WISE_Update(&g_control, &g_sensor_state, &g_wise_state );
-		}
-	}
+    /* Run the processing stages
+    ** (Timing, Calibration, DSP, DCM, GaPA, WISE) */
+    Pipeline_Update( &g_pipeline );
+  #endif
     
   /* Read/Respond to command */
+  PROFILE_MARK( &g_pipeline.control );
   if( COMM_AVAILABLE>0 )
   { 
-    f_RespondToInput( &g_control, &g_sensor_state, &g_calibration, COMM_AVAILABLE );  
+    f_RespondToInput( &g_pipeline.control, &g_pipeline.sensor_state, &g_pipeline.calibration, &g_pipeline.wise_state, COMM_AVAILABLE );  
+    PROFILE_LAP( &g_pipeline.control, PROFILE_COMM );
   }
 
   /* We blink every UART_LOG_RATE millisecods */
-  if ( micros()>(g_control.LastLogTime+UART_LOG_RATE) )
+  PROFILE_MARK( &g_pipeline.control );
+  if ( micros()>(g_pipeline.control.LastLogTime+UART_LOG_RATE) )
   {
   	/* Log the current states to the debug port */
-    Debug_LogOut( &g_control, &g_sensor_state, &g_gapa_state, &g_wise_state );
+    Debug_LogOut( &g_pipeline.control, &g_pipeline.sensor_state, &g_pipeline.gapa_state, &g_pipeline.wise_state );
+    PROFILE_LAP( &g_pipeline.control, PROFILE_LOG );
     
-    g_control.LastLogTime = micros();
+    g_pipeline.control.LastLogTime = micros();
 
     /* Display number of bytes available on comm port
     ** Com port is used for real-time communication with
@@ -219,7 +173,9 @@ void loop( void )
   /* Blink LED 
   ** TO DO: It would be nice to have a blink code
   **        to communicate during operation */
-  Blink_LED( &g_control );
+  Blink_LED( &g_pipeline.control );
+
+  PROFILE_LOOP_END( &g_pipeline.control );
 } /* End loop */
 
 
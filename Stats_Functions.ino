@@ -0,0 +1,207 @@
+/*******************************************************************
+** FILE:
+**   	Stats_Functions
+** DESCRIPTION:
+** 		This file contains the sliding window motion
+** 		statistics (see Stats_Config.h). Each sample pushes
+** 		the gyro and accel magnitudes into their windows and
+** 		fills the stats of the sensor state, at a fixed cost
+** 		per sample (plus one rebuild of the sums per window).
+********************************************************************/
+
+
+/*******************************************************************
+** Includes ********************************************************
+********************************************************************/
+
+#ifndef COMMON_CONFIG_H
+	#include "../Include/Common_Config.h"
+#endif
+#if EXE_MODE==1 /* Emulator Mode */
+	/* In emulation mode, "Emulator_Protos" is needed to
+	** use functions in other files.
+	** NOTE: This header should contain the function
+	** 			 prototypes for all execution functions */
+	#include "../Include/Emulator_Protos.h"
+#endif  /* End Emulator Mode */
+
+
+/*******************************************************************
+** Functions *******************************************************
+********************************************************************/
+
+/*************************************************
+** FUNCTION: Stats_Init
+** VARIABLES:
+**		[O ]	STATS_STATE_TYPE	*p_stats
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Empty both windows
+*/
+void Stats_Init( STATS_STATE_TYPE *p_stats )
+{
+	memset( p_stats, 0, sizeof(STATS_STATE_TYPE) );
+} /* End Stats_Init */
+
+
+/*************************************************
+** FUNCTION: Stats_Window_Push
+** VARIABLES:
+**		[IO]	STATS_WINDOW_TYPE	*p_win
+**		[I ]	uint32_t					n
+**		[I ]	float							x
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Add sample n to the window, dropping
+** 		sample n-STATS_WINDOW.
+** 		The running sums subtract the dropped
+** 		sample and add the new one. Once per
+** 		window (last slot), ref is moved to the
+** 		window mean and the sums are rebuilt.
+** 		The deques first drop the expired sample
+** 		(n-STATS_WINDOW, whose slot now holds x)
+** 		from the head, then the samples the new
+** 		one makes useless (not below/above it, so
+** 		never the min/max again) from the tail.
+** 		A deque then holds at most STATS_WINDOW-1
+** 		samples before the push, so the push never
+** 		overwrites the head (a monotone run of
+** 		STATS_WINDOW samples fills it).
+*/
+void Stats_Window_Push( STATS_WINDOW_TYPE	*p_win,
+												uint32_t					n,
+												float							x )
+{
+	uint32_t slot = n & STATS_MASK;
+	uint32_t count, i;
+	float    d, mean;
+
+	/* Running sums */
+	if( n==0 ) { p_win->ref = x; }
+	if( n>=STATS_WINDOW )
+	{
+		d = p_win->x[slot] - p_win->ref;
+		p_win->sum   -= d;
+		p_win->sumsq -= d*d;
+	}
+	p_win->x[slot] = x;
+	d = x - p_win->ref;
+	p_win->sum   += d;
+	p_win->sumsq += d*d;
+
+	if( slot==STATS_MASK )
+	{
+		count = ( n<STATS_WINDOW ) ? n+1 : STATS_WINDOW;
+		mean  = 0.0f;
+		for( i=0; i<count; i++ ) { mean += p_win->x[i]; }
+		p_win->ref   = mean/count;
+		p_win->sum   = 0.0f;
+		p_win->sumsq = 0.0f;
+		for( i=0; i<count; i++ )
+		{
+			d = p_win->x[i] - p_win->ref;
+			p_win->sum   += d;
+			p_win->sumsq += d*d;
+		}
+	}
+
+	/* Min deque (increasing values) */
+	if( p_win->min_tail!=p_win->min_head &&
+			p_win->min_q[ p_win->min_head & STATS_MASK ]+STATS_WINDOW<=n ) { p_win->min_head++; }
+	while( p_win->min_tail!=p_win->min_head &&
+				 p_win->x[ p_win->min_q[(p_win->min_tail-1)&STATS_MASK] & STATS_MASK ]>=x ) { p_win->min_tail--; }
+	p_win->min_q[ p_win->min_tail++ & STATS_MASK ] = n;
+
+	/* Max deque (decreasing values) */
+	if( p_win->max_tail!=p_win->max_head &&
+			p_win->max_q[ p_win->max_head & STATS_MASK ]+STATS_WINDOW<=n ) { p_win->max_head++; }
+	while( p_win->max_tail!=p_win->max_head &&
+				 p_win->x[ p_win->max_q[(p_win->max_tail-1)&STATS_MASK] & STATS_MASK ]<=x ) { p_win->max_tail--; }
+	p_win->max_q[ p_win->max_tail++ & STATS_MASK ] = n;
+} /* End Stats_Window_Push */
+
+
+/*************************************************
+** FUNCTION: Stats_Window_Read
+** VARIABLES:
+**		[I ]	const STATS_WINDOW_TYPE	*p_win
+**		[I ]	uint32_t								count
+**		[O ]	float										*p_mAve
+**		[O ]	float										*p_M2
+**		[O ]	float										*p_min
+**		[O ]	float										*p_max
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Mean, sum of squared deviations, min and
+** 		max of the count samples in the window.
+** 		M2 = sum((x-ref)^2) - sum(x-ref)^2/count
+*/
+void Stats_Window_Read( const STATS_WINDOW_TYPE	*p_win,
+												uint32_t								count,
+												float										*p_mAve,
+												float										*p_M2,
+												float										*p_min,
+												float										*p_max )
+{
+	float M2 = p_win->sumsq - p_win->sum*p_win->sum/count;
+
+	*p_mAve = p_win->ref + p_win->sum/count;
+	*p_M2   = ( M2>0.0f ) ? M2 : 0.0f;
+	*p_min  = p_win->x[ p_win->min_q[ p_win->min_head & STATS_MASK ] & STATS_MASK ];
+	*p_max  = p_win->x[ p_win->max_q[ p_win->max_head & STATS_MASK ] & STATS_MASK ];
+} /* End Stats_Window_Read */
+
+
+/*************************************************
+** FUNCTION: Stats_Update
+** VARIABLES:
+**		[IO]	STATS_STATE_TYPE	*p_stats
+**		[IO]	SENSOR_STATE_TYPE	*p_sensor_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Push the gyro and accel magnitudes of the
+** 		current sample and update the stats of
+** 		the sensor state:
+** 		  *_Ave       - mean since start
+** 		  *_mAve      - window mean
+** 		  *_M2        - window sum of squares
+** 		  *_sVar/pVar - window sample/population variance
+** 		  *_min/max   - window min/max
+*/
+void Stats_Update( STATS_STATE_TYPE		*p_stats,
+									 SENSOR_STATE_TYPE	*p_sensor_state )
+{
+	uint32_t n = p_stats->n;
+	uint32_t count;
+	float    gyro, accel;
+
+	gyro  = f_sqrt( p_sensor_state->gyro[0]*p_sensor_state->gyro[0] +
+									p_sensor_state->gyro[1]*p_sensor_state->gyro[1] +
+									p_sensor_state->gyro[2]*p_sensor_state->gyro[2] );
+	accel = f_sqrt( p_sensor_state->accel[0]*p_sensor_state->accel[0] +
+									p_sensor_state->accel[1]*p_sensor_state->accel[1] +
+									p_sensor_state->accel[2]*p_sensor_state->accel[2] );
+
+	Stats_Window_Push( &p_stats->gyro,  n, gyro );
+	Stats_Window_Push( &p_stats->accel, n, accel );
+	p_stats->n = n+1;
+	count = ( n<STATS_WINDOW ) ? n+1 : STATS_WINDOW;
+
+	/* Gyro */
+	p_sensor_state->gyro_Ave = Rolling_Mean( n+1, p_sensor_state->gyro_Ave, gyro );
+	Stats_Window_Read( &p_stats->gyro, count, &p_sensor_state->gyro_mAve, &p_sensor_state->gyro_M2,
+										 &p_sensor_state->gyro_min, &p_sensor_state->gyro_max );
+	p_sensor_state->gyro_sVar = ( count>1 ) ? Rolling_Sample_Variance( count, p_sensor_state->gyro_M2 ) : 0.0f;
+	p_sensor_state->gyro_pVar = Rolling_Population_Variance( count, p_sensor_state->gyro_M2 );
+
+	/* Accel */
+	p_sensor_state->accel_Ave = Rolling_Mean( n+1, p_sensor_state->accel_Ave, accel );
+	Stats_Window_Read( &p_stats->accel, count, &p_sensor_state->accel_mAve, &p_sensor_state->accel_M2,
+										 &p_sensor_state->accel_min, &p_sensor_state->accel_max );
+	p_sensor_state->accel_sVar = ( count>1 ) ? Rolling_Sample_Variance( count, p_sensor_state->accel_M2 ) : 0.0f;
+	p_sensor_state->accel_pVar = Rolling_Population_Variance( count, p_sensor_state->accel_M2 );
+} /* End Stats_Update */
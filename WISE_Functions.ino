@@ -67,7 +67,8 @@ void WISE_Init ( CONTROL_TYPE				*p_control,
 
   p_wise_state->swing_state = FALSE; /* Bool */
   p_wise_state->toe_off     = FALSE; /* Bool */
-  p_wise_state->minCount    = WISE_MINCOUNT;
+  p_wise_state->stride_end  = FALSE; /* Bool */
+  p_wise_state->minCount    = p_control->wise_prms.mini_count;
 
   p_wise_state->Nsamples = 1.0f;
   p_wise_state->Ncycles  = 0.0f;
@@ -96,6 +97,13 @@ void WISE_Init ( CONTROL_TYPE				*p_control,
 
   p_wise_state->CrossingP.vel[0] = 999;
 
+  memset( &p_wise_state->fit, 0, sizeof(WISE_FIT_TYPE) );
+  memset( &p_wise_state->GaitStart.fit, 0, sizeof(WISE_FIT_TYPE) );
+  memset( &p_wise_state->GaitEnd.fit, 0, sizeof(WISE_FIT_TYPE) );
+  memset( p_wise_state->strides, 0, sizeof(p_wise_state->strides) );
+  p_wise_state->nStrides        = 0;
+  p_wise_state->gapa_cycle_time = 0.0f;
+
   for( i=0;i<3;i++ )
   {
     /* Initialize WISE Acceleration state vector */
@@ -166,6 +174,9 @@ void WISE_Update ( CONTROL_TYPE				*p_control,
   /* Get distance traveled and compute incline */
   Adjust_Incline( p_control, p_sensor_state, p_wise_state );
 
+  /* Record the stride once both stages are done with it */
+  if( p_wise_state->stride_end==TRUE ) { WISE_Stride_Push( p_wise_state ); }
+
   /* Reset at toeoff */
   if( p_wise_state->toe_off==TRUE ) { WISE_Reset( p_control, p_wise_state ); }
 
@@ -192,8 +203,9 @@ void WISE_Reset ( CONTROL_TYPE			*p_control,
 {
   int i;
 
-  p_wise_state->toe_off  = FALSE;
-  p_wise_state->Nsamples = 1.0f;
+  p_wise_state->toe_off    = FALSE;
+  p_wise_state->stride_end = FALSE;
+  p_wise_state->Nsamples   = 1.0f;
 
   for( i=0; i<=2; i++)
   {
@@ -219,6 +231,9 @@ void WISE_Reset ( CONTROL_TYPE			*p_control,
 
     p_wise_state->dist[i]      = 0.0f;
   }
+
+  /* New integration segment */
+  memset( &p_wise_state->fit, 0, sizeof(WISE_FIT_TYPE) );
 } /* End WISE_Reset */
 
 
@@ -282,40 +297,33 @@ void Map_Accel_2D ( CONTROL_TYPE				*p_control,
   **       Rotation will need to be accounted for
   */
   float Ax, Az, R;
-
-  switch( PITCH_O )
-  {
-  	case 1: /* P: 0:Nadir0/Zenith down  +90:Aft down   -90:Fore down */
-		  Ax = p_sensor_state->accel[0]; /* Movement: +x */
-		  Az = p_sensor_state->accel[2]; /* Gravity:  -z */
-		  R  = p_sensor_state->gyro[1];  /* Rotation: -y */
-		  break;
-		case 2: /* P: 0:Fore/Aft down       +90:Port down  -90:Starboard down */
-		  Ax = p_sensor_state->accel[1]; /* Movement: +y (stbd) */
-		  Az = p_sensor_state->accel[0]; /* Gravity:  -x (fwd) */
-		  R  = p_sensor_state->gyro[2];  /* Rotation: -z */
-			break;
-		case 3: /* P: 0:Fore/Aft down       +90:Nadir down -90:Zenith down */
-		  Ax = p_sensor_state->accel[2]; /* Movement: +x */
-		  Az = p_sensor_state->accel[0]; /* Gravity:  -z */
-		  R  = p_sensor_state->gyro[1];  /* Rotation: -y */
-			break;
-	}
+  float sp, cp;
+
+  /* Movement, gravity and rotation axes for PITCH_O (see DCM_Kernels.h)
+  ** PITCH_O:1 - Movement: +x  Gravity: -z  Rotation: -y
+  ** PITCH_O:2 - Movement: +y  Gravity: -x  Rotation: -z
+  ** PITCH_O:3 - Movement: +z  Gravity: -x  Rotation: -y */
+  Ax = p_sensor_state->accel[DCM_PITCH_POLICY<PITCH_O>::ACCEL_X];
+  Az = p_sensor_state->accel[DCM_PITCH_POLICY<PITCH_O>::ACCEL_Z];
+  R  = p_sensor_state->gyro[DCM_PITCH_POLICY<PITCH_O>::GYRO];
   p_wise_state->accel_delta[0] = Ax;
   p_wise_state->accel_delta[1] = Az;
   p_wise_state->gyr[0]         = R;
 
+  /* Pitch rotation, used by both parts */
+  f_sincos( p_sensor_state->pitch, &sp, &cp );
+
   /**********************************
   ** Tangent Part *******************
   **********************************/
 
   /* Calc wrt world coordinate system */
-  p_wise_state->accel[0]   = (Ax*cos(p_sensor_state->pitch) - Az*sin(p_sensor_state->pitch)) * GTOMPS2/GRAVITY * MPSTOMPH * WISE_CORRECTION;
+  p_wise_state->accel[0]   = (Ax*cp - Az*sp) * GTOMPS2/GRAVITY * MPSTOMPH * p_control->wise_prms.correction;
 
   /* Feedback */
   p_wise_state->accel_delta[0] = p_wise_state->accel[0] - p_wise_state->accel_delta[0];
-  p_wise_state->omega_ad[0]    = p_wise_state->accel_delta[0]*WISE_GAIN_AD;
-  p_wise_state->omega_ap[0]    = p_wise_state->accel[0]*WISE_GAIN_AP;
+  p_wise_state->omega_ad[0]    = p_wise_state->accel_delta[0]*p_control->wise_prms.gain_ad;
+  p_wise_state->omega_ap[0]    = p_wise_state->accel[0]*p_control->wise_prms.gain_ap;
 
   /* Get average */
   p_wise_state->accel_total[0] += p_wise_state->accel[0];
@@ -326,12 +334,12 @@ void Map_Accel_2D ( CONTROL_TYPE				*p_control,
   **********************************/
 
   /* Calc Ay wrt world coordinate system */
-  p_wise_state->accel[1]  = -(Ax*sin(p_sensor_state->pitch) - Az*cos(p_sensor_state->pitch)  - GRAVITY) * GTOMPS2/GRAVITY * MPSTOMPH;// * (1/WISE_CORRECTION);
+  p_wise_state->accel[1]  = -(Ax*sp - Az*cp  - GRAVITY) * GTOMPS2/GRAVITY * MPSTOMPH;// * (1/WISE_CORRECTION);
 
   /* Feedback */
   p_wise_state->accel_delta[1] = p_wise_state->accel[1] - p_wise_state->accel_delta[1];
-  p_wise_state->omega_ad[1]    = p_wise_state->accel_delta[1]*WISE_GAIN_AD;
-  p_wise_state->omega_ap[1]    = p_wise_state->accel[1]*WISE_GAIN_AP;
+  p_wise_state->omega_ad[1]    = p_wise_state->accel_delta[1]*p_control->wise_prms.gain_ad;
+  p_wise_state->omega_ap[1]    = p_wise_state->accel[1]*p_control->wise_prms.gain_ap;
 
   /* Get average */
   p_wise_state->accel_total[1] += p_wise_state->accel[1];
@@ -354,12 +362,16 @@ void Map_Accel_2D ( CONTROL_TYPE				*p_control,
 **		Integrate acceleration (wrt leg ref coordinates)
 ** 		to get velocity (wrt leg ref coordinates)
 ** 		Assumes 2D motion
+** 		Also adds the velocity to the line fit sums
+** 		used by Adjust_Velocity to estimate the drift
 */
 void Integrate_Accel_2D ( CONTROL_TYPE				*p_control,
 								   				SENSOR_STATE_TYPE		*p_sensor_state,
 									 				WISE_STATE_TYPE			*p_wise_state )
 {
   int i;
+  float t;
+
   for( i=0; i<=2; i++)
   {
     p_wise_state->vel_delta[i] = p_wise_state->vel[i];
@@ -374,7 +386,7 @@ void Integrate_Accel_2D ( CONTROL_TYPE				*p_control,
     if( (p_wise_state->Ncycles>=1) )
     {
 	    //p_wise_state->omega_vp[i]  = (p_wise_state->GaitStart.drift[i]*0.5*p_wise_state->Nsamples*p_wise_state->Nsamples)*WISE_GAIN_VP;
-	    p_wise_state->omega_vp[i]  = (p_wise_state->GaitStart.drift[i])*WISE_GAIN_VP;
+	    p_wise_state->omega_vp[i]  = (p_wise_state->GaitStart.drift[i])*p_control->wise_prms.gain_vp;
 	    //p_wise_state->vel[i]      -= (p_wise_state->omega_vp[i]);
 		}
 
@@ -382,11 +394,24 @@ void Integrate_Accel_2D ( CONTROL_TYPE				*p_control,
     //p_wise_state->vel_ave[i]  = p_wise_state->vel_total[i]/p_wise_state->Nsample;
   }
 
+  /* Line fit sums, t is the time since the first
+  ** sample of the segment (s) */
+  if( p_wise_state->fit.n==0.0f ) { p_wise_state->fit.Time0 = p_control->timestamp; }
+  t = (float)( p_control->timestamp - p_wise_state->fit.Time0 )/TIME_RESOLUTION;
+  p_wise_state->fit.n  += 1.0f;
+  p_wise_state->fit.t  += t;
+  p_wise_state->fit.tt += t*t;
+  for( i=0; i<2; i++ )
+  {
+    p_wise_state->fit.v[i]  += p_wise_state->vel[i];
+    p_wise_state->fit.tv[i] += t*p_wise_state->vel[i];
+  }
+
 
   /*********************************
   ** Rotational Part ***************
   **********************************/
-  p_wise_state->rot[0] = p_wise_state->rot[i] + p_wise_state->gyr[i]*p_control->G_Dt;
+  p_wise_state->rot[0] = p_wise_state->rot[0] + p_wise_state->gyr[0]*p_control->G_Dt;
 
 
 } /* End Integrate_Accel_2D */
@@ -407,13 +432,15 @@ void Integrate_Accel_2D ( CONTROL_TYPE				*p_control,
 ** 		We detect toe-off events, from there we
 ** 		can determine an estimated drift over the previous
 ** 		gait cycle. Then we can adjust the average velocity.
+** 		The drift is the slope of the least-squares line
+** 		through every velocity sample of the segment up to
+** 		toe-off (see WISE_Drift_Fit), so a single noisy
+** 		sample at toe-off does not set it.
 */
 void Adjust_Velocity( CONTROL_TYPE				*p_control,
 								   		SENSOR_STATE_TYPE		*p_sensor_state,
 									 		WISE_STATE_TYPE			*p_wise_state )
 {
-  float NGaitSamples = 0.0f;
-
   /* Part 0: Set gait start for first cycle */
   if( (p_wise_state->Ncycles==0) & (p_wise_state->Nsamples==1) )
   {
@@ -444,6 +471,7 @@ void Adjust_Velocity( CONTROL_TYPE				*p_control,
 		p_wise_state->GaitEnd.vel_total[0] = p_wise_state->vel_total[0];
 		p_wise_state->GaitEnd.vel_total[1] = p_wise_state->vel_total[1];
 		p_wise_state->GaitEnd.Nsamples     = p_wise_state->Nsamples;
+		p_wise_state->GaitEnd.fit          = p_wise_state->fit;
 	}
 
   /* Part I : At toe-off, we must correct velocity measured
@@ -464,20 +492,19 @@ void Adjust_Velocity( CONTROL_TYPE				*p_control,
     ** GaitStart[1] is reset within the first full gait cycle */
     if( p_wise_state->Ncycles>=1 )
     {
-    	/* Get number of samples in this gait */
-    	NGaitSamples = p_wise_state->GaitEnd.Nsamples - p_wise_state->GaitStart.Nsamples - 1;
-
-      /* We correct for the drift by approximating
-      ** the slope in velocity over the gait cycle.
-      ** We can then subtract the accumulated drift
-      ** over the cycle and the dc bias.
-      ** GaitStart = {vel0_i, vel1_i}
-      ** This assumes we reset N at each toeoff */
-      p_wise_state->GaitEnd.drift[0] = ( p_wise_state->GaitEnd.vel[0]-p_wise_state->GaitStart.vel[0] )/NGaitSamples;
-      p_wise_state->vel_ave[0]   = ( (p_wise_state->GaitStart.vel_total[0]) - (p_wise_state->GaitEnd.drift[0]*0.5*NGaitSamples*NGaitSamples) - (p_wise_state->GaitStart.vel[0]*NGaitSamples) ) * (1/NGaitSamples);
-
-      p_wise_state->GaitEnd.drift[1] = ( p_wise_state->GaitEnd.vel[1]-p_wise_state->GaitStart.vel[1] )/NGaitSamples;
-      p_wise_state->vel_ave[1]   = ( (p_wise_state->GaitStart.vel_total[1]) - (p_wise_state->GaitEnd.drift[1]*0.5*NGaitSamples*NGaitSamples) - (p_wise_state->GaitStart.vel[1]*NGaitSamples) ) * (1/NGaitSamples);
+      /* We correct for the drift by fitting a line
+      ** to the velocity over the gait cycle. The
+      ** velocity starts from 0 at the segment start,
+      ** so removing the drift line from there leaves
+      ** vel_ave = ( Sv - drift*St )/n
+      ** No fit (toe-off not found in this segment)
+      ** keeps the last estimate. The stride is recorded
+      ** by WISE_Update, once the incline is updated */
+      if( WISE_Drift_Fit( &p_wise_state->GaitEnd.fit, 0, &p_wise_state->GaitEnd.drift[0], &p_wise_state->vel_ave[0] ) &&
+          WISE_Drift_Fit( &p_wise_state->GaitEnd.fit, 1, &p_wise_state->GaitEnd.drift[1], &p_wise_state->vel_ave[1] ) )
+      {
+        p_wise_state->stride_end = TRUE;
+      }
     }
 
     /* Reset saved minima and increment cycle counter */
@@ -491,6 +518,7 @@ void Adjust_Velocity( CONTROL_TYPE				*p_control,
     p_wise_state->GaitEnd.vel_total[0] = (999);
     p_wise_state->GaitEnd.vel_total[1] = (999);
     p_wise_state->GaitEnd.Nsamples     = (999);
+    memset( &p_wise_state->GaitEnd.fit, 0, sizeof(WISE_FIT_TYPE) );
 
     p_wise_state->CrossingP.vel[0] = p_wise_state->rot[0];
 
@@ -532,6 +560,84 @@ void Adjust_Velocity( CONTROL_TYPE				*p_control,
 } /* End Adjust_Velocity */
 
 
+/*****************************************************************
+** FUNCTION: WISE_Drift_Fit
+** VARIABLES:
+**		[I ]	const WISE_FIT_TYPE	*p_fit
+**		[I ]	int									i
+**		[O ]	float								*p_drift
+**		[O ]	float								*p_vel_ave
+** RETURN:
+**		BOOL	1:Fitted
+**					0:Less than 2 samples, outputs unchanged
+** DESCRIPTION:
+** 		Least-squares line of velocity i over
+** 		the segment (see WISE_FIT_TYPE). The
+** 		drift is the slope (per second), and the
+** 		mean velocity is taken without the drift
+** 		line from 0 at the segment start.
+** 		With the denominator at or near 0 (no
+** 		spread in t, see WISE_FIT_MIN_DEN) there
+** 		is no slope: the drift is 0 and vel_ave
+** 		the plain mean.
+** 		Same operations as Sweep_WISE_Update.
+*/
+bool WISE_Drift_Fit( const WISE_FIT_TYPE	*p_fit,
+										 int									i,
+										 float								*p_drift,
+										 float								*p_vel_ave )
+{
+	float den = p_fit->n*p_fit->tt - p_fit->t*p_fit->t;
+
+	if( p_fit->n<2.0f ) { return FALSE; }
+
+	*p_drift   = ( den>WISE_FIT_MIN_DEN*p_fit->n*p_fit->tt ) ? ( p_fit->n*p_fit->tv[i] - p_fit->t*p_fit->v[i] )/den : 0.0f;
+	*p_vel_ave = ( p_fit->v[i] - (*p_drift)*p_fit->t )/p_fit->n;
+	return TRUE;
+} /* End WISE_Drift_Fit */
+
+
+/*****************************************************************
+** FUNCTION: WISE_Stride_Push
+** VARIABLES:
+**		[IO]	WISE_STATE_TYPE		*p_wise_state
+** RETURN:
+**		NONE
+** DESCRIPTION:
+** 		Record the stride which just ended (at
+** 		toe-off, once vel_ave and Incline_gait
+** 		are updated) in the stride history, over
+** 		the oldest one. Adjust_Velocity has moved
+** 		the ended gait to GaitStart by then.
+** 		The times and the sample count are those
+** 		of the fit vel_ave comes from (GaitStart.fit,
+** 		from the segment start to the rotational
+** 		maximum), so the duration and Nsamples
+** 		cover the same samples.
+** 		A stride with no samples (toe-off found
+** 		again on the next sample) has no mean
+** 		velocity and is not recorded.
+*/
+void WISE_Stride_Push( WISE_STATE_TYPE *p_wise_state )
+{
+	WISE_STRIDE_TYPE *p_stride = &p_wise_state->strides[ p_wise_state->nStrides & WISE_STRIDE_MASK ];
+	const WISE_GATE_TYPE *p_gait = &p_wise_state->GaitStart;
+
+	if( p_gait->fit.n<1.0f ) { return; }
+
+	p_stride->StartTime    = p_gait->fit.Time0;
+	p_stride->EndTime      = p_gait->Time;
+	p_stride->Nsamples     = p_gait->fit.n;
+	p_stride->vel_ave[0]   = p_wise_state->vel_ave[0];
+	p_stride->vel_ave[1]   = p_wise_state->vel_ave[1];
+	p_stride->Incline_gait = p_wise_state->Incline_gait;
+	p_stride->drift[0]     = p_gait->drift[0];
+	p_stride->drift[1]     = p_gait->drift[1];
+	p_stride->cycle_time   = p_wise_state->gapa_cycle_time;
+	p_wise_state->nStrides++;
+} /* End WISE_Stride_Push */
+
+
 /*****************************************************************
 ** FUNCTION: Adjust_Incline
 ** VARIABLES:
@@ -558,16 +664,22 @@ void Adjust_Incline( CONTROL_TYPE				*p_control,
 	p_wise_state->dist[1] += p_wise_state->vel[1]*(p_control->G_Dt);
 
 
-	/* Compute incline estimate */
-	tempi = (p_wise_state->dist[1]/p_wise_state->dist[0])*100;
-	p_wise_state->Incline_ave = Rolling_Mean( p_wise_state->Nsamples, p_wise_state->Incline_ave, tempi );
+	/* Compute incline estimate
+	** No horizontal distance yet (e.g. first sample after a reset),
+	** 0/0 would poison the rolling mean */
+	if( p_wise_state->dist[0]!=0 )
+	{
+		tempi = (p_wise_state->dist[1]/p_wise_state->dist[0])*100;
+		p_wise_state->Incline_ave = Rolling_Mean( p_wise_state->Nsamples, p_wise_state->Incline_ave, tempi );
+	}
 
-	/* Compute an average incline estimate using the final velocity estimate */
+	/* Compute an average incline estimate using the final velocity estimate
+	** No horizontal distance (no time since the gait start), keep the last */
 	if( (p_wise_state->Ncycles>3) )
 	{
 		tempx = p_wise_state->vel_ave[0]*(p_control->timestamp-p_wise_state->GaitStart.Time)/TIME_RESOLUTION;
-		tempx = p_wise_state->vel_ave[1]*(p_control->timestamp-p_wise_state->GaitStart.Time)/TIME_RESOLUTION;
-		p_wise_state->Incline_gait = (tempy/tempx)*100;
+		tempy = p_wise_state->vel_ave[1]*(p_control->timestamp-p_wise_state->GaitStart.Time)/TIME_RESOLUTION;
+		if( tempx!=0 ) { p_wise_state->Incline_gait = (tempy/tempx)*100; }
 	}
 
 } /* End Get_WISE */